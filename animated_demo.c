@@ -1,5 +1,18 @@
+/*
+ * Animated linked list demo
+ *
+ * Usage:
+ *   animated_demo [-f] [-n extra_nodes] [-r recording] [-p recording]
+ *
+ *   -f  Frame mode: buffered frames, elided long lists, time budget
+ *   -n  Append this many random nodes after the demo's five
+ *   -r  Headless: record the frames to a file instead of showing them
+ *   -p  Replay a recording and exit
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "linked_list.h"
 #include "animation.h"
 
@@ -16,8 +29,39 @@ void printHeader() {
     printf("%s\n", RESET);
 }
 
-int main() {
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-f] [-n extra_nodes] [-r recording] [-p recording]\n", prog);
+}
+
+int main(int argc, char** argv) {
     Node* list = NULL;
+    int extraNodes = 0;
+    const char* recordPath = NULL;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "fn:r:p:h")) != -1) {
+        switch (opt) {
+            case 'f': setAnimationMode(ANIMATE_FRAMES); break;
+            case 'n': extraNodes = atoi(optarg); break;
+            case 'r': recordPath = optarg; break;
+            case 'p': {
+                int frames = replayAnimation(optarg, 1.0);
+                if (frames < 0) {
+                    fprintf(stderr, "✗ Cannot replay %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                printf("%s✓ Replayed %d frames%s\n", GREEN, frames, RESET);
+                return EXIT_SUCCESS;
+            }
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (recordPath != NULL && startAnimationRecording(recordPath) != 0) {
+        fprintf(stderr, "✗ Cannot create %s\n", recordPath);
+        return EXIT_FAILURE;
+    }
     
     // Set line buffering
     setvbuf(stdout, NULL, _IOLBF, 0);
@@ -53,6 +97,17 @@ int main() {
     
     animateInsert(list, 56, "end");
     list = insertEnd(list, 56);
+    
+    if (extraNodes > 0) {
+        int* values = (int*)malloc(sizeof(int) * (size_t)extraNodes);
+        if (values != NULL) {
+            for (int i = 0; i < extraNodes; i++) {
+                values[i] = 100 + rand() % 900;
+            }
+            list = insertArray(list, values, extraNodes);
+            free(values);
+        }
+    }
     animateDisplay(list, "Current list");
     sleep_ms(1000);
     
@@ -118,5 +173,9 @@ int main() {
     
     freeList(list);
     
+    if (recordPath != NULL) {
+        stopAnimationRecording();
+        printf("%s✓ Frames recorded to %s (replay with -p)%s\n", GREEN, recordPath, RESET);
+    }
     return EXIT_SUCCESS;
 }
@@ -1,15 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
 #include "animation.h"
 
-// Sleep function for milliseconds
+static AnimationMode animationMode = ANIMATE_STEPWISE;
+static int animationWindow = ANIMATION_WINDOW;
+static int animationBudget = ANIMATION_BUDGET;
+static FILE* animationRecord = NULL;
+
+// Sleep function for milliseconds (no-op while recording)
 void sleep_ms(int milliseconds) {
+    if (animationRecord != NULL) return;
     usleep(milliseconds * 1000);
 }
 
+static int framedDisplay(Node* head, const char* label);
+static int framedInsert(Node* head, int value, const char* position);
+static int framedDelete(Node* head, int value);
+static int framedSearch(Node* head, int target);
+static int framedSort(Node* head, const char* algorithm);
+static int framedReverse(Node* head);
+
 // Animated display with color highlighting
 void animateDisplay(Node* head, const char* label) {
+    if (animationMode == ANIMATE_FRAMES && framedDisplay(head, label)) return;
+    
     if (head == NULL) {
         printf("%s%s%s: %s[Empty]%s\n", BOLD, CYAN, label, RED, RESET);
         return;
@@ -38,6 +57,8 @@ void animateDisplay(Node* head, const char* label) {
 
 // Animate insertion with visual feedback
 void animateInsert(Node* head, int value, const char* position) {
+    if (animationMode == ANIMATE_FRAMES && framedInsert(head, value, position)) return;
+    
     printf("\n%s=== INSERTING %d at %s ===%s\n", YELLOW, value, position, RESET);
     sleep_ms(ANIMATION_DELAY);
     
@@ -56,6 +77,8 @@ void animateInsert(Node* head, int value, const char* position) {
 
 // Animate deletion with visual feedback
 void animateDelete(Node* head, int value) {
+    if (animationMode == ANIMATE_FRAMES && framedDelete(head, value)) return;
+    
     printf("\n%s=== DELETING %d ===%s\n", YELLOW, value, RESET);
     sleep_ms(ANIMATION_DELAY);
     
@@ -89,6 +112,8 @@ void animateDelete(Node* head, int value) {
 
 // Animate search with visual feedback
 void animateSearch(Node* head, int target) {
+    if (animationMode == ANIMATE_FRAMES && framedSearch(head, target)) return;
+    
     printf("\n%s=== SEARCHING FOR %d ===%s\n", YELLOW, target, RESET);
     sleep_ms(ANIMATION_DELAY);
     
@@ -118,6 +143,8 @@ void animateSearch(Node* head, int target) {
 
 // Animate sort with visual feedback
 void animateSort(Node* head, const char* algorithm) {
+    if (animationMode == ANIMATE_FRAMES && framedSort(head, algorithm)) return;
+    
     printf("\n%s=== SORTING USING %s ===%s\n", YELLOW, algorithm, RESET);
     sleep_ms(ANIMATION_DELAY);
     
@@ -156,6 +183,8 @@ void animateSort(Node* head, const char* algorithm) {
 
 // Animate reverse with visual feedback
 void animateReverse(Node* head) {
+    if (animationMode == ANIMATE_FRAMES && framedReverse(head)) return;
+    
     printf("\n%s=== REVERSING LIST ===%s\n", YELLOW, RESET);
     sleep_ms(ANIMATION_DELAY);
     
@@ -191,3 +220,444 @@ void animateReverse(Node* head) {
     printf("%s✓ Reverse complete!%s\n", GREEN, RESET);
     sleep_ms(ANIMATION_DELAY / 2);
 }
+
+// ============================================================================
+// FRAME RENDERING
+// ============================================================================
+
+void setAnimationMode(AnimationMode mode) {
+    animationMode = mode;
+}
+
+void setAnimationWindow(int nodes) {
+    animationWindow = nodes < 0 ? 0 : nodes;
+}
+
+void setAnimationBudget(int milliseconds) {
+    animationBudget = milliseconds > 0 ? milliseconds : ANIMATION_BUDGET;
+}
+
+// The frame being built; reused, so steady-state frames do not allocate
+typedef struct Frame {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int openRows;       // Rows the last frame left on screen without a newline
+} Frame;
+
+static Frame frame;
+
+// Format straight into the frame, growing it to fit whatever the length
+static void frameAppendV(const char* format, va_list args) {
+    for (;;) {
+        size_t room = frame.capacity - frame.length;
+        va_list copy;
+        va_copy(copy, args);
+        int n = vsnprintf(frame.data + frame.length, room, format, copy);
+        va_end(copy);
+        if (n < 0) return;
+        if ((size_t)n < room) {
+            frame.length += (size_t)n;
+            return;
+        }
+        size_t capacity = frame.capacity ? frame.capacity * 2 : 4096;
+        while (capacity - frame.length <= (size_t)n) capacity *= 2;
+        char* data = (char*)realloc(frame.data, capacity);
+        if (data == NULL) return;   // Frame comes out truncated
+        frame.data = data;
+        frame.capacity = capacity;
+    }
+}
+
+static void frameAppend(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    frameAppendV(format, args);
+    va_end(args);
+}
+
+static void frameAppendByte(char byte) {
+    if (frame.length + 1 >= frame.capacity) {
+        size_t capacity = frame.capacity ? frame.capacity * 2 : 4096;
+        char* data = (char*)realloc(frame.data, capacity);
+        if (data == NULL) return;
+        frame.data = data;
+        frame.capacity = capacity;
+    }
+    frame.data[frame.length++] = byte;
+}
+
+// Columns a line takes on screen: UTF-8 characters, less escape sequences
+static int visibleWidth(const char* text, size_t length) {
+    int width = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '\x1b') {
+            while (i + 1 < length && !((text[i + 1] >= 'A' && text[i + 1] <= 'Z') ||
+                                       (text[i + 1] >= 'a' && text[i + 1] <= 'z'))) {
+                i++;
+            }
+            i++;
+        } else if (c >= ' ' && (c & 0xC0) != 0x80) {
+            width++;
+        }
+    }
+    return width;
+}
+
+static int terminalWidth(void) {
+    struct winsize size;
+    if (animationRecord == NULL && isatty(STDOUT_FILENO) &&
+        ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+        return size.ws_col;
+    }
+    return 80;
+}
+
+// Start a frame. If the last frame ended mid-line it is redrawn in place:
+// back to its first row, then clear to the end of the screen.
+static void frameBegin(void) {
+    frame.length = 0;
+    if (frame.openRows > 0) {
+        frameAppend("\r");
+        if (frame.openRows > 1) frameAppend("\x1b[%dA", frame.openRows - 1);
+        frameAppend("\x1b[J");
+    }
+}
+
+static void writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+}
+
+// Put the frame on screen with one write (or into the recording), then
+// hold it for delayMs
+static void frameShow(int delayMs) {
+    const char* lastLine = frame.data;
+    for (size_t i = frame.length; i > 0; i--) {
+        if (frame.data[i - 1] == '\n') {
+            lastLine = frame.data + i;
+            break;
+        }
+    }
+    size_t tail = frame.length - (size_t)(lastLine - frame.data);
+    int width = terminalWidth();
+    frame.openRows = tail == 0 ? 0 : (visibleWidth(lastLine, tail) + width - 1) / width;
+
+    if (animationRecord != NULL) {
+        fprintf(animationRecord, "\f%d\n", delayMs);
+        fwrite(frame.data, 1, frame.length, animationRecord);
+        return;
+    }
+    fflush(stdout);     // Keep order with the caller's printf output
+    writeAll(STDOUT_FILENO, frame.data, frame.length);
+    sleep_ms(delayMs);
+}
+
+// A frame of one line of text, of any length
+static void frameMessage(int delayMs, const char* format, ...) {
+    frameBegin();
+    va_list args;
+    va_start(args, format);
+    frameAppendV(format, args);
+    va_end(args);
+    frameAppendByte('\n');
+    frameShow(delayMs);
+}
+
+// Copy the values out so frames can index the list; NULL if out of memory
+// (an empty list gives a non-NULL array of length 0)
+static int* listValues(Node* head, int* length) {
+    int count = getListLength(head);
+    int* values = (int*)malloc(sizeof(int) * (size_t)(count > 0 ? count : 1));
+    if (values == NULL) return NULL;
+    int i = 0;
+    for (Node* current = head; current != NULL; current = current->next) {
+        values[i++] = current->data;
+    }
+    *length = count;
+    return values;
+}
+
+// Append values as [a] → [b] → … 990 more → [y] → [z] → NULL, keeping
+// `window` nodes at each end and around `cursor` (-1: none), which is
+// drawn in `cursorColor`. A gap of one node is drawn instead of elided.
+static void frameList(const int* values, int length, int window, int cursor,
+                      const char* cursorColor) {
+    int i = 0;
+    while (i < length) {
+        int shown = window == 0 || i < window || i >= length - window ||
+                    (cursor >= 0 && abs(i - cursor) <= window / 2);
+        int next = i + 1;
+        if (!shown) {
+            next = length - window;
+            int around = cursor - window / 2;
+            if (cursor >= 0 && around > i && around < next) next = around;
+        }
+        if (next - i > 1) {
+            frameAppend("%s… %d more%s %s→%s ", CYAN, next - i, RESET, BLUE, RESET);
+        } else if (i == cursor) {
+            frameAppend("%s%s[%d]%s %s→%s ", BOLD, cursorColor, values[i], RESET, BLUE, RESET);
+        } else {
+            frameAppend("%s[%d]%s %s→%s ", BOLD, values[i], RESET, BLUE, RESET);
+        }
+        i = next;
+    }
+    frameAppend("%sNULL%s", RED, RESET);
+}
+
+// Append `prefix`, the list and `suffix` on one line, narrowing the windows
+// until the line fits the terminal
+static void frameListLine(const char* prefix, const int* values, int length, int cursor,
+                          const char* cursorColor, const char* suffix) {
+    size_t start = frame.length;
+    int width = terminalWidth();
+    for (int window = animationWindow; ; window--) {
+        frame.length = start;
+        frameAppend("%s", prefix);
+        frameList(values, length, window, cursor, cursorColor);
+        frameAppend("%s", suffix);
+        if (window <= 1 || visibleWidth(frame.data + start, frame.length - start) <= width) {
+            break;
+        }
+    }
+}
+
+// Walk a cursor over the first `steps` values, one frame per step, redrawn
+// in place. Long walks skip steps so the frames fit the budget; a frame
+// stays up for naturalMs, or less if the budget is short. The last frame
+// is left open for the caller to draw the outcome over.
+static void frameWalk(const char* prefix, const int* values, int length, int steps,
+                      int naturalMs) {
+    if (steps <= 0) return;
+    int maxFrames = animationBudget / ANIMATION_MIN_FRAME;
+    if (maxFrames < 1) maxFrames = 1;
+    int stride = (steps + maxFrames - 1) / maxFrames;
+    int frames = (steps + stride - 1) / stride;
+    int delay = animationBudget / frames;
+    if (delay > naturalMs) delay = naturalMs;
+
+    for (int i = 0; i < steps; i += stride) {
+        frameBegin();
+        frameListLine(prefix, values, length, i, YELLOW, "");
+        frameShow(delay);
+    }
+}
+
+// A frame of the whole list on one line, closed with a newline
+static void frameListMessage(int delayMs, const char* prefix, const int* values, int length,
+                             int cursor, const char* cursorColor, const char* suffix) {
+    frameBegin();
+    frameListLine(prefix, values, length, cursor, cursorColor, suffix);
+    frameAppend("\n");
+    frameShow(delayMs);
+}
+
+static int framedDisplay(Node* head, const char* label) {
+    if (head == NULL) {
+        frameMessage(0, "%s%s%s: %s[Empty]%s", BOLD, CYAN, label, RED, RESET);
+        return 1;
+    }
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    // Sized from the label so a long one keeps its RESET
+    size_t size = strlen(label) + sizeof(BOLD CYAN ": " RESET);
+    char* prefix = (char*)malloc(size);
+    if (prefix == NULL) {
+        free(values);
+        return 0;
+    }
+    snprintf(prefix, size, "%s%s%s: %s", BOLD, CYAN, label, RESET);
+    frameListMessage(ANIMATION_DELAY / 2, prefix, values, length, -1, "", "");
+    free(prefix);
+    free(values);
+    return 1;
+}
+
+static int framedInsert(Node* head, int value, const char* position) {
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    frameMessage(ANIMATION_DELAY, "\n%s=== INSERTING %d at %s ===%s", YELLOW, value, position, RESET);
+    frameMessage(ANIMATION_DELAY, "%sSearching for insertion point...%s", CYAN, RESET);
+    if (strcmp(position, "end") == 0 && length > 0) {
+        frameWalk("", values, length, length, ANIMATION_DELAY / 3);
+        frameListMessage(ANIMATION_DELAY / 2, "", values, length, length - 1, GREEN, "");
+    }
+    frameMessage(ANIMATION_DELAY, "%sCreating node with value: %s[%d]%s", CYAN, BOLD, value, RESET);
+    frameMessage(ANIMATION_DELAY, "%sLinking node to list...%s", CYAN, RESET);
+    frameMessage(ANIMATION_DELAY / 2, "%s✓ Node %s[%d]%s inserted successfully!%s",
+                 GREEN, BOLD, value, GREEN, RESET);
+    free(values);
+    return 1;
+}
+
+// Index of the first node holding value, or length if there is none
+static int findValue(const int* values, int length, int value) {
+    int i = 0;
+    while (i < length && values[i] != value) i++;
+    return i;
+}
+
+static int framedDelete(Node* head, int value) {
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    frameMessage(ANIMATION_DELAY, "\n%s=== DELETING %d ===%s", YELLOW, value, RESET);
+    frameMessage(ANIMATION_DELAY, "%sSearching for node with value: %s[%d]%s",
+                 CYAN, BOLD, value, RESET);
+    int found = findValue(values, length, value);
+    frameWalk("", values, length, found < length ? found + 1 : length, ANIMATION_DELAY / 3);
+    if (found < length) {
+        frameListMessage(ANIMATION_DELAY / 2, "", values, length, found, RED, "");
+        frameMessage(ANIMATION_DELAY, "%sFound at position %d!%s", GREEN, found, RESET);
+    } else if (length > 0) {
+        frameListMessage(ANIMATION_DELAY / 2, "", values, length, -1, "", "");
+    }
+    frameMessage(ANIMATION_DELAY, "%sUpdating links...%s", CYAN, RESET);
+    frameMessage(ANIMATION_DELAY, "%sFreeing memory...%s", CYAN, RESET);
+    frameMessage(ANIMATION_DELAY / 2, "%s✓ Node deleted successfully!%s", GREEN, RESET);
+    free(values);
+    return 1;
+}
+
+static int framedSearch(Node* head, int target) {
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    frameMessage(ANIMATION_DELAY, "\n%s=== SEARCHING FOR %d ===%s", YELLOW, target, RESET);
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%sTraversing list: %s", CYAN, RESET);
+    int found = findValue(values, length, target);
+    frameWalk(prefix, values, length, found < length ? found + 1 : length, ANIMATION_DELAY / 3);
+    if (found < length) {
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), " %sFound!%s", GREEN, RESET);
+        frameListMessage(ANIMATION_DELAY, prefix, values, length, found, GREEN, suffix);
+        frameMessage(0, "%s✓ Element found at position %d (0-indexed)%s", GREEN, found, RESET);
+    } else {
+        frameListMessage(0, prefix, values, length, -1, "", "");
+        frameMessage(ANIMATION_DELAY / 2, "%s✗ Element not found!%s", RED, RESET);
+    }
+    free(values);
+    return 1;
+}
+
+// Dots or arrows drawn one by one on a line, in place
+static void frameProgress(const char* label, const char* mark) {
+    char marks[64] = "";
+    for (int i = 0; i < 5; i++) {
+        strcat(marks, mark);
+        frameBegin();
+        frameAppend("%s%s%s%s%s", CYAN, label, YELLOW, marks, RESET);
+        frameShow(ANIMATION_DELAY / 3);
+    }
+    frameBegin();
+    frameAppend("%s%s%s%s%s\n", CYAN, label, YELLOW, marks, RESET);
+    frameShow(ANIMATION_DELAY / 2);
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int framedSort(Node* head, const char* algorithm) {
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    frameMessage(ANIMATION_DELAY, "\n%s=== SORTING USING %s ===%s", YELLOW, algorithm, RESET);
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%sInitial list: %s", CYAN, RESET);
+    frameListMessage(ANIMATION_DELAY, prefix, values, length, -1, "", "");
+    frameProgress("Comparing and reordering elements", ".");
+    
+    qsort(values, (size_t)length, sizeof(int), compareInts);
+    snprintf(prefix, sizeof(prefix), "%sSorted list: %s", GREEN, RESET);
+    frameListMessage(ANIMATION_DELAY / 2, prefix, values, length, -1, "", "");
+    frameMessage(ANIMATION_DELAY / 2, "%s✓ Sorting complete!%s", GREEN, RESET);
+    free(values);
+    return 1;
+}
+
+static int framedReverse(Node* head) {
+    int length;
+    int* values = listValues(head, &length);
+    if (values == NULL) return 0;
+    
+    frameMessage(ANIMATION_DELAY, "\n%s=== REVERSING LIST ===%s", YELLOW, RESET);
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%sOriginal list: %s", CYAN, RESET);
+    frameListMessage(ANIMATION_DELAY, prefix, values, length, -1, "", "");
+    frameProgress("Reversing pointers...", "↻");
+    
+    for (int i = 0, j = length - 1; i < j; i++, j--) {
+        int swap = values[i];
+        values[i] = values[j];
+        values[j] = swap;
+    }
+    snprintf(prefix, sizeof(prefix), "%sReversed list: %s", GREEN, RESET);
+    frameListMessage(ANIMATION_DELAY / 2, prefix, values, length, -1, "", "");
+    frameMessage(ANIMATION_DELAY / 2, "%s✓ Reverse complete!%s", GREEN, RESET);
+    free(values);
+    return 1;
+}
+
+// ============================================================================
+// RECORDING AND REPLAY
+// ============================================================================
+
+// A recording is a run of frames, each "\f<delay ms>\n" then its bytes
+int startAnimationRecording(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return -1;
+    stopAnimationRecording();
+    animationRecord = file;
+    animationMode = ANIMATE_FRAMES;
+    frame.openRows = 0;
+    return 0;
+}
+
+void stopAnimationRecording(void) {
+    if (animationRecord == NULL) return;
+    fclose(animationRecord);
+    animationRecord = NULL;
+    frame.openRows = 0;
+}
+
+int replayAnimation(const char* path, double speed) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return -1;
+    if (speed <= 0) speed = 1.0;
+    
+    int frames = 0;
+    int c = fgetc(file);
+    while (c == '\f') {
+        int delay = 0;
+        if (fscanf(file, "%d", &delay) != 1 || fgetc(file) != '\n') break;
+        frame.length = 0;
+        while ((c = fgetc(file)) != EOF && c != '\f') {
+            frameAppendByte((char)c);
+        }
+        fflush(stdout);
+        writeAll(STDOUT_FILENO, frame.data, frame.length);
+        usleep((useconds_t)(delay * 1000 / speed));
+        frames++;
+    }
+    int ok = c == EOF && !ferror(file);
+    fclose(file);
+    return ok ? frames : -1;
+}
@@ -6,6 +6,22 @@
 // Animation speed control (milliseconds delay)
 #define ANIMATION_DELAY 500
 
+// Frame mode: each step of an animation is built in one buffer and written
+// with a single write, redrawn in place. Lists longer than two windows plus
+// one are elided to head and tail windows (and, while walking, a window
+// around the current node) with a count of what is left out. The frames
+// of a walk over the list share a time budget instead of a fixed delay
+// per node, so a walk over 10k nodes takes no longer than the budget,
+// showing fewer steps.
+#define ANIMATION_WINDOW 4          // Nodes kept at each end when eliding
+#define ANIMATION_BUDGET 3000       // Milliseconds per animation
+#define ANIMATION_MIN_FRAME 30      // Shortest time a frame stays up
+
+typedef enum {
+    ANIMATE_STEPWISE,               // One printf and delay per node (default)
+    ANIMATE_FRAMES
+} AnimationMode;
+
 // Color codes for terminal
 #define RESET   "\x1b[0m"
 #define RED     "\x1b[31m"
@@ -24,4 +40,21 @@ void animateSort(Node* head, const char* algorithm);
 void animateReverse(Node* head);
 void sleep_ms(int milliseconds);
 
+// Rendering settings. A window of 0 never elides; a budget of 0 uses
+// ANIMATION_BUDGET.
+void setAnimationMode(AnimationMode mode);
+void setAnimationWindow(int nodes);
+void setAnimationBudget(int milliseconds);
+
+// Headless recording: switches to frame mode and writes every frame, with
+// the delay it would have been shown for, to `path` instead of the
+// terminal. Nothing sleeps while recording, sleep_ms included. Returns 0
+// on success, -1 if the file cannot be created.
+int startAnimationRecording(const char* path);
+void stopAnimationRecording(void);
+
+// Play a recording back to the terminal at its recorded pace (speed 2.0
+// is twice as fast). Returns the number of frames, or -1 on error.
+int replayAnimation(const char* path, double speed);
+
 #endif
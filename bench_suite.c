@@ -0,0 +1,700 @@
+/*
+ * Benchmark suite for simple_db and the list libraries
+ *
+ * Times db_set, db_get and db_delete with uniform and Zipfian (theta 0.99)
+ * keys over databases of 1k, 10k ... up to max_keys entries, and insert,
+ * search, sort and reverse on the singly, doubly and circular lists. Every
+ * operation is timed on its own; each result reports ns/op, p50/p90/p99/
+ * p99.9, RSS after the run and, where the kernel allows perf_event_open,
+ * cycles, instructions, cache misses and branch misses per op.
+ *
+ * Results are written as JSON (-o), one result object per line. With -c a
+ * previous results file is read back as the baseline and every benchmark
+ * whose median got more than threshold percent (and REGRESSION_MIN_NS)
+ * slower is flagged; the exit status is 2 if any was. Medians rather than
+ * means, so one preempted sample does not fail the comparison.
+ *
+ * Usage:
+ *   bench_suite [-m max_keys] [-n ops] [-l max_list] [-f filter]
+ *               [-o results.json] [-c baseline.json] [-r threshold_pct]
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 bench_suite.c simple_db.c linked_list.c \
+ *     doubly_linked_list.c circular_linked_list.c node_pool.c list_sort.c \
+ *     -o bench_suite -lm
+ */
+
+#define _GNU_SOURCE  // syscall
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "simple_db.h"
+#include "linked_list.h"
+#include "doubly_linked_list.h"
+#include "circular_linked_list.h"
+
+#define KEY_STRIDE 16               // "k" + 10 digits + NUL, padded
+#define MAX_RESULTS 256
+#define PERF_EVENTS 4
+#define REGRESSION_MIN_NS 10.0      // Smaller slowdowns are timer noise
+
+typedef struct {
+    size_t max_keys;
+    size_t ops;                     // Timed operations per DB benchmark
+    int max_list;
+    const char *filter;             // Only run benchmarks whose name contains it
+    const char *out_path;
+    const char *baseline_path;
+    double threshold_pct;
+} BenchConfig;
+
+typedef struct {
+    char name[64];
+    size_t ops;
+    double ns_per_op;
+    double p50, p90, p99, p999;
+    long rss_kb;
+    long peak_rss_kb;
+    bool has_perf;
+    double perf[PERF_EVENTS];       // Per op, in perf_names order
+} BenchResult;
+
+static const char *perf_names[PERF_EVENTS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+static BenchResult results[MAX_RESULTS];
+static size_t result_count;
+static double timer_ns;             // Cost of one back-to-back pair of clock reads
+
+// ============================================================================
+// Timing, memory and hardware counters
+// ============================================================================
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of many empty start/stop pairs, subtracted from every sample
+static double calibrate_timer(void) {
+    enum { N = 10001 };
+    static uint32_t samples[N];
+    for (int i = 0; i < N; i++) {
+        uint64_t start = now_ns();
+        samples[i] = (uint32_t)(now_ns() - start);
+    }
+    qsort(samples, N, sizeof(uint32_t), compare_u32);
+    return samples[N / 2];
+}
+
+// Resident set size in KB now (Linux), or the peak where /proc is missing
+static long current_rss_kb(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        long pages = 0, resident = 0;
+        int ok = fscanf(f, "%ld %ld", &pages, &resident) == 2;
+        fclose(f);
+        if (ok) return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+typedef struct {
+    int fds[PERF_EVENTS];           // -1: counter unavailable
+} PerfGroup;
+
+static void perf_open(PerfGroup *group) {
+    for (int i = 0; i < PERF_EVENTS; i++) group->fds[i] = -1;
+#ifdef __linux__
+    static const uint64_t configs[PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i = 0; i < PERF_EVENTS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        group->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+static void perf_start(PerfGroup *group) {
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENTS; i++) {
+        if (group->fds[i] < 0) continue;
+        ioctl(group->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(group->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)group;
+#endif
+}
+
+// Stop the counters; returns false unless every one of them could be read
+static bool perf_stop(PerfGroup *group, uint64_t counts[PERF_EVENTS]) {
+    bool ok = true;
+    for (int i = 0; i < PERF_EVENTS; i++) {
+        counts[i] = 0;
+        if (group->fds[i] < 0) { ok = false; continue; }
+#ifdef __linux__
+        ioctl(group->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        ok &= read(group->fds[i], &counts[i], sizeof(uint64_t)) == sizeof(uint64_t);
+#endif
+    }
+    return ok;
+}
+
+static void perf_close(PerfGroup *group) {
+    for (int i = 0; i < PERF_EVENTS; i++) {
+        if (group->fds[i] >= 0) close(group->fds[i]);
+    }
+}
+
+// ============================================================================
+// Results
+// ============================================================================
+
+// Nearest-rank percentile of sorted samples
+static double percentile(uint32_t *sorted, size_t n, double p) {
+    size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+    return sorted[i];
+}
+
+static bool wanted(const BenchConfig *config, const char *name) {
+    return config->filter == NULL || strstr(name, config->filter) != NULL;
+}
+
+// Turn per-op samples (ns, timer cost included) into a result line
+static void record(const char *name, uint32_t *samples, size_t n, const uint64_t *perf,
+                   bool has_perf) {
+    if (n == 0 || result_count == MAX_RESULTS) return;
+    BenchResult *r = &results[result_count++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+
+    uint32_t overhead = (uint32_t)timer_ns;
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        samples[i] = samples[i] > overhead ? samples[i] - overhead : 0;
+        total += samples[i];
+    }
+    qsort(samples, n, sizeof(uint32_t), compare_u32);
+
+    r->ops = n;
+    r->ns_per_op = total / (double)n;
+    r->p50 = percentile(samples, n, 0.50);
+    r->p90 = percentile(samples, n, 0.90);
+    r->p99 = percentile(samples, n, 0.99);
+    r->p999 = percentile(samples, n, 0.999);
+    r->rss_kb = current_rss_kb();
+    r->peak_rss_kb = peak_rss_kb();
+    r->has_perf = has_perf;
+    for (int i = 0; i < PERF_EVENTS && has_perf; i++) {
+        r->perf[i] = (double)perf[i] / (double)n;
+    }
+
+    printf("%-34s %10zu %12.1f %10.0f %10.0f %10.0f %10ld\n", r->name, r->ops, r->ns_per_op,
+           r->p50, r->p99, r->p999, r->rss_kb);
+    fflush(stdout);
+}
+
+static bool write_json(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "{\n  \"suite\": \"bench_suite\",\n  \"timer_ns\": %.1f,\n  \"results\": [\n",
+            timer_ns);
+    for (size_t i = 0; i < result_count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.2f, "
+                   "\"p50_ns\": %.0f, \"p90_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f, "
+                   "\"rss_kb\": %ld, \"peak_rss_kb\": %ld",
+                r->name, r->ops, r->ns_per_op, r->p50, r->p90, r->p99, r->p999,
+                r->rss_kb, r->peak_rss_kb);
+        for (int k = 0; k < PERF_EVENTS; k++) {
+            if (r->has_perf) {
+                fprintf(f, ", \"%s_per_op\": %.2f", perf_names[k], r->perf[k]);
+            } else {
+                fprintf(f, ", \"%s_per_op\": null", perf_names[k]);
+            }
+        }
+        fprintf(f, "}%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+// Compare against a file written by write_json (one result per line).
+// Returns the number of regressions, or -1 if the file cannot be read.
+static int compare_baseline(const char *path, double threshold_pct) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    printf("\nBaseline %s (regression: median > %.0f%% slower)\n", path, threshold_pct);
+    printf("%-34s %12s %12s %9s\n", "benchmark", "base p50", "p50", "change");
+
+    char line[1024];
+    int regressions = 0;
+    size_t matched = 0;
+    while (fgets(line, sizeof(line), f)) {
+        char *name = strstr(line, "\"name\": \"");
+        char *median = strstr(line, "\"p50_ns\": ");
+        if (!name || !median) continue;
+        name += strlen("\"name\": \"");
+        char *end = strchr(name, '"');
+        if (!end) continue;
+        *end = '\0';
+        double base = atof(median + strlen("\"p50_ns\": "));
+
+        for (size_t i = 0; i < result_count; i++) {
+            if (strcmp(results[i].name, name) != 0) continue;
+            matched++;
+            double now = results[i].p50;
+            double change = base > 0 ? (now - base) / base * 100.0 : 0;
+            bool slower = change > threshold_pct && now - base > REGRESSION_MIN_NS;
+            regressions += slower;
+            printf("%-34s %12.0f %12.0f %+8.1f%%%s\n", name, base, now, change,
+                   slower ? "  ✗ REGRESSION" : "");
+            break;
+        }
+    }
+    fclose(f);
+    printf("%zu of %zu benchmarks matched the baseline, %d regression(s)\n", matched,
+           result_count, regressions);
+    return regressions;
+}
+
+// ============================================================================
+// Key distributions
+// ============================================================================
+
+// xorshift64: cheap random numbers, no shared state
+static inline uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static inline double next_unit(uint64_t *state) {
+    return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Zipfian ranks in [0, n) (Gray et al., as used by YCSB): rank 0 is the
+// hottest. Setup is O(n) for the zeta sum; each draw is O(1).
+typedef struct {
+    size_t n;
+    double theta, alpha, zetan, eta;
+} Zipf;
+
+static void zipf_init(Zipf *z, size_t n, double theta) {
+    double zeta2 = 1.0 + pow(0.5, theta);
+    z->n = n;
+    z->theta = theta;
+    z->zetan = 0;
+    for (size_t i = 1; i <= n; i++) z->zetan += 1.0 / pow((double)i, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+static size_t zipf_next(const Zipf *z, uint64_t *state) {
+    double u = next_unit(state);
+    double uz = u * z->zetan;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + pow(0.5, z->theta)) return 1;
+    size_t rank = (size_t)((double)z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+    return rank < z->n ? rank : z->n - 1;
+}
+
+// Spread ranks over the key space so hot keys are not neighbours
+static inline size_t scramble(size_t rank, size_t n) {
+    return (size_t)((rank * 0x9E3779B97F4A7C15ull) % n);
+}
+
+// ============================================================================
+// simple_db benchmarks
+// ============================================================================
+
+static void make_keys(char *keys, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        snprintf(keys + i * KEY_STRIDE, KEY_STRIDE, "k%010u", (unsigned)i);
+    }
+}
+
+// Key indexes for one run, drawn up front so draws are not timed
+static void draw_indexes(size_t *out, size_t ops, size_t keys, const Zipf *zipf,
+                         uint64_t seed) {
+    uint64_t state = seed;
+    for (size_t i = 0; i < ops; i++) {
+        out[i] = zipf ? scramble(zipf_next(zipf, &state), keys)
+                      : (size_t)(next_random(&state) % keys);
+    }
+}
+
+static void bench_db_size(const BenchConfig *config, size_t keys, const char *keybuf,
+                          size_t *indexes, uint32_t *samples, PerfGroup *perf) {
+    char name[64];
+    uint64_t counts[PERF_EVENTS];
+    const char *value = "value_0123456789";
+
+    Database *db = db_create();
+    if (!db) return;
+
+    // Fresh inserts of every key, in order
+    uint32_t *load = (uint32_t*)malloc(keys * sizeof(uint32_t));
+    if (!load) {
+        db_destroy(db);
+        return;
+    }
+    perf_start(perf);
+    for (size_t i = 0; i < keys; i++) {
+        uint64_t start = now_ns();
+        db_set(db, keybuf + i * KEY_STRIDE, value);
+        load[i] = (uint32_t)(now_ns() - start);
+    }
+    bool has_perf = perf_stop(perf, counts);
+    snprintf(name, sizeof(name), "db_insert/%zu", keys);
+    if (wanted(config, name)) record(name, load, keys, counts, has_perf);
+    free(load);
+
+    Zipf zipf;
+    zipf_init(&zipf, keys, 0.99);
+
+    for (int dist = 0; dist < 2; dist++) {
+        const char *dist_name = dist == 0 ? "uniform" : "zipf";
+        draw_indexes(indexes, config->ops, keys, dist == 0 ? NULL : &zipf, 42 + keys);
+
+        // Overwrites of existing keys
+        snprintf(name, sizeof(name), "db_set/%s/%zu", dist_name, keys);
+        if (wanted(config, name)) {
+            perf_start(perf);
+            for (size_t i = 0; i < config->ops; i++) {
+                const char *key = keybuf + indexes[i] * KEY_STRIDE;
+                uint64_t start = now_ns();
+                db_set(db, key, value);
+                samples[i] = (uint32_t)(now_ns() - start);
+            }
+            has_perf = perf_stop(perf, counts);
+            record(name, samples, config->ops, counts, has_perf);
+        }
+
+        snprintf(name, sizeof(name), "db_get/%s/%zu", dist_name, keys);
+        if (wanted(config, name)) {
+            size_t found = 0;
+            perf_start(perf);
+            for (size_t i = 0; i < config->ops; i++) {
+                const char *key = keybuf + indexes[i] * KEY_STRIDE;
+                uint64_t start = now_ns();
+                found += db_get(db, key) != NULL;
+                samples[i] = (uint32_t)(now_ns() - start);
+            }
+            has_perf = perf_stop(perf, counts);
+            if (found != config->ops) fprintf(stderr, "✗ %s: %zu misses\n", name, config->ops - found);
+            record(name, samples, config->ops, counts, has_perf);
+        }
+
+        // Each deleted key is put back untimed, so every delete is a hit
+        snprintf(name, sizeof(name), "db_delete/%s/%zu", dist_name, keys);
+        if (wanted(config, name)) {
+            uint64_t total[PERF_EVENTS] = {0};
+            has_perf = true;
+            for (size_t i = 0; i < config->ops; i++) {
+                const char *key = keybuf + indexes[i] * KEY_STRIDE;
+                perf_start(perf);
+                uint64_t start = now_ns();
+                db_delete(db, key);
+                samples[i] = (uint32_t)(now_ns() - start);
+                has_perf &= perf_stop(perf, counts);
+                for (int k = 0; k < PERF_EVENTS; k++) total[k] += counts[k];
+                db_set(db, key, value);
+            }
+            record(name, samples, config->ops, total, has_perf);
+        }
+    }
+    db_destroy(db);
+}
+
+static void bench_db(const BenchConfig *config) {
+    char *keybuf = (char*)malloc(config->max_keys * KEY_STRIDE);
+    size_t *indexes = (size_t*)malloc(config->ops * sizeof(size_t));
+    uint32_t *samples = (uint32_t*)malloc(config->ops * sizeof(uint32_t));
+    if (!keybuf || !indexes || !samples) {
+        fprintf(stderr, "✗ Memory allocation failed!\n");
+        free(keybuf);
+        free(indexes);
+        free(samples);
+        return;
+    }
+    make_keys(keybuf, config->max_keys);
+
+    PerfGroup perf;
+    perf_open(&perf);
+    for (size_t keys = 1000; keys <= config->max_keys; keys *= 10) {
+        bench_db_size(config, keys, keybuf, indexes, samples, &perf);
+    }
+    perf_close(&perf);
+
+    free(keybuf);
+    free(indexes);
+    free(samples);
+}
+
+// ============================================================================
+// List benchmarks
+// ============================================================================
+
+// The three list types behind one set of calls
+typedef struct {
+    const char *name;
+    int (*init)(void *list);
+    void (*destroy)(void *list);
+    int (*append)(void *list, int data);
+    int (*search)(void *list, int target);
+    void (*sort)(void *list);
+    void (*reverse)(void *list);
+} ListOps;
+
+static int single_init(void *l) { return initList((List*)l, NULL); }
+static void single_destroy(void *l) { destroyList((List*)l); }
+static int single_append(void *l, int v) { return listAppend((List*)l, v); }
+static int single_search(void *l, int v) { return search(((List*)l)->head, v); }
+static void single_sort(void *l) { listSort((List*)l); }
+static void single_reverse(void *l) { listReverse((List*)l); }
+
+static int doubly_init(void *l) { return initDList((DList*)l, NULL); }
+static void doubly_destroy(void *l) { destroyDList((DList*)l); }
+static int doubly_append(void *l, int v) { return dListAppend((DList*)l, v); }
+static int doubly_search(void *l, int v) { return searchD(((DList*)l)->head, v); }
+static void doubly_sort(void *l) { dListSort((DList*)l); }
+static void doubly_reverse(void *l) { dListReverse((DList*)l); }
+
+static int circular_init(void *l) { return initCList((CList*)l, NULL); }
+static void circular_destroy(void *l) { destroyCList((CList*)l); }
+static int circular_append(void *l, int v) { return cListAppend((CList*)l, v); }
+static int circular_search(void *l, int v) { return searchC(((CList*)l)->head, v); }
+static void circular_sort(void *l) { cListSort((CList*)l); }
+static void circular_reverse(void *l) { cListReverse((CList*)l); }
+
+static const ListOps list_types[] = {
+    { "singly", single_init, single_destroy, single_append, single_search, single_sort,
+      single_reverse },
+    { "doubly", doubly_init, doubly_destroy, doubly_append, doubly_search, doubly_sort,
+      doubly_reverse },
+    { "circular", circular_init, circular_destroy, circular_append, circular_search,
+      circular_sort, circular_reverse },
+};
+
+#define LIST_SEARCHES 200
+#define LIST_REPEATS 20
+
+static void bench_list_size(const BenchConfig *config, const ListOps *ops, int size,
+                            int *values, uint32_t *samples, PerfGroup *perf) {
+    union { List s; DList d; CList c; } list;
+    char name[64];
+    uint64_t counts[PERF_EVENTS];
+    bool has_perf;
+
+    if (!ops->init(&list)) return;
+
+    // Appends of shuffled values (O(1) each through the handle)
+    perf_start(perf);
+    for (int i = 0; i < size; i++) {
+        uint64_t start = now_ns();
+        ops->append(&list, values[i]);
+        samples[i] = (uint32_t)(now_ns() - start);
+    }
+    has_perf = perf_stop(perf, counts);
+    snprintf(name, sizeof(name), "list_insert/%s/%d", ops->name, size);
+    if (wanted(config, name)) record(name, samples, (size_t)size, counts, has_perf);
+
+    snprintf(name, sizeof(name), "list_search/%s/%d", ops->name, size);
+    if (wanted(config, name)) {
+        uint64_t state = 7 + (uint64_t)size;
+        int missing = 0;
+        perf_start(perf);
+        for (int i = 0; i < LIST_SEARCHES; i++) {
+            int target = values[next_random(&state) % (uint64_t)size];
+            uint64_t start = now_ns();
+            missing += ops->search(&list, target) < 0;
+            samples[i] = (uint32_t)(now_ns() - start);
+        }
+        has_perf = perf_stop(perf, counts);
+        if (missing) fprintf(stderr, "✗ %s: %d values not found\n", name, missing);
+        record(name, samples, LIST_SEARCHES, counts, has_perf);
+    }
+
+    // Whole-list operations: one op is one call; sort rebuilds from the
+    // shuffled values each time so it never sees sorted input
+    snprintf(name, sizeof(name), "list_sort/%s/%d", ops->name, size);
+    if (wanted(config, name)) {
+        uint64_t total[PERF_EVENTS] = {0};
+        has_perf = true;
+        for (int r = 0; r < LIST_REPEATS; r++) {
+            ops->destroy(&list);
+            if (!ops->init(&list)) return;
+            for (int i = 0; i < size; i++) ops->append(&list, values[i]);
+            perf_start(perf);
+            uint64_t start = now_ns();
+            ops->sort(&list);
+            samples[r] = (uint32_t)(now_ns() - start);
+            has_perf &= perf_stop(perf, counts);
+            for (int k = 0; k < PERF_EVENTS; k++) total[k] += counts[k];
+        }
+        record(name, samples, LIST_REPEATS, total, has_perf);
+    }
+
+    snprintf(name, sizeof(name), "list_reverse/%s/%d", ops->name, size);
+    if (wanted(config, name)) {
+        perf_start(perf);
+        for (int r = 0; r < LIST_REPEATS; r++) {
+            uint64_t start = now_ns();
+            ops->reverse(&list);
+            samples[r] = (uint32_t)(now_ns() - start);
+        }
+        has_perf = perf_stop(perf, counts);
+        record(name, samples, LIST_REPEATS, counts, has_perf);
+    }
+    ops->destroy(&list);
+}
+
+static void bench_lists(const BenchConfig *config) {
+    int *values = (int*)malloc((size_t)config->max_list * sizeof(int));
+    uint32_t *samples = (uint32_t*)malloc((size_t)config->max_list * sizeof(uint32_t));
+    if (!values || !samples) {
+        fprintf(stderr, "✗ Memory allocation failed!\n");
+        free(values);
+        free(samples);
+        return;
+    }
+
+    PerfGroup perf;
+    perf_open(&perf);
+    for (int size = 1000; size <= config->max_list; size *= 10) {
+        // Distinct values in shuffled order
+        uint64_t state = 99 + (uint64_t)size;
+        for (int i = 0; i < size; i++) values[i] = i;
+        for (int i = size - 1; i > 0; i--) {
+            int j = (int)(next_random(&state) % (uint64_t)(i + 1));
+            int t = values[i];
+            values[i] = values[j];
+            values[j] = t;
+        }
+        for (size_t t = 0; t < sizeof(list_types) / sizeof(list_types[0]); t++) {
+            bench_list_size(config, &list_types[t], size, values, samples, &perf);
+        }
+    }
+    perf_close(&perf);
+
+    free(values);
+    free(samples);
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-m max_keys] [-n ops] [-l max_list] [-f filter] "
+                    "[-o results.json] [-c baseline.json] [-r threshold_pct]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config = { 10000000, 200000, 100000, NULL, NULL, NULL, 20.0 };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:n:l:f:o:c:r:h")) != -1) {
+        switch (opt) {
+            case 'm': config.max_keys = (size_t)atol(optarg); break;
+            case 'n': config.ops = (size_t)atol(optarg); break;
+            case 'l': config.max_list = atoi(optarg); break;
+            case 'f': config.filter = optarg; break;
+            case 'o': config.out_path = optarg; break;
+            case 'c': config.baseline_path = optarg; break;
+            case 'r': config.threshold_pct = atof(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.max_keys < 1000 || config.ops < 1 || config.max_list < 1000 ||
+        config.threshold_pct < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    timer_ns = calibrate_timer();
+    PerfGroup probe;
+    perf_open(&probe);
+    uint64_t counts[PERF_EVENTS];
+    perf_start(&probe);
+    bool perf_ok = perf_stop(&probe, counts);
+    perf_close(&probe);
+
+    printf("bench_suite: keys 1000..%zu, %zu ops per DB benchmark, lists 1000..%d\n",
+           config.max_keys, config.ops, config.max_list);
+    printf("timer overhead %.0f ns (subtracted), perf counters %s\n\n", timer_ns,
+           perf_ok ? "on" : "unavailable");
+    printf("%-34s %10s %12s %10s %10s %10s %10s\n", "benchmark", "ops", "ns/op", "p50",
+           "p99", "p99.9", "rss KB");
+
+    bench_db(&config);
+    bench_lists(&config);
+
+    if (config.out_path) {
+        if (!write_json(config.out_path)) {
+            fprintf(stderr, "✗ Cannot write %s\n", config.out_path);
+            return 1;
+        }
+        printf("\n✓ Results written to %s\n", config.out_path);
+    }
+    if (config.baseline_path) {
+        int regressions = compare_baseline(config.baseline_path, config.threshold_pct);
+        if (regressions < 0) {
+            fprintf(stderr, "✗ Cannot read baseline %s\n", config.baseline_path);
+            return 1;
+        }
+        if (regressions > 0) return 2;
+    }
+    return 0;
+}
@@ -1,59 +1,87 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "circular_linked_list.h"
+#include "list_sort.h"
 
-// Create a new circular linked list node
-CNode* createCNode(int data) {
-    CNode* newNode = (CNode*)malloc(sizeof(CNode));
+// Sorted runs kept by the bottom-up merge sort: bin i holds 2^i nodes
+#define SORT_BINS 64
+
+// Create a pool sized for circular linked list nodes
+NodePool* createCListPool(int nodesPerBlock) {
+    return createNodePool(sizeof(CNode), nodesPerBlock > 0 ? (size_t)nodesPerBlock : 0);
+}
+
+// Create a new node from a pool (or malloc without one); NULL on failure
+CNode* createCNodeIn(NodePool* pool, int data) {
+    CNode* newNode = pool != NULL ? (CNode*)poolAllocNode(pool) : (CNode*)malloc(sizeof(CNode));
     if (newNode == NULL) {
         printf("Memory allocation failed!\n");
-        exit(1);
+        return NULL;
     }
     newNode->data = data;
     newNode->next = newNode; // Points to itself initially
     return newNode;
 }
 
-// Insert at the end of the circular list
-CNode* insertCEnd(CNode* head, int data) {
-    CNode* newNode = createCNode(data);
-    
-    if (head == NULL) {
-        return newNode;
+// Give a node back to wherever it came from
+static void releaseCNode(NodePool* pool, CNode* node) {
+    if (pool != NULL) {
+        poolFreeNode(pool, node);
+    } else {
+        free(node);
     }
-    
-    // Find the tail (node that points back to head)
-    CNode* temp = head;
-    while (temp->next != head) {
-        temp = temp->next;
+}
+
+// View a bare ring as a list handle, so the head-pointer functions run
+// the handle code. Every edit of a ring needs the tail, so this walks it
+// once, as those functions always did.
+static CList wrapCChain(NodePool* pool, CNode* head) {
+    CList list = { head, NULL, 0, pool, 0 };
+    CNode* node = head;
+    while (node != NULL) {
+        list.tail = node;
+        list.length++;
+        node = node->next != head ? node->next : NULL;
     }
-    
-    temp->next = newNode;
-    newNode->next = head;
-    return head;
+    return list;
+}
+
+// Create a new circular linked list node
+CNode* createCNode(int data) {
+    return createCNodeIn(NULL, data);
+}
+
+// Insert at the end of the circular list
+CNode* insertCEnd(CNode* head, int data) {
+    return insertCEndIn(NULL, head, data);
+}
+
+// Insert at the end of the circular list, allocating from a pool
+CNode* insertCEndIn(NodePool* pool, CNode* head, int data) {
+    CList list = wrapCChain(pool, head);
+    cListAppend(&list, data);
+    return list.head;
 }
 
 // Insert at the beginning of the circular list
 CNode* insertCBegin(CNode* head, int data) {
-    CNode* newNode = createCNode(data);
-    
-    if (head == NULL) {
-        return newNode;
-    }
-    
-    // Find the tail
-    CNode* temp = head;
-    while (temp->next != head) {
-        temp = temp->next;
-    }
-    
-    newNode->next = head;
-    temp->next = newNode;
-    return newNode;
+    return insertCBeginIn(NULL, head, data);
+}
+
+// Insert at the beginning of the circular list, allocating from a pool
+CNode* insertCBeginIn(NodePool* pool, CNode* head, int data) {
+    CList list = wrapCChain(pool, head);
+    cListPrepend(&list, data);
+    return list.head;
 }
 
 // Insert after a specific value
 CNode* insertCAfter(CNode* head, int afterValue, int data) {
+    return insertCAfterIn(NULL, head, afterValue, data);
+}
+
+// Insert after a specific value, allocating from a pool
+CNode* insertCAfterIn(NodePool* pool, CNode* head, int afterValue, int data) {
     if (head == NULL) {
         printf("List is empty. Cannot insert after %d.\n", afterValue);
         return head;
@@ -62,7 +90,8 @@ CNode* insertCAfter(CNode* head, int afterValue, int data) {
     CNode* temp = head;
     do {
         if (temp->data == afterValue) {
-            CNode* newNode = createCNode(data);
+            CNode* newNode = createCNodeIn(pool, data);
+            if (newNode == NULL) return head;
             newNode->next = temp->next;
             temp->next = newNode;
             return head;
@@ -76,50 +105,21 @@ CNode* insertCAfter(CNode* head, int afterValue, int data) {
 
 // Delete a node with specific data
 CNode* deleteCNode(CNode* head, int data) {
+    return deleteCNodeIn(NULL, head, data);
+}
+
+// Delete a node with specific data, returning it to its pool
+CNode* deleteCNodeIn(NodePool* pool, CNode* head, int data) {
     if (head == NULL) {
         printf("List is empty.\n");
         return NULL;
     }
     
-    CNode* temp = head;
-    CNode* prev = NULL;
-    
-    // If head node contains the data
-    if (head->data == data) {
-        // If only one node
-        if (head->next == head) {
-            free(head);
-            return NULL;
-        }
-        
-        // Find the tail
-        while (temp->next != head) {
-            temp = temp->next;
-        }
-        
-        temp->next = head->next;
-        CNode* toDelete = head;
-        head = head->next;
-        free(toDelete);
-        return head;
+    CList list = wrapCChain(pool, head);
+    if (!cListDelete(&list, data)) {
+        printf("Element %d not found.\n", data);
     }
-    
-    // Search for the node to delete
-    prev = head;
-    temp = head->next;
-    
-    do {
-        if (temp->data == data) {
-            prev->next = temp->next;
-            free(temp);
-            return head;
-        }
-        prev = temp;
-        temp = temp->next;
-    } while (temp != head);
-    
-    printf("Element %d not found.\n", data);
-    return head;
+    return list.head;
 }
 
 // Display circular list
@@ -147,6 +147,11 @@ void displayCircular(CNode* head, const char* label) {
 
 // Free the entire circular list
 void freeCList(CNode* head) {
+    freeCListIn(NULL, head);
+}
+
+// Free the entire circular list node by node into its pool
+void freeCListIn(NodePool* pool, CNode* head) {
     if (head == NULL) {
         return;
     }
@@ -156,7 +161,7 @@ void freeCList(CNode* head) {
     
     do {
         next = temp->next;
-        free(temp);
+        releaseCNode(pool, temp);
         temp = next;
     } while (temp != head);
 }
@@ -181,12 +186,22 @@ int searchC(CNode* head, int target) {
     return -1; // Not found
 }
 
-// Bubble sort for circular linked list
+// Bubble sort for circular linked list (merge sort once the list is long)
 CNode* bubbleSortC(CNode* head) {
     if (head == NULL || head->next == head) {
         return head;
     }
     
+    int length = 0;
+    CNode* node = head;
+    do {
+        length++;
+        node = node->next;
+    } while (node != head && length <= LIST_BUBBLE_SORT_MAX);
+    if (length > LIST_BUBBLE_SORT_MAX) {
+        return mergeSortC(head);
+    }
+    
     int swapped;
     CNode* ptr1;
     CNode* lptr = NULL;
@@ -240,65 +255,98 @@ CNode* makeCircular(CNode* head) {
     return head;
 }
 
-// Helper function for merge sort - split list
-CNode* splitC(CNode* head) {
-    CNode* fast = head;
-    CNode* slow = head;
-    
-    while (fast->next != NULL && fast->next->next != NULL) {
-        fast = fast->next->next;
-        slow = slow->next;
+// Helper function for merge sort - merge two sorted linear chains;
+// ties keep first's nodes first
+CNode* mergeC(CNode* first, CNode* second) {
+    CNode dummy = {0, NULL};
+    CNode* tail = &dummy;
+    
+    while (first != NULL && second != NULL) {
+        if (first->data <= second->data) {
+            tail->next = first;
+            first = first->next;
+        } else {
+            tail->next = second;
+            second = second->next;
+        }
+        tail = tail->next;
     }
+    tail->next = (first != NULL) ? first : second;
     
-    CNode* temp = slow->next;
-    slow->next = NULL;
-    return temp;
+    return dummy.next;
 }
 
-// Helper function for merge sort - merge two sorted lists
-CNode* mergeC(CNode* first, CNode* second) {
-    if (first == NULL) return second;
-    if (second == NULL) return first;
+// Merge sort helper (works on linear list) - bottom-up: each node is
+// merged into a binary counter of sorted runs, with no recursion
+CNode* mergeSortLinear(CNode* head) {
+    CNode* bins[SORT_BINS] = {NULL};
+    int used = 0;
     
-    if (first->data < second->data) {
-        first->next = mergeC(first->next, second);
-        return first;
-    } else {
-        second->next = mergeC(first, second->next);
-        return second;
+    while (head != NULL) {
+        CNode* run = head;
+        head = head->next;
+        run->next = NULL;
+        
+        int i = 0;
+        while (i < SORT_BINS - 1 && bins[i] != NULL) {
+            run = mergeC(bins[i], run);
+            bins[i] = NULL;
+            i++;
+        }
+        bins[i] = run;
+        if (i >= used) {
+            used = i + 1;
+        }
+    }
+    
+    CNode* result = NULL;
+    for (int i = 0; i < used; i++) {
+        result = mergeC(bins[i], result);
     }
+    return result;
 }
 
-// Merge sort helper (works on linear list)
-CNode* mergeSortLinear(CNode* head) {
-    if (head == NULL || head->next == NULL) {
+// Merge sort for circular linked list
+CNode* mergeSortC(CNode* head) {
+    if (head == NULL || head->next == head) {
         return head;
     }
     
-    CNode* second = splitC(head);
-    
+    // Break circular structure, sort, and make it circular again
+    head = breakCircular(head);
     head = mergeSortLinear(head);
-    second = mergeSortLinear(second);
-    
-    return mergeC(head, second);
+    return makeCircular(head);
 }
 
-// Merge sort for circular linked list
-CNode* mergeSortC(CNode* head) {
+// Adapters for the shared parallel sort
+static void* sortGetNext(void* node) {
+    return ((CNode*)node)->next;
+}
+
+static void sortSetNext(void* node, void* next) {
+    ((CNode*)node)->next = (CNode*)next;
+}
+
+static void* sortChain(void* head) {
+    return mergeSortLinear((CNode*)head);
+}
+
+static void* mergeChains(void* first, void* second) {
+    return mergeC((CNode*)first, (CNode*)second);
+}
+
+static const ListSortOps cnodeSortOps = {sortGetNext, sortSetNext, sortChain, mergeChains};
+
+// Merge sort chunks of the circular list on several threads
+CNode* mergeSortCParallel(CNode* head, int threads) {
     if (head == NULL || head->next == head) {
         return head;
     }
     
-    // Break circular structure
+    int length = getCListLength(head);
     head = breakCircular(head);
-    
-    // Perform merge sort
-    head = mergeSortLinear(head);
-    
-    // Make it circular again
-    head = makeCircular(head);
-    
-    return head;
+    head = (CNode*)parallelListSort(head, length, threads, &cnodeSortOps);
+    return makeCircular(head);
 }
 
 // Reverse the circular linked list
@@ -332,27 +380,192 @@ CNode* reverseCList(CNode* head) {
 
 // Get the length of the circular list
 int getCListLength(CNode* head) {
-    if (head == NULL) {
-        return 0;
+    CList list = wrapCChain(NULL, head);
+    return cListLength(&list);
+}
+
+// Insert array of elements
+CNode* insertCArray(CNode* head, int* arr, int size) {
+    return insertCArrayIn(NULL, head, arr, size);
+}
+
+// Build a ring holding arr in one pass: one contiguous run from a pool,
+// or one malloc per node without one. NULL if out of memory.
+static CNode* buildCChain(NodePool* pool, int* arr, int size, CNode** tail) {
+    if (pool != NULL) {
+        CNode* run = (CNode*)poolAllocRun(pool, (size_t)size);
+        if (run == NULL) {
+            return NULL;
+        }
+        for (int i = 0; i < size; i++) {
+            run[i].data = arr[i];
+            run[i].next = i + 1 < size ? &run[i + 1] : run;
+        }
+        *tail = &run[size - 1];
+        return run;
     }
     
-    int count = 0;
-    CNode* temp = head;
+    CNode* chain = NULL;
+    CNode* last = NULL;
+    for (int i = 0; i < size; i++) {
+        CNode* newNode = createCNodeIn(NULL, arr[i]);
+        if (newNode == NULL) {
+            freeCListIn(NULL, chain);
+            return NULL;
+        }
+        if (last == NULL) {
+            chain = newNode;
+        } else {
+            newNode->next = chain;
+            last->next = newNode;
+        }
+        last = newNode;
+    }
+    *tail = last;
+    return chain;
+}
+
+// Splice the ring chain..chainTail in behind tail (or make it the list)
+static CNode* appendCChain(CNode* head, CNode* tail, CNode* chain, CNode* chainTail) {
+    if (tail == NULL) {
+        return chain;
+    }
+    tail->next = chain;
+    chainTail->next = head;
+    return head;
+}
+
+// Insert array of elements, allocating from a pool
+CNode* insertCArrayIn(NodePool* pool, CNode* head, int* arr, int size) {
+    if (arr == NULL || size <= 0) {
+        return head;
+    }
+    
+    // Find the tail once and append behind it
+    CList list = wrapCChain(pool, head);
+    cListInsertArray(&list, arr, size);
+    return list.head;
+}
+
+// Set up an empty list handle
+int initCList(CList* list, NodePool* pool) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->ownsPool = (pool == NULL);
+    list->pool = pool != NULL ? pool : createCListPool(0);
+    return list->pool != NULL;
+}
+
+// Free a list handle's nodes (and its pool, if it owns one)
+void destroyCList(CList* list) {
+    if (list->ownsPool) {
+        destroyNodePool(list->pool);
+    } else {
+        freeCListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->pool = NULL;
+}
+
+// Empty a list handle but keep it usable
+void cListClear(CList* list) {
+    if (list->ownsPool) {
+        resetNodePool(list->pool);
+    } else {
+        freeCListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Append in O(1) behind the remembered tail
+int cListAppend(CList* list, int data) {
+    CNode* newNode = createCNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
+    
+    list->head = appendCChain(list->head, list->tail, newNode, newNode);
+    list->tail = newNode;
+    list->length++;
+    return 1;
+}
+
+// Insert at the front of a list handle
+int cListPrepend(CList* list, int data) {
+    CNode* newNode = createCNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
     
+    if (list->tail == NULL) {
+        list->tail = newNode;
+    } else {
+        newNode->next = list->head;
+        list->tail->next = newNode;
+    }
+    list->head = newNode;
+    list->length++;
+    return 1;
+}
+
+// Append a whole array as one ring
+int cListInsertArray(CList* list, int* arr, int size) {
+    if (size == 0) return 1;
+    if (arr == NULL || size < 0) return 0;
+    
+    CNode* chainTail;
+    CNode* chain = buildCChain(list->pool, arr, size, &chainTail);
+    if (chain == NULL) return 0;
+    
+    list->head = appendCChain(list->head, list->tail, chain, chainTail);
+    list->tail = chainTail;
+    list->length += size;
+    return 1;
+}
+
+// Delete the first node holding data from a list handle
+int cListDelete(CList* list, int data) {
+    if (list->head == NULL) return 0;
+    
+    CNode* prev = list->tail;
+    CNode* temp = list->head;
     do {
-        count++;
+        if (temp->data == data) {
+            if (temp == prev) {
+                list->head = NULL;
+                list->tail = NULL;
+            } else {
+                prev->next = temp->next;
+                if (temp == list->head) list->head = temp->next;
+                if (temp == list->tail) list->tail = prev;
+            }
+            releaseCNode(list->pool, temp);
+            list->length--;
+            return 1;
+        }
+        prev = temp;
         temp = temp->next;
-    } while (temp != head);
+    } while (temp != list->head);
     
-    return count;
+    return 0;
 }
 
-// Insert array of elements
-CNode* insertCArray(CNode* head, int* arr, int size) {
-    for (int i = 0; i < size; i++) {
-        head = insertCEnd(head, arr[i]);
-    }
-    return head;
+// Get a list handle's length in O(1)
+int cListLength(const CList* list) {
+    return list->length;
+}
+
+// Merge sort a list handle's ring
+void cListSort(CList* list) {
+    list->head = mergeSortC(list->head);
+    list->tail = getTailC(list->head);
+}
+
+// Reverse a list handle's ring
+void cListReverse(CList* list) {
+    list->tail = list->head;
+    list->head = reverseCList(list->head);
 }
 
 // Get tail of the circular list
@@ -1,6 +1,8 @@
 #ifndef CIRCULAR_LINKED_LIST_H
 #define CIRCULAR_LINKED_LIST_H
 
+#include "node_pool.h"
+
 typedef struct CNode {
     int data;
     struct CNode* next;
@@ -15,12 +17,53 @@ CNode* deleteCNode(CNode* head, int data);
 void displayCircular(CNode* head, const char* label);
 void freeCList(CNode* head);
 
+// Pooled variants: nodes come from `pool` (NULL: malloc) and deleted nodes
+// go back to its freelist. Inserts return the list unchanged if a node
+// cannot be allocated. Free a pooled list node by node with freeCListIn,
+// or all at once with destroyNodePool / resetNodePool.
+NodePool* createCListPool(int nodesPerBlock);
+CNode* createCNodeIn(NodePool* pool, int data);
+CNode* insertCEndIn(NodePool* pool, CNode* head, int data);
+CNode* insertCBeginIn(NodePool* pool, CNode* head, int data);
+CNode* insertCAfterIn(NodePool* pool, CNode* head, int afterValue, int data);
+CNode* insertCArrayIn(NodePool* pool, CNode* head, int* arr, int size);
+CNode* deleteCNodeIn(NodePool* pool, CNode* head, int data);
+void freeCListIn(NodePool* pool, CNode* head);
+
+// List handle: remembers the tail and length, so appends, getting the
+// tail and the length are O(1). Nodes come from `pool`, or from a pool the
+// handle creates and owns when it is NULL. Calls return 1 on success and 0
+// if out of memory (or, for cListDelete, if the value is absent). Code may
+// walk the ring, but must relink it only through the handle.
+typedef struct CList {
+    CNode* head;
+    CNode* tail;
+    int length;
+    NodePool* pool;
+    int ownsPool;
+} CList;
+
+int initCList(CList* list, NodePool* pool);
+void destroyCList(CList* list);
+void cListClear(CList* list);
+int cListAppend(CList* list, int data);
+int cListPrepend(CList* list, int data);
+int cListInsertArray(CList* list, int* arr, int size);  // One contiguous run
+int cListDelete(CList* list, int data);
+int cListLength(const CList* list);
+void cListSort(CList* list);
+void cListReverse(CList* list);
+
 // Search algorithm
 int searchC(CNode* head, int target);
 
-// Sort algorithms
+// Sort algorithms. mergeSortC is bottom-up, with no recursion or
+// allocation; mergeSortCParallel sorts chunks on `threads` threads (0: one
+// per CPU) and merges them. bubbleSortC hands lists longer than
+// LIST_BUBBLE_SORT_MAX (list_sort.h) to mergeSortC.
 CNode* bubbleSortC(CNode* head);
 CNode* mergeSortC(CNode* head);
+CNode* mergeSortCParallel(CNode* head, int threads);
 
 // Reverse algorithm
 CNode* reverseCList(CNode* head);
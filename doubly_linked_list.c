@@ -1,13 +1,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "doubly_linked_list.h"
+#include "list_sort.h"
 
-// Create a new doubly linked list node
-DNode* createDNode(int data) {
-    DNode* newNode = (DNode*)malloc(sizeof(DNode));
+// Sorted runs kept by the bottom-up merge sort: bin i holds 2^i nodes
+#define SORT_BINS 64
+
+// Create a pool sized for doubly linked list nodes
+NodePool* createDListPool(int nodesPerBlock) {
+    return createNodePool(sizeof(DNode), nodesPerBlock > 0 ? (size_t)nodesPerBlock : 0);
+}
+
+// Create a new node from a pool (or malloc without one); NULL on failure
+DNode* createDNodeIn(NodePool* pool, int data) {
+    DNode* newNode = pool != NULL ? (DNode*)poolAllocNode(pool) : (DNode*)malloc(sizeof(DNode));
     if (newNode == NULL) {
         printf("Memory allocation failed!\n");
-        exit(1);
+        return NULL;
     }
     newNode->data = data;
     newNode->next = NULL;
@@ -15,37 +24,66 @@ DNode* createDNode(int data) {
     return newNode;
 }
 
-// Insert at the end of the list
-DNode* insertDEnd(DNode* head, int data) {
-    DNode* newNode = createDNode(data);
-    
-    if (head == NULL) {
-        return newNode;
+// Give a node back to wherever it came from
+static void releaseDNode(NodePool* pool, DNode* node) {
+    if (pool != NULL) {
+        poolFreeNode(pool, node);
+    } else {
+        free(node);
     }
-    
-    DNode* temp = head;
-    while (temp->next != NULL) {
-        temp = temp->next;
+}
+
+// View a bare chain as a list handle, so the head-pointer functions run
+// the handle code. Walking for the tail and length costs what those
+// functions always did; without the walk the tail stands in as head,
+// which is all prepends and deletes look at.
+static DList wrapDChain(NodePool* pool, DNode* head, int walk) {
+    DList list = { head, head, 0, pool, 0 };
+    if (walk) {
+        for (DNode* node = head; node != NULL; node = node->next) {
+            list.tail = node;
+            list.length++;
+        }
     }
-    
-    temp->next = newNode;
-    newNode->prev = temp;
-    return head;
+    return list;
+}
+
+// Create a new doubly linked list node
+DNode* createDNode(int data) {
+    return createDNodeIn(NULL, data);
+}
+
+// Insert at the end of the list
+DNode* insertDEnd(DNode* head, int data) {
+    return insertDEndIn(NULL, head, data);
+}
+
+// Insert at the end of the list, allocating from a pool
+DNode* insertDEndIn(NodePool* pool, DNode* head, int data) {
+    DList list = wrapDChain(pool, head, 1);
+    dListAppend(&list, data);
+    return list.head;
 }
 
 // Insert at the beginning of the list
 DNode* insertDBegin(DNode* head, int data) {
-    DNode* newNode = createDNode(data);
-    
-    if (head != NULL) {
-        head->prev = newNode;
-    }
-    newNode->next = head;
-    return newNode;
+    return insertDBeginIn(NULL, head, data);
+}
+
+// Insert at the beginning of the list, allocating from a pool
+DNode* insertDBeginIn(NodePool* pool, DNode* head, int data) {
+    DList list = wrapDChain(pool, head, 0);
+    dListPrepend(&list, data);
+    return list.head;
 }
 
 // Insert after a specific value
 DNode* insertDAfter(DNode* head, int afterValue, int data) {
+    return insertDAfterIn(NULL, head, afterValue, data);
+}
+
+// Insert after a specific value, allocating from a pool
+DNode* insertDAfterIn(NodePool* pool, DNode* head, int afterValue, int data) {
     if (head == NULL) {
         printf("List is empty. Cannot insert after %d.\n", afterValue);
         return head;
@@ -61,7 +99,8 @@ DNode* insertDAfter(DNode* head, int afterValue, int data) {
         return head;
     }
     
-    DNode* newNode = createDNode(data);
+    DNode* newNode = createDNodeIn(pool, data);
+    if (newNode == NULL) return head;
     newNode->next = temp->next;
     newNode->prev = temp;
     
@@ -75,13 +114,18 @@ DNode* insertDAfter(DNode* head, int afterValue, int data) {
 
 // Insert before a specific value
 DNode* insertDBefore(DNode* head, int beforeValue, int data) {
+    return insertDBeforeIn(NULL, head, beforeValue, data);
+}
+
+// Insert before a specific value, allocating from a pool
+DNode* insertDBeforeIn(NodePool* pool, DNode* head, int beforeValue, int data) {
     if (head == NULL) {
         printf("List is empty. Cannot insert before %d.\n", beforeValue);
         return head;
     }
     
     if (head->data == beforeValue) {
-        return insertDBegin(head, data);
+        return insertDBeginIn(pool, head, data);
     }
     
     DNode* temp = head;
@@ -94,7 +138,8 @@ DNode* insertDBefore(DNode* head, int beforeValue, int data) {
         return head;
     }
     
-    DNode* newNode = createDNode(data);
+    DNode* newNode = createDNodeIn(pool, data);
+    if (newNode == NULL) return head;
     newNode->next = temp;
     newNode->prev = temp->prev;
     
@@ -106,44 +151,21 @@ DNode* insertDBefore(DNode* head, int beforeValue, int data) {
 
 // Delete a node with specific data
 DNode* deleteDNode(DNode* head, int data) {
+    return deleteDNodeIn(NULL, head, data);
+}
+
+// Delete a node with specific data, returning it to its pool
+DNode* deleteDNodeIn(NodePool* pool, DNode* head, int data) {
     if (head == NULL) {
         printf("List is empty.\n");
         return NULL;
     }
     
-    DNode* temp = head;
-    
-    // If head node contains the data
-    if (temp->data == data) {
-        head = temp->next;
-        if (head != NULL) {
-            head->prev = NULL;
-        }
-        free(temp);
-        return head;
-    }
-    
-    // Search for the node to delete
-    while (temp != NULL && temp->data != data) {
-        temp = temp->next;
-    }
-    
-    // If data was not found
-    if (temp == NULL) {
+    DList list = wrapDChain(pool, head, 0);
+    if (!dListDelete(&list, data)) {
         printf("Element %d not found.\n", data);
-        return head;
-    }
-    
-    // Unlink the node
-    if (temp->next != NULL) {
-        temp->next->prev = temp->prev;
-    }
-    if (temp->prev != NULL) {
-        temp->prev->next = temp->next;
     }
-    
-    free(temp);
-    return head;
+    return list.head;
 }
 
 // Display list forward
@@ -201,11 +223,16 @@ void displayDBackward(DNode* head, const char* label) {
 
 // Free the entire list
 void freeDList(DNode* head) {
+    freeDListIn(NULL, head);
+}
+
+// Free the entire list node by node into its pool
+void freeDListIn(NodePool* pool, DNode* head) {
     DNode* temp;
     while (head != NULL) {
         temp = head;
         head = head->next;
-        free(temp);
+        releaseDNode(pool, temp);
     }
 }
 
@@ -225,12 +252,20 @@ int searchD(DNode* head, int target) {
     return -1; // Not found
 }
 
-// Bubble sort for doubly linked list
+// Bubble sort for doubly linked list (merge sort once the list is long)
 DNode* bubbleSortD(DNode* head) {
     if (head == NULL || head->next == NULL) {
         return head;
     }
     
+    int length = 0;
+    for (DNode* node = head; node != NULL && length <= LIST_BUBBLE_SORT_MAX; node = node->next) {
+        length++;
+    }
+    if (length > LIST_BUBBLE_SORT_MAX) {
+        return mergeSortD(head);
+    }
+    
     int swapped;
     DNode* ptr1;
     DNode* lptr = NULL;
@@ -255,59 +290,94 @@ DNode* bubbleSortD(DNode* head) {
     return head;
 }
 
-// Helper function for merge sort - split list
-DNode* splitD(DNode* head) {
-    DNode* fast = head;
-    DNode* slow = head;
-    
-    while (fast->next != NULL && fast->next->next != NULL) {
-        fast = fast->next->next;
-        slow = slow->next;
-    }
-    
-    DNode* temp = slow->next;
-    slow->next = NULL;
-    if (temp != NULL) {
-        temp->prev = NULL;
+// Helper function for merge sort - merge two sorted chains by next
+// pointers only (prev is rebuilt once the sort is done); ties keep first
+DNode* mergeD(DNode* first, DNode* second) {
+    DNode dummy = {0, NULL, NULL};
+    DNode* tail = &dummy;
+    
+    while (first != NULL && second != NULL) {
+        if (first->data <= second->data) {
+            tail->next = first;
+            first = first->next;
+        } else {
+            tail->next = second;
+            second = second->next;
+        }
+        tail = tail->next;
     }
+    tail->next = (first != NULL) ? first : second;
     
-    return temp;
+    return dummy.next;
 }
 
-// Helper function for merge sort - merge two sorted lists
-DNode* mergeD(DNode* first, DNode* second) {
-    if (first == NULL) return second;
-    if (second == NULL) return first;
+// Helper function for merge sort - bottom-up over next pointers: each node
+// is merged into a binary counter of sorted runs, with no recursion
+static DNode* sortDChain(DNode* head) {
+    DNode* bins[SORT_BINS] = {NULL};
+    int used = 0;
     
-    if (first->data < second->data) {
-        first->next = mergeD(first->next, second);
-        if (first->next != NULL) {
-            first->next->prev = first;
+    while (head != NULL) {
+        DNode* run = head;
+        head = head->next;
+        run->next = NULL;
+        
+        int i = 0;
+        while (i < SORT_BINS - 1 && bins[i] != NULL) {
+            run = mergeD(bins[i], run);
+            bins[i] = NULL;
+            i++;
         }
-        first->prev = NULL;
-        return first;
-    } else {
-        second->next = mergeD(first, second->next);
-        if (second->next != NULL) {
-            second->next->prev = second;
+        bins[i] = run;
+        if (i >= used) {
+            used = i + 1;
         }
-        second->prev = NULL;
-        return second;
     }
+    
+    DNode* result = NULL;
+    for (int i = 0; i < used; i++) {
+        result = mergeD(bins[i], result);
+    }
+    return result;
+}
+
+// Helper function for merge sort - restore prev pointers along next
+static DNode* relinkPrev(DNode* head) {
+    DNode* prev = NULL;
+    for (DNode* node = head; node != NULL; node = node->next) {
+        node->prev = prev;
+        prev = node;
+    }
+    return head;
 }
 
 // Merge sort for doubly linked list
 DNode* mergeSortD(DNode* head) {
-    if (head == NULL || head->next == NULL) {
-        return head;
-    }
-    
-    DNode* second = splitD(head);
-    
-    head = mergeSortD(head);
-    second = mergeSortD(second);
-    
-    return mergeD(head, second);
+    return relinkPrev(sortDChain(head));
+}
+
+// Adapters for the shared parallel sort
+static void* sortGetNext(void* node) {
+    return ((DNode*)node)->next;
+}
+
+static void sortSetNext(void* node, void* next) {
+    ((DNode*)node)->next = (DNode*)next;
+}
+
+static void* sortChain(void* head) {
+    return sortDChain((DNode*)head);
+}
+
+static void* mergeChains(void* first, void* second) {
+    return mergeD((DNode*)first, (DNode*)second);
+}
+
+static const ListSortOps dnodeSortOps = {sortGetNext, sortSetNext, sortChain, mergeChains};
+
+// Merge sort chunks of the list on several threads
+DNode* mergeSortDParallel(DNode* head, int threads) {
+    return relinkPrev((DNode*)parallelListSort(head, getDListLength(head), threads, &dnodeSortOps));
 }
 
 // Reverse the doubly linked list
@@ -331,25 +401,191 @@ DNode* reverseDList(DNode* head) {
 
 // Get the length of the list
 int getDListLength(DNode* head) {
-    int count = 0;
-    DNode* temp = head;
-    
-    while (temp != NULL) {
-        count++;
-        temp = temp->next;
-    }
-    
-    return count;
+    DList list = wrapDChain(NULL, head, 1);
+    return dListLength(&list);
 }
 
 // Insert array of elements
 DNode* insertDArray(DNode* head, int* arr, int size) {
+    return insertDArrayIn(NULL, head, arr, size);
+}
+
+// Build a chain holding arr in one pass: one contiguous run from a pool,
+// or one malloc per node without one. NULL if out of memory.
+static DNode* buildDChain(NodePool* pool, int* arr, int size, DNode** tail) {
+    if (pool != NULL) {
+        DNode* run = (DNode*)poolAllocRun(pool, (size_t)size);
+        if (run == NULL) {
+            return NULL;
+        }
+        for (int i = 0; i < size; i++) {
+            run[i].data = arr[i];
+            run[i].next = i + 1 < size ? &run[i + 1] : NULL;
+            run[i].prev = i > 0 ? &run[i - 1] : NULL;
+        }
+        *tail = &run[size - 1];
+        return run;
+    }
+    
+    DNode* chain = NULL;
+    DNode* last = NULL;
     for (int i = 0; i < size; i++) {
-        head = insertDEnd(head, arr[i]);
+        DNode* newNode = createDNodeIn(NULL, arr[i]);
+        if (newNode == NULL) {
+            freeDListIn(NULL, chain);
+            return NULL;
+        }
+        if (last == NULL) {
+            chain = newNode;
+        } else {
+            last->next = newNode;
+            newNode->prev = last;
+        }
+        last = newNode;
     }
+    *tail = last;
+    return chain;
+}
+
+// Link a chain behind tail (or make it the list, if tail is NULL)
+static DNode* appendDChain(DNode* head, DNode* tail, DNode* chain) {
+    if (tail == NULL) {
+        return chain;
+    }
+    tail->next = chain;
+    chain->prev = tail;
     return head;
 }
 
+// Insert array of elements, allocating from a pool
+DNode* insertDArrayIn(NodePool* pool, DNode* head, int* arr, int size) {
+    if (arr == NULL || size <= 0) {
+        return head;
+    }
+    
+    // Find the tail once and append behind it
+    DList list = wrapDChain(pool, head, 1);
+    dListInsertArray(&list, arr, size);
+    return list.head;
+}
+
+// Set up an empty list handle
+int initDList(DList* list, NodePool* pool) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->ownsPool = (pool == NULL);
+    list->pool = pool != NULL ? pool : createDListPool(0);
+    return list->pool != NULL;
+}
+
+// Free a list handle's nodes (and its pool, if it owns one)
+void destroyDList(DList* list) {
+    if (list->ownsPool) {
+        destroyNodePool(list->pool);
+    } else {
+        freeDListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->pool = NULL;
+}
+
+// Empty a list handle but keep it usable
+void dListClear(DList* list) {
+    if (list->ownsPool) {
+        resetNodePool(list->pool);
+    } else {
+        freeDListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Append in O(1) behind the remembered tail
+int dListAppend(DList* list, int data) {
+    DNode* newNode = createDNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
+    
+    list->head = appendDChain(list->head, list->tail, newNode);
+    list->tail = newNode;
+    list->length++;
+    return 1;
+}
+
+// Insert at the front of a list handle
+int dListPrepend(DList* list, int data) {
+    DNode* newNode = createDNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
+    
+    newNode->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = newNode;
+    } else {
+        list->tail = newNode;
+    }
+    list->head = newNode;
+    list->length++;
+    return 1;
+}
+
+// Append a whole array as one chain
+int dListInsertArray(DList* list, int* arr, int size) {
+    if (size == 0) return 1;
+    if (arr == NULL || size < 0) return 0;
+    
+    DNode* chainTail;
+    DNode* chain = buildDChain(list->pool, arr, size, &chainTail);
+    if (chain == NULL) return 0;
+    
+    list->head = appendDChain(list->head, list->tail, chain);
+    list->tail = chainTail;
+    list->length += size;
+    return 1;
+}
+
+// Delete the first node holding data from a list handle
+int dListDelete(DList* list, int data) {
+    DNode* temp = list->head;
+    while (temp != NULL && temp->data != data) {
+        temp = temp->next;
+    }
+    if (temp == NULL) return 0;
+    
+    if (temp->prev != NULL) {
+        temp->prev->next = temp->next;
+    } else {
+        list->head = temp->next;
+    }
+    if (temp->next != NULL) {
+        temp->next->prev = temp->prev;
+    } else {
+        list->tail = temp->prev;
+    }
+    releaseDNode(list->pool, temp);
+    list->length--;
+    return 1;
+}
+
+// Get a list handle's length in O(1)
+int dListLength(const DList* list) {
+    return list->length;
+}
+
+// Merge sort a list handle's chain
+void dListSort(DList* list) {
+    list->head = mergeSortD(list->head);
+    list->tail = getTail(list->head);
+}
+
+// Reverse a list handle's chain
+void dListReverse(DList* list) {
+    list->tail = list->head;
+    list->head = reverseDList(list->head);
+}
+
 // Get tail of the list
 DNode* getTail(DNode* head) {
     if (head == NULL) {
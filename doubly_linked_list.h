@@ -1,6 +1,8 @@
 #ifndef DOUBLY_LINKED_LIST_H
 #define DOUBLY_LINKED_LIST_H
 
+#include "node_pool.h"
+
 typedef struct DNode {
     int data;
     struct DNode* next;
@@ -18,12 +20,54 @@ void displayDForward(DNode* head, const char* label);
 void displayDBackward(DNode* head, const char* label);
 void freeDList(DNode* head);
 
+// Pooled variants: nodes come from `pool` (NULL: malloc) and deleted nodes
+// go back to its freelist. Inserts return the list unchanged if a node
+// cannot be allocated. Free a pooled list node by node with freeDListIn,
+// or all at once with destroyNodePool / resetNodePool.
+NodePool* createDListPool(int nodesPerBlock);
+DNode* createDNodeIn(NodePool* pool, int data);
+DNode* insertDEndIn(NodePool* pool, DNode* head, int data);
+DNode* insertDBeginIn(NodePool* pool, DNode* head, int data);
+DNode* insertDAfterIn(NodePool* pool, DNode* head, int afterValue, int data);
+DNode* insertDBeforeIn(NodePool* pool, DNode* head, int beforeValue, int data);
+DNode* insertDArrayIn(NodePool* pool, DNode* head, int* arr, int size);
+DNode* deleteDNodeIn(NodePool* pool, DNode* head, int data);
+void freeDListIn(NodePool* pool, DNode* head);
+
+// List handle: remembers the tail and length, so appends, getting the
+// tail and the length are O(1). Nodes come from `pool`, or from a pool the
+// handle creates and owns when it is NULL. Calls return 1 on success and 0
+// if out of memory (or, for dListDelete, if the value is absent). Code may
+// walk the chain, but must relink it only through the handle.
+typedef struct DList {
+    DNode* head;
+    DNode* tail;
+    int length;
+    NodePool* pool;
+    int ownsPool;
+} DList;
+
+int initDList(DList* list, NodePool* pool);
+void destroyDList(DList* list);
+void dListClear(DList* list);
+int dListAppend(DList* list, int data);
+int dListPrepend(DList* list, int data);
+int dListInsertArray(DList* list, int* arr, int size);  // One contiguous run
+int dListDelete(DList* list, int data);
+int dListLength(const DList* list);
+void dListSort(DList* list);
+void dListReverse(DList* list);
+
 // Search algorithm
 int searchD(DNode* head, int target);
 
-// Sort algorithms
+// Sort algorithms. mergeSortD is bottom-up, with no recursion or
+// allocation; mergeSortDParallel sorts chunks on `threads` threads (0: one
+// per CPU) and merges them. bubbleSortD hands lists longer than
+// LIST_BUBBLE_SORT_MAX (list_sort.h) to mergeSortD.
 DNode* bubbleSortD(DNode* head);
 DNode* mergeSortD(DNode* head);
+DNode* mergeSortDParallel(DNode* head, int threads);
 
 // Reverse algorithm
 DNode* reverseDList(DNode* head);
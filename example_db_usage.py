@@ -57,7 +57,7 @@ def main():
     stats = db.stats()
     print("Database Statistics:")
     print(f"  Entries: {stats['total_entries']}")
-    print(f"  Buckets used: {stats['used_buckets']}/1024")
+    print(f"  Buckets used: {stats['used_buckets']}/{stats['total_buckets']}")
     print(f"  Collisions: {stats['total_collisions']}")
     print(f"  Max chain: {stats['max_chain_length']}\n")
     
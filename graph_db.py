@@ -2,17 +2,122 @@
 Graph Database with Traversal Algorithms
 
 Supports:
-- Import/export from structured text (JSON, adjacency list)
-- In-memory storage using SimpleDB
+- Import/export from structured text (JSON, adjacency list) and a binary
+  graph file for fast loading
+- Adjacency in the native graph engine (graph_engine.c), node data in SimpleDB
+- Scalar node properties mirrored into typed engine columns for native
+  filtering (find_where)
 - Graph traversal (BFS, DFS)
 - Node/edge operations (add, delete, search)
 - Multiple graph types (directed, undirected, weighted)
 """
 
 import json
-from typing import List, Dict, Set, Optional, Tuple, Any
-from collections import deque
+import math
+import os
+from typing import List, Dict, Set, Optional, Tuple, Any, Callable, Iterator, Mapping, Union, TextIO
 from simple_db_python import SimpleDB
+from graph_engine_python import (GraphEngine, GraphFile, Coordinates, NO_NODE, PROP_INT,
+                                 PROP_DOUBLE, PROP_STRING, INT64_MIN, INT64_MAX)
+
+# Binary graph file flags (GraphEngine.save)
+FILE_DIRECTED = 1
+FILE_WEIGHTED = 2
+
+# Top-level JSON members whose arrays import_from_json_file streams
+_STREAMED_MEMBERS = ("nodes", "edges")
+
+
+def _json_events(fp: TextIO, chunk_size: int) -> Iterator[Tuple[str, str, Any]]:
+    """
+    Parse a JSON object from fp incrementally
+    
+    Yields ("member", key, value) for each top-level member, except that the
+    arrays under _STREAMED_MEMBERS come out as one ("item", key, element)
+    per element. Only a chunk and the element being decoded are held in
+    memory.
+    
+    Raises:
+        ValueError: If the document is not a JSON object
+    """
+    decoder = json.JSONDecoder()
+    buf, pos, eof = "", 0, False
+    
+    def fill() -> bool:
+        nonlocal buf, pos, eof
+        if eof:
+            return False
+        chunk = fp.read(chunk_size)
+        eof = not chunk
+        buf, pos = buf[pos:] + chunk, 0
+        return not eof
+    
+    def peek() -> str:
+        nonlocal pos
+        while True:
+            while pos < len(buf) and buf[pos] in " \t\r\n":
+                pos += 1
+            if pos < len(buf) or not fill():
+                return buf[pos] if pos < len(buf) else ""
+    
+    def expect(chars: str) -> str:
+        nonlocal pos
+        char = peek()
+        if not char or char not in chars:
+            raise ValueError(f"Expected one of {chars!r} in JSON, found {char!r}")
+        pos += 1
+        return char
+    
+    def value() -> Any:
+        nonlocal pos
+        peek()
+        while True:
+            try:
+                result, end = decoder.raw_decode(buf, pos)
+                # A number at the end of the buffer may continue in the next chunk
+                if end < len(buf) or eof:
+                    pos = end
+                    return result
+            except json.JSONDecodeError:
+                if eof:
+                    raise
+            fill()
+    
+    expect("{")
+    if peek() == "}":
+        return
+    while True:
+        key = value()
+        expect(":")
+        if key in _STREAMED_MEMBERS and peek() == "[":
+            expect("[")
+            if peek() == "]":
+                expect("]")
+            else:
+                while True:
+                    yield "item", key, value()
+                    if expect(",]") == "]":
+                        break
+        else:
+            yield "member", key, value()
+        if expect(",}") == "}":
+            return
+
+
+def _condition_holds(data: Dict[str, Any], name: str, condition: Any) -> bool:
+    """find_where's test of one condition against a node's data, in Python"""
+    if name not in data:
+        return False
+    value = data[name]
+    try:
+        if isinstance(condition, tuple):
+            lo, hi = condition
+            return (lo is None or value >= lo) and (hi is None or value <= hi)
+        if isinstance(condition, (list, set, frozenset)):
+            return value in condition
+        return value == condition
+    except TypeError:
+        return False
 
 
 class GraphDB:
@@ -30,19 +135,95 @@ class GraphDB:
         self.directed = directed
         self.weighted = weighted
         
+        # Edges live in the native engine under integer IDs; these map
+        # node names to IDs and back (None marks a deleted node)
+        self._graph = GraphEngine()
+        self._ids: Dict[str, int] = {}
+        self._names: List[Optional[str]] = []
+        self._edge_count = 0
+        
+        # Scalar properties are also kept in typed engine columns for
+        # find_where: name -> (column, type). Names that held values of
+        # different types, or lists, dicts or nulls, are filtered in Python.
+        self._columns: Dict[str, Tuple[int, int]] = {}
+        self._mixed: Set[str] = set()
+        self._columns_stale = False     # After load(): rebuilt on first query
+        
         # Store metadata
         self.db.set("__meta__:directed", str(directed))
         self.db.set("__meta__:weighted", str(weighted))
-        self.db.set("__meta__:node_count", "0")
-        self.db.set("__meta__:edge_count", "0")
     
     def __enter__(self):
         return self
     
     def __exit__(self, exc_type, exc_val, exc_tb):
-        self.db.clear()
+        self._reset()
         return False
     
+    def _reset(self):
+        """Remove every node and edge, keeping the graph type"""
+        self.db.clear()
+        self.db.set("__meta__:directed", str(self.directed))
+        self.db.set("__meta__:weighted", str(self.weighted))
+        self._graph.clear()
+        self._ids.clear()
+        self._names.clear()
+        self._edge_count = 0
+        self._columns.clear()
+        self._mixed.clear()
+        self._columns_stale = False
+    
+    def _column_for(self, name: str, value: Any) -> Optional[Tuple[int, int]]:
+        """The engine column a property value goes into, None if it can't"""
+        if name in self._mixed:
+            return None
+        if isinstance(value, bool) or (isinstance(value, int) and INT64_MIN <= value <= INT64_MAX):
+            kind = PROP_INT
+        elif isinstance(value, (int, float)):
+            kind = PROP_DOUBLE
+        elif isinstance(value, str):
+            kind = PROP_STRING
+        else:
+            kind = None
+        
+        column = self._columns.get(name)
+        if column is None and kind is not None:
+            column = self._columns[name] = (self._graph.prop_column(name, kind), kind)
+        if column is not None and (column[1] == kind or (column[1] == PROP_DOUBLE and kind == PROP_INT)):
+            return column
+        
+        # Values of two types (or a list, dict or null): stop using the
+        # column and filter in Python from now on
+        self._mixed.add(name)
+        self._columns.pop(name, None)
+        return None
+    
+    def _index_node(self, node: int, data: Dict[str, Any]):
+        """Put a node's scalar properties into the engine columns"""
+        if self._columns_stale:
+            return
+        for name, value in data.items():
+            column = self._column_for(name, value)
+            if column is not None:
+                self._graph.set_props(column[0], column[1], [node], [value])
+    
+    def _build_columns(self):
+        """Fill the columns from the stored node data, one native call per column"""
+        self._columns_stale = False
+        names = [name for name in self._names if name is not None]
+        nodes = [self._ids[name] for name in names]
+        batches: Dict[str, Tuple[List[int], List[Any]]] = {}
+        for node, data in zip(nodes, self.db.mget(f"node:{name}" for name in names)):
+            for name, value in json.loads(data).items():
+                if self._column_for(name, value) is not None:
+                    batch = batches.setdefault(name, ([], []))
+                    batch[0].append(node)
+                    batch[1].append(value)
+        for name, (batch_nodes, values) in batches.items():
+            column = self._columns.get(name)
+            if column is not None:
+                self._graph.set_props(column[0], column[1], batch_nodes, values)
+    
     # ========================================================================
     # Node Operations
     # ========================================================================
@@ -54,25 +235,23 @@ class GraphDB:
         Args:
             node_id: Unique identifier for the node
             data: Optional dictionary of node attributes
-            
+        
         Returns:
             True if node was added, False if already exists
         """
         key = f"node:{node_id}"
         
-        if self.db.exists(key):
+        if node_id in self._ids:
             return False
         
         # Store node data
         node_data = data or {}
         self.db.set(key, json.dumps(node_data))
         
-        # Initialize empty adjacency list
-        self.db.set(f"adj:{node_id}", "[]")
-        
-        # Update node count
-        count = int(self.db.get("__meta__:node_count") or "0")
-        self.db.set("__meta__:node_count", str(count + 1))
+        # Register the node with the engine
+        node = self._ids[node_id] = self._graph.add_node()
+        self._names.append(node_id)
+        self._index_node(node, node_data)
         
         return True
     
@@ -82,42 +261,26 @@ class GraphDB:
         
         Args:
             node_id: Node to delete
-            
+        
         Returns:
             True if deleted, False if node doesn't exist
         """
-        key = f"node:{node_id}"
-        
-        if not self.db.exists(key):
+        node = self._ids.pop(node_id, None)
+        if node is None:
             return False
         
-        # Remove all edges to/from this node
-        edges_to_remove = []
-        for edge_key in self.db.keys():
-            if edge_key.startswith("edge:"):
-                parts = edge_key.split(":")
-                if len(parts) >= 3:
-                    from_node, to_node = parts[1], parts[2]
-                    if from_node == node_id or to_node == node_id:
-                        edges_to_remove.append(edge_key)
-        
-        for edge_key in edges_to_remove:
-            self.db.delete(edge_key)
-        
-        # Remove from adjacency lists
-        for adj_key in self.db.keys():
-            if adj_key.startswith("adj:") and adj_key != f"adj:{node_id}":
-                adj_list = json.loads(self.db.get(adj_key))
-                adj_list = [item for item in adj_list if item.get('to') != node_id]
-                self.db.set(adj_key, json.dumps(adj_list))
-        
-        # Delete node data and adjacency list
-        self.db.delete(key)
-        self.db.delete(f"adj:{node_id}")
-        
-        # Update node count
-        count = int(self.db.get("__meta__:node_count") or "0")
-        self.db.set("__meta__:node_count", str(max(0, count - 1)))
+        # Every edge touching the node goes with it; a self-loop counts once
+        # and undirected edges are stored in both directions
+        removed = self._graph.out_degree(node)
+        if self.directed:
+            removed += self._graph.in_degree(node)
+            if self._graph.edge_weight(node, node) is not None:
+                removed -= 1
+        self._edge_count -= removed
+        
+        self._graph.delete_node(node)
+        self._names[node] = None
+        self.db.delete(f"node:{node_id}")
         
         return True
     
@@ -127,7 +290,7 @@ class GraphDB:
         
         Args:
             node_id: Node identifier
-            
+        
         Returns:
             Dictionary of node attributes including 'id', or None if not found
         """
@@ -150,30 +313,29 @@ class GraphDB:
         Args:
             node_id: Node identifier
             data: New node attributes
-            
+        
         Returns:
             True if updated, False if node doesn't exist
         """
         key = f"node:{node_id}"
         
-        if not self.db.exists(key):
+        node = self._ids.get(node_id)
+        if node is None:
             return False
         
         self.db.set(key, json.dumps(data))
+        for column, _ in self._columns.values():
+            self._graph.unset_prop(column, node)
+        self._index_node(node, data)
         return True
     
     def node_exists(self, node_id: str) -> bool:
         """Check if node exists"""
-        return self.db.exists(f"node:{node_id}")
+        return node_id in self._ids
     
     def get_all_nodes(self) -> List[str]:
         """Get list of all node IDs"""
-        nodes = []
-        for key in self.db.keys():
-            if key.startswith("node:"):
-                node_id = key[5:]  # Remove "node:" prefix
-                nodes.append(node_id)
-        return sorted(nodes)
+        return sorted(self._ids)
     
     # ========================================================================
     # Edge Operations
@@ -187,47 +349,23 @@ class GraphDB:
             from_node: Source node
             to_node: Destination node
             weight: Edge weight (for weighted graphs)
-            
+        
         Returns:
             True if edge was added, False otherwise
         """
         # Ensure both nodes exist
-        if not self.node_exists(from_node) or not self.node_exists(to_node):
+        u, v = self._ids.get(from_node), self._ids.get(to_node)
+        if u is None or v is None:
             return False
         
-        # Add edge
-        edge_key = f"edge:{from_node}:{to_node}"
-        edge_data = {"weight": weight} if self.weighted else {}
-        self.db.set(edge_key, json.dumps(edge_data))
-        
-        # Update adjacency list for from_node
-        adj_list = json.loads(self.db.get(f"adj:{from_node}") or "[]")
-        edge_info = {"to": to_node}
-        if self.weighted:
-            edge_info["weight"] = weight
-        
-        # Remove existing edge to same node (if updating)
-        adj_list = [e for e in adj_list if e.get('to') != to_node]
-        adj_list.append(edge_info)
-        self.db.set(f"adj:{from_node}", json.dumps(adj_list))
+        # Re-adding an edge updates its weight and moves it last
+        if self._graph.edge_weight(u, v) is None:
+            self._edge_count += 1
+        self._graph.add_edge(u, v, weight)
         
         # For undirected graphs, add reverse edge
         if not self.directed:
-            reverse_edge_key = f"edge:{to_node}:{from_node}"
-            self.db.set(reverse_edge_key, json.dumps(edge_data))
-            
-            adj_list_reverse = json.loads(self.db.get(f"adj:{to_node}") or "[]")
-            reverse_edge_info = {"to": from_node}
-            if self.weighted:
-                reverse_edge_info["weight"] = weight
-            
-            adj_list_reverse = [e for e in adj_list_reverse if e.get('to') != from_node]
-            adj_list_reverse.append(reverse_edge_info)
-            self.db.set(f"adj:{to_node}", json.dumps(adj_list_reverse))
-        
-        # Update edge count
-        count = int(self.db.get("__meta__:edge_count") or "0")
-        self.db.set("__meta__:edge_count", str(count + 1))
+            self._graph.add_edge(v, u, weight)
         
         return True
     
@@ -238,50 +376,38 @@ class GraphDB:
         Args:
             from_node: Source node
             to_node: Destination node
-            
+        
         Returns:
             True if deleted, False if edge doesn't exist
         """
-        edge_key = f"edge:{from_node}:{to_node}"
-        
-        if not self.db.exists(edge_key):
+        u, v = self._ids.get(from_node), self._ids.get(to_node)
+        if u is None or v is None or not self._graph.delete_edge(u, v):
             return False
         
-        # Delete edge
-        self.db.delete(edge_key)
-        
-        # Update adjacency list
-        adj_list = json.loads(self.db.get(f"adj:{from_node}") or "[]")
-        adj_list = [e for e in adj_list if e.get('to') != to_node]
-        self.db.set(f"adj:{from_node}", json.dumps(adj_list))
-        
         # For undirected graphs, delete reverse edge
         if not self.directed:
-            reverse_edge_key = f"edge:{to_node}:{from_node}"
-            self.db.delete(reverse_edge_key)
-            
-            adj_list_reverse = json.loads(self.db.get(f"adj:{to_node}") or "[]")
-            adj_list_reverse = [e for e in adj_list_reverse if e.get('to') != from_node]
-            self.db.set(f"adj:{to_node}", json.dumps(adj_list_reverse))
-        
-        # Update edge count
-        count = int(self.db.get("__meta__:edge_count") or "0")
-        self.db.set("__meta__:edge_count", str(max(0, count - 1)))
+            self._graph.delete_edge(v, u)
         
+        self._edge_count -= 1
         return True
     
+    def _edge_weight(self, from_node: str, to_node: str) -> Optional[float]:
+        """Weight of an edge by node name, or None if there is none"""
+        u, v = self._ids.get(from_node), self._ids.get(to_node)
+        if u is None or v is None:
+            return None
+        return self._graph.edge_weight(u, v)
+    
     def get_edge(self, from_node: str, to_node: str) -> Optional[Dict[str, Any]]:
         """Get edge data"""
-        edge_key = f"edge:{from_node}:{to_node}"
-        data = self.db.get(edge_key)
-        
-        if data:
-            return json.loads(data)
-        return None
+        weight = self._edge_weight(from_node, to_node)
+        if weight is None:
+            return None
+        return {"weight": weight} if self.weighted else {}
     
     def edge_exists(self, from_node: str, to_node: str) -> bool:
         """Check if edge exists"""
-        return self.db.exists(f"edge:{from_node}:{to_node}")
+        return self._edge_weight(from_node, to_node) is not None
     
     def get_neighbors(self, node_id: str) -> List[Dict[str, Any]]:
         """
@@ -290,10 +416,14 @@ class GraphDB:
         Returns:
             List of dictionaries with 'to' and optionally 'weight'
         """
-        adj_list = self.db.get(f"adj:{node_id}")
-        if adj_list:
-            return json.loads(adj_list)
-        return []
+        node = self._ids.get(node_id)
+        if node is None:
+            return []
+        
+        nodes, weights = self._graph.neighbors(node)
+        if self.weighted:
+            return [{"to": self._names[n], "weight": w} for n, w in zip(nodes, weights)]
+        return [{"to": self._names[n]} for n in nodes]
     
     def get_all_edges(self) -> List[Tuple[str, str, Optional[float]]]:
         """
@@ -303,24 +433,17 @@ class GraphDB:
             List of tuples (from_node, to_node, weight)
         """
         edges = []
-        seen = set()
         
-        for key in self.db.keys():
-            if key.startswith("edge:"):
-                parts = key.split(":")
-                if len(parts) >= 3:
-                    from_node, to_node = parts[1], parts[2]
-                    
-                    # For undirected graphs, avoid duplicates
-                    if not self.directed:
-                        edge_tuple = tuple(sorted([from_node, to_node]))
-                        if edge_tuple in seen:
-                            continue
-                        seen.add(edge_tuple)
-                    
-                    edge_data = json.loads(self.db.get(key))
-                    weight = edge_data.get("weight") if self.weighted else None
-                    edges.append((from_node, to_node, weight))
+        for u, from_node in enumerate(self._names):
+            if from_node is None:
+                continue
+            
+            nodes, weights = self._graph.neighbors(u)
+            for v, weight in zip(nodes, weights):
+                # For undirected graphs, report each pair once, from its lower ID
+                if not self.directed and v < u:
+                    continue
+                edges.append((from_node, self._names[v], weight if self.weighted else None))
         
         return edges
     
@@ -332,10 +455,14 @@ class GraphDB:
         """
         Breadth-First Search traversal
         
+        Without a target the whole reachable graph is traversed by the
+        parallel kernel (see bfs_tree), and nodes at the same distance are
+        listed in the order they were added rather than in queue order.
+        
         Args:
             start_node: Starting node
             target_node: Optional target node (stops when found)
-            
+        
         Returns:
             Dictionary with:
             - 'visited': List of nodes in BFS order
@@ -346,49 +473,59 @@ class GraphDB:
         if not self.node_exists(start_node):
             return {"visited": [], "found": False, "path": [], "distances": {}}
         
-        visited = []
-        queue = deque([start_node])
-        visited_set = {start_node}
-        parent = {start_node: None}
-        distances = {start_node: 0}
+        if not target_node:
+            tree = self.bfs_tree(start_node)
+            names, dist = tree["nodes"], tree["distance"]
+            visited = [names[n] for n in tree["order"]]
+            return {
+                "visited": visited,
+                "found": True,
+                "path": [],
+                "distances": {names[n]: dist[n] for n in tree["order"]}
+            }
         
-        while queue:
-            current = queue.popleft()
-            visited.append(current)
-            
-            # Check if we found the target
-            if target_node and current == target_node:
-                path = self._reconstruct_path(parent, start_node, target_node)
-                return {
-                    "visited": visited,
-                    "found": True,
-                    "path": path,
-                    "distances": distances
-                }
-            
-            # Visit neighbors
-            neighbors = self.get_neighbors(current)
-            for neighbor_info in neighbors:
-                neighbor = neighbor_info['to']
-                
-                if neighbor not in visited_set:
-                    visited_set.add(neighbor)
-                    queue.append(neighbor)
-                    parent[neighbor] = current
-                    distances[neighbor] = distances[current] + 1
+        start = self._ids[start_node]
+        target = self._ids.get(target_node, NO_NODE) if target_node else NO_NODE
+        order, visited, parent, dist = self._graph.bfs(start, target)
         
-        # Build path if target was specified
-        path = []
-        if target_node and target_node in parent:
-            path = self._reconstruct_path(parent, start_node, target_node)
+        # The target was dequeued if and only if it was discovered
+        found = target != NO_NODE and dist[target] >= 0
+        path = self._native_path(parent, start, target) if found else []
         
         return {
-            "visited": visited,
-            "found": target_node in visited_set if target_node else True,
+            "visited": [self._names[n] for n in order[:visited]],
+            "found": found,
             "path": path,
-            "distances": distances
+            "distances": {self._names[n]: dist[n] for n in order}
         }
     
+    def bfs_tree(self, start_node: str) -> Dict[str, Any]:
+        """
+        Whole-graph BFS as flat arrays, for reachability over large graphs
+        
+        Runs on the native direction-optimizing kernel, split across worker
+        threads for large graphs. Arrays are indexed by node index; use
+        'nodes' to map indices to node IDs.
+        
+        Args:
+            start_node: Starting node
+        
+        Returns:
+            Dictionary with:
+            - 'nodes': Node ID for each index (None for deleted nodes)
+            - 'order': Indices of the reached nodes, by distance
+            - 'parent': Index of a node one hop closer to the start
+              (NO_NODE for the start and unreached nodes)
+            - 'distance': Hops from the start (-1 if unreachable)
+        """
+        if not self.node_exists(start_node):
+            empty = memoryview(b'').cast('I')
+            return {"nodes": list(self._names), "order": empty, "parent": empty,
+                    "distance": memoryview(b'').cast('i')}
+        
+        order, parent, dist = self._graph.bfs_tree(self._ids[start_node])
+        return {"nodes": list(self._names), "order": order, "parent": parent, "distance": dist}
+    
     def dfs(self, start_node: str, target_node: Optional[str] = None) -> Dict[str, Any]:
         """
         Depth-First Search traversal
@@ -396,7 +533,7 @@ class GraphDB:
         Args:
             start_node: Starting node
             target_node: Optional target node (stops when found)
-            
+        
         Returns:
             Dictionary with:
             - 'visited': List of nodes in DFS order
@@ -406,63 +543,38 @@ class GraphDB:
         if not self.node_exists(start_node):
             return {"visited": [], "found": False, "path": []}
         
-        visited = []
-        visited_set = set()
-        parent = {}
-        
-        def dfs_recursive(node):
-            visited.append(node)
-            visited_set.add(node)
-            
-            # Check if we found the target
-            if target_node and node == target_node:
-                return True
-            
-            # Visit neighbors
-            neighbors = self.get_neighbors(node)
-            for neighbor_info in neighbors:
-                neighbor = neighbor_info['to']
-                
-                if neighbor not in visited_set:
-                    parent[neighbor] = node
-                    if dfs_recursive(neighbor):
-                        return True
-            
-            return False
-        
-        found = dfs_recursive(start_node)
-        parent[start_node] = None
+        start = self._ids[start_node]
+        target = self._ids.get(target_node, NO_NODE) if target_node else NO_NODE
+        order, found, parent = self._graph.dfs(start, target)
         
         # Build path if target was specified
-        path = []
-        if target_node and target_node in parent:
-            path = self._reconstruct_path(parent, start_node, target_node)
+        path = self._native_path(parent, start, target) if found else []
         
         return {
-            "visited": visited,
+            "visited": [self._names[n] for n in order],
             "found": found if target_node else True,
             "path": path
         }
     
-    def _reconstruct_path(self, parent: Dict[str, Optional[str]], 
-                         start: str, end: str) -> List[str]:
-        """Reconstruct path from parent dictionary"""
+    def _native_path(self, parent, start: int, end: int) -> List[str]:
+        """Reconstruct a path of node names from an engine parent array"""
         path = []
         current = end
         
-        while current is not None:
-            path.append(current)
-            current = parent.get(current)
+        while current != NO_NODE:
+            path.append(self._names[current])
+            current = parent[current]
         
         path.reverse()
         
         # Verify path starts at start node
-        if path and path[0] == start:
+        if path and path[0] == self._names[start]:
             return path
         return []
     
     def find_all_paths(self, start_node: str, end_node: str, 
-                      max_length: Optional[int] = None) -> List[List[str]]:
+                      max_length: Optional[int] = None, max_cost: Optional[float] = None,
+                      max_results: Optional[int] = None) -> List[List[str]]:
         """
         Find all paths between two nodes
         
@@ -470,45 +582,85 @@ class GraphDB:
             start_node: Starting node
             end_node: Ending node
             max_length: Maximum path length (None for unlimited)
-            
+            max_cost: Maximum total edge weight (None for unlimited)
+            max_results: Stop after this many paths (None for unlimited)
+        
         Returns:
             List of paths (each path is a list of nodes)
         """
-        all_paths = []
+        return list(self.iter_paths(start_node, end_node, max_length, max_cost, max_results))
+    
+    def iter_paths(self, start_node: str, end_node: str,
+                   max_length: Optional[int] = None, max_cost: Optional[float] = None,
+                   max_results: Optional[int] = None) -> Iterator[List[str]]:
+        """
+        Yield the paths between two nodes one at a time, in find_all_paths order
         
-        def dfs_paths(current, target, path, visited):
-            if max_length and len(path) > max_length:
-                return
-            
-            if current == target:
-                all_paths.append(path.copy())
-                return
-            
-            neighbors = self.get_neighbors(current)
-            for neighbor_info in neighbors:
-                neighbor = neighbor_info['to']
-                
-                if neighbor not in visited:
-                    visited.add(neighbor)
-                    path.append(neighbor)
-                    dfs_paths(neighbor, target, path, visited)
-                    path.pop()
-                    visited.remove(neighbor)
+        The search runs iteratively in the native engine, so memory stays
+        flat however many paths exist and deep graphs don't hit Python's
+        recursion limit. Stop iterating to end the search.
         
-        if self.node_exists(start_node) and self.node_exists(end_node):
-            dfs_paths(start_node, end_node, [start_node], {start_node})
+        Args:
+            start_node: Starting node
+            end_node: Ending node
+            max_length: Maximum nodes per path, endpoints included (None for unlimited)
+            max_cost: Maximum total edge weight; weights must not be negative
+            max_results: Stop after this many paths (None for unlimited)
         
-        return all_paths
+        Yields:
+            Paths as lists of nodes
+        
+        Raises:
+            RuntimeError: If the graph changes during iteration
+        """
+        if not self.node_exists(start_node) or not self.node_exists(end_node):
+            return
+        
+        if max_results is not None and max_results <= 0:
+            return
+        
+        start, end = self._ids[start_node], self._ids[end_node]
+        names = self._names
+        paths = self._graph.paths(start, end, max_length or 0,
+                                  float('inf') if max_cost is None else max_cost)
+        for count, (path, _) in enumerate(paths, 1):
+            yield [names[node] for node in path]
+            if count == max_results:
+                paths.close()
+                return
     
-    def shortest_path(self, start_node: str, end_node: str) -> Dict[str, Any]:
+    def shortest_path(self, start_node: str, end_node: str, algorithm: str = "dijkstra",
+                      heuristic: Union[Callable[[str, str], float],
+                                       Mapping[str, Tuple[float, float]],
+                                       Coordinates, None] = None
+                      ) -> Dict[str, Any]:
         """
         Find shortest path between two nodes (unweighted or weighted)
         
+        Args:
+            start_node: Starting node
+            end_node: Target node
+            algorithm: For weighted graphs, 'dijkstra', 'bidirectional'
+                (searches from both ends) or 'astar'
+            heuristic: For 'astar', a function (node, target) -> float that
+                never overestimates the remaining cost, or a mapping of node
+                to (x, y) for a straight-line estimate (edge weights must be
+                at least the distance between their ends). Pass the mapping
+                through coordinates() first to reuse it across queries.
+        
         Returns:
             Dictionary with 'path' and 'distance'
+        
+        Raises:
+            ValueError: On an unknown algorithm, or 'astar' without a heuristic
         """
+        if algorithm not in ("dijkstra", "bidirectional", "astar"):
+            raise ValueError(f"Unknown shortest path algorithm: {algorithm}")
+        if algorithm == "astar" and heuristic is None:
+            raise ValueError("A* needs a heuristic")
+        
         if self.weighted:
-            return self._dijkstra(start_node, end_node)
+            return self._dijkstra(start_node, end_node, algorithm, heuristic)
         else:
             result = self.bfs(start_node, end_node)
             return {
@@ -516,45 +668,40 @@ class GraphDB:
                 "distance": len(result["path"]) - 1 if result["path"] else float('inf')
             }
     
-    def _dijkstra(self, start_node: str, end_node: str) -> Dict[str, Any]:
-        """Dijkstra's algorithm for weighted shortest path"""
-        import heapq
-        
-        distances = {node: float('inf') for node in self.get_all_nodes()}
-        distances[start_node] = 0
-        parent = {start_node: None}
-        pq = [(0, start_node)]
-        visited = set()
-        
-        while pq:
-            current_dist, current = heapq.heappop(pq)
-            
-            if current in visited:
-                continue
-            
-            visited.add(current)
-            
-            if current == end_node:
-                break
-            
-            neighbors = self.get_neighbors(current)
-            for neighbor_info in neighbors:
-                neighbor = neighbor_info['to']
-                weight = neighbor_info.get('weight', 1.0)
-                distance = current_dist + weight
-                
-                if distance < distances[neighbor]:
-                    distances[neighbor] = distance
-                    parent[neighbor] = current
-                    heapq.heappush(pq, (distance, neighbor))
-        
-        path = self._reconstruct_path(parent, start_node, end_node)
+    def _dijkstra(self, start_node: str, end_node: str, algorithm: str = "dijkstra",
+                  heuristic=None) -> Dict[str, Any]:
+        """Weighted shortest path on the native engine's heap-based searches"""
+        if not self.node_exists(start_node) or not self.node_exists(end_node):
+            return {"path": [], "distance": float('inf')}
+        
+        start, end = self._ids[start_node], self._ids[end_node]
+        if algorithm == "astar":
+            if isinstance(heuristic, Coordinates):
+                path, cost = self._graph.astar(start, end, heuristic)
+            elif callable(heuristic):
+                names = self._names
+                path, cost = self._graph.astar(
+                    start, end, lambda node, target: heuristic(names[node], names[target]))
+            else:
+                path, cost = self._graph.astar(start, end, self.coordinates(heuristic))
+        else:
+            path, cost = self._graph.shortest_path(start, end,
+                                                   bidirectional=algorithm == "bidirectional")
         
         return {
-            "path": path,
-            "distance": distances[end_node]
+            "path": [self._names[node] for node in path],
+            "distance": cost
         }
     
+    def coordinates(self, positions: Mapping[str, Tuple[float, float]]) -> Coordinates:
+        """
+        Prepare node positions for A* (see shortest_path)
+        
+        Nodes without a position, or added later, get a zero estimate.
+        """
+        return Coordinates([positions.get(name) if name is not None else None
+                            for name in self._names])
+    
     # ========================================================================
     # Search and Query Operations
     # ========================================================================
@@ -565,7 +712,7 @@ class GraphDB:
         
         Args:
             predicate: Function that takes (node_id, node_data) and returns bool
-            
+        
         Returns:
             List of matching node IDs
         """
@@ -578,6 +725,91 @@ class GraphDB:
         
         return matching
     
+    def find_where(self, conditions: Optional[Mapping[str, Any]] = None,
+                   **kwargs: Any) -> List[str]:
+        """
+        Find nodes whose data matches every condition
+        
+        Scalar properties are filtered natively: each condition scans one
+        typed column with SIMD compares and ANDs into a bitmap of node
+        IDs, so no Python code runs per node. Conditions on properties
+        that mix types (or hold lists, dicts or nulls), ranges of strings and IN
+        on float properties are then checked in Python on the nodes left.
+        
+        Args:
+            conditions: Property name -> condition, as for kwargs
+            **kwargs: name=value (equality), name=(lo, hi) (inclusive
+                range, None for an open end) or name=[v1, v2, ...] (any
+                of; also a set or frozenset)
+        
+        Returns:
+            Sorted list of matching node IDs
+        
+        Example:
+            graph.find_where(city="NYC", age=(30, None))
+        """
+        wanted = dict(conditions or {}, **kwargs)
+        if self._columns_stale:
+            self._build_columns()
+        
+        bits = self._graph.bitmap()
+        filtered = False
+        slow = []
+        for name, condition in wanted.items():
+            column = self._columns.get(name)
+            if column is None and name not in self._mixed:
+                return []   # No node has a value for it
+            count = self._native_filter(column, condition, bits, filtered) if column else None
+            if count is None:
+                slow.append((name, condition))
+                continue
+            filtered = True
+            if count == 0:
+                return []
+        
+        if filtered:
+            names = [self._names[node] for node in self._graph.bitmap_nodes(bits, count)]
+        else:
+            names = list(self._ids)
+        if slow:
+            data = self.db.mget(f"node:{name}" for name in names)
+            names = [name for name, item in zip(names, data)
+                     if all(_condition_holds(json.loads(item), key, condition)
+                            for key, condition in slow)]
+        return sorted(names)
+    
+    def _native_filter(self, column: Tuple[int, int], condition: Any, bits,
+                       intersect: bool) -> Optional[int]:
+        """Apply one condition to bits in the engine; None if it must run in Python"""
+        column_id, kind = column
+        g = self._graph
+        if isinstance(condition, tuple):
+            if len(condition) != 2:
+                raise ValueError("A range condition is a (lo, hi) pair")
+            lo, hi = condition
+            if kind == PROP_STRING or isinstance(lo, str) or isinstance(hi, str):
+                return None
+            if kind == PROP_DOUBLE:
+                return g.filter_double_range(column_id, -math.inf if lo is None else float(lo),
+                                             math.inf if hi is None else float(hi), bits, intersect)
+            return g.filter_int_range(column_id, INT64_MIN if lo is None else math.ceil(lo),
+                                      INT64_MAX if hi is None else math.floor(hi), bits, intersect)
+        
+        values = list(condition) if isinstance(condition, (list, set, frozenset)) else [condition]
+        if kind == PROP_STRING:
+            return g.filter_string_in(column_id, [v for v in values if isinstance(v, str)],
+                                      bits, intersect)
+        numbers = [v for v in values if isinstance(v, (int, float)) and not isinstance(v, str)]
+        if kind == PROP_DOUBLE:
+            if len(numbers) != 1:
+                return None
+            return g.filter_double_range(column_id, float(numbers[0]), float(numbers[0]),
+                                         bits, intersect)
+        ints = [int(v) for v in numbers
+                if (isinstance(v, int) or math.isfinite(v) and v.is_integer())
+                and INT64_MIN <= v <= INT64_MAX]
+        return g.filter_int_in(column_id, ints, bits, intersect)
+    
     def get_degree(self, node_id: str) -> Dict[str, int]:
         """
         Get degree of a node
@@ -585,14 +817,12 @@ class GraphDB:
         Returns:
             Dictionary with 'in_degree', 'out_degree', 'total'
         """
-        out_degree = len(self.get_neighbors(node_id))
+        node = self._ids.get(node_id)
+        if node is None:
+            return {"in_degree": 0, "out_degree": 0, "total": 0}
         
-        # Count in-degree
-        in_degree = 0
-        for node in self.get_all_nodes():
-            neighbors = self.get_neighbors(node)
-            if any(n['to'] == node_id for n in neighbors):
-                in_degree += 1
+        out_degree = self._graph.out_degree(node)
+        in_degree = self._graph.in_degree(node)
         
         return {
             "in_degree": in_degree,
@@ -600,6 +830,30 @@ class GraphDB:
             "total": in_degree + out_degree
         }
     
+    def get_component(self, node_id: str) -> Optional[str]:
+        """
+        Name the weakly connected component a node belongs to
+        
+        Returns:
+            The component's earliest-added node (the same for every member),
+            or None if the node doesn't exist
+        """
+        node = self._ids.get(node_id)
+        if node is None:
+            return None
+        return self._names[self._graph.component(node)]
+    
+    def get_degrees(self) -> Dict[str, Any]:
+        """
+        Get the degree of every node at once, in one native call
+        
+        Returns:
+            Dictionary with 'nodes' (node ID per index, None for deleted
+            nodes) and 'in_degree' / 'out_degree' arrays indexed alike
+        """
+        out_degree, in_degree = self._graph.degrees()
+        return {"nodes": list(self._names), "in_degree": in_degree, "out_degree": out_degree}
+    
     # ========================================================================
     # Import/Export Operations
     # ========================================================================
@@ -624,16 +878,10 @@ class GraphDB:
         try:
             graph_data = json.loads(json_str)
             
-            # Clear existing graph
-            self.db.clear()
-            
-            # Set metadata
+            # Clear existing graph and set metadata
             self.directed = graph_data.get("directed", True)
             self.weighted = graph_data.get("weighted", False)
-            self.db.set("__meta__:directed", str(self.directed))
-            self.db.set("__meta__:weighted", str(self.weighted))
-            self.db.set("__meta__:node_count", "0")
-            self.db.set("__meta__:edge_count", "0")
+            self._reset()
             
             # Import nodes
             for node in graph_data.get("nodes", []):
@@ -645,7 +893,7 @@ class GraphDB:
                 self.add_edge(edge["from"], edge["to"], weight)
             
             return True
-            
+        
         except Exception as e:
             print(f"Error importing JSON: {e}")
             return False
@@ -656,7 +904,7 @@ class GraphDB:
         
         Args:
             pretty: Pretty print JSON
-            
+        
         Returns:
             JSON string representation of the graph
         """
@@ -686,6 +934,103 @@ class GraphDB:
             return json.dumps(graph_data, indent=2)
         return json.dumps(graph_data)
     
+    def import_from_json_file(self, source: Union[str, os.PathLike, TextIO],
+                              chunk_size: int = 1 << 20) -> bool:
+        """
+        Import graph from a JSON file without loading the whole document
+        
+        Same format as import_from_json. Nodes and edges are added as they
+        are parsed, so memory use doesn't grow with the file; "directed"
+        and "weighted" must come before them (export_to_json writes them
+        first).
+        
+        Args:
+            source: File path or open text file
+            chunk_size: Characters read at a time
+        
+        Returns:
+            True on success, False on error (message printed)
+        """
+        try:
+            if isinstance(source, (str, os.PathLike)):
+                with open(source, encoding="utf-8") as fp:
+                    self._import_json_events(_json_events(fp, chunk_size))
+            else:
+                self._import_json_events(_json_events(source, chunk_size))
+            return True
+        
+        except Exception as e:
+            print(f"Error importing JSON: {e}")
+            return False
+    
+    def _import_json_events(self, events):
+        """Apply _json_events output to an emptied graph"""
+        self.directed, self.weighted = True, False
+        self._reset()
+        started = False
+        
+        for kind, key, item in events:
+            if kind == "item":
+                started = True
+                if key == "nodes":
+                    self.add_node(item["id"], item.get("data", {}))
+                else:
+                    self.add_edge(item["from"], item["to"], item.get("weight", 1.0))
+            elif key in ("directed", "weighted"):
+                if started and item != getattr(self, key):
+                    raise ValueError(f'"{key}" must come before nodes and edges')
+                setattr(self, key, item)
+                self._reset()
+    
+    def save(self, path: str):
+        """
+        Write the graph to a binary graph file (atomically replaced)
+        
+        The file holds node names and data as string tables, edges as
+        delta-encoded varint rows and weights as a column; GraphDB.load
+        maps it straight into the engine. Deleted nodes leave no gaps.
+        
+        Raises:
+            OSError: If the file cannot be written
+        """
+        names = [name for name in self._names if name is not None]
+        packed_names = ("\0".join(names) + "\0").encode("utf-8") if names else b""
+        data = self.db.mget(f"node:{name}" for name in names)
+        packed_data = ("\0".join(data) + "\0").encode("utf-8") if names else b""
+        flags = (FILE_DIRECTED if self.directed else 0) | (FILE_WEIGHTED if self.weighted else 0)
+        self._graph.save(path, [packed_names, packed_data], flags)
+    
+    @classmethod
+    def load(cls, path: str) -> 'GraphDB':
+        """
+        Open a graph written by save()
+        
+        Edges are decoded by the engine from the mapped file and node data
+        goes to SimpleDB in one batch, with no JSON parsing.
+        
+        Raises:
+            OSError: If the file is missing or not a graph file
+            ValueError: If its contents are corrupt
+        """
+        with GraphFile(path) as f:
+            info = f.info
+            if info.table_count != 2:
+                raise ValueError(f"Not a GraphDB file: {path}")
+            graph = cls(bool(info.flags & FILE_DIRECTED), bool(info.flags & FILE_WEIGHTED))
+            f.load_into(graph._graph)
+            names = f.strings(0)
+            keys = ("\0".join(f"node:{name}" for name in names) + "\0").encode("utf-8")
+            graph.db.mset_packed(keys, f.table(1), len(names))
+        
+        graph._names = names
+        graph._ids = {name: node for node, name in enumerate(names)}
+        graph._columns_stale = True
+        if graph.directed:
+            graph._edge_count = info.edges
+        else:
+            graph._edge_count = (info.edges + info.self_loops) // 2
+        return graph
+    
     def import_from_adjacency_list(self, text: str) -> bool:
         """
         Import graph from adjacency list format
@@ -699,11 +1044,7 @@ class GraphDB:
         A -> B(1.5), C(2.0)
         """
         try:
-            self.db.clear()
-            self.db.set("__meta__:directed", str(self.directed))
-            self.db.set("__meta__:weighted", str(self.weighted))
-            self.db.set("__meta__:node_count", "0")
-            self.db.set("__meta__:edge_count", "0")
+            self._reset()
             
             lines = text.strip().split('\n')
             
@@ -743,7 +1084,7 @@ class GraphDB:
                             self.add_edge(from_node, to_node, weight)
             
             return True
-            
+        
         except Exception as e:
             print(f"Error importing adjacency list: {e}")
             return False
@@ -780,10 +1121,17 @@ class GraphDB:
     # ========================================================================
     
     def get_stats(self) -> Dict[str, Any]:
-        """Get graph statistics"""
+        """
+        Get graph statistics
+        
+        Every figure is kept up to date as the graph changes, so this is
+        cheap to poll. 'components' counts weakly connected components;
+        after a delete the first call relabels the graph once.
+        """
         return {
-            "nodes": int(self.db.get("__meta__:node_count") or "0"),
-            "edges": int(self.db.get("__meta__:edge_count") or "0"),
+            "nodes": len(self._ids),
+            "edges": self._edge_count,
+            "components": self._graph.component_count(),
             "directed": self.directed,
             "weighted": self.weighted,
             "db_entries": self.db.count()
@@ -849,6 +1197,14 @@ if __name__ == "__main__":
     print(f"  Path: {dfs_result['path']}")
     print()
     
+    # Whole-graph reachability as flat arrays
+    print("BFS tree from A:")
+    tree = graph.bfs_tree("A")
+    print(f"  Distances: {dict(zip(tree['nodes'], tree['distance'].tolist()))}")
+    degrees = graph.get_degrees()
+    print(f"  In-degrees: {dict(zip(degrees['nodes'], degrees['in_degree'].tolist()))}")
+    print()
+    
     # Find all paths
     print("All paths from A to E:")
     all_paths = graph.find_all_paths("A", "E")
@@ -856,6 +1212,16 @@ if __name__ == "__main__":
         print(f"  Path {i}: {' -> '.join(path)}")
     print()
     
+    # Property filters over the engine's typed columns
+    print("Property filters:")
+    people = GraphDB()
+    for name, age, city in [("ann", 34, "NYC"), ("bob", 27, "LA"), ("cy", 45, "NYC"),
+                            ("dee", 31, "SF")]:
+        people.add_node(name, {"age": age, "city": city})
+    print(f"  age 30..40: {people.find_where(age=(30, 40))}")
+    print(f"  city in NYC, SF and age >= 40: {people.find_where(city=['NYC', 'SF'], age=(40, None))}")
+    print()
+    
     # Export to JSON
     print("Exporting to JSON...")
     json_export = graph.export_to_json()
@@ -887,6 +1253,8 @@ if __name__ == "__main__":
     shortest = weighted_graph.shortest_path("A", "E")
     print(f"  Path: {' -> '.join(shortest['path'])}")
     print(f"  Total weight: {shortest['distance']}")
+    bidirectional = weighted_graph.shortest_path("A", "E", "bidirectional")
+    print(f"  Bidirectional search: {bidirectional['distance']}")
     print()
     
     # Graph statistics
@@ -894,3 +1262,13 @@ if __name__ == "__main__":
     stats = weighted_graph.get_stats()
     for key, value in stats.items():
         print(f"  {key}: {value}")
+    print()
+    
+    # Binary graph file round trip
+    import tempfile
+    path = os.path.join(tempfile.gettempdir(), f"graph_db_demo_{os.getpid()}.wgb")
+    weighted_graph.save(path)
+    loaded = GraphDB.load(path)
+    os.remove(path)
+    print(f"Saved to a binary graph file and loaded back: {loaded}")
+    print(f"  Same shortest path: {loaded.shortest_path('A', 'E') == shortest}")
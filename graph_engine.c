@@ -0,0 +1,3511 @@
+/*
+ * Native Graph Engine in C
+ *
+ * Features:
+ * - Integer node IDs, directed weighted edges, out- and in-adjacency
+ * - Compressed sparse row (CSR) arrays for the settled graph, plus a
+ *   per-node delta of recent additions and a tombstone bitmap for
+ *   deletions; compaction folds both back into fresh CSR arrays
+ * - O(1) edge lookup through a hash index of (from, to) pairs
+ * - BFS and DFS kernels writing into caller-provided arrays
+ * - Direction-optimizing BFS (top-down/bottom-up over queue and bitmap
+ *   frontiers) and degree kernels split across a worker thread pool
+ * - Shortest paths: Dijkstra on an indexed binary heap with decrease-key,
+ *   bidirectional Dijkstra and A*, on workspaces reused across queries
+ * - Streaming enumeration of simple paths on an explicit stack, with
+ *   length and cost cutoffs
+ * - Binary graph files (varint CSR rows, a weight column, string tables)
+ *   loaded from a memory mapping
+ * - Degree counters and weakly connected components kept up to date as
+ *   the graph changes (union-find, relabelled lazily after deletes)
+ * - Typed node property columns (int64, double, dictionary-encoded
+ *   strings) with SIMD range and IN filters producing node bitmaps
+ * - Python FFI compatible (graph_engine_python.py, used by graph_db.py)
+ *
+ * Compile as shared library:
+ * gcc -shared -fPIC -pthread -Wall -Wextra -g -O2 graph_engine.c -o libgraphengine.so -lm
+ *
+ * Or on macOS:
+ * gcc -shared -fPIC -pthread -Wall -Wextra -g -O2 graph_engine.c -o libgraphengine.dylib
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph_engine.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+#define INITIAL_NODE_CAPACITY 64  // Node slots allocated by the first add
+#define DELTA_INITIAL 4           // First allocation of a node's delta list
+#define COMPACT_MIN_EDITS 1024    // Never compact for fewer pending edits
+#define INDEX_MIN_CAPACITY 64     // Smallest edge index (power of two)
+#define MAX_THREADS 64            // Upper bound on traversal workers
+#define PARALLEL_MIN_NODES 16384  // Smaller graphs stay on the calling thread
+#define TOP_DOWN_CHUNK 64         // Frontier nodes claimed at a time
+#define BOTTOM_UP_CHUNK 4096      // Node IDs claimed at a time (multiple of 64)
+#define LOCAL_QUEUE 256           // Discoveries buffered before publishing
+#define BFS_ALPHA 14              // Go bottom-up when frontier edges > unexplored / ALPHA
+#define BFS_BETA 24               // Go top-down when frontier nodes < nodes / BETA
+#define PROP_MIN_CAPACITY 64      // First allocation of a property column (multiple of 64)
+#define DICT_MIN_CAPACITY 16      // First allocation of a string dictionary
+#define PROP_IN_SIMD_MAX 8        // Larger IN lists use a sorted list or code bitmap
+
+// ============================================================================
+// DATA STRUCTURES
+// ============================================================================
+
+// One direction of the settled adjacency in CSR form: the neighbors of
+// node u are targets[offsets[u] .. offsets[u + 1]) with matching weights,
+// in insertion order. Only nodes below `rows` have a row. Deleted edges
+// stay in place with their bit set in `dead` until the next compaction.
+typedef struct Csr {
+    size_t rows;
+    size_t edges;           // Slots, dead ones included
+    size_t dead_count;
+    uint64_t *offsets;      // rows + 1
+    uint32_t *targets;
+    double *weights;
+    uint64_t *dead;         // One bit per slot
+} Csr;
+
+// Edges added to one node since the last compaction, in insertion order
+typedef struct EdgeList {
+    uint32_t *nodes;
+    double *weights;
+    uint32_t count;
+    uint32_t cap;
+} EdgeList;
+
+// One adjacency direction: the CSR arrays with the delta on top
+typedef struct Adjacency {
+    Csr csr;
+    EdgeList *delta;        // node_cap lists
+    size_t delta_edges;
+} Adjacency;
+
+// Open-addressing map from an edge to its weight. Keys are
+// (from << 32 | to) + 1, so 0 can mark an empty slot.
+#define INDEX_EMPTY 0
+#define INDEX_DELETED UINT64_MAX
+
+typedef struct EdgeIndex {
+    uint64_t *keys;
+    double *weights;
+    size_t cap;             // Power of two
+    size_t used;            // Live keys plus tombstones
+} EdgeIndex;
+
+// Persistent helper threads for the parallel kernels; the calling thread
+// joins in as worker 0
+typedef void (*PoolTask)(void *arg, unsigned worker);
+
+typedef struct WorkerPool {
+    pthread_t *threads;
+    unsigned count;             // Workers, the caller included
+    unsigned next_index;        // Hands helpers their worker numbers
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    pthread_mutex_t run_lock;   // One task at a time
+    PoolTask task;
+    void *arg;
+    uint64_t generation;        // Bumped for every task
+    unsigned running;           // Helpers still inside the current task
+    bool stop;
+} WorkerPool;
+
+// Shortest-path state for one search direction. Entries are valid only
+// where stamp[v] equals the workspace epoch, so starting a query is O(1)
+// instead of clearing every array.
+typedef struct HeapEntry {
+    double key;
+    uint32_t node;
+} HeapEntry;
+
+#define HEAP_SETTLED UINT32_MAX  // pos[] value of a settled node
+
+typedef struct PathSide {
+    double *dist;
+    double *estimate;       // A* heuristic, computed once per node
+    uint32_t *parent;       // Previous hop (forward) or next hop (backward)
+    uint32_t *stamp;
+    uint32_t *pos;          // Heap index + 1, 0 if not queued, or HEAP_SETTLED
+    HeapEntry *heap;
+    size_t heap_len;
+} PathSide;
+
+// Everything one query needs, kept between queries so they don't allocate
+typedef struct PathWorkspace {
+    size_t cap;             // Node IDs the arrays cover
+    uint32_t epoch;
+    PathSide side[2];       // Forward, backward
+    struct PathWorkspace *next;
+} PathWorkspace;
+
+// One node property: values indexed by node ID in an array of the
+// column's type (int64_t, double, or uint32_t codes into the string
+// dictionary), and a bit per node ID saying whether it has one
+typedef struct PropColumn {
+    char *name;
+    GraphPropType type;
+    size_t cap;             // Node slots (a power of two, at least 64)
+    uint64_t *present;
+    void *values;
+    char **strings;         // GRAPH_PROP_STRING: code -> string
+    uint32_t string_count;
+    uint32_t string_cap;
+    uint32_t *lookup;       // Open addressing on the string hash: code + 1, 0 empty
+    size_t lookup_cap;      // Power of two, at most half full
+} PropColumn;
+
+struct Graph {
+    size_t node_cap;        // Slots allocated in the per-node arrays
+    size_t node_ids;        // IDs issued so far
+    size_t live_nodes;
+    size_t edges;
+    uint8_t *alive;
+    Adjacency out;
+    Adjacency in;
+    EdgeIndex index;
+    unsigned threads;       // Requested workers, 0 for one per online CPU
+    WorkerPool *pool;       // Started by the first large parallel kernel
+    pthread_mutex_t pool_lock;
+    PathWorkspace *workspaces;  // Idle shortest-path workspaces
+    pthread_mutex_t workspace_lock;
+    uint64_t version;       // Bumped by every change; open path enumerators check it
+    uint32_t *out_degree;   // Live edges per node, node_cap entries each
+    uint32_t *in_degree;
+    uint32_t *component;    // Union-find parents; a root is its component's smallest ID
+    size_t components;
+    bool components_stale;  // A delete may have split one; relabel on next query
+    PropColumn *columns;    // Indexed by column ID
+    size_t column_count;
+};
+
+// Walks one node's adjacency: the live part of its CSR row, then its delta
+typedef struct EdgeCursor {
+    const Adjacency *adj;
+    uint64_t pos;
+    uint64_t end;
+    uint32_t delta_pos;
+    uint32_t node;
+} EdgeCursor;
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+static inline bool bit_test(const uint64_t *bits, uint64_t i) {
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void bit_set(uint64_t *bits, uint64_t i) {
+    bits[i >> 6] |= 1ull << (i & 63);
+}
+
+// Slots in a node's row, dead ones included; cheap enough for heuristics
+static inline size_t row_slots(const Adjacency *adj, uint32_t node) {
+    size_t slots = adj->delta[node].count;
+    if (node < adj->csr.rows) slots += adj->csr.offsets[node + 1] - adj->csr.offsets[node];
+    return slots;
+}
+
+static void cursor_init(EdgeCursor *c, const Adjacency *adj, uint32_t node) {
+    c->adj = adj;
+    c->node = node;
+    c->delta_pos = 0;
+    if (node < adj->csr.rows) {
+        c->pos = adj->csr.offsets[node];
+        c->end = adj->csr.offsets[node + 1];
+    } else {
+        c->pos = c->end = 0;
+    }
+}
+
+static inline bool cursor_next(EdgeCursor *c, uint32_t *node, double *weight) {
+    const Csr *csr = &c->adj->csr;
+    while (c->pos < c->end) {
+        uint64_t i = c->pos++;
+        if (csr->dead_count && bit_test(csr->dead, i)) continue;
+        *node = csr->targets[i];
+        if (weight) *weight = csr->weights[i];
+        return true;
+    }
+    
+    const EdgeList *list = &c->adj->delta[c->node];
+    if (c->delta_pos < list->count) {
+        *node = list->nodes[c->delta_pos];
+        if (weight) *weight = list->weights[c->delta_pos];
+        c->delta_pos++;
+        return true;
+    }
+    return false;
+}
+
+static void csr_free(Csr *csr) {
+    free(csr->offsets);
+    free(csr->targets);
+    free(csr->weights);
+    free(csr->dead);
+    memset(csr, 0, sizeof(*csr));
+}
+
+static void adjacency_free(Adjacency *adj, size_t nodes) {
+    csr_free(&adj->csr);
+    for (size_t i = 0; adj->delta && i < nodes; i++) {
+        free(adj->delta[i].nodes);
+        free(adj->delta[i].weights);
+    }
+    free(adj->delta);
+    adj->delta = NULL;
+    adj->delta_edges = 0;
+}
+
+// Make room for one more edge in a delta list
+static bool list_reserve(EdgeList *list) {
+    if (list->count < list->cap) return true;
+    
+    uint32_t cap = list->cap ? list->cap * 2 : DELTA_INITIAL;
+    uint32_t *nodes = (uint32_t*)realloc(list->nodes, cap * sizeof(uint32_t));
+    if (!nodes) return false;
+    list->nodes = nodes;
+    double *weights = (double*)realloc(list->weights, cap * sizeof(double));
+    if (!weights) return false;
+    list->weights = weights;
+    list->cap = cap;
+    return true;
+}
+
+// Remove `node` from one row, keeping the others in order
+static bool adjacency_remove(Adjacency *adj, uint32_t row, uint32_t node) {
+    Csr *csr = &adj->csr;
+    if (row < csr->rows) {
+        for (uint64_t i = csr->offsets[row]; i < csr->offsets[row + 1]; i++) {
+            if (csr->targets[i] == node && !bit_test(csr->dead, i)) {
+                bit_set(csr->dead, i);
+                csr->dead_count++;
+                return true;
+            }
+        }
+    }
+    
+    EdgeList *list = &adj->delta[row];
+    for (uint32_t i = 0; i < list->count; i++) {
+        if (list->nodes[i] != node) continue;
+        memmove(list->nodes + i, list->nodes + i + 1, (list->count - i - 1) * sizeof(uint32_t));
+        memmove(list->weights + i, list->weights + i + 1, (list->count - i - 1) * sizeof(double));
+        list->count--;
+        adj->delta_edges--;
+        return true;
+    }
+    return false;
+}
+
+// Drop a whole row (its node is being deleted)
+static void adjacency_clear_row(Adjacency *adj, uint32_t row) {
+    Csr *csr = &adj->csr;
+    if (row < csr->rows) {
+        for (uint64_t i = csr->offsets[row]; i < csr->offsets[row + 1]; i++) {
+            if (!bit_test(csr->dead, i)) {
+                bit_set(csr->dead, i);
+                csr->dead_count++;
+            }
+        }
+    }
+    
+    EdgeList *list = &adj->delta[row];
+    adj->delta_edges -= list->count;
+    free(list->nodes);
+    free(list->weights);
+    memset(list, 0, sizeof(*list));
+}
+
+// Build fresh CSR arrays holding every live edge of `adj`, row order kept
+static bool csr_build(Csr *fresh, const Adjacency *adj, size_t rows) {
+    memset(fresh, 0, sizeof(*fresh));
+    fresh->rows = rows;
+    fresh->offsets = (uint64_t*)calloc(rows + 1, sizeof(uint64_t));
+    if (!fresh->offsets) return false;
+    
+    EdgeCursor c;
+    uint32_t node;
+    for (size_t u = 0; u < rows; u++) {
+        uint64_t degree = 0;
+        cursor_init(&c, adj, (uint32_t)u);
+        while (cursor_next(&c, &node, NULL)) degree++;
+        fresh->offsets[u + 1] = fresh->offsets[u] + degree;
+    }
+    
+    fresh->edges = fresh->offsets[rows];
+    size_t slots = fresh->edges ? fresh->edges : 1;
+    fresh->targets = (uint32_t*)malloc(slots * sizeof(uint32_t));
+    fresh->weights = (double*)malloc(slots * sizeof(double));
+    fresh->dead = (uint64_t*)calloc((slots + 63) / 64, sizeof(uint64_t));
+    if (!fresh->targets || !fresh->weights || !fresh->dead) {
+        csr_free(fresh);
+        return false;
+    }
+    
+    uint64_t i = 0;
+    for (size_t u = 0; u < rows; u++) {
+        cursor_init(&c, adj, (uint32_t)u);
+        while (cursor_next(&c, &fresh->targets[i], &fresh->weights[i])) i++;
+    }
+    return true;
+}
+
+// Compact once the pending edits outweigh half the live edges; amortized
+// over those edits this costs O(1) each
+static void maybe_compact(Graph *g) {
+    size_t edits = g->out.delta_edges + g->out.csr.dead_count;
+    if (edits >= COMPACT_MIN_EDITS && edits > g->edges / 2) graph_compact(g);
+}
+
+// ============================================================================
+// EDGE INDEX
+// ============================================================================
+
+static inline uint64_t index_key(uint32_t from, uint32_t to) {
+    return ((uint64_t)from << 32 | to) + 1;
+}
+
+static inline size_t index_home(const EdgeIndex *ix, uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    return (size_t)key & (ix->cap - 1);
+}
+
+// Slot holding key, or SIZE_MAX if absent
+static size_t index_find(const EdgeIndex *ix, uint64_t key) {
+    if (ix->cap == 0) return SIZE_MAX;
+    for (size_t i = index_home(ix, key); ; i = (i + 1) & (ix->cap - 1)) {
+        if (ix->keys[i] == key) return i;
+        if (ix->keys[i] == INDEX_EMPTY) return SIZE_MAX;
+    }
+}
+
+// Rebuild with `cap` slots, dropping tombstones
+static bool index_resize(EdgeIndex *ix, size_t cap) {
+    uint64_t *keys = (uint64_t*)calloc(cap, sizeof(uint64_t));
+    double *weights = (double*)malloc(cap * sizeof(double));
+    if (!keys || !weights) {
+        free(keys);
+        free(weights);
+        return false;
+    }
+    
+    EdgeIndex fresh = { keys, weights, cap, 0 };
+    for (size_t i = 0; i < ix->cap; i++) {
+        uint64_t key = ix->keys[i];
+        if (key == INDEX_EMPTY || key == INDEX_DELETED) continue;
+        size_t j = index_home(&fresh, key);
+        while (keys[j] != INDEX_EMPTY) j = (j + 1) & (cap - 1);
+        keys[j] = key;
+        weights[j] = ix->weights[i];
+        fresh.used++;
+    }
+    
+    free(ix->keys);
+    free(ix->weights);
+    *ix = fresh;
+    return true;
+}
+
+// Make sure one more key can go in at a load of at most one half
+static bool index_reserve(EdgeIndex *ix, size_t live) {
+    if ((ix->used + 1) * 2 <= ix->cap) return true;
+    size_t cap = INDEX_MIN_CAPACITY;
+    while (cap < (live + 1) * 4) cap *= 2;
+    return index_resize(ix, cap);
+}
+
+// Insert or update; index_reserve must have been called
+static void index_put(EdgeIndex *ix, uint64_t key, double weight) {
+    size_t i = index_home(ix, key), tomb = SIZE_MAX;
+    for (; ix->keys[i] != INDEX_EMPTY; i = (i + 1) & (ix->cap - 1)) {
+        if (ix->keys[i] == key) {
+            ix->weights[i] = weight;
+            return;
+        }
+        if (ix->keys[i] == INDEX_DELETED && tomb == SIZE_MAX) tomb = i;
+    }
+    if (tomb != SIZE_MAX) {
+        i = tomb;
+    } else {
+        ix->used++;
+    }
+    ix->keys[i] = key;
+    ix->weights[i] = weight;
+}
+
+static bool index_remove(EdgeIndex *ix, uint64_t key) {
+    size_t i = index_find(ix, key);
+    if (i == SIZE_MAX) return false;
+    ix->keys[i] = INDEX_DELETED;
+    return true;
+}
+
+// ============================================================================
+// THREAD POOL
+// ============================================================================
+
+static void* pool_worker(void *arg) {
+    WorkerPool *pool = (WorkerPool*)arg;
+    unsigned worker = __atomic_add_fetch(&pool->next_index, 1, __ATOMIC_RELAXED);
+    uint64_t seen = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) break;
+        
+        seen = pool->generation;
+        PoolTask task = pool->task;
+        void *task_arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+        
+        task(task_arg, worker);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void pool_destroy(WorkerPool *pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned i = 0; i + 1 < pool->count; i++) pthread_join(pool->threads[i], NULL);
+    
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool);
+}
+
+// Start count - 1 helpers; NULL if not even one could be started
+static WorkerPool* pool_create(unsigned count) {
+    WorkerPool *pool = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+    if (!pool) return NULL;
+    pool->threads = (pthread_t*)calloc(count, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    
+    // count is the caller plus the helpers that actually started
+    pool->count = 1;
+    while (pool->count < count &&
+           pthread_create(&pool->threads[pool->count - 1], NULL, pool_worker, pool) == 0) {
+        pool->count++;
+    }
+    if (pool->count == 1) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// Run task on every worker and wait for all of them
+static void pool_run(WorkerPool *pool, PoolTask task, void *arg) {
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->running = pool->count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    
+    task(arg, 0);
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+static unsigned graph_wanted_threads(const Graph *g) {
+    long threads = g->threads;
+    if (threads == 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    return threads > MAX_THREADS ? MAX_THREADS : (unsigned)threads;
+}
+
+// The pool for a kernel over this graph, or NULL to run on the caller only
+static WorkerPool* graph_pool(Graph *g) {
+    if (g->node_ids < PARALLEL_MIN_NODES) return NULL;
+    
+    pthread_mutex_lock(&g->pool_lock);
+    unsigned wanted = graph_wanted_threads(g);
+    if (!g->pool && wanted > 1) g->pool = pool_create(wanted);
+    WorkerPool *pool = g->pool;
+    pthread_mutex_unlock(&g->pool_lock);
+    return pool;
+}
+
+// Run task on the pool's workers, or just on this thread. Returns the
+// number of workers, which index the task's per-worker slots.
+static unsigned graph_parallel(WorkerPool *pool, PoolTask task, void *arg) {
+    if (!pool) {
+        task(arg, 0);
+        return 1;
+    }
+    pool_run(pool, task, arg);
+    return pool->count;
+}
+
+// ============================================================================
+// SHORTEST-PATH WORKSPACES
+// ============================================================================
+
+static void workspace_free(PathWorkspace *ws) {
+    for (int s = 0; s < 2; s++) {
+        PathSide *side = &ws->side[s];
+        free(side->dist);
+        free(side->estimate);
+        free(side->parent);
+        free(side->stamp);
+        free(side->pos);
+        free(side->heap);
+    }
+    free(ws);
+}
+
+// Cover node IDs below `cap`; new stamps are 0, which no epoch uses
+static bool workspace_grow(PathWorkspace *ws, size_t cap) {
+    if (cap <= ws->cap) return true;
+    
+    for (int s = 0; s < 2; s++) {
+        PathSide *side = &ws->side[s];
+        double *dist = (double*)realloc(side->dist, cap * sizeof(double));
+        if (dist) side->dist = dist;
+        double *estimate = (double*)realloc(side->estimate, cap * sizeof(double));
+        if (estimate) side->estimate = estimate;
+        uint32_t *parent = (uint32_t*)realloc(side->parent, cap * sizeof(uint32_t));
+        if (parent) side->parent = parent;
+        uint32_t *pos = (uint32_t*)realloc(side->pos, cap * sizeof(uint32_t));
+        if (pos) side->pos = pos;
+        HeapEntry *heap = (HeapEntry*)realloc(side->heap, cap * sizeof(HeapEntry));
+        if (heap) side->heap = heap;
+        uint32_t *stamp = (uint32_t*)realloc(side->stamp, cap * sizeof(uint32_t));
+        if (stamp) {
+            memset(stamp + ws->cap, 0, (cap - ws->cap) * sizeof(uint32_t));
+            side->stamp = stamp;
+        }
+        if (!dist || !estimate || !parent || !pos || !heap || !stamp) return false;
+    }
+    ws->cap = cap;
+    return true;
+}
+
+// Take an idle workspace (or make one) sized for the current graph and
+// start a new epoch on it
+static PathWorkspace* workspace_acquire(Graph *g) {
+    pthread_mutex_lock(&g->workspace_lock);
+    PathWorkspace *ws = g->workspaces;
+    if (ws) g->workspaces = ws->next;
+    pthread_mutex_unlock(&g->workspace_lock);
+    
+    if (!ws) {
+        ws = (PathWorkspace*)calloc(1, sizeof(PathWorkspace));
+        if (!ws) return NULL;
+    }
+    if (!workspace_grow(ws, g->node_ids)) {
+        workspace_free(ws);
+        return NULL;
+    }
+    
+    if (++ws->epoch == UINT32_MAX) {
+        memset(ws->side[0].stamp, 0, ws->cap * sizeof(uint32_t));
+        memset(ws->side[1].stamp, 0, ws->cap * sizeof(uint32_t));
+        ws->epoch = 1;
+    }
+    ws->side[0].heap_len = ws->side[1].heap_len = 0;
+    return ws;
+}
+
+static void workspace_release(Graph *g, PathWorkspace *ws) {
+    pthread_mutex_lock(&g->workspace_lock);
+    ws->next = g->workspaces;
+    g->workspaces = ws;
+    pthread_mutex_unlock(&g->workspace_lock);
+}
+
+// ============================================================================
+// COMPONENTS
+// ============================================================================
+
+// Root of node's set, halving the path on the way
+static uint32_t component_find(Graph *g, uint32_t node) {
+    uint32_t *parent = g->component;
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+// Merge the sets of a and b under the smaller root
+static void component_union(Graph *g, uint32_t a, uint32_t b) {
+    a = component_find(g, a);
+    b = component_find(g, b);
+    if (a == b) return;
+    if (a < b) {
+        g->component[b] = a;
+    } else {
+        g->component[a] = b;
+    }
+    g->components--;
+}
+
+// Rebuild the sets from every edge, after deletes
+static void component_refresh(Graph *g) {
+    if (!g->components_stale) return;
+    
+    for (size_t u = 0; u < g->node_ids; u++) g->component[u] = (uint32_t)u;
+    g->components = g->live_nodes;
+    g->components_stale = false;
+    
+    EdgeCursor c;
+    uint32_t v;
+    for (size_t u = 0; u < g->node_ids; u++) {
+        if (!g->alive[u]) continue;
+        cursor_init(&c, &g->out, (uint32_t)u);
+        while (cursor_next(&c, &v, NULL)) component_union(g, (uint32_t)u, v);
+    }
+}
+
+size_t graph_component_count(Graph *g) {
+    if (!g) return 0;
+    
+    component_refresh(g);
+    return g->components;
+}
+
+uint32_t graph_component(Graph *g, uint32_t node) {
+    if (!graph_node_exists(g, node)) return GRAPH_NO_NODE;
+    
+    component_refresh(g);
+    return component_find(g, node);
+}
+
+bool graph_components(Graph *g, uint32_t *labels) {
+    if (!g) return false;
+    
+    component_refresh(g);
+    for (size_t u = 0; u < g->node_ids; u++) {
+        labels[u] = g->alive[u] ? component_find(g, (uint32_t)u) : GRAPH_NO_NODE;
+    }
+    return true;
+}
+
+// ============================================================================
+// NODE PROPERTIES
+// ============================================================================
+
+static size_t prop_value_size(GraphPropType type) {
+    return type == GRAPH_PROP_STRING ? sizeof(uint32_t) : sizeof(int64_t);
+}
+
+// FNV-1a over a NUL-terminated string
+static uint64_t prop_string_hash(const char *s) {
+    uint64_t hash = 14695981039346656037ull;
+    for (; *s; s++) hash = (hash ^ (unsigned char)*s) * 1099511628211ull;
+    return hash;
+}
+
+static void props_free(Graph *g) {
+    for (size_t i = 0; i < g->column_count; i++) {
+        PropColumn *col = &g->columns[i];
+        free(col->name);
+        free(col->present);
+        free(col->values);
+        for (uint32_t s = 0; s < col->string_count; s++) free(col->strings[s]);
+        free(col->strings);
+        free(col->lookup);
+    }
+    free(g->columns);
+    g->columns = NULL;
+    g->column_count = 0;
+}
+
+// Drop a deleted node's values
+static void props_clear_node(Graph *g, uint32_t node) {
+    for (size_t i = 0; i < g->column_count; i++) {
+        PropColumn *col = &g->columns[i];
+        if (node < col->cap) col->present[node >> 6] &= ~(1ull << (node & 63));
+    }
+}
+
+// The column, or NULL if there is none of that type
+static PropColumn* prop_column(const Graph *g, int column, GraphPropType type) {
+    if (!g || column < 0 || (size_t)column >= g->column_count) return NULL;
+    PropColumn *col = &g->columns[column];
+    return col->type == type ? col : NULL;
+}
+
+static inline bool prop_present(const PropColumn *col, uint32_t node) {
+    return node < col->cap && bit_test(col->present, node);
+}
+
+// Make room for node IDs below nodes; new slots hold no value
+static bool column_reserve(PropColumn *col, size_t nodes) {
+    if (nodes <= col->cap) return true;
+    
+    size_t cap = col->cap ? col->cap : PROP_MIN_CAPACITY;
+    while (cap < nodes) cap *= 2;
+    size_t size = prop_value_size(col->type);
+    void *values = realloc(col->values, cap * size);
+    if (!values) return false;
+    memset((char*)values + col->cap * size, 0, (cap - col->cap) * size);
+    col->values = values;
+    
+    uint64_t *present = (uint64_t*)realloc(col->present, cap / 64 * sizeof(uint64_t));
+    if (!present) return false;
+    memset(present + col->cap / 64, 0, (cap - col->cap) / 64 * sizeof(uint64_t));
+    col->present = present;
+    col->cap = cap;
+    return true;
+}
+
+// Code of s in the column's dictionary, or UINT32_MAX if it isn't there
+static uint32_t dict_find(const PropColumn *col, const char *s, uint64_t hash) {
+    if (col->lookup_cap == 0) return UINT32_MAX;
+    
+    size_t mask = col->lookup_cap - 1;
+    for (size_t i = hash & mask; col->lookup[i]; i = (i + 1) & mask) {
+        uint32_t code = col->lookup[i] - 1;
+        if (strcmp(col->strings[code], s) == 0) return code;
+    }
+    return UINT32_MAX;
+}
+
+static void dict_place(uint32_t *lookup, size_t cap, uint64_t hash, uint32_t code) {
+    size_t i = hash & (cap - 1);
+    while (lookup[i]) i = (i + 1) & (cap - 1);
+    lookup[i] = code + 1;
+}
+
+// Code of s, adding it to the dictionary if new; UINT32_MAX if memory ran
+// out. Strings stay in the dictionary after the last node using them goes.
+static uint32_t dict_intern(PropColumn *col, const char *s) {
+    uint64_t hash = prop_string_hash(s);
+    uint32_t code = dict_find(col, s, hash);
+    if (code != UINT32_MAX) return code;
+    
+    if (col->string_count == col->string_cap) {
+        uint32_t cap = col->string_cap ? col->string_cap * 2 : DICT_MIN_CAPACITY;
+        char **strings = (char**)realloc(col->strings, cap * sizeof(char*));
+        if (!strings) return UINT32_MAX;
+        col->strings = strings;
+        col->string_cap = cap;
+    }
+    // The lookup stays at most half full
+    if ((col->string_count + 1) * 2 > col->lookup_cap) {
+        size_t cap = col->lookup_cap ? col->lookup_cap * 2 : DICT_MIN_CAPACITY * 2;
+        uint32_t *lookup = (uint32_t*)calloc(cap, sizeof(uint32_t));
+        if (!lookup) return UINT32_MAX;
+        for (uint32_t c = 0; c < col->string_count; c++) {
+            dict_place(lookup, cap, prop_string_hash(col->strings[c]), c);
+        }
+        free(col->lookup);
+        col->lookup = lookup;
+        col->lookup_cap = cap;
+    }
+    
+    char *copy = strdup(s);
+    if (!copy) return UINT32_MAX;
+    code = col->string_count++;
+    col->strings[code] = copy;
+    dict_place(col->lookup, col->lookup_cap, hash, code);
+    return code;
+}
+
+int graph_prop_find(const Graph *g, const char *name, GraphPropType *type) {
+    if (!g || !name) return -1;
+    
+    for (size_t i = 0; i < g->column_count; i++) {
+        if (strcmp(g->columns[i].name, name) == 0) {
+            if (type) *type = g->columns[i].type;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int graph_prop_column(Graph *g, const char *name, GraphPropType type) {
+    if (!g || !name || (unsigned)type > GRAPH_PROP_STRING) return -1;
+    
+    GraphPropType existing;
+    int column = graph_prop_find(g, name, &existing);
+    if (column >= 0) return existing == type ? column : -1;
+    if (g->column_count >= INT32_MAX) return -1;
+    
+    PropColumn *columns = (PropColumn*)realloc(g->columns,
+                                               (g->column_count + 1) * sizeof(PropColumn));
+    if (!columns) return -1;
+    g->columns = columns;
+    char *copy = strdup(name);
+    if (!copy) return -1;
+    
+    PropColumn *col = &columns[g->column_count];
+    memset(col, 0, sizeof(*col));
+    col->name = copy;
+    col->type = type;
+    return (int)g->column_count++;
+}
+
+// The setters' column, with a slot for every node ID issued
+static PropColumn* prop_prepare(Graph *g, int column, GraphPropType type, const uint32_t *nodes,
+                                const void *values) {
+    PropColumn *col = prop_column(g, column, type);
+    if (!col || !nodes || !values || !column_reserve(col, g->node_ids)) return NULL;
+    return col;
+}
+
+size_t graph_prop_set_ints(Graph *g, int column, const uint32_t *nodes, const int64_t *values,
+                           size_t count) {
+    PropColumn *col = prop_prepare(g, column, GRAPH_PROP_INT, nodes, values);
+    if (!col) return 0;
+    
+    size_t set = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!graph_node_exists(g, nodes[i])) continue;
+        ((int64_t*)col->values)[nodes[i]] = values[i];
+        bit_set(col->present, nodes[i]);
+        set++;
+    }
+    return set;
+}
+
+size_t graph_prop_set_doubles(Graph *g, int column, const uint32_t *nodes, const double *values,
+                              size_t count) {
+    PropColumn *col = prop_prepare(g, column, GRAPH_PROP_DOUBLE, nodes, values);
+    if (!col) return 0;
+    
+    size_t set = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!graph_node_exists(g, nodes[i])) continue;
+        ((double*)col->values)[nodes[i]] = values[i];
+        bit_set(col->present, nodes[i]);
+        set++;
+    }
+    return set;
+}
+
+size_t graph_prop_set_strings(Graph *g, int column, const uint32_t *nodes,
+                              const char *const *values, size_t count) {
+    PropColumn *col = prop_prepare(g, column, GRAPH_PROP_STRING, nodes, values);
+    if (!col) return 0;
+    
+    size_t set = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!graph_node_exists(g, nodes[i]) || !values[i]) continue;
+        uint32_t code = dict_intern(col, values[i]);
+        if (code == UINT32_MAX) break;
+        ((uint32_t*)col->values)[nodes[i]] = code;
+        bit_set(col->present, nodes[i]);
+        set++;
+    }
+    return set;
+}
+
+// True if the node had a value in the column
+bool graph_prop_unset(Graph *g, int column, uint32_t node) {
+    if (!g || column < 0 || (size_t)column >= g->column_count) return false;
+    
+    PropColumn *col = &g->columns[column];
+    if (!prop_present(col, node)) return false;
+    col->present[node >> 6] &= ~(1ull << (node & 63));
+    return true;
+}
+
+bool graph_prop_get_int(const Graph *g, int column, uint32_t node, int64_t *value) {
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_INT);
+    if (!col || !prop_present(col, node)) return false;
+    if (value) *value = ((const int64_t*)col->values)[node];
+    return true;
+}
+
+bool graph_prop_get_double(const Graph *g, int column, uint32_t node, double *value) {
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_DOUBLE);
+    if (!col || !prop_present(col, node)) return false;
+    if (value) *value = ((const double*)col->values)[node];
+    return true;
+}
+
+const char* graph_prop_get_string(const Graph *g, int column, uint32_t node) {
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_STRING);
+    if (!col || !prop_present(col, node)) return NULL;
+    return col->strings[((const uint32_t*)col->values)[node]];
+}
+
+// ============================================================================
+// PROPERTY FILTERS
+// ============================================================================
+
+// Each kernel turns the 64 values of one bitmap word into a match mask (bit
+// i for value i), then match_store folds it into the result. AVX2 compares
+// four 64-bit values or eight string codes at a time and SSE2 two or four;
+// other targets use a loop.
+
+// One word of the result: present values that match and, when
+// intersecting, passed the earlier filters
+static inline size_t match_store(uint64_t *bits, size_t w, uint64_t match,
+                                 const PropColumn *col, bool intersect) {
+    match &= col->present[w];
+    if (intersect) match &= bits[w];
+    bits[w] = match;
+    return (size_t)__builtin_popcountll(match);
+}
+
+// Words of the column to scan; the rest of the bitmap never matches
+static size_t match_words(const Graph *g, const PropColumn *col) {
+    size_t words = GRAPH_BITMAP_WORDS(g->node_ids);
+    if (!col) return 0;
+    return col->cap / 64 < words ? col->cap / 64 : words;
+}
+
+static void match_clear(const Graph *g, uint64_t *bits, size_t from) {
+    size_t words = GRAPH_BITMAP_WORDS(g->node_ids);
+    if (from < words) memset(bits + from, 0, (words - from) * sizeof(uint64_t));
+}
+
+// lo <= v <= hi as one unsigned compare, v - lo <= hi - lo
+static size_t scan_int_range(const PropColumn *col, size_t words, uint64_t lo, uint64_t span,
+                             bool intersect, uint64_t *bits) {
+    const int64_t *values = (const int64_t*)col->values;
+    size_t hits = 0;
+#if defined(__AVX2__)
+    // Unsigned compare as signed, both sides with the sign bit flipped
+    __m256i base = _mm256_set1_epi64x((long long)lo);
+    __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    __m256i limit = _mm256_xor_si256(_mm256_set1_epi64x((long long)span), sign);
+#elif defined(__SSE2__)
+    // No 64-bit compare: compare the 32-bit halves unsigned and combine,
+    // above = high half above, or high halves equal and low half above
+    __m128i base = _mm_set1_epi64x((long long)lo);
+    __m128i flip = _mm_set1_epi32(INT32_MIN);
+    __m128i limit = _mm_xor_si128(_mm_set1_epi64x((long long)span), flip);
+#endif
+    for (size_t w = 0; w < words; w++) {
+        const int64_t *v = values + w * 64;
+        uint64_t match = 0;
+#if defined(__AVX2__)
+        for (int i = 0; i < 64; i += 4) {
+            __m256i x = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(v + i)), base);
+            __m256i above = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), limit);
+            match |= (uint64_t)(~_mm256_movemask_pd(_mm256_castsi256_pd(above)) & 15) << i;
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < 64; i += 2) {
+            __m128i x = _mm_sub_epi64(_mm_loadu_si128((const __m128i*)(v + i)), base);
+            x = _mm_xor_si128(x, flip);
+            __m128i gt = _mm_cmpgt_epi32(x, limit);
+            __m128i eq = _mm_cmpeq_epi32(x, limit);
+            __m128i above = _mm_or_si128(_mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1)),
+                                         _mm_and_si128(_mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1)),
+                                                       _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0))));
+            match |= (uint64_t)(~_mm_movemask_pd(_mm_castsi128_pd(above)) & 3) << i;
+        }
+#else
+        for (int i = 0; i < 64; i++) match |= (uint64_t)((uint64_t)v[i] - lo <= span) << i;
+#endif
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+// Ordered compares, so NaN matches nothing
+static size_t scan_double_range(const PropColumn *col, size_t words, double lo, double hi,
+                                bool intersect, uint64_t *bits) {
+    const double *values = (const double*)col->values;
+    size_t hits = 0;
+#if defined(__AVX2__)
+    __m256d low = _mm256_set1_pd(lo), high = _mm256_set1_pd(hi);
+#elif defined(__SSE2__)
+    __m128d low = _mm_set1_pd(lo), high = _mm_set1_pd(hi);
+#endif
+    for (size_t w = 0; w < words; w++) {
+        const double *v = values + w * 64;
+        uint64_t match = 0;
+#if defined(__AVX2__)
+        for (int i = 0; i < 64; i += 4) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            __m256d in = _mm256_and_pd(_mm256_cmp_pd(x, low, _CMP_GE_OQ),
+                                       _mm256_cmp_pd(x, high, _CMP_LE_OQ));
+            match |= (uint64_t)_mm256_movemask_pd(in) << i;
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < 64; i += 2) {
+            __m128d x = _mm_loadu_pd(v + i);
+            __m128d in = _mm_and_pd(_mm_cmpge_pd(x, low), _mm_cmple_pd(x, high));
+            match |= (uint64_t)_mm_movemask_pd(in) << i;
+        }
+#else
+        for (int i = 0; i < 64; i++) match |= (uint64_t)(v[i] >= lo && v[i] <= hi) << i;
+#endif
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+// IN over a few integers: one equality compare per wanted value
+static size_t scan_int_equal(const PropColumn *col, size_t words, const int64_t *wanted,
+                             size_t count, bool intersect, uint64_t *bits) {
+    const int64_t *values = (const int64_t*)col->values;
+    size_t hits = 0;
+#if defined(__AVX2__)
+    __m256i needles[PROP_IN_SIMD_MAX];
+    for (size_t k = 0; k < count; k++) needles[k] = _mm256_set1_epi64x((long long)wanted[k]);
+#elif defined(__SSE2__)
+    __m128i needles[PROP_IN_SIMD_MAX];
+    for (size_t k = 0; k < count; k++) needles[k] = _mm_set1_epi64x((long long)wanted[k]);
+#endif
+    for (size_t w = 0; w < words; w++) {
+        const int64_t *v = values + w * 64;
+        uint64_t match = 0;
+#if defined(__AVX2__)
+        for (int i = 0; i < 64; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(v + i));
+            __m256i any = _mm256_setzero_si256();
+            for (size_t k = 0; k < count; k++) {
+                any = _mm256_or_si256(any, _mm256_cmpeq_epi64(x, needles[k]));
+            }
+            match |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(any)) << i;
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < 64; i += 2) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(v + i));
+            __m128i any = _mm_setzero_si128();
+            for (size_t k = 0; k < count; k++) {
+                // Equal 64-bit lanes have both 32-bit halves equal
+                __m128i eq = _mm_cmpeq_epi32(x, needles[k]);
+                any = _mm_or_si128(any, _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))));
+            }
+            match |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(any)) << i;
+        }
+#else
+        for (int i = 0; i < 64; i++) {
+            for (size_t k = 0; k < count; k++) match |= (uint64_t)(v[i] == wanted[k]) << i;
+        }
+#endif
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+static int compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// IN over many integers: binary search of a sorted copy, only for the
+// nodes still in the running
+static size_t scan_int_sorted(const PropColumn *col, size_t words, const int64_t *sorted,
+                              size_t count, bool intersect, uint64_t *bits) {
+    const int64_t *values = (const int64_t*)col->values;
+    size_t hits = 0;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t candidates = col->present[w] & (intersect ? bits[w] : UINT64_MAX);
+        uint64_t match = 0;
+        for (uint64_t word = candidates; word; word &= word - 1) {
+            int i = __builtin_ctzll(word);
+            int64_t v = values[w * 64 + i];
+            size_t lo = 0, hi = count;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (sorted[mid] < v) lo = mid + 1; else hi = mid;
+            }
+            if (lo < count && sorted[lo] == v) match |= 1ull << i;
+        }
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+// IN over a few string codes, compared like the integers
+static size_t scan_code_equal(const PropColumn *col, size_t words, const uint32_t *wanted,
+                              size_t count, bool intersect, uint64_t *bits) {
+    const uint32_t *values = (const uint32_t*)col->values;
+    size_t hits = 0;
+#if defined(__AVX2__)
+    __m256i needles[PROP_IN_SIMD_MAX];
+    for (size_t k = 0; k < count; k++) needles[k] = _mm256_set1_epi32((int)wanted[k]);
+#elif defined(__SSE2__)
+    __m128i needles[PROP_IN_SIMD_MAX];
+    for (size_t k = 0; k < count; k++) needles[k] = _mm_set1_epi32((int)wanted[k]);
+#endif
+    for (size_t w = 0; w < words; w++) {
+        const uint32_t *v = values + w * 64;
+        uint64_t match = 0;
+#if defined(__AVX2__)
+        for (int i = 0; i < 64; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(v + i));
+            __m256i any = _mm256_setzero_si256();
+            for (size_t k = 0; k < count; k++) {
+                any = _mm256_or_si256(any, _mm256_cmpeq_epi32(x, needles[k]));
+            }
+            match |= (uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(any)) << i;
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < 64; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(v + i));
+            __m128i any = _mm_setzero_si128();
+            for (size_t k = 0; k < count; k++) {
+                any = _mm_or_si128(any, _mm_cmpeq_epi32(x, needles[k]));
+            }
+            match |= (uint64_t)(unsigned)_mm_movemask_ps(_mm_castsi128_ps(any)) << i;
+        }
+#else
+        for (int i = 0; i < 64; i++) {
+            for (size_t k = 0; k < count; k++) match |= (uint64_t)(v[i] == wanted[k]) << i;
+        }
+#endif
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+// IN over many string codes: a lookup in a bitmap of the wanted codes
+static size_t scan_code_set(const PropColumn *col, size_t words, const uint64_t *wanted,
+                            bool intersect, uint64_t *bits) {
+    const uint32_t *values = (const uint32_t*)col->values;
+    size_t hits = 0;
+    for (size_t w = 0; w < words; w++) {
+        const uint32_t *v = values + w * 64;
+        uint64_t match = 0;
+        for (int i = 0; i < 64; i++) match |= (uint64_t)bit_test(wanted, v[i]) << i;
+        hits += match_store(bits, w, match, col, intersect);
+    }
+    return hits;
+}
+
+size_t graph_prop_match_int_range(const Graph *g, int column, int64_t lo, int64_t hi,
+                                  bool intersect, uint64_t *bits) {
+    if (!g || !bits) return 0;
+    
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_INT);
+    size_t words = lo <= hi ? match_words(g, col) : 0;
+    size_t hits = 0;
+    if (words) hits = scan_int_range(col, words, (uint64_t)lo, (uint64_t)hi - (uint64_t)lo,
+                                     intersect, bits);
+    match_clear(g, bits, words);
+    return hits;
+}
+
+size_t graph_prop_match_double_range(const Graph *g, int column, double lo, double hi,
+                                     bool intersect, uint64_t *bits) {
+    if (!g || !bits) return 0;
+    
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_DOUBLE);
+    size_t words = lo <= hi ? match_words(g, col) : 0;
+    size_t hits = 0;
+    if (words) hits = scan_double_range(col, words, lo, hi, intersect, bits);
+    match_clear(g, bits, words);
+    return hits;
+}
+
+size_t graph_prop_match_int_in(const Graph *g, int column, const int64_t *values, size_t count,
+                               bool intersect, uint64_t *bits) {
+    if (!g || !bits) return 0;
+    
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_INT);
+    size_t words = values && count ? match_words(g, col) : 0;
+    size_t hits = 0;
+    if (words && count <= PROP_IN_SIMD_MAX) {
+        hits = scan_int_equal(col, words, values, count, intersect, bits);
+    } else if (words) {
+        int64_t *sorted = (int64_t*)malloc(count * sizeof(int64_t));
+        if (sorted) {
+            memcpy(sorted, values, count * sizeof(int64_t));
+            qsort(sorted, count, sizeof(int64_t), compare_int64);
+            hits = scan_int_sorted(col, words, sorted, count, intersect, bits);
+            free(sorted);
+        } else {
+            words = 0;
+        }
+    }
+    match_clear(g, bits, words);
+    return hits;
+}
+
+// Strings are looked up in the column's dictionary once; ones it doesn't
+// hold can't match
+size_t graph_prop_match_string_in(const Graph *g, int column, const char *const *values,
+                                  size_t count, bool intersect, uint64_t *bits) {
+    if (!g || !bits) return 0;
+    
+    const PropColumn *col = prop_column(g, column, GRAPH_PROP_STRING);
+    size_t words = values ? match_words(g, col) : 0;
+    uint32_t codes[PROP_IN_SIMD_MAX];
+    uint64_t *set = NULL;
+    size_t found = 0;
+    if (words && count > PROP_IN_SIMD_MAX) {
+        set = (uint64_t*)calloc(GRAPH_BITMAP_WORDS(col->string_count), sizeof(uint64_t));
+        if (!set) words = 0;
+    }
+    for (size_t k = 0; words && k < count; k++) {
+        uint32_t code = values[k] ? dict_find(col, values[k], prop_string_hash(values[k]))
+                                  : UINT32_MAX;
+        if (code == UINT32_MAX) continue;
+        if (set) {
+            bit_set(set, code);
+        } else {
+            codes[found] = code;
+        }
+        found++;
+    }
+    
+    size_t hits = 0;
+    if (!found) {
+        words = 0;
+    } else if (set) {
+        hits = scan_code_set(col, words, set, intersect, bits);
+    } else {
+        hits = scan_code_equal(col, words, codes, found, intersect, bits);
+    }
+    free(set);
+    match_clear(g, bits, words);
+    return hits;
+}
+
+size_t graph_bitmap_nodes(const uint64_t *bits, size_t node_capacity, uint32_t *nodes) {
+    if (!bits || !nodes) return 0;
+    
+    size_t n = 0;
+    for (size_t w = 0; w < GRAPH_BITMAP_WORDS(node_capacity); w++) {
+        for (uint64_t word = bits[w]; word; word &= word - 1) {
+            nodes[n++] = (uint32_t)(w * 64 + __builtin_ctzll(word));
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+// PUBLIC API FUNCTIONS
+// ============================================================================
+
+Graph* graph_create(void) {
+    Graph *g = (Graph*)calloc(1, sizeof(Graph));
+    if (!g) return NULL;
+    pthread_mutex_init(&g->pool_lock, NULL);
+    pthread_mutex_init(&g->workspace_lock, NULL);
+    return g;
+}
+
+static void graph_free_data(Graph *g) {
+    adjacency_free(&g->out, g->node_cap);
+    adjacency_free(&g->in, g->node_cap);
+    free(g->alive);
+    free(g->out_degree);
+    free(g->in_degree);
+    free(g->component);
+    free(g->index.keys);
+    free(g->index.weights);
+    props_free(g);
+}
+
+void graph_destroy(Graph *g) {
+    if (!g) return;
+    
+    graph_free_data(g);
+    pool_destroy(g->pool);
+    pthread_mutex_destroy(&g->pool_lock);
+    while (g->workspaces) {
+        PathWorkspace *ws = g->workspaces;
+        g->workspaces = ws->next;
+        workspace_free(ws);
+    }
+    pthread_mutex_destroy(&g->workspace_lock);
+    free(g);
+}
+
+// Remove every node and edge; IDs start from 0 again. The thread setting,
+// pool and shortest-path workspaces are kept.
+void graph_clear(Graph *g) {
+    if (!g) return;
+    
+    graph_free_data(g);
+    g->node_cap = g->node_ids = g->live_nodes = g->edges = 0;
+    g->alive = NULL;
+    g->out_degree = g->in_degree = g->component = NULL;
+    g->components = 0;
+    g->components_stale = false;
+    memset(&g->out, 0, sizeof(g->out));
+    memset(&g->in, 0, sizeof(g->in));
+    memset(&g->index, 0, sizeof(g->index));
+    g->version++;
+}
+
+// Number of workers for the parallel kernels (0: one per online CPU, the
+// default; 1: always on the calling thread). Takes effect on a running
+// pool by replacing it.
+void graph_set_threads(Graph *g, unsigned threads) {
+    if (!g) return;
+    
+    pthread_mutex_lock(&g->pool_lock);
+    g->threads = threads;
+    WorkerPool *old = g->pool;
+    if (old && old->count != graph_wanted_threads(g)) {
+        g->pool = NULL;
+    } else {
+        old = NULL;
+    }
+    pthread_mutex_unlock(&g->pool_lock);
+    pool_destroy(old);
+}
+
+// Add a node and return its ID, or GRAPH_NO_NODE if memory ran out
+uint32_t graph_add_node(Graph *g) {
+    if (!g || g->node_ids >= GRAPH_NO_NODE) return GRAPH_NO_NODE;
+    
+    if (g->node_ids == g->node_cap) {
+        size_t cap = g->node_cap ? g->node_cap * 2 : INITIAL_NODE_CAPACITY;
+        uint8_t *alive = (uint8_t*)realloc(g->alive, cap);
+        if (!alive) return GRAPH_NO_NODE;
+        g->alive = alive;
+        
+        uint32_t **counters[3] = { &g->out_degree, &g->in_degree, &g->component };
+        for (int i = 0; i < 3; i++) {
+            uint32_t *grown = (uint32_t*)realloc(*counters[i], cap * sizeof(uint32_t));
+            if (!grown) return GRAPH_NO_NODE;
+            *counters[i] = grown;
+        }
+        
+        Adjacency *sides[2] = { &g->out, &g->in };
+        for (int s = 0; s < 2; s++) {
+            EdgeList *delta = (EdgeList*)realloc(sides[s]->delta, cap * sizeof(EdgeList));
+            if (!delta) return GRAPH_NO_NODE;
+            memset(delta + g->node_cap, 0, (cap - g->node_cap) * sizeof(EdgeList));
+            sides[s]->delta = delta;
+        }
+        memset(g->alive + g->node_cap, 0, cap - g->node_cap);
+        g->node_cap = cap;
+    }
+    
+    uint32_t node = (uint32_t)g->node_ids++;
+    g->alive[node] = 1;
+    g->out_degree[node] = g->in_degree[node] = 0;
+    g->component[node] = node;
+    g->components++;
+    g->live_nodes++;
+    g->version++;
+    return node;
+}
+
+// Delete a node together with every edge into or out of it
+bool graph_delete_node(Graph *g, uint32_t node) {
+    if (!graph_node_exists(g, node)) return false;
+    
+    // Removing an isolated node can't split a component
+    if (g->out_degree[node] == 0 && g->in_degree[node] == 0) {
+        g->components--;
+    } else {
+        g->components_stale = true;
+    }
+    
+    EdgeCursor c;
+    uint32_t other;
+    cursor_init(&c, &g->out, node);
+    while (cursor_next(&c, &other, NULL)) {
+        index_remove(&g->index, index_key(node, other));
+        g->edges--;
+        g->in_degree[other]--;
+        if (other != node) adjacency_remove(&g->in, other, node);
+    }
+    
+    // A self-loop was counted on the way out
+    cursor_init(&c, &g->in, node);
+    while (cursor_next(&c, &other, NULL)) {
+        if (other == node) continue;
+        index_remove(&g->index, index_key(other, node));
+        g->edges--;
+        g->out_degree[other]--;
+        adjacency_remove(&g->out, other, node);
+    }
+    
+    adjacency_clear_row(&g->out, node);
+    adjacency_clear_row(&g->in, node);
+    props_clear_node(g, node);
+    g->out_degree[node] = g->in_degree[node] = 0;
+    g->alive[node] = 0;
+    g->live_nodes--;
+    g->version++;
+    maybe_compact(g);
+    return true;
+}
+
+bool graph_node_exists(const Graph *g, uint32_t node) {
+    return g && node < g->node_ids && g->alive[node];
+}
+
+// Add (or re-add) the edge from -> to. Everything that can fail happens
+// before the first change, so a false return leaves the graph as it was.
+bool graph_add_edge(Graph *g, uint32_t from, uint32_t to, double weight) {
+    if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) return false;
+    
+    uint64_t key = index_key(from, to);
+    bool existed = index_find(&g->index, key) != SIZE_MAX;
+    if (!list_reserve(&g->out.delta[from]) || !list_reserve(&g->in.delta[to]) ||
+        !index_reserve(&g->index, g->edges)) return false;
+    
+    if (existed) {
+        adjacency_remove(&g->out, from, to);
+        adjacency_remove(&g->in, to, from);
+    }
+    
+    EdgeList *out = &g->out.delta[from], *in = &g->in.delta[to];
+    out->nodes[out->count] = to;
+    out->weights[out->count++] = weight;
+    in->nodes[in->count] = from;
+    in->weights[in->count++] = weight;
+    g->out.delta_edges++;
+    g->in.delta_edges++;
+    
+    index_put(&g->index, key, weight);
+    if (!existed) {
+        g->edges++;
+        g->out_degree[from]++;
+        g->in_degree[to]++;
+        if (!g->components_stale) component_union(g, from, to);
+    }
+    g->version++;
+    maybe_compact(g);
+    return true;
+}
+
+bool graph_delete_edge(Graph *g, uint32_t from, uint32_t to) {
+    if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) return false;
+    if (!index_remove(&g->index, index_key(from, to))) return false;
+    
+    adjacency_remove(&g->out, from, to);
+    adjacency_remove(&g->in, to, from);
+    g->edges--;
+    g->out_degree[from]--;
+    g->in_degree[to]--;
+    g->components_stale = true;
+    g->version++;
+    maybe_compact(g);
+    return true;
+}
+
+// True if the edge exists; its weight goes to *weight unless NULL
+bool graph_edge_weight(Graph *g, uint32_t from, uint32_t to, double *weight) {
+    if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) return false;
+    
+    size_t i = index_find(&g->index, index_key(from, to));
+    if (i == SIZE_MAX) return false;
+    if (weight) *weight = g->index.weights[i];
+    return true;
+}
+
+static size_t copy_row(const Graph *g, const Adjacency *adj, uint32_t node, uint32_t *nodes,
+                       double *weights, size_t cap) {
+    if (!graph_node_exists(g, node)) return 0;
+    
+    EdgeCursor c;
+    cursor_init(&c, adj, node);
+    size_t degree = 0;
+    uint32_t other;
+    double weight;
+    while (cursor_next(&c, &other, &weight)) {
+        if (degree < cap) {
+            if (nodes) nodes[degree] = other;
+            if (weights) weights[degree] = weight;
+        }
+        degree++;
+    }
+    return degree;
+}
+
+size_t graph_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights,
+                       size_t cap) {
+    return g ? copy_row(g, &g->out, node, nodes, weights, cap) : 0;
+}
+
+size_t graph_in_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights,
+                          size_t cap) {
+    return g ? copy_row(g, &g->in, node, nodes, weights, cap) : 0;
+}
+
+size_t graph_out_degree(const Graph *g, uint32_t node) {
+    return graph_node_exists(g, node) ? g->out_degree[node] : 0;
+}
+
+size_t graph_in_degree(const Graph *g, uint32_t node) {
+    return graph_node_exists(g, node) ? g->in_degree[node] : 0;
+}
+
+// Out- and in-degree of every node ID, copied from the counters
+bool graph_degrees(Graph *g, uint32_t *out, uint32_t *in) {
+    if (!g) return false;
+    
+    if (out && g->node_ids) memcpy(out, g->out_degree, g->node_ids * sizeof(uint32_t));
+    if (in && g->node_ids) memcpy(in, g->in_degree, g->node_ids * sizeof(uint32_t));
+    return true;
+}
+
+size_t graph_node_count(const Graph *g) {
+    return g ? g->live_nodes : 0;
+}
+
+size_t graph_node_capacity(const Graph *g) {
+    return g ? g->node_ids : 0;
+}
+
+size_t graph_edge_count(const Graph *g) {
+    return g ? g->edges : 0;
+}
+
+// Rebuild both directions as CSR arrays with no deltas or tombstones
+bool graph_compact(Graph *g) {
+    if (!g) return false;
+    
+    Csr out, in;
+    if (!csr_build(&out, &g->out, g->node_ids)) return false;
+    if (!csr_build(&in, &g->in, g->node_ids)) {
+        csr_free(&out);
+        return false;
+    }
+    
+    Adjacency *sides[2] = { &g->out, &g->in };
+    Csr fresh[2] = { out, in };
+    for (int s = 0; s < 2; s++) {
+        csr_free(&sides[s]->csr);
+        sides[s]->csr = fresh[s];
+        for (size_t i = 0; i < g->node_ids; i++) {
+            EdgeList *list = &sides[s]->delta[i];
+            free(list->nodes);
+            free(list->weights);
+            memset(list, 0, sizeof(*list));
+        }
+        sides[s]->delta_edges = 0;
+    }
+    g->version++;
+    return true;
+}
+
+// ============================================================================
+// TRAVERSALS
+// ============================================================================
+
+size_t graph_bfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+                 uint32_t *parent, int32_t *dist, size_t *visited) {
+    if (visited) *visited = 0;
+    if (!order || !parent || !dist || !graph_node_exists(g, start)) return 0;
+    
+    for (size_t i = 0; i < g->node_ids; i++) {
+        parent[i] = GRAPH_NO_NODE;
+        dist[i] = -1;
+    }
+    
+    // order[] is the queue: [head, tail) waits, [0, head) was dequeued
+    size_t head = 0, tail = 0;
+    order[tail++] = start;
+    dist[start] = 0;
+    while (head < tail) {
+        uint32_t u = order[head++];
+        if (u == target) break;
+        
+        EdgeCursor c;
+        uint32_t v;
+        cursor_init(&c, &g->out, u);
+        while (cursor_next(&c, &v, NULL)) {
+            if (dist[v] >= 0) continue;
+            dist[v] = dist[u] + 1;
+            parent[v] = u;
+            order[tail++] = v;
+        }
+    }
+    
+    if (visited) *visited = head;
+    return tail;
+}
+
+// Iterative, with one cursor per stack frame, so it visits nodes in the
+// same order as the recursive version without its depth limit
+size_t graph_dfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+                 uint32_t *parent, bool *found) {
+    if (found) *found = false;
+    if (!order || !parent || !graph_node_exists(g, start)) return 0;
+    
+    EdgeCursor *stack = (EdgeCursor*)malloc(g->node_ids * sizeof(EdgeCursor));
+    uint8_t *seen = (uint8_t*)calloc(g->node_ids, 1);
+    if (!stack || !seen) {
+        free(stack);
+        free(seen);
+        return 0;
+    }
+    for (size_t i = 0; i < g->node_ids; i++) parent[i] = GRAPH_NO_NODE;
+    
+    size_t count = 0, depth = 0;
+    bool hit = start == target;
+    seen[start] = 1;
+    order[count++] = start;
+    if (!hit) cursor_init(&stack[depth++], &g->out, start);
+    
+    while (depth > 0) {
+        uint32_t v;
+        if (!cursor_next(&stack[depth - 1], &v, NULL)) {
+            depth--;
+            continue;
+        }
+        if (seen[v]) continue;
+        
+        seen[v] = 1;
+        parent[v] = stack[depth - 1].node;
+        order[count++] = v;
+        if (v == target) {
+            hit = true;
+            break;
+        }
+        cursor_init(&stack[depth++], &g->out, v);
+    }
+    
+    free(stack);
+    free(seen);
+    if (found) *found = hit;
+    return count;
+}
+
+// ============================================================================
+// PARALLEL KERNELS
+// ============================================================================
+
+// Per-worker results, one cache line each so workers don't share lines
+typedef struct WorkerTally {
+    size_t nodes;           // Discovered this level
+    size_t edges;           // Out-slots of those nodes
+    char pad[64 - 2 * sizeof(size_t)];
+} WorkerTally;
+
+// State shared by the workers of one direction-optimizing BFS. Each level
+// is expanded either top-down, from a queue of frontier nodes through
+// their out-edges, or bottom-up, from every unvisited node through its
+// in-edges until one lands in the frontier bitmap. Bottom-up wins once the
+// frontier is a large part of the graph, since most unvisited nodes find
+// a parent after a few edges.
+typedef struct BfsState {
+    const Graph *g;
+    uint32_t *parent;
+    int32_t *dist;
+    int32_t level;          // Depth of the frontier being expanded
+    uint32_t *queue;        // Top-down frontier
+    size_t queue_len;
+    uint32_t *next_queue;
+    size_t next_len;        // Claimed atomically
+    uint64_t *bits;         // Bottom-up frontier
+    uint64_t *next_bits;
+    size_t cursor;          // Next chunk to claim
+    WorkerTally tally[MAX_THREADS];
+} BfsState;
+
+static void bfs_publish(BfsState *s, const uint32_t *local, size_t count) {
+    size_t at = __atomic_fetch_add(&s->next_len, count, __ATOMIC_RELAXED);
+    memcpy(s->next_queue + at, local, count * sizeof(uint32_t));
+}
+
+static void bfs_top_down(void *arg, unsigned worker) {
+    BfsState *s = (BfsState*)arg;
+    const Graph *g = s->g;
+    uint32_t local[LOCAL_QUEUE];
+    size_t local_len = 0, edges = 0, nodes = 0;
+    
+    for (;;) {
+        size_t begin = __atomic_fetch_add(&s->cursor, TOP_DOWN_CHUNK, __ATOMIC_RELAXED);
+        if (begin >= s->queue_len) break;
+        size_t end = begin + TOP_DOWN_CHUNK < s->queue_len ? begin + TOP_DOWN_CHUNK : s->queue_len;
+        
+        for (size_t i = begin; i < end; i++) {
+            uint32_t u = s->queue[i], v;
+            EdgeCursor c;
+            cursor_init(&c, &g->out, u);
+            while (cursor_next(&c, &v, NULL)) {
+                if (__atomic_load_n(&s->dist[v], __ATOMIC_RELAXED) >= 0) continue;
+                int32_t unseen = -1;
+                if (!__atomic_compare_exchange_n(&s->dist[v], &unseen, s->level + 1, false,
+                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) continue;
+                
+                s->parent[v] = u;
+                edges += row_slots(&g->out, v);
+                nodes++;
+                local[local_len++] = v;
+                if (local_len == LOCAL_QUEUE) {
+                    bfs_publish(s, local, local_len);
+                    local_len = 0;
+                }
+            }
+        }
+    }
+    
+    bfs_publish(s, local, local_len);
+    s->tally[worker].nodes = nodes;
+    s->tally[worker].edges = edges;
+}
+
+// Chunks are whole bitmap words, so each worker writes only its own words
+// of next_bits and its own nodes' dist and parent
+static void bfs_bottom_up(void *arg, unsigned worker) {
+    BfsState *s = (BfsState*)arg;
+    const Graph *g = s->g;
+    size_t n = g->node_ids, edges = 0, nodes = 0;
+    
+    for (;;) {
+        size_t begin = __atomic_fetch_add(&s->cursor, BOTTOM_UP_CHUNK, __ATOMIC_RELAXED);
+        if (begin >= n) break;
+        size_t end = begin + BOTTOM_UP_CHUNK < n ? begin + BOTTOM_UP_CHUNK : n;
+        
+        for (size_t v = begin; v < end; v++) {
+            if (s->dist[v] >= 0 || !g->alive[v]) continue;
+            
+            uint32_t w;
+            EdgeCursor c;
+            cursor_init(&c, &g->in, (uint32_t)v);
+            while (cursor_next(&c, &w, NULL)) {
+                if (!bit_test(s->bits, w)) continue;
+                s->dist[v] = s->level + 1;
+                s->parent[v] = w;
+                bit_set(s->next_bits, v);
+                edges += row_slots(&g->out, (uint32_t)v);
+                nodes++;
+                break;
+            }
+        }
+    }
+    
+    s->tally[worker].nodes = nodes;
+    s->tally[worker].edges = edges;
+}
+
+size_t graph_bfs_tree(Graph *g, uint32_t start, uint32_t *order, uint32_t *parent,
+                      int32_t *dist) {
+    if (!parent || !dist || !graph_node_exists(g, start)) return 0;
+    
+    size_t n = g->node_ids, words = (n + 63) / 64;
+    BfsState s;
+    memset(&s, 0, sizeof(s));
+    s.g = g;
+    s.parent = parent;
+    s.dist = dist;
+    s.queue = (uint32_t*)malloc(n * sizeof(uint32_t));
+    s.next_queue = (uint32_t*)malloc(n * sizeof(uint32_t));
+    s.bits = (uint64_t*)calloc(words, sizeof(uint64_t));
+    s.next_bits = (uint64_t*)calloc(words, sizeof(uint64_t));
+    size_t levels_cap = 64, *levels = (size_t*)malloc(levels_cap * sizeof(size_t));
+    if (!s.queue || !s.next_queue || !s.bits || !s.next_bits || !levels) {
+        free(s.queue);
+        free(s.next_queue);
+        free(s.bits);
+        free(s.next_bits);
+        free(levels);
+        return 0;
+    }
+    
+    // All bits set is -1 and GRAPH_NO_NODE
+    memset(parent, 0xFF, n * sizeof(uint32_t));
+    memset(dist, 0xFF, n * sizeof(int32_t));
+    dist[start] = 0;
+    s.queue[0] = start;
+    s.queue_len = 1;
+    levels[0] = 1;
+    
+    WorkerPool *pool = graph_pool(g);
+    size_t reached = 1, frontier = 1, previous = 0, depth = 1;
+    size_t frontier_edges = row_slots(&g->out, start);
+    size_t unexplored_edges = g->edges;
+    bool bottom_up = false;
+    
+    while (frontier > 0) {
+        // Switch representation when the frontier's size calls for it
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_ALPHA) {
+            memset(s.bits, 0, words * sizeof(uint64_t));
+            for (size_t i = 0; i < s.queue_len; i++) bit_set(s.bits, s.queue[i]);
+            bottom_up = true;
+        } else if (bottom_up && frontier < previous && frontier < n / BFS_BETA) {
+            s.queue_len = 0;
+            for (size_t w = 0; w < words; w++) {
+                for (uint64_t word = s.bits[w]; word; word &= word - 1) {
+                    s.queue[s.queue_len++] = (uint32_t)(w * 64 + __builtin_ctzll(word));
+                }
+            }
+            bottom_up = false;
+        }
+        unexplored_edges -= frontier_edges < unexplored_edges ? frontier_edges : unexplored_edges;
+        
+        s.cursor = 0;
+        s.next_len = 0;
+        unsigned workers;
+        if (bottom_up) {
+            memset(s.next_bits, 0, words * sizeof(uint64_t));
+            workers = graph_parallel(pool, bfs_bottom_up, &s);
+            uint64_t *swap = s.bits;
+            s.bits = s.next_bits;
+            s.next_bits = swap;
+        } else {
+            workers = graph_parallel(pool, bfs_top_down, &s);
+            uint32_t *swap = s.queue;
+            s.queue = s.next_queue;
+            s.next_queue = swap;
+            s.queue_len = s.next_len;
+        }
+        
+        previous = frontier;
+        frontier = frontier_edges = 0;
+        for (unsigned w = 0; w < workers; w++) {
+            frontier += s.tally[w].nodes;
+            frontier_edges += s.tally[w].edges;
+        }
+        if (frontier == 0) break;
+        
+        if (depth == levels_cap) {
+            size_t *grown = (size_t*)realloc(levels, 2 * levels_cap * sizeof(size_t));
+            if (!grown) {
+                reached = 0;
+                break;
+            }
+            levels = grown;
+            levels_cap *= 2;
+        }
+        levels[depth++] = frontier;
+        reached += frontier;
+        s.level++;
+    }
+    
+    // order[]: by level, then by node ID, whatever the thread count
+    if (order && reached > 0) {
+        size_t at = 0;
+        for (size_t d = 0; d < depth; d++) {
+            size_t count = levels[d];
+            levels[d] = at;
+            at += count;
+        }
+        for (size_t v = 0; v < n; v++) {
+            if (dist[v] >= 0) order[levels[dist[v]]++] = (uint32_t)v;
+        }
+    }
+    
+    free(s.queue);
+    free(s.next_queue);
+    free(s.bits);
+    free(s.next_bits);
+    free(levels);
+    return reached;
+}
+
+// ============================================================================
+// SHORTEST PATHS
+// ============================================================================
+
+// First sight of v in this query: unreached and unqueued
+static inline void side_touch(PathSide *side, uint32_t epoch, uint32_t v) {
+    if (side->stamp[v] == epoch) return;
+    side->stamp[v] = epoch;
+    side->dist[v] = INFINITY;
+    side->parent[v] = GRAPH_NO_NODE;
+    side->pos[v] = 0;
+}
+
+static void heap_up(PathSide *side, size_t i) {
+    HeapEntry entry = side->heap[i];
+    while (i > 0) {
+        size_t up = (i - 1) / 2;
+        if (side->heap[up].key <= entry.key) break;
+        side->heap[i] = side->heap[up];
+        side->pos[side->heap[i].node] = (uint32_t)i + 1;
+        i = up;
+    }
+    side->heap[i] = entry;
+    side->pos[entry.node] = (uint32_t)i + 1;
+}
+
+static void heap_down(PathSide *side, size_t i) {
+    HeapEntry entry = side->heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= side->heap_len) break;
+        if (child + 1 < side->heap_len && side->heap[child + 1].key < side->heap[child].key) {
+            child++;
+        }
+        if (entry.key <= side->heap[child].key) break;
+        side->heap[i] = side->heap[child];
+        side->pos[side->heap[i].node] = (uint32_t)i + 1;
+        i = child;
+    }
+    side->heap[i] = entry;
+    side->pos[entry.node] = (uint32_t)i + 1;
+}
+
+// Queue v with `key`, or lower its key if it is already queued
+static void heap_push(PathSide *side, uint32_t v, double key) {
+    uint32_t pos = side->pos[v];
+    if (pos == 0 || pos == HEAP_SETTLED) {
+        side->heap[side->heap_len].key = key;
+        side->heap[side->heap_len].node = v;
+        heap_up(side, side->heap_len++);
+    } else {
+        side->heap[pos - 1].key = key;
+        heap_up(side, pos - 1);
+    }
+}
+
+static uint32_t heap_pop(PathSide *side) {
+    uint32_t node = side->heap[0].node;
+    side->pos[node] = HEAP_SETTLED;
+    if (--side->heap_len > 0) {
+        side->heap[0] = side->heap[side->heap_len];
+        heap_down(side, 0);
+    }
+    return node;
+}
+
+// Write from .. meet (forward parents) then meet .. to (backward parents,
+// if any) into path when it fits; returns the node count either way
+static size_t path_emit(const PathWorkspace *ws, uint32_t meet, bool backward,
+                        uint32_t *path, size_t cap) {
+    const PathSide *forward = &ws->side[0], *reverse = &ws->side[1];
+    size_t head = 0, tail = 0;
+    for (uint32_t v = meet; v != GRAPH_NO_NODE; v = forward->parent[v]) head++;
+    if (backward) {
+        for (uint32_t v = reverse->parent[meet]; v != GRAPH_NO_NODE; v = reverse->parent[v]) tail++;
+    }
+    if (!path || head + tail > cap) return head + tail;
+    
+    size_t i = head;
+    for (uint32_t v = meet; v != GRAPH_NO_NODE; v = forward->parent[v]) path[--i] = v;
+    i = head;
+    if (backward) {
+        for (uint32_t v = reverse->parent[meet]; v != GRAPH_NO_NODE; v = reverse->parent[v]) {
+            path[i++] = v;
+        }
+    }
+    return head + tail;
+}
+
+// One-directional search; heuristic NULL is Dijkstra, otherwise A*.
+// Returns true once `to` is settled.
+static bool path_search(const Graph *g, PathWorkspace *ws, uint32_t from, uint32_t to,
+                        GraphHeuristic heuristic, void *ctx) {
+    PathSide *side = &ws->side[0];
+    uint32_t epoch = ws->epoch;
+    
+    side_touch(side, epoch, from);
+    side->dist[from] = 0;
+    side->estimate[from] = heuristic ? heuristic(from, to, ctx) : 0;
+    heap_push(side, from, side->estimate[from]);
+    
+    while (side->heap_len > 0) {
+        uint32_t u = heap_pop(side);
+        if (u == to) return true;
+        
+        EdgeCursor c;
+        uint32_t v;
+        double weight;
+        cursor_init(&c, &g->out, u);
+        while (cursor_next(&c, &v, &weight)) {
+            side_touch(side, epoch, v);
+            double dist = side->dist[u] + weight;
+            if (dist >= side->dist[v]) continue;
+            
+            // Dijkstra never improves a settled node; A* may with an
+            // inconsistent heuristic, and then the node is re-opened
+            if (!heuristic && side->pos[v] == HEAP_SETTLED) continue;
+            if (side->dist[v] == INFINITY) {
+                side->estimate[v] = heuristic ? heuristic(v, to, ctx) : 0;
+            }
+            side->dist[v] = dist;
+            side->parent[v] = u;
+            heap_push(side, v, dist + side->estimate[v]);
+        }
+    }
+    return false;
+}
+
+// Bidirectional Dijkstra: forward over out-edges from `from`, backward
+// over in-edges from `to`, always expanding the side with the smaller
+// queue head. Stops once the two heads together can't beat the best
+// meeting point. Returns the meeting node, or GRAPH_NO_NODE.
+static uint32_t path_search_bidirectional(const Graph *g, PathWorkspace *ws, uint32_t from,
+                                          uint32_t to, double *cost) {
+    uint32_t epoch = ws->epoch, meet = GRAPH_NO_NODE;
+    uint32_t ends[2] = { from, to };
+    double best = INFINITY;
+    
+    for (int s = 0; s < 2; s++) {
+        side_touch(&ws->side[s], epoch, ends[s]);
+        ws->side[s].dist[ends[s]] = 0;
+        heap_push(&ws->side[s], ends[s], 0);
+    }
+    
+    while (ws->side[0].heap_len > 0 && ws->side[1].heap_len > 0) {
+        double head0 = ws->side[0].heap[0].key, head1 = ws->side[1].heap[0].key;
+        if (head0 + head1 >= best) break;
+        
+        int s = head0 <= head1 ? 0 : 1;
+        PathSide *side = &ws->side[s], *other = &ws->side[1 - s];
+        uint32_t u = heap_pop(side);
+        
+        EdgeCursor c;
+        uint32_t v;
+        double weight;
+        cursor_init(&c, s == 0 ? &g->out : &g->in, u);
+        while (cursor_next(&c, &v, &weight)) {
+            side_touch(side, epoch, v);
+            double dist = side->dist[u] + weight;
+            if (dist >= side->dist[v] || side->pos[v] == HEAP_SETTLED) continue;
+            
+            side->dist[v] = dist;
+            side->parent[v] = u;
+            heap_push(side, v, dist);
+            if (other->stamp[v] == epoch && dist + other->dist[v] < best) {
+                best = dist + other->dist[v];
+                meet = v;
+            }
+        }
+    }
+    
+    *cost = best;
+    return meet;
+}
+
+size_t graph_shortest_path(Graph *g, uint32_t from, uint32_t to, bool bidirectional,
+                           uint32_t *path, size_t cap, double *cost) {
+    if (cost) *cost = INFINITY;
+    if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) return 0;
+    if (from == to) {
+        if (path && cap > 0) path[0] = from;
+        if (cost) *cost = 0;
+        return 1;
+    }
+    if (!bidirectional) return graph_astar(g, from, to, NULL, NULL, path, cap, cost);
+    
+    PathWorkspace *ws = workspace_acquire(g);
+    if (!ws) {
+        if (cost) *cost = NAN;
+        return 0;
+    }
+    
+    double best;
+    uint32_t meet = path_search_bidirectional(g, ws, from, to, &best);
+    size_t length = 0;
+    if (meet != GRAPH_NO_NODE) {
+        length = path_emit(ws, meet, true, path, cap);
+        if (cost) *cost = best;
+    }
+    workspace_release(g, ws);
+    return length;
+}
+
+size_t graph_astar(Graph *g, uint32_t from, uint32_t to, GraphHeuristic heuristic, void *ctx,
+                   uint32_t *path, size_t cap, double *cost) {
+    if (cost) *cost = INFINITY;
+    if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) return 0;
+    
+    PathWorkspace *ws = workspace_acquire(g);
+    if (!ws) {
+        if (cost) *cost = NAN;
+        return 0;
+    }
+    
+    size_t length = 0;
+    if (path_search(g, ws, from, to, heuristic, ctx)) {
+        length = path_emit(ws, to, false, path, cap);
+        if (cost) *cost = ws->side[0].dist[to];
+    }
+    workspace_release(g, ws);
+    return length;
+}
+
+// Straight-line distance between (x, y) pairs; ctx points at
+// GraphCoordinates. Nodes without coordinates (NaN) estimate 0.
+double graph_euclidean_heuristic(uint32_t node, uint32_t target, void *ctx) {
+    const GraphCoordinates *coords = (const GraphCoordinates*)ctx;
+    if (node >= coords->count || target >= coords->count) return 0;
+    
+    double dx = coords->xy[2 * node] - coords->xy[2 * target];
+    double dy = coords->xy[2 * node + 1] - coords->xy[2 * target + 1];
+    double estimate = coords->scale * sqrt(dx * dx + dy * dy);
+    return isnan(estimate) ? 0 : estimate;
+}
+
+// ============================================================================
+// PATH ENUMERATION
+// ============================================================================
+
+// One node on the current path and where its neighbor scan stands
+typedef struct PathFrame {
+    EdgeCursor cursor;
+    double cost;            // From the start to this node
+} PathFrame;
+
+struct GraphPaths {
+    const Graph *g;
+    uint64_t version;       // The graph's version when opened
+    uint32_t target;
+    size_t max_nodes;       // 0: no limit
+    double max_cost;
+    PathFrame *stack;       // The current path, start at the bottom
+    size_t depth;
+    size_t stack_cap;
+    uint64_t *on_path;      // Bitmap over node IDs
+    bool pending;           // Top of stack is a path not yet handed out
+};
+
+static bool paths_push(GraphPaths *it, uint32_t node, double cost) {
+    if (it->depth == it->stack_cap) {
+        size_t cap = it->stack_cap ? it->stack_cap * 2 : 16;
+        PathFrame *stack = (PathFrame*)realloc(it->stack, cap * sizeof(PathFrame));
+        if (!stack) return false;
+        it->stack = stack;
+        it->stack_cap = cap;
+    }
+    
+    PathFrame *frame = &it->stack[it->depth++];
+    cursor_init(&frame->cursor, &it->g->out, node);
+    frame->cost = cost;
+    it->on_path[node / 64] |= 1ull << (node % 64);
+    it->pending = node == it->target;
+    return true;
+}
+
+static void paths_pop(GraphPaths *it) {
+    uint32_t node = it->stack[--it->depth].cursor.node;
+    it->on_path[node / 64] &= ~(1ull << (node % 64));
+}
+
+// Start enumerating the simple paths from -> to of at most max_nodes nodes
+// (0: any) and cost at most max_cost. NULL only if memory ran out.
+GraphPaths* graph_paths_open(const Graph *g, uint32_t from, uint32_t to, size_t max_nodes,
+                             double max_cost) {
+    if (!g) return NULL;
+    
+    GraphPaths *it = (GraphPaths*)calloc(1, sizeof(GraphPaths));
+    if (!it) return NULL;
+    it->g = g;
+    it->version = g->version;
+    it->target = to;
+    it->max_nodes = max_nodes;
+    it->max_cost = isnan(max_cost) ? INFINITY : max_cost;
+    it->on_path = (uint64_t*)calloc(g->node_ids / 64 + 1, sizeof(uint64_t));
+    if (!it->on_path) {
+        free(it);
+        return NULL;
+    }
+    
+    // A missing endpoint gives an enumerator with nothing to hand out
+    if (graph_node_exists(g, from) && graph_node_exists(g, to) && max_cost >= 0 &&
+        !paths_push(it, from, 0)) {
+        graph_paths_close(it);
+        return NULL;
+    }
+    return it;
+}
+
+// Advance the depth-first search to the next path ending at the target
+static bool paths_advance(GraphPaths *it) {
+    while (it->depth > 0) {
+        PathFrame *top = &it->stack[it->depth - 1];
+        
+        // Paths stop at the target, and at the length limit
+        if (top->cursor.node == it->target ||
+            (it->max_nodes && it->depth >= it->max_nodes)) {
+            paths_pop(it);
+            continue;
+        }
+        
+        uint32_t v;
+        double weight;
+        bool pushed = false;
+        while (cursor_next(&top->cursor, &v, &weight)) {
+            if (it->on_path[v / 64] & (1ull << (v % 64))) continue;
+            double cost = top->cost + weight;
+            if (cost > it->max_cost) continue;
+            if (!paths_push(it, v, cost)) return false;
+            pushed = true;
+            break;
+        }
+        if (!pushed) paths_pop(it);
+        if (it->pending) return true;
+    }
+    return true;
+}
+
+// Hand out the next path: returns its node count and writes the nodes
+// into path and its cost into *cost if it fits in cap. A path that doesn't
+// fit stays current, so a retry with a bigger buffer gets it. 0 means no
+// more paths, or (with *cost NaN) that the graph changed since open or
+// memory ran out; graph_paths_stale tells the two apart.
+size_t graph_paths_next(GraphPaths *it, uint32_t *path, size_t cap, double *cost) {
+    if (cost) *cost = NAN;
+    if (!it || graph_paths_stale(it)) return 0;
+    if (!it->pending && !paths_advance(it)) return 0;
+    if (!it->pending) {
+        if (cost) *cost = INFINITY;
+        return 0;
+    }
+    
+    size_t length = it->depth;
+    if (cost) *cost = it->stack[length - 1].cost;
+    if (!path || length > cap) return length;
+    for (size_t i = 0; i < length; i++) {
+        path[i] = it->stack[i].cursor.node;
+    }
+    it->pending = false;
+    return length;
+}
+
+bool graph_paths_stale(const GraphPaths *it) {
+    return it && it->version != it->g->version;
+}
+
+void graph_paths_close(GraphPaths *it) {
+    if (!it) return;
+    
+    free(it->stack);
+    free(it->on_path);
+    free(it);
+}
+
+// ============================================================================
+// GRAPH FILES
+// ============================================================================
+
+// Layout, little-endian, every block 8-byte aligned:
+//
+//   GraphFileHeader
+//   string tables: per live node, one NUL-terminated string each
+//   edge rows: per node, varint degree, then each target as a zigzag
+//     varint delta from the previous one (the first from the node itself)
+//   weights: one double per edge in row order, omitted if all are 1
+//
+// Nodes are renumbered 0 .. n-1 in ID order, so files have no holes.
+#define GRAPH_FILE_MAGIC "WGRAPHB1"
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FILE_BUFFER 65536
+
+typedef struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t nodes;
+    uint64_t edges;
+    uint64_t self_loops;
+    uint64_t file_size;
+    uint64_t rows_offset;
+    uint64_t rows_size;
+    uint64_t weights_offset;    // 0: every weight is 1
+    uint64_t table_count;
+    uint64_t tables[GRAPH_FILE_MAX_TABLES][2];  // Offset, size
+} GraphFileHeader;
+
+struct GraphFile {
+    const uint8_t *map;
+    size_t size;
+    const GraphFileHeader *header;
+};
+
+// Buffered sequential writer that tracks the file offset
+typedef struct FileWriter {
+    FILE *fp;
+    uint8_t *buf;
+    size_t len;
+    uint64_t offset;
+    bool ok;
+} FileWriter;
+
+static void writer_flush(FileWriter *w) {
+    if (w->ok && w->len > 0 && fwrite(w->buf, 1, w->len, w->fp) != w->len) w->ok = false;
+    w->len = 0;
+}
+
+static void writer_bytes(FileWriter *w, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    while (len > 0) {
+        if (w->len == GRAPH_FILE_BUFFER) writer_flush(w);
+        size_t n = GRAPH_FILE_BUFFER - w->len < len ? GRAPH_FILE_BUFFER - w->len : len;
+        memcpy(w->buf + w->len, p, n);
+        w->len += n;
+        w->offset += n;
+        p += n;
+        len -= n;
+    }
+}
+
+static void writer_varint(FileWriter *w, uint64_t v) {
+    if (GRAPH_FILE_BUFFER - w->len < 10) writer_flush(w);
+    size_t start = w->len;
+    while (v >= 0x80) {
+        w->buf[w->len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    w->buf[w->len++] = (uint8_t)v;
+    w->offset += w->len - start;
+}
+
+static void writer_align(FileWriter *w) {
+    static const uint8_t padding[8] = {0};
+    writer_bytes(w, padding, (8 - w->offset % 8) % 8);
+}
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+// Write the live nodes, their edges and `table_count` string tables (each
+// one NUL-terminated string per live node, in ID order, packed like
+// db_mset's keys) to `path`. Written next to it and renamed over it once
+// synced. `flags` is stored for the caller.
+bool graph_save(const Graph *g, const char *path, uint32_t flags, const char *const *tables,
+                size_t table_count) {
+    if (!g || !path || table_count > GRAPH_FILE_MAX_TABLES) return false;
+    for (size_t t = 0; t < table_count; t++) {
+        if (!tables[t]) return false;
+    }
+    
+    size_t path_len = strlen(path);
+    char *tmp_path = (char*)malloc(path_len + 5);
+    uint32_t *renumber = (uint32_t*)malloc((g->node_ids + 1) * sizeof(uint32_t));
+    uint8_t *buf = (uint8_t*)malloc(GRAPH_FILE_BUFFER);
+    if (!tmp_path || !renumber || !buf) {
+        free(tmp_path);
+        free(renumber);
+        free(buf);
+        return false;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+    
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, 8);
+    header.version = GRAPH_FILE_VERSION;
+    header.flags = flags;
+    header.nodes = g->live_nodes;
+    header.edges = g->edges;
+    header.table_count = table_count;
+    
+    uint32_t next = 0;
+    for (size_t u = 0; u < g->node_ids; u++) {
+        renumber[u] = g->alive[u] ? next++ : GRAPH_NO_NODE;
+    }
+    
+    FileWriter w = { fopen(tmp_path, "wb"), buf, 0, 0, true };
+    w.ok = w.fp != NULL;
+    writer_bytes(&w, &header, sizeof(header));
+    
+    for (size_t t = 0; t < table_count; t++) {
+        const char *table = tables[t], *p = table;
+        for (size_t i = 0; i < g->live_nodes; i++) p += strlen(p) + 1;
+        header.tables[t][0] = w.offset;
+        header.tables[t][1] = (uint64_t)(p - table);
+        writer_bytes(&w, table, (size_t)(p - table));
+        writer_align(&w);
+    }
+    
+    header.rows_offset = w.offset;
+    bool unit_weights = true;
+    EdgeCursor c;
+    uint32_t v;
+    double weight;
+    for (size_t u = 0; u < g->node_ids; u++) {
+        if (!g->alive[u]) continue;
+        
+        uint64_t degree = 0;
+        cursor_init(&c, &g->out, (uint32_t)u);
+        while (cursor_next(&c, &v, &weight)) {
+            degree++;
+            if (weight != 1.0) unit_weights = false;
+            if (v == u) header.self_loops++;
+        }
+        writer_varint(&w, degree);
+        
+        int64_t previous = renumber[u];
+        cursor_init(&c, &g->out, (uint32_t)u);
+        while (cursor_next(&c, &v, NULL)) {
+            writer_varint(&w, zigzag((int64_t)renumber[v] - previous));
+            previous = renumber[v];
+        }
+    }
+    header.rows_size = w.offset - header.rows_offset;
+    writer_align(&w);
+    
+    if (!unit_weights) {
+        header.weights_offset = w.offset;
+        for (size_t u = 0; u < g->node_ids; u++) {
+            if (!g->alive[u]) continue;
+            cursor_init(&c, &g->out, (uint32_t)u);
+            while (cursor_next(&c, &v, &weight)) writer_bytes(&w, &weight, sizeof(weight));
+        }
+    }
+    header.file_size = w.offset;
+    writer_flush(&w);
+    
+    w.ok = w.ok &&
+           fseek(w.fp, 0, SEEK_SET) == 0 &&
+           fwrite(&header, sizeof(header), 1, w.fp) == 1 &&
+           fflush(w.fp) == 0 &&
+           fsync(fileno(w.fp)) == 0;
+    if (w.fp && fclose(w.fp) != 0) w.ok = false;
+    w.ok = w.ok && rename(tmp_path, path) == 0;
+    
+    if (!w.ok) remove(tmp_path);
+    free(tmp_path);
+    free(renumber);
+    free(buf);
+    return w.ok;
+}
+
+// Map a file written by graph_save and check that its blocks lie inside it
+GraphFile* graph_file_open(const char *path) {
+    if (!path) return NULL;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GraphFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (map == MAP_FAILED) return NULL;
+    
+    const GraphFileHeader *header = (const GraphFileHeader*)map;
+    bool valid = memcmp(header->magic, GRAPH_FILE_MAGIC, 8) == 0 &&
+                 header->version == GRAPH_FILE_VERSION &&
+                 header->file_size == size &&
+                 header->nodes < GRAPH_NO_NODE &&
+                 header->table_count <= GRAPH_FILE_MAX_TABLES &&
+                 header->rows_offset <= size && header->rows_size <= size - header->rows_offset &&
+                 // Each row's degree and each edge's delta take a byte or more,
+                 // so the counts can't outgrow the rows whatever the layout
+                 header->nodes <= header->rows_size &&
+                 header->edges <= header->rows_size - header->nodes &&
+                 header->weights_offset % 8 == 0 &&
+                 (header->weights_offset == 0 ||
+                  (header->weights_offset <= size &&
+                   header->edges <= (size - header->weights_offset) / sizeof(double)));
+    for (size_t t = 0; valid && t < header->table_count; t++) {
+        uint64_t offset = header->tables[t][0], bytes = header->tables[t][1];
+        valid = offset <= size && bytes <= size - offset &&
+                (bytes == 0 ? header->nodes == 0 : ((const uint8_t*)map)[offset + bytes - 1] == 0);
+    }
+    
+    GraphFile *f = valid ? (GraphFile*)malloc(sizeof(GraphFile)) : NULL;
+    if (!f) {
+        munmap(map, size);
+        return NULL;
+    }
+    
+    f->map = (const uint8_t*)map;
+    f->size = size;
+    f->header = header;
+    madvise(map, size, MADV_SEQUENTIAL);
+    return f;
+}
+
+void graph_file_info(const GraphFile *f, GraphFileInfo *info) {
+    const GraphFileHeader *header = f->header;
+    info->flags = header->flags;
+    info->nodes = header->nodes;
+    info->edges = header->edges;
+    info->self_loops = header->self_loops;
+    info->table_count = header->table_count;
+}
+
+// A string table's packed strings, inside the mapping (valid until close)
+const char* graph_file_table(const GraphFile *f, size_t table, size_t *size) {
+    if (!f || table >= f->header->table_count) return NULL;
+    if (size) *size = f->header->tables[table][1];
+    return (const char*)f->map + f->header->tables[table][0];
+}
+
+static bool varint_get(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *v = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decode the file's rows into out-CSR arrays and build the in-CSR arrays
+// and edge index around them. False if the rows are corrupt.
+static bool file_decode(const GraphFile *f, Csr *out, Csr *in, EdgeIndex *ix) {
+    const GraphFileHeader *header = f->header;
+    size_t n = header->nodes, m = header->edges, slots = m ? m : 1;
+    
+    Csr *sides[2] = { out, in };
+    for (int s = 0; s < 2; s++) {
+        sides[s]->rows = n;
+        sides[s]->edges = m;
+        sides[s]->offsets = (uint64_t*)calloc(n + 1, sizeof(uint64_t));
+        sides[s]->targets = (uint32_t*)malloc(slots * sizeof(uint32_t));
+        sides[s]->weights = (double*)malloc(slots * sizeof(double));
+        sides[s]->dead = (uint64_t*)calloc((slots + 63) / 64, sizeof(uint64_t));
+        if (!sides[s]->offsets || !sides[s]->targets || !sides[s]->weights ||
+            !sides[s]->dead) return false;
+    }
+    ix->cap = INDEX_MIN_CAPACITY;
+    while (ix->cap < (m + 1) * 4) ix->cap *= 2;
+    ix->keys = (uint64_t*)calloc(ix->cap, sizeof(uint64_t));
+    ix->weights = (double*)malloc(ix->cap * sizeof(double));
+    if (!ix->keys || !ix->weights) return false;
+    
+    const uint8_t *p = f->map + header->rows_offset, *end = p + header->rows_size;
+    uint64_t edge = 0, loops = 0;
+    for (size_t u = 0; u < n; u++) {
+        uint64_t degree, delta;
+        if (!varint_get(&p, end, &degree) || degree > m - edge) return false;
+        
+        uint64_t target = u;  // Wraps like the signed deltas it adds
+        for (uint64_t i = 0; i < degree; i++, edge++) {
+            if (!varint_get(&p, end, &delta)) return false;
+            target += (delta >> 1) ^ (0 - (delta & 1));
+            if (target >= n) return false;
+            out->targets[edge] = (uint32_t)target;
+            in->offsets[target + 1]++;
+            if (target == u) loops++;
+        }
+        out->offsets[u + 1] = edge;
+    }
+    if (edge != m || p != end || loops != header->self_loops) return false;
+    
+    if (header->weights_offset) {
+        memcpy(out->weights, f->map + header->weights_offset, m * sizeof(double));
+    } else {
+        for (size_t i = 0; i < m; i++) out->weights[i] = 1.0;
+    }
+    
+    // In-rows by counting sort over sources, so each lists sources in ID order
+    for (size_t v = 0; v < n; v++) in->offsets[v + 1] += in->offsets[v];
+    uint64_t *fill = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+    if (!fill) return false;
+    memcpy(fill, in->offsets, (n + 1) * sizeof(uint64_t));
+    
+    bool ok = true;
+    for (size_t u = 0; ok && u < n; u++) {
+        for (uint64_t i = out->offsets[u]; i < out->offsets[u + 1]; i++) {
+            uint32_t v = out->targets[i];
+            uint64_t slot = fill[v]++;
+            in->targets[slot] = (uint32_t)u;
+            in->weights[slot] = out->weights[i];
+            
+            // A repeated edge would leave the rows and index disagreeing
+            uint64_t key = index_key((uint32_t)u, v);
+            size_t j = index_home(ix, key);
+            while (ix->keys[j] != INDEX_EMPTY && ix->keys[j] != key) j = (j + 1) & (ix->cap - 1);
+            if (ix->keys[j] == key) {
+                ok = false;
+                break;
+            }
+            ix->keys[j] = key;
+            ix->weights[j] = out->weights[i];
+            ix->used++;
+        }
+    }
+    free(fill);
+    return ok;
+}
+
+// Replace g's nodes and edges with the file's. Node i of the file gets ID
+// i. On failure (corrupt file, no memory) g is left unchanged.
+bool graph_file_load(const GraphFile *f, Graph *g) {
+    if (!f || !g) return false;
+    
+    size_t n = f->header->nodes;
+    size_t cap = n ? n : INITIAL_NODE_CAPACITY;
+    Csr out, in;
+    EdgeIndex ix;
+    memset(&out, 0, sizeof(out));
+    memset(&in, 0, sizeof(in));
+    memset(&ix, 0, sizeof(ix));
+    uint8_t *alive = (uint8_t*)malloc(cap);
+    EdgeList *out_delta = (EdgeList*)calloc(cap, sizeof(EdgeList));
+    EdgeList *in_delta = (EdgeList*)calloc(cap, sizeof(EdgeList));
+    uint32_t *out_degree = (uint32_t*)malloc(cap * sizeof(uint32_t));
+    uint32_t *in_degree = (uint32_t*)malloc(cap * sizeof(uint32_t));
+    uint32_t *component = (uint32_t*)malloc(cap * sizeof(uint32_t));
+    
+    if (!alive || !out_delta || !in_delta || !out_degree || !in_degree || !component ||
+        !file_decode(f, &out, &in, &ix)) {
+        free(alive);
+        free(out_delta);
+        free(in_delta);
+        free(out_degree);
+        free(in_degree);
+        free(component);
+        csr_free(&out);
+        csr_free(&in);
+        free(ix.keys);
+        free(ix.weights);
+        return false;
+    }
+    memset(alive, 1, n);
+    memset(alive + n, 0, cap - n);
+    for (size_t u = 0; u < n; u++) {
+        out_degree[u] = (uint32_t)(out.offsets[u + 1] - out.offsets[u]);
+        in_degree[u] = (uint32_t)(in.offsets[u + 1] - in.offsets[u]);
+    }
+    
+    graph_free_data(g);
+    g->node_cap = cap;
+    g->node_ids = g->live_nodes = n;
+    g->edges = f->header->edges;
+    g->alive = alive;
+    g->out = (Adjacency){ out, out_delta, 0 };
+    g->in = (Adjacency){ in, in_delta, 0 };
+    g->index = ix;
+    g->out_degree = out_degree;
+    g->in_degree = in_degree;
+    g->component = component;
+    g->components_stale = true;
+    g->version++;
+    return true;
+}
+
+void graph_file_close(GraphFile *f) {
+    if (!f) return;
+    
+    munmap((void*)f->map, f->size);
+    free(f);
+}
+
+// ============================================================================
+// STANDALONE TEST
+// ============================================================================
+
+#ifdef BUILD_STANDALONE
+
+// Neighbors of node as a string like "1,2,3", for comparing orders
+static const char* row_string(const Graph *g, uint32_t node, bool in) {
+    static char text[4096];
+    uint32_t nodes[512];
+    size_t n = in ? graph_in_neighbors(g, node, nodes, NULL, 512)
+                  : graph_neighbors(g, node, nodes, NULL, 512);
+    size_t used = 0;
+    text[0] = '\0';
+    for (size_t i = 0; i < n && i < 512 && used < sizeof(text) - 16; i++) {
+        used += snprintf(text + used, sizeof(text) - used, i ? ",%u" : "%u", nodes[i]);
+    }
+    return text;
+}
+
+static bool basic_test(void) {
+    printf("Basic test: nodes, edges, order, compaction...\n");
+    Graph *g = graph_create();
+    if (!g) return false;
+    
+    bool ok = true;
+    for (uint32_t i = 0; i < 6; i++) ok = ok && graph_add_node(g) == i;
+    ok = ok && graph_add_edge(g, 0, 1, 1.0) && graph_add_edge(g, 0, 2, 2.0) &&
+         graph_add_edge(g, 0, 3, 3.0) && graph_add_edge(g, 2, 0, 4.0) &&
+         graph_add_edge(g, 3, 3, 5.0) && !graph_add_edge(g, 0, 9, 1.0);
+    ok = ok && strcmp(row_string(g, 0, false), "1,2,3") == 0 && graph_edge_count(g) == 5;
+    
+    // Re-adding moves the edge to the end and updates its weight
+    double w = 0;
+    ok = ok && graph_add_edge(g, 0, 1, 7.5) && strcmp(row_string(g, 0, false), "2,3,1") == 0 &&
+         graph_edge_weight(g, 0, 1, &w) && w == 7.5 && graph_edge_count(g) == 5;
+    
+    // The same answers from the CSR arrays, then with tombstones on top
+    ok = ok && graph_compact(g) && strcmp(row_string(g, 0, false), "2,3,1") == 0 &&
+         strcmp(row_string(g, 0, true), "2") == 0 && graph_in_degree(g, 3) == 2;
+    ok = ok && graph_delete_edge(g, 0, 3) && !graph_delete_edge(g, 0, 3) &&
+         strcmp(row_string(g, 0, false), "2,1") == 0 && graph_add_edge(g, 0, 4, 1.0) &&
+         strcmp(row_string(g, 0, false), "2,1,4") == 0 && graph_edge_count(g) == 5;
+    
+    // Deleting a node takes its edges both ways, self-loop included
+    ok = ok && graph_delete_node(g, 3) && graph_delete_node(g, 0) && !graph_delete_node(g, 0) &&
+         graph_edge_count(g) == 0 && graph_node_count(g) == 4 &&
+         graph_out_degree(g, 2) == 0 && graph_in_degree(g, 1) == 0 &&
+         !graph_edge_weight(g, 2, 0, NULL) && graph_add_node(g) == 6;
+    
+    printf("%s Adjacency keeps insertion order through edits and compaction\n\n",
+           ok ? "✓" : "✗");
+    graph_destroy(g);
+    return ok;
+}
+
+static bool traversal_test(void) {
+    printf("Traversal test: BFS and DFS on a small DAG...\n");
+    // A=0 -> B=1, C=2; B -> D=3; C -> D, E=4; D -> E
+    Graph *g = graph_create();
+    if (!g) return false;
+    for (int i = 0; i < 5; i++) graph_add_node(g);
+    graph_add_edge(g, 0, 1, 1);
+    graph_add_edge(g, 0, 2, 1);
+    graph_add_edge(g, 1, 3, 1);
+    graph_add_edge(g, 2, 3, 1);
+    graph_add_edge(g, 3, 4, 1);
+    graph_add_edge(g, 2, 4, 1);
+    
+    uint32_t order[5], parent[5];
+    int32_t dist[5];
+    size_t visited;
+    size_t found_count = graph_bfs(g, 0, 4, order, parent, dist, &visited);
+    bool ok = found_count == 5 && visited == 5 && order[3] == 3 && order[4] == 4 &&
+              dist[4] == 2 && parent[4] == 2 && parent[0] == GRAPH_NO_NODE;
+    
+    bool found = false;
+    size_t n = graph_dfs(g, 0, 4, order, parent, &found);
+    ok = ok && found && n == 4 && order[1] == 1 && order[2] == 3 && order[3] == 4 &&
+         parent[4] == 3 && parent[2] == GRAPH_NO_NODE;
+    
+    n = graph_dfs(g, 4, 0, order, parent, &found);
+    ok = ok && !found && n == 1;
+    
+    printf("%s BFS and DFS visit in the recursive Python order\n\n", ok ? "✓" : "✗");
+    graph_destroy(g);
+    return ok;
+}
+
+// Random edits checked against an adjacency matrix, across the automatic
+// compactions they trigger
+static bool random_test(void) {
+    enum { N = 200, OPS = 200000 };
+    printf("Random test: %d edits on %d nodes against a matrix...\n", OPS, N);
+    Graph *g = graph_create();
+    double *matrix = (double*)calloc(N * N, sizeof(double));  // 0: no edge
+    bool *alive = (bool*)calloc(N, sizeof(bool));
+    if (!g || !matrix || !alive) return false;
+    
+    for (int i = 0; i < N; i++) alive[i] = graph_add_node(g) == (uint32_t)i;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t edges = 0;
+    bool ok = true;
+    for (int op = 0; ok && op < OPS; op++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        uint32_t u = (uint32_t)(seed % N), v = (uint32_t)((seed >> 20) % N);
+        int kind = (int)((seed >> 40) % 100);
+        
+        if (kind < 60) {
+            double w = (double)(op % 97 + 1);
+            ok = graph_add_edge(g, u, v, w) == (alive[u] && alive[v]);
+            if (ok && alive[u] && alive[v]) {
+                if (matrix[u * N + v] == 0) edges++;
+                matrix[u * N + v] = w;
+            }
+        } else if (kind < 98) {
+            bool had = matrix[u * N + v] != 0;
+            ok = graph_delete_edge(g, u, v) == had;
+            if (had) edges--;
+            matrix[u * N + v] = 0;
+        } else if (alive[u] && (seed >> 60) == 0) {
+            ok = graph_delete_node(g, u);
+            for (int x = 0; x < N; x++) {
+                if (matrix[u * N + x] != 0) edges--;
+                if (x != (int)u && matrix[x * N + u] != 0) edges--;
+                matrix[u * N + x] = matrix[x * N + u] = 0;
+            }
+            alive[u] = false;
+        }
+        ok = ok && graph_edge_count(g) == edges;
+    }
+    
+    // Every row matches the matrix in both directions
+    uint32_t nodes[N];
+    double weights[N];
+    for (uint32_t u = 0; ok && u < N; u++) {
+        size_t degree = graph_neighbors(g, u, nodes, weights, N), expected = 0;
+        for (size_t i = 0; ok && i < degree; i++) ok = matrix[u * N + nodes[i]] == weights[i];
+        for (int v = 0; v < N; v++) expected += matrix[u * N + v] != 0;
+        size_t in_expected = 0;
+        for (int v = 0; v < N; v++) in_expected += matrix[v * N + u] != 0;
+        ok = ok && degree == expected && graph_out_degree(g, u) == expected &&
+             graph_in_degree(g, u) == in_expected;
+        ok = ok && graph_in_neighbors(g, u, NULL, NULL, 0) == in_expected;
+    }
+    
+    printf("%s %zu edges left, rows agree with the matrix\n\n", ok ? "✓" : "✗", edges);
+    free(matrix);
+    free(alive);
+    graph_destroy(g);
+    return ok;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Direction-optimizing BFS against the sequential one, on a graph large
+// enough to use the pool: same distances, valid parents, ordered output
+static bool parallel_test(void) {
+    enum { N = 100000, DEGREE = 8 };
+    printf("Parallel test: %d nodes, %d edges, 4 workers...\n", N, N * DEGREE);
+    Graph *g = graph_create();
+    uint32_t *order = (uint32_t*)malloc(N * sizeof(uint32_t));
+    uint32_t *tree_order = (uint32_t*)malloc(N * sizeof(uint32_t));
+    uint32_t *parent = (uint32_t*)malloc(N * sizeof(uint32_t));
+    uint32_t *tree_parent = (uint32_t*)malloc(N * sizeof(uint32_t));
+    int32_t *dist = (int32_t*)malloc(N * sizeof(int32_t));
+    int32_t *tree_dist = (int32_t*)malloc(N * sizeof(int32_t));
+    uint32_t *out = (uint32_t*)malloc(N * sizeof(uint32_t));
+    uint32_t *in = (uint32_t*)malloc(N * sizeof(uint32_t));
+    if (!g || !order || !tree_order || !parent || !tree_parent || !dist || !tree_dist ||
+        !out || !in) return false;
+    
+    graph_set_threads(g, 4);
+    for (int i = 0; i < N; i++) graph_add_node(g);
+    uint64_t seed = 42;
+    for (int i = 0; i < N * DEGREE; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        graph_add_edge(g, (uint32_t)((seed >> 33) % N), (uint32_t)((seed >> 13) % N), 1.0);
+    }
+    graph_delete_node(g, 7);  // Leave a hole in the ID range
+    
+    bool ok = true;
+    for (int round = 0; ok && round < 2; round++) {
+        if (round == 1) graph_compact(g);
+        
+        // Best of three, so allocator warm-up after compaction isn't timed
+        size_t visited, reached = 0, tree_reached = 0;
+        double sequential = 1e9, tree = 1e9;
+        for (int run = 0; run < 3; run++) {
+            double t0 = now_ms();
+            reached = graph_bfs(g, 0, GRAPH_NO_NODE, order, parent, dist, &visited);
+            double t1 = now_ms();
+            tree_reached = graph_bfs_tree(g, 0, tree_order, tree_parent, tree_dist);
+            double t2 = now_ms();
+            if (t1 - t0 < sequential) sequential = t1 - t0;
+            if (t2 - t1 < tree) tree = t2 - t1;
+        }
+        
+        ok = reached == tree_reached && reached > N / 2;
+        for (uint32_t v = 0; ok && v < N; v++) {
+            ok = dist[v] == tree_dist[v];
+            if (ok && v != 0 && tree_dist[v] > 0) {
+                uint32_t p = tree_parent[v];
+                ok = p < N && tree_dist[p] == tree_dist[v] - 1 && graph_edge_weight(g, p, v, NULL);
+            }
+        }
+        for (size_t i = 1; ok && i < tree_reached; i++) {
+            uint32_t a = tree_order[i - 1], b = tree_order[i];
+            ok = tree_dist[a] < tree_dist[b] || (tree_dist[a] == tree_dist[b] && a < b);
+        }
+        printf("  %s: %zu reached, sequential %.1f ms, direction-optimizing %.1f ms\n",
+               round ? "compacted" : "with delta", tree_reached, sequential, tree);
+    }
+    
+    ok = ok && graph_degrees(g, out, in);
+    for (uint32_t u = 0; ok && u < N; u++) {
+        ok = out[u] == graph_out_degree(g, u) && in[u] == graph_in_degree(g, u);
+    }
+    
+    printf("%s Distances match, parents are one hop closer, degrees agree\n\n",
+           ok ? "✓" : "✗");
+    free(order);
+    free(tree_order);
+    free(parent);
+    free(tree_parent);
+    free(dist);
+    free(tree_dist);
+    free(out);
+    free(in);
+    graph_destroy(g);
+    return ok;
+}
+
+// Sum the weights along path, or -1 if some hop is not an edge
+static double path_cost(Graph *g, const uint32_t *path, size_t length) {
+    double total = 0, weight;
+    for (size_t i = 1; i < length; i++) {
+        if (!graph_edge_weight(g, path[i - 1], path[i], &weight)) return -1;
+        total += weight;
+    }
+    return total;
+}
+
+// Dijkstra, bidirectional Dijkstra and A* on a weighted grid with random
+// shortcuts: equal costs, valid paths, edge cases
+static bool path_test(void) {
+    enum { SIDE = 200, N = SIDE * SIDE, QUERIES = 200 };
+    printf("Shortest path test: %dx%d grid, %d queries...\n", SIDE, SIDE, QUERIES);
+    Graph *g = graph_create();
+    double *xy = (double*)malloc(2 * N * sizeof(double));
+    uint32_t *path = (uint32_t*)malloc(N * sizeof(uint32_t));
+    if (!g || !xy || !path) return false;
+    
+    // Edge weights are at least the straight-line distance, so the
+    // euclidean heuristic is admissible
+    uint64_t seed = 7;
+    for (int i = 0; i < N; i++) {
+        graph_add_node(g);
+        xy[2 * i] = i % SIDE;
+        xy[2 * i + 1] = i / SIDE;
+    }
+    for (int i = 0; i < N; i++) {
+        int neighbors[4] = { i + 1, i - 1, i + SIDE, i - SIDE };
+        for (int k = 0; k < 4; k++) {
+            int j = neighbors[k];
+            if (j < 0 || j >= N || (k < 2 && j / SIDE != i / SIDE)) continue;
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            graph_add_edge(g, (uint32_t)i, (uint32_t)j, 1.0 + (double)(seed >> 40) / (1 << 24));
+        }
+    }
+    graph_delete_node(g, SIDE + 1);
+    
+    GraphCoordinates coords = { xy, N, 1.0 };
+    double cost, other, times[3] = { 0, 0, 0 };
+    bool ok = true;
+    for (int q = 0; ok && q < QUERIES; q++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t from = (uint32_t)((seed >> 33) % N), to = (uint32_t)((seed >> 13) % N);
+        if (!graph_node_exists(g, from) || !graph_node_exists(g, to)) continue;
+        
+        double t0 = now_ms();
+        size_t length = graph_shortest_path(g, from, to, false, path, N, &cost);
+        double t1 = now_ms();
+        ok = length > 0 && path[0] == from && path[length - 1] == to &&
+             fabs(path_cost(g, path, length) - cost) < 1e-9;
+        
+        size_t bi = graph_shortest_path(g, from, to, true, path, N, &other);
+        double t2 = now_ms();
+        ok = ok && bi > 0 && fabs(other - cost) < 1e-9 && path[0] == from &&
+             path[bi - 1] == to && fabs(path_cost(g, path, bi) - other) < 1e-9;
+        
+        size_t star = graph_astar(g, from, to, graph_euclidean_heuristic, &coords, path, N, &other);
+        double t3 = now_ms();
+        ok = ok && star > 0 && fabs(other - cost) < 1e-9 &&
+             fabs(path_cost(g, path, star) - other) < 1e-9;
+        times[0] += t1 - t0;
+        times[1] += t2 - t1;
+        times[2] += t3 - t2;
+    }
+    printf("  Dijkstra %.2f ms, bidirectional %.2f ms, A* %.2f ms per query\n",
+           times[0] / QUERIES, times[1] / QUERIES, times[2] / QUERIES);
+    
+    // Short buffer reports the length without writing; unreachable and
+    // missing nodes give 0 and an infinite cost; a node reaches itself
+    uint32_t small[2] = { GRAPH_NO_NODE, GRAPH_NO_NODE };
+    size_t length = graph_shortest_path(g, 0, N - 1, true, small, 2, &cost);
+    ok = ok && length >= 2 * SIDE - 1 && small[0] == GRAPH_NO_NODE;
+    uint32_t island = graph_add_node(g);
+    ok = ok && graph_shortest_path(g, 0, island, false, path, N, &cost) == 0 && isinf(cost);
+    ok = ok && graph_shortest_path(g, 0, island, true, path, N, &cost) == 0 && isinf(cost);
+    ok = ok && graph_astar(g, 0, SIDE + 1, NULL, NULL, path, N, &cost) == 0 && isinf(cost);
+    ok = ok && graph_shortest_path(g, 5, 5, true, path, N, &cost) == 1 && path[0] == 5 &&
+         cost == 0;
+    
+    printf("%s Costs agree across searches, paths follow edges\n\n", ok ? "✓" : "✗");
+    free(xy);
+    free(path);
+    graph_destroy(g);
+    return ok;
+}
+
+// Recursive reference enumeration; folds each path into *hash in order
+typedef struct PathReference {
+    Graph *g;
+    uint32_t target;
+    size_t max_nodes;
+    double max_cost;
+    uint32_t path[16];
+    bool on_path[16];
+    size_t count;
+    uint64_t hash;
+} PathReference;
+
+static uint64_t path_hash(uint64_t hash, const uint32_t *path, size_t length, double cost) {
+    for (size_t i = 0; i < length; i++) hash = hash * 1099511628211ull + path[i] + 1;
+    return hash * 31 + (uint64_t)(cost * 1000);
+}
+
+static void reference_paths(PathReference *ref, size_t depth, double cost) {
+    uint32_t u = ref->path[depth - 1];
+    if (u == ref->target) {
+        ref->count++;
+        ref->hash = path_hash(ref->hash, ref->path, depth, cost);
+        return;
+    }
+    if (ref->max_nodes && depth >= ref->max_nodes) return;
+    
+    uint32_t nodes[16];
+    double weights[16];
+    size_t degree = graph_neighbors(ref->g, u, nodes, weights, 16);
+    for (size_t i = 0; i < degree; i++) {
+        uint32_t v = nodes[i];
+        if (ref->on_path[v] || cost + weights[i] > ref->max_cost) continue;
+        ref->on_path[v] = true;
+        ref->path[depth] = v;
+        reference_paths(ref, depth + 1, cost + weights[i]);
+        ref->on_path[v] = false;
+    }
+}
+
+// Streaming path enumeration against the recursive reference, with and
+// without cutoffs; short buffers, stale enumerators
+static bool paths_test(void) {
+    enum { N = 9 };
+    printf("Path enumeration test: %d nodes...\n", N);
+    Graph *g = graph_create();
+    if (!g) return false;
+    
+    for (int i = 0; i < N; i++) graph_add_node(g);
+    uint64_t seed = 11;
+    for (int i = 0; i < N * 5; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        graph_add_edge(g, (uint32_t)((seed >> 33) % N), (uint32_t)((seed >> 13) % N),
+                       (double)((seed >> 50) % 5 + 1));
+    }
+    
+    size_t limits[3] = { 0, 4, 6 };
+    double costs[3] = { INFINITY, 9, 14 };
+    size_t total = 0;
+    bool ok = true;
+    for (uint32_t from = 0; ok && from < N; from++) {
+        for (uint32_t to = 0; ok && to < N; to++) {
+            for (int k = 0; ok && k < 3; k++) {
+                PathReference ref = { g, to, limits[k], costs[k], { from }, { false }, 0, 0 };
+                ref.on_path[from] = true;
+                reference_paths(&ref, 1, 0);
+                
+                GraphPaths *it = graph_paths_open(g, from, to, limits[k], costs[k]);
+                uint32_t path[N], tiny[1];
+                size_t count = 0, length;
+                uint64_t hash = 0;
+                double cost;
+                ok = it != NULL;
+                while (ok && (length = graph_paths_next(it, tiny, 1, &cost)) > 0) {
+                    if (length > 1) {
+                        ok = graph_paths_next(it, path, N, &cost) == length;
+                    } else {
+                        path[0] = tiny[0];
+                    }
+                    ok = ok && path[0] == from && path[length - 1] == to &&
+                         fabs(path_cost(g, path, length) - cost) < 1e-9;
+                    hash = path_hash(hash, path, length, cost);
+                    count++;
+                }
+                ok = ok && isinf(cost) && count == ref.count && hash == ref.hash;
+                total += count;
+                graph_paths_close(it);
+            }
+        }
+    }
+    printf("  %zu paths streamed across all pairs and cutoffs\n", total);
+    
+    // Editing the graph ends an open enumeration
+    GraphPaths *it = graph_paths_open(g, 0, N - 1, 0, INFINITY);
+    uint32_t path[N];
+    double cost;
+    ok = ok && it && !graph_paths_stale(it);
+    graph_add_node(g);
+    ok = ok && graph_paths_stale(it) && graph_paths_next(it, path, N, &cost) == 0 && isnan(cost);
+    graph_paths_close(it);
+    
+    it = graph_paths_open(g, 0, 1000, 0, INFINITY);
+    ok = ok && it && graph_paths_next(it, path, N, &cost) == 0 && isinf(cost);
+    graph_paths_close(it);
+    
+    printf("%s Streamed paths match the recursive enumeration\n\n", ok ? "✓" : "✗");
+    graph_destroy(g);
+    return ok;
+}
+
+// Write `header` over the file's and see whether it is accepted
+static bool file_opens_as(const char *path, int fd, const GraphFileHeader *header) {
+    if (pwrite(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) return false;
+    GraphFile *f = graph_file_open(path);
+    graph_file_close(f);
+    return f != NULL;
+}
+
+// Save a graph with holes, self-loops and weights, load it back renumbered,
+// compare every row; unit weights drop the column; corrupt files fail
+static bool file_test(void) {
+    enum { N = 3000 };
+    printf("Graph file test: %d nodes...\n", N);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/graph_engine_test_%d.wgb", (int)getpid());
+    Graph *g = graph_create(), *loaded = graph_create();
+    uint32_t *renumber = (uint32_t*)malloc(N * sizeof(uint32_t));
+    char *names = (char*)malloc(N * 8);
+    if (!g || !loaded || !renumber || !names) return false;
+    
+    for (int i = 0; i < N; i++) graph_add_node(g);
+    uint64_t seed = 5;
+    for (int i = 0; i < N * 6; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t from = (uint32_t)((seed >> 33) % N);
+        uint32_t to = i % 50 == 0 ? from : (uint32_t)((seed >> 13) % N);
+        graph_add_edge(g, from, to, (double)(seed >> 54) / 4);
+    }
+    for (uint32_t u = 0; u < N; u += 7) graph_delete_node(g, u);
+    
+    char *p = names;
+    uint32_t live = 0;
+    for (uint32_t u = 0; u < N; u++) {
+        renumber[u] = graph_node_exists(g, u) ? live++ : GRAPH_NO_NODE;
+        if (renumber[u] != GRAPH_NO_NODE) p += sprintf(p, "n%u", u) + 1;
+    }
+    
+    const char *tables[2] = { names, names };
+    bool ok = graph_save(g, path, 3, tables, 2);
+    GraphFile *f = ok ? graph_file_open(path) : NULL;
+    GraphFileInfo info;
+    size_t size = 0;
+    ok = f != NULL;
+    if (ok) graph_file_info(f, &info);
+    ok = ok && info.flags == 3 && info.nodes == live && info.edges == graph_edge_count(g) &&
+         info.table_count == 2 && graph_file_table(f, 1, &size) != NULL &&
+         size == (size_t)(p - names) && memcmp(graph_file_table(f, 1, NULL), names, size) == 0;
+    ok = ok && graph_add_node(loaded) != GRAPH_NO_NODE && graph_file_load(f, loaded);
+    graph_file_close(f);
+    
+    ok = ok && graph_node_count(loaded) == live && graph_node_capacity(loaded) == live &&
+         graph_edge_count(loaded) == graph_edge_count(g) &&
+         graph_component_count(loaded) == graph_component_count(g);
+    uint32_t nodes[64], loaded_nodes[64];
+    double weights[64], loaded_weights[64];
+    for (uint32_t u = 0; ok && u < N; u++) {
+        if (renumber[u] == GRAPH_NO_NODE) continue;
+        size_t degree = graph_neighbors(g, u, nodes, weights, 64);
+        ok = degree <= 64 &&
+             graph_neighbors(loaded, renumber[u], loaded_nodes, loaded_weights, 64) == degree &&
+             graph_in_degree(loaded, renumber[u]) == graph_in_degree(g, u);
+        for (size_t i = 0; ok && i < degree; i++) {
+            double weight;
+            ok = loaded_nodes[i] == renumber[nodes[i]] && loaded_weights[i] == weights[i] &&
+                 graph_edge_weight(loaded, renumber[u], loaded_nodes[i], &weight) &&
+                 weight == weights[i];
+        }
+    }
+    
+    // The loaded graph is an ordinary one: it takes edits
+    ok = ok && graph_add_edge(loaded, 0, live - 1, 2.5) && graph_delete_node(loaded, 1) &&
+         graph_add_node(loaded) == live;
+    
+    // All-unit weights leave the column out; damaged files are refused
+    Graph *unit = graph_create();
+    for (int i = 0; i < 4; i++) graph_add_node(unit);
+    graph_add_edge(unit, 3, 0, 1.0);
+    graph_add_edge(unit, 0, 2, 1.0);
+    struct stat st;
+    ok = ok && graph_save(unit, path, 0, NULL, 0) && stat(path, &st) == 0 &&
+         (size_t)st.st_size < sizeof(GraphFileHeader) + 16;
+    f = graph_file_open(path);
+    ok = ok && f && graph_file_load(f, loaded) && graph_node_count(loaded) == 4 &&
+         graph_edge_weight(loaded, 3, 0, NULL) && graph_in_degree(loaded, 2) == 1;
+    graph_file_close(f);
+    
+    // Counts the rows are too short for are refused before any allocation
+    GraphFileHeader header, corrupt;
+    int fd = ok ? open(path, O_RDWR) : -1;
+    ok = fd >= 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header);
+    corrupt = header;
+    corrupt.nodes = 1u << 30;
+    ok = ok && !file_opens_as(path, fd, &corrupt);
+    corrupt = header;
+    corrupt.edges = header.rows_size;
+    ok = ok && !file_opens_as(path, fd, &corrupt) && file_opens_as(path, fd, &header);
+    if (fd >= 0) close(fd);
+    ok = ok && truncate(path, st.st_size - 1) == 0 && graph_file_open(path) == NULL;
+    
+    printf("%s Rows, weights and tables survive a save and load\n\n", ok ? "✓" : "✗");
+    remove(path);
+    free(renumber);
+    free(names);
+    graph_destroy(unit);
+    graph_destroy(loaded);
+    graph_destroy(g);
+    return ok;
+}
+
+// Component labels after interleaved edits, against a flood fill over a
+// symmetric adjacency matrix. The edge count hovers near N / 2, where
+// components keep merging and splitting. Counts are also read between
+// checks, as a dashboard would.
+static bool components_test(void) {
+    enum { N = 300, OPS = 20000, CHECK = 500 };
+    printf("Components test: %d edits on %d nodes...\n", OPS, N);
+    Graph *g = graph_create();
+    uint8_t *matrix = (uint8_t*)calloc(N * N, 1);
+    uint32_t *edges = (uint32_t*)malloc(2 * N * N * sizeof(uint32_t));
+    bool alive[N];
+    uint32_t labels[N], expected[N], stack[N];
+    if (!g || !matrix || !edges) return false;
+    
+    for (int i = 0; i < N; i++) alive[i] = graph_add_node(g) == (uint32_t)i;
+    uint64_t seed = 99;
+    size_t relabels = 0, edge_count = 0;
+    bool ok = true;
+    for (int op = 0; ok && op < OPS; op++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t u = (uint32_t)((seed >> 33) % N), v = (uint32_t)((seed >> 13) % N);
+        
+        if ((seed >> 56) == 0 && alive[u]) {
+            graph_delete_node(g, u);
+            for (int x = 0; x < N; x++) matrix[u * N + x] = matrix[x * N + u] = 0;
+            alive[u] = false;
+        } else if (edge_count < N / 2) {
+            if (alive[u] && alive[v] && !matrix[u * N + v]) {
+                graph_add_edge(g, u, v, 1.0);
+                matrix[u * N + v] = 1;
+                edges[2 * edge_count] = u;
+                edges[2 * edge_count++ + 1] = v;
+            }
+        } else {
+            // Drop a random remembered edge (already gone if an end was deleted)
+            size_t i = (seed >> 20) % edge_count;
+            uint32_t a = edges[2 * i], b = edges[2 * i + 1];
+            graph_delete_edge(g, a, b);
+            matrix[a * N + b] = 0;
+            edges[2 * i] = edges[2 * --edge_count];
+            edges[2 * i + 1] = edges[2 * edge_count + 1];
+        }
+        if (op % CHECK != 0) {
+            graph_component_count(g);
+            continue;
+        }
+        
+        // Flood fill from each unlabelled node in ID order gives the
+        // smallest ID of each component as its label
+        size_t count = 0;
+        for (uint32_t x = 0; x < N; x++) expected[x] = GRAPH_NO_NODE;
+        for (uint32_t x = 0; x < N; x++) {
+            if (!alive[x] || expected[x] != GRAPH_NO_NODE) continue;
+            size_t top = 0;
+            stack[top++] = x;
+            expected[x] = x;
+            count++;
+            while (top > 0) {
+                uint32_t y = stack[--top];
+                for (uint32_t z = 0; z < N; z++) {
+                    if ((matrix[y * N + z] || matrix[z * N + y]) && expected[z] == GRAPH_NO_NODE) {
+                        expected[z] = x;
+                        stack[top++] = z;
+                    }
+                }
+            }
+        }
+        ok = graph_component_count(g) == count && graph_components(g, labels) &&
+             memcmp(labels, expected, sizeof(labels)) == 0 &&
+             graph_component(g, u) == expected[u];
+        relabels++;
+    }
+    
+    printf("  %zu components at the end\n", graph_component_count(g));
+    printf("%s Components agree with a flood fill at %zu checkpoints\n\n",
+           ok ? "✓" : "✗", relabels);
+    free(matrix);
+    free(edges);
+    graph_destroy(g);
+    return ok;
+}
+
+// Filters against a direct evaluation of the same predicate, node by node,
+// over random values with gaps, deleted nodes, NaN and extreme integers;
+// then one range filter over a million nodes
+static int64_t random_int(uint64_t *seed) {
+    *seed = *seed * 6364136223846793005ull + 1442695040888963407ull;
+    switch ((*seed >> 60) & 3) {
+        case 0: return (int64_t)(*seed >> 7) * ((*seed & 1) ? 1 : -1);  // Anywhere
+        case 1: return *seed & 2 ? INT64_MAX : INT64_MIN;
+        default: return (int64_t)((*seed >> 33) % 100) - 50;
+    }
+}
+
+static bool props_test(void) {
+    enum { N = 5000, ROUNDS = 300 };
+    static const char *words[] = { "red", "green", "blue", "cyan", "magenta", "yellow",
+                                   "black", "white", "grey", "orange", "pink", "brown" };
+    printf("Properties test: %d filters over %d nodes...\n", ROUNDS, N);
+    Graph *g = graph_create();
+    int64_t ints[N];
+    double doubles[N];
+    const char *strings[N];
+    bool has_int[N], has_double[N], has_string[N];
+    uint64_t bits[GRAPH_BITMAP_WORDS(N)], expected[GRAPH_BITMAP_WORDS(N)];
+    uint32_t ids[N];
+    if (!g) return false;
+    
+    int ci = graph_prop_column(g, "age", GRAPH_PROP_INT);
+    int cd = graph_prop_column(g, "score", GRAPH_PROP_DOUBLE);
+    int cs = graph_prop_column(g, "color", GRAPH_PROP_STRING);
+    bool ok = ci == 0 && cd == 1 && cs == 2 && graph_prop_column(g, "age", GRAPH_PROP_INT) == 0 &&
+              graph_prop_column(g, "age", GRAPH_PROP_STRING) == -1;
+    
+    uint64_t seed = 7;
+    for (uint32_t u = 0; u < N; u++) {
+        ids[u] = graph_add_node(g);
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        ints[u] = random_int(&seed);
+        doubles[u] = (seed >> 40) % 17 == 0 ? NAN : (double)((seed >> 20) % 2000) / 10 - 100;
+        strings[u] = words[(seed >> 10) % 12];
+        has_int[u] = (seed >> 3) % 5 != 0;
+        has_double[u] = (seed >> 5) % 4 != 0;
+        has_string[u] = (seed >> 7) % 3 != 0;
+        if (has_int[u]) ok = ok && graph_prop_set_ints(g, ci, &u, &ints[u], 1) == 1;
+        if (has_double[u]) ok = ok && graph_prop_set_doubles(g, cd, &u, &doubles[u], 1) == 1;
+        if (has_string[u]) ok = ok && graph_prop_set_strings(g, cs, &u, &strings[u], 1) == 1;
+    }
+    for (uint32_t u = 0; u < N; u += 97) {
+        graph_delete_node(g, u);
+        has_int[u] = has_double[u] = has_string[u] = false;
+    }
+    for (uint32_t u = 1; u < N; u += 101) {
+        if (graph_prop_unset(g, ci, u) != has_int[u]) ok = false;
+        has_int[u] = false;
+    }
+    int64_t got_int = 0;
+    ok = ok && !graph_prop_get_int(g, ci, 0, &got_int) && !graph_prop_get_double(g, ci, 2, NULL) &&
+         (has_int[2] ? graph_prop_get_int(g, ci, 2, &got_int) && got_int == ints[2] : true) &&
+         (has_string[3] ? strcmp(graph_prop_get_string(g, cs, 3), strings[3]) == 0 : true);
+    
+    size_t total = 0;
+    for (int round = 0; ok && round < ROUNDS; round++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        int kind = (int)(seed >> 61) % 4;
+        bool intersect = round % 3 == 2;
+        int64_t lo = random_int(&seed), hi = random_int(&seed);
+        if (round % 4 == 0 && lo > hi) { int64_t t = lo; lo = hi; hi = t; }
+        double dlo = (double)((seed >> 20) % 2400) / 10 - 120, dhi = dlo + (double)(round % 50);
+        int64_t set[20];
+        const char *names[20];
+        size_t count = round % 2 ? 3 : 20;
+        for (size_t k = 0; k < count; k++) {
+            set[k] = ints[(seed >> 11) % N] ^ (int64_t)(k % 2);
+            names[k] = k % 5 == 4 ? "violet" : words[(seed >> (k % 40)) % 12];
+        }
+        
+        if (intersect) {
+            memcpy(expected, bits, sizeof(bits));
+        } else {
+            memset(expected, 0xff, sizeof(expected));
+        }
+        size_t want = 0;
+        for (uint32_t u = 0; u < N; u++) {
+            bool match;
+            switch (kind) {
+                case 0: match = has_int[u] && ints[u] >= lo && ints[u] <= hi; break;
+                case 1: match = has_double[u] && doubles[u] >= dlo && doubles[u] <= dhi; break;
+                case 2:
+                    match = false;
+                    for (size_t k = 0; k < count; k++) match = match || (has_int[u] && ints[u] == set[k]);
+                    break;
+                default:
+                    match = false;
+                    for (size_t k = 0; k < count; k++) {
+                        match = match || (has_string[u] && strcmp(strings[u], names[k]) == 0);
+                    }
+            }
+            if (!match || !bit_test(expected, u)) expected[u >> 6] &= ~(1ull << (u & 63));
+            want += bit_test(expected, u);
+        }
+        // Bits past the last node ID are never set
+        expected[GRAPH_BITMAP_WORDS(N) - 1] &= (1ull << (N % 64)) - 1;
+        
+        size_t hits;
+        switch (kind) {
+            case 0: hits = graph_prop_match_int_range(g, ci, lo, hi, intersect, bits); break;
+            case 1: hits = graph_prop_match_double_range(g, cd, dlo, dhi, intersect, bits); break;
+            case 2: hits = graph_prop_match_int_in(g, ci, set, count, intersect, bits); break;
+            default: hits = graph_prop_match_string_in(g, cs, names, count, intersect, bits);
+        }
+        ok = hits == want && memcmp(bits, expected, sizeof(bits)) == 0 &&
+             graph_bitmap_nodes(bits, N, ids) == want;
+        total += hits;
+    }
+    
+    // A missing column, or one of another type, matches nothing
+    ok = ok && graph_prop_match_int_range(g, 9, INT64_MIN, INT64_MAX, false, bits) == 0 &&
+         graph_prop_match_int_range(g, cd, INT64_MIN, INT64_MAX, false, bits) == 0 &&
+         graph_prop_match_int_range(g, ci, INT64_MIN, INT64_MAX, false, bits) > 0;
+    printf("  %zu matches in all\n", total);
+    graph_destroy(g);
+    
+    // Timing: a range and an IN filter over a million nodes, combined
+    enum { BIG = 1 << 20 };
+    g = graph_create();
+    int64_t *big = (int64_t*)malloc(BIG * sizeof(int64_t));
+    uint32_t *nodes = (uint32_t*)malloc(BIG * sizeof(uint32_t));
+    uint64_t *big_bits = (uint64_t*)malloc(GRAPH_BITMAP_WORDS(BIG) * sizeof(uint64_t));
+    const char **colors = (const char**)malloc(BIG * sizeof(char*));
+    if (!g || !big || !nodes || !big_bits || !colors) return false;
+    for (uint32_t u = 0; u < BIG; u++) {
+        nodes[u] = graph_add_node(g);
+        big[u] = (int64_t)((u * 2654435761u) % 100000);
+        colors[u] = words[u % 12];
+    }
+    ci = graph_prop_column(g, "age", GRAPH_PROP_INT);
+    cs = graph_prop_column(g, "color", GRAPH_PROP_STRING);
+    ok = ok && graph_prop_set_ints(g, ci, nodes, big, BIG) == BIG &&
+         graph_prop_set_strings(g, cs, nodes, colors, BIG) == BIG;
+    const char *wanted[] = { "red", "blue" };
+    double start = now_ms();
+    size_t ranged = graph_prop_match_int_range(g, ci, 1000, 5999, false, big_bits);
+    double ranged_ms = now_ms() - start;
+    size_t both = graph_prop_match_string_in(g, cs, wanted, 2, true, big_bits);
+    double both_ms = now_ms() - start;
+    ok = ok && ranged > 0 && both > 0 && both < ranged;
+    printf("  %d nodes: range filter %.2f ms (%zu), then AND IN filter %.2f ms (%zu)\n",
+           BIG, ranged_ms, ranged, both_ms - ranged_ms, both);
+    free(big);
+    free(nodes);
+    free(big_bits);
+    free(colors);
+    graph_destroy(g);
+    printf("%s Property filters agree with direct evaluation\n\n", ok ? "✓" : "✗");
+    return ok;
+}
+
+int main(void) {
+    printf("=== Graph Engine Test ===\n\n");
+    
+    if (!basic_test() || !traversal_test() || !random_test() || !parallel_test() ||
+        !path_test() || !paths_test() || !file_test() || !components_test() ||
+        !props_test()) {
+        printf("✗ Graph engine test failed\n");
+        return 1;
+    }
+    
+    printf("✓ All graph engine tests passed\n");
+    return 0;
+}
+
+#endif
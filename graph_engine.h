@@ -0,0 +1,208 @@
+#ifndef GRAPH_ENGINE_H
+#define GRAPH_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Opaque graph handle
+typedef struct Graph Graph;
+
+// Node IDs are dense integers handed out by graph_add_node; deleted IDs
+// are not reused. GRAPH_NO_NODE marks "none" in results and arguments.
+#define GRAPH_NO_NODE UINT32_MAX
+
+// Lifecycle
+Graph* graph_create(void);
+void graph_destroy(Graph *g);
+void graph_clear(Graph *g);
+
+// Nodes
+uint32_t graph_add_node(Graph *g);
+bool graph_delete_node(Graph *g, uint32_t node);
+bool graph_node_exists(const Graph *g, uint32_t node);
+
+// Directed edges. Adding an edge that exists replaces its weight and moves
+// it to the end of both adjacency lists, like deleting and re-adding it.
+bool graph_add_edge(Graph *g, uint32_t from, uint32_t to, double weight);
+bool graph_delete_edge(Graph *g, uint32_t from, uint32_t to);
+bool graph_edge_weight(Graph *g, uint32_t from, uint32_t to, double *weight);
+
+// Adjacency in insertion order: copies up to `cap` neighbors (and their
+// weights, if `weights` is not NULL) and returns the full degree
+size_t graph_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights,
+                       size_t cap);
+size_t graph_in_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights,
+                          size_t cap);
+size_t graph_out_degree(const Graph *g, uint32_t node);  // O(1), from counters
+size_t graph_in_degree(const Graph *g, uint32_t node);
+
+// Counts: live nodes, node IDs issued (the size result arrays need), edges
+size_t graph_node_count(const Graph *g);
+size_t graph_node_capacity(const Graph *g);
+size_t graph_edge_count(const Graph *g);
+
+// Fold recent edits into the compressed (CSR) arrays. Writers do this on
+// their own once the edits outweigh half the graph; call it before a
+// read-heavy phase to traverse only the compact layout.
+bool graph_compact(Graph *g);
+
+// Traversals. Result arrays hold graph_node_capacity() entries.
+//
+// graph_bfs: breadth-first from start until target is dequeued (or the
+// queue empties when target is GRAPH_NO_NODE). order receives nodes in
+// discovery order; parent[v] and dist[v] are set for discovered nodes and
+// GRAPH_NO_NODE / -1 elsewhere. Returns the number discovered and sets
+// *visited to how many of them were dequeued.
+size_t graph_bfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+                 uint32_t *parent, int32_t *dist, size_t *visited);
+
+// graph_dfs: depth-first preorder from start, neighbors in adjacency
+// order, stopping at target. order receives the visited nodes and parent
+// their tree parents. Returns the number visited, or 0 if start is absent.
+size_t graph_dfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+                 uint32_t *parent, bool *found);
+
+// Parallel kernels. Large graphs are split across a pool of worker threads
+// (started on first use, stopped by graph_destroy); small ones run on the
+// calling thread. Don't change the thread count while a kernel runs.
+void graph_set_threads(Graph *g, unsigned threads);  // 0: one per online CPU
+
+// graph_bfs_tree: whole-graph BFS from start, switching between top-down
+// and bottom-up steps by frontier size. dist[v] is the exact hop count (-1
+// if unreachable) and parent[v] a neighbor one hop closer to start (any
+// one, if several). order, unless NULL, receives the reached nodes by
+// distance and then by ID. Returns the number reached, 0 on failure.
+size_t graph_bfs_tree(Graph *g, uint32_t start, uint32_t *order, uint32_t *parent,
+                      int32_t *dist);
+
+// Statistics kept up to date by every change, so reading them is cheap.
+//
+// graph_degrees: out- and in-degree of every node ID (0 for deleted IDs);
+// either array may be NULL
+bool graph_degrees(Graph *g, uint32_t *out, uint32_t *in);
+
+// Weakly connected components (edge direction ignored), labelled by their
+// smallest node ID. Union-find keeps them current while edges are only
+// added; deleting an edge or a connected node marks them stale and the
+// next query relabels the graph in one O(V + E) pass. Queries compress
+// paths, so they must not run concurrently with each other or writers.
+size_t graph_component_count(Graph *g);
+uint32_t graph_component(Graph *g, uint32_t node);  // GRAPH_NO_NODE if absent
+bool graph_components(Graph *g, uint32_t *labels);  // GRAPH_NO_NODE for deleted IDs
+
+// Shortest paths over non-negative weights. Each returns the number of
+// nodes on the path (from and to included) and writes them into path when
+// they fit in cap, so a caller can retry with a bigger buffer. 0 means no
+// path (*cost INFINITY) or out of memory (*cost NaN). Queries reuse
+// per-graph workspaces, one per concurrent caller; they can run in
+// parallel with each other but not with writers.
+size_t graph_shortest_path(Graph *g, uint32_t from, uint32_t to, bool bidirectional,
+                           uint32_t *path, size_t cap, double *cost);
+
+// A*: heuristic(node, target, ctx) must not overestimate the remaining cost
+typedef double (*GraphHeuristic)(uint32_t node, uint32_t target, void *ctx);
+size_t graph_astar(Graph *g, uint32_t from, uint32_t to, GraphHeuristic heuristic, void *ctx,
+                   uint32_t *path, size_t cap, double *cost);
+
+// Built-in heuristic: scale times the straight-line distance between
+// (x, y) coordinates, xy[2 * node] and xy[2 * node + 1], NaN if unknown
+typedef struct GraphCoordinates {
+    const double *xy;
+    size_t count;           // Nodes covered by xy
+    double scale;           // Cost per unit of distance, at most the cheapest
+} GraphCoordinates;
+double graph_euclidean_heuristic(uint32_t node, uint32_t target, void *ctx);
+
+// Simple paths (no repeated node) from -> to, streamed in depth-first
+// order with neighbors in adjacency order. Memory grows with the longest
+// path, not the number of paths. max_nodes bounds the nodes per path (0:
+// no bound) and max_cost the summed weight (INFINITY: no bound); cost
+// pruning assumes non-negative weights. Any change to the graph ends the
+// enumeration.
+typedef struct GraphPaths GraphPaths;
+GraphPaths* graph_paths_open(const Graph *g, uint32_t from, uint32_t to, size_t max_nodes,
+                             double max_cost);
+size_t graph_paths_next(GraphPaths *it, uint32_t *path, size_t cap, double *cost);
+bool graph_paths_stale(const GraphPaths *it);
+void graph_paths_close(GraphPaths *it);
+
+// Binary graph files. graph_save writes the live nodes (renumbered 0 ..
+// n-1 in ID order), their edges and up to GRAPH_FILE_MAX_TABLES string
+// tables: buffers of NUL-terminated strings, one per live node in ID
+// order. graph_file_open maps a file; its tables are read in place and
+// graph_file_load decodes the edges straight into the engine's arrays.
+#define GRAPH_FILE_MAX_TABLES 4
+
+typedef struct GraphFile GraphFile;
+
+typedef struct GraphFileInfo {
+    uint32_t flags;         // As passed to graph_save
+    size_t nodes;
+    size_t edges;
+    size_t self_loops;
+    size_t table_count;
+} GraphFileInfo;
+
+bool graph_save(const Graph *g, const char *path, uint32_t flags, const char *const *tables,
+                size_t table_count);
+GraphFile* graph_file_open(const char *path);
+void graph_file_info(const GraphFile *f, GraphFileInfo *info);
+const char* graph_file_table(const GraphFile *f, size_t table, size_t *size);
+bool graph_file_load(const GraphFile *f, Graph *g);
+void graph_file_close(GraphFile *f);
+
+// Node properties in typed columns: one array of int64, double or string
+// values per property, indexed by node ID, with a bitmap of the nodes that
+// have one. Strings are dictionary-encoded per column. Deleting a node
+// drops its values; graph_clear and graph_file_load drop every column.
+//
+// graph_prop_column finds or adds the column called name; -1 if that name
+// has another type or memory ran out. graph_prop_find returns -1 if there
+// is no such column, and its type through *type unless NULL.
+typedef enum GraphPropType {
+    GRAPH_PROP_INT = 0,
+    GRAPH_PROP_DOUBLE = 1,
+    GRAPH_PROP_STRING = 2
+} GraphPropType;
+
+int graph_prop_column(Graph *g, const char *name, GraphPropType type);
+int graph_prop_find(const Graph *g, const char *name, GraphPropType *type);
+
+// Set values[i] for nodes[i], in bulk; nodes that don't exist are skipped.
+// Returns how many were set (fewer than count also if memory ran out), 0
+// if column isn't of the setter's type.
+size_t graph_prop_set_ints(Graph *g, int column, const uint32_t *nodes, const int64_t *values,
+                           size_t count);
+size_t graph_prop_set_doubles(Graph *g, int column, const uint32_t *nodes, const double *values,
+                              size_t count);
+size_t graph_prop_set_strings(Graph *g, int column, const uint32_t *nodes,
+                              const char *const *values, size_t count);
+bool graph_prop_unset(Graph *g, int column, uint32_t node);
+
+// False / NULL if the node has no value in the column
+bool graph_prop_get_int(const Graph *g, int column, uint32_t node, int64_t *value);
+bool graph_prop_get_double(const Graph *g, int column, uint32_t node, double *value);
+const char* graph_prop_get_string(const Graph *g, int column, uint32_t node);
+
+// Filters scan a column with SIMD compares and write one bit per node ID
+// into bits, GRAPH_BITMAP_WORDS(graph_node_capacity()) words: set where
+// the node has a value and it matches. With intersect, bits already clear
+// stay clear, so successive filters AND together. Ranges are inclusive
+// (equality is lo == hi; NaN matches nothing), IN matches any of count
+// values. A missing column matches nothing. Returns the bits set.
+#define GRAPH_BITMAP_WORDS(nodes) (((nodes) + 63) / 64)
+
+size_t graph_prop_match_int_range(const Graph *g, int column, int64_t lo, int64_t hi,
+                                  bool intersect, uint64_t *bits);
+size_t graph_prop_match_double_range(const Graph *g, int column, double lo, double hi,
+                                     bool intersect, uint64_t *bits);
+size_t graph_prop_match_int_in(const Graph *g, int column, const int64_t *values, size_t count,
+                               bool intersect, uint64_t *bits);
+size_t graph_prop_match_string_in(const Graph *g, int column, const char *const *values,
+                                  size_t count, bool intersect, uint64_t *bits);
+
+// Node IDs of the set bits, ascending; nodes holds the count a filter returned
+size_t graph_bitmap_nodes(const uint64_t *bits, size_t node_capacity, uint32_t *nodes);
+
+#endif
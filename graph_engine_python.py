@@ -0,0 +1,933 @@
+"""
+Native Graph Engine - Python Wrapper
+
+Python interface to the C graph engine (graph_engine.c) using ctypes.
+Nodes are dense integer IDs; graph_db.py maps node names onto them.
+
+Usage:
+    from graph_engine_python import GraphEngine
+    
+    g = GraphEngine()
+    a, b = g.add_node(), g.add_node()
+    g.add_edge(a, b, 2.5)
+    print(g.neighbors(a))  # ([1], [2.5])
+"""
+
+import ctypes
+import math
+import os
+import sys
+import threading
+from typing import Callable, Iterator, List, Optional, Sequence, Tuple, Union
+
+# Determine the library name based on platform
+if sys.platform == 'darwin':
+    LIB_NAME = 'libgraphengine.dylib'
+elif sys.platform == 'win32':
+    LIB_NAME = 'graphengine.dll'
+else:
+    LIB_NAME = 'libgraphengine.so'
+
+# Find the library in the current directory or bin directory
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+LIB_PATHS = [
+    os.path.join(SCRIPT_DIR, LIB_NAME),
+    os.path.join(SCRIPT_DIR, 'bin', LIB_NAME),
+    os.path.join(SCRIPT_DIR, '..', 'bin', LIB_NAME),
+]
+
+# Load the shared library
+lib = None
+for lib_path in LIB_PATHS:
+    if os.path.exists(lib_path):
+        lib = ctypes.CDLL(lib_path)
+        break
+
+if lib is None:
+    raise RuntimeError(f"Could not find {LIB_NAME}. Please compile the library first (make build-graph).")
+
+# Marks "no node" in results and arguments (GRAPH_NO_NODE)
+NO_NODE = 0xFFFFFFFF
+
+# Property column types (GraphPropType)
+PROP_INT = 0
+PROP_DOUBLE = 1
+PROP_STRING = 2
+
+INT64_MIN = -(1 << 63)
+INT64_MAX = (1 << 63) - 1
+
+# ============================================================================
+# C Function Signatures
+# ============================================================================
+
+# Graph* graph_create(void)
+lib.graph_create.argtypes = []
+lib.graph_create.restype = ctypes.c_void_p
+
+# void graph_destroy(Graph *g)
+lib.graph_destroy.argtypes = [ctypes.c_void_p]
+lib.graph_destroy.restype = None
+
+# void graph_clear(Graph *g)
+lib.graph_clear.argtypes = [ctypes.c_void_p]
+lib.graph_clear.restype = None
+
+# uint32_t graph_add_node(Graph *g)
+lib.graph_add_node.argtypes = [ctypes.c_void_p]
+lib.graph_add_node.restype = ctypes.c_uint32
+
+# bool graph_delete_node(Graph *g, uint32_t node)
+lib.graph_delete_node.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+lib.graph_delete_node.restype = ctypes.c_bool
+
+# bool graph_node_exists(const Graph *g, uint32_t node)
+lib.graph_node_exists.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+lib.graph_node_exists.restype = ctypes.c_bool
+
+# bool graph_add_edge(Graph *g, uint32_t from, uint32_t to, double weight)
+lib.graph_add_edge.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_double]
+lib.graph_add_edge.restype = ctypes.c_bool
+
+# bool graph_delete_edge(Graph *g, uint32_t from, uint32_t to)
+lib.graph_delete_edge.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32]
+lib.graph_delete_edge.restype = ctypes.c_bool
+
+# bool graph_edge_weight(Graph *g, uint32_t from, uint32_t to, double *weight)
+lib.graph_edge_weight.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                                  ctypes.POINTER(ctypes.c_double)]
+lib.graph_edge_weight.restype = ctypes.c_bool
+
+# size_t graph_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights, size_t cap)
+lib.graph_neighbors.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint32),
+                                ctypes.POINTER(ctypes.c_double), ctypes.c_size_t]
+lib.graph_neighbors.restype = ctypes.c_size_t
+
+# size_t graph_in_neighbors(const Graph *g, uint32_t node, uint32_t *nodes, double *weights, size_t cap)
+lib.graph_in_neighbors.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint32),
+                                   ctypes.POINTER(ctypes.c_double), ctypes.c_size_t]
+lib.graph_in_neighbors.restype = ctypes.c_size_t
+
+# size_t graph_out_degree(const Graph *g, uint32_t node)
+lib.graph_out_degree.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+lib.graph_out_degree.restype = ctypes.c_size_t
+
+# size_t graph_in_degree(const Graph *g, uint32_t node)
+lib.graph_in_degree.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+lib.graph_in_degree.restype = ctypes.c_size_t
+
+# size_t graph_node_count(const Graph *g)
+lib.graph_node_count.argtypes = [ctypes.c_void_p]
+lib.graph_node_count.restype = ctypes.c_size_t
+
+# size_t graph_node_capacity(const Graph *g)
+lib.graph_node_capacity.argtypes = [ctypes.c_void_p]
+lib.graph_node_capacity.restype = ctypes.c_size_t
+
+# size_t graph_edge_count(const Graph *g)
+lib.graph_edge_count.argtypes = [ctypes.c_void_p]
+lib.graph_edge_count.restype = ctypes.c_size_t
+
+# bool graph_compact(Graph *g)
+lib.graph_compact.argtypes = [ctypes.c_void_p]
+lib.graph_compact.restype = ctypes.c_bool
+
+# size_t graph_bfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+#                  uint32_t *parent, int32_t *dist, size_t *visited)
+lib.graph_bfs.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                          ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint32),
+                          ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_size_t)]
+lib.graph_bfs.restype = ctypes.c_size_t
+
+# size_t graph_dfs(const Graph *g, uint32_t start, uint32_t target, uint32_t *order,
+#                  uint32_t *parent, bool *found)
+lib.graph_dfs.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                          ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint32),
+                          ctypes.POINTER(ctypes.c_bool)]
+lib.graph_dfs.restype = ctypes.c_size_t
+
+# void graph_set_threads(Graph *g, unsigned threads)
+lib.graph_set_threads.argtypes = [ctypes.c_void_p, ctypes.c_uint]
+lib.graph_set_threads.restype = None
+
+# size_t graph_bfs_tree(Graph *g, uint32_t start, uint32_t *order, uint32_t *parent, int32_t *dist)
+lib.graph_bfs_tree.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint32),
+                               ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_int32)]
+lib.graph_bfs_tree.restype = ctypes.c_size_t
+
+# bool graph_degrees(Graph *g, uint32_t *out, uint32_t *in)
+lib.graph_degrees.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32),
+                              ctypes.POINTER(ctypes.c_uint32)]
+lib.graph_degrees.restype = ctypes.c_bool
+
+# size_t graph_component_count(Graph *g)
+lib.graph_component_count.argtypes = [ctypes.c_void_p]
+lib.graph_component_count.restype = ctypes.c_size_t
+
+# uint32_t graph_component(Graph *g, uint32_t node)
+lib.graph_component.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+lib.graph_component.restype = ctypes.c_uint32
+
+# bool graph_components(Graph *g, uint32_t *labels)
+lib.graph_components.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32)]
+lib.graph_components.restype = ctypes.c_bool
+
+# typedef double (*GraphHeuristic)(uint32_t node, uint32_t target, void *ctx)
+GraphHeuristic = ctypes.CFUNCTYPE(ctypes.c_double, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_void_p)
+
+
+# typedef struct GraphCoordinates { const double *xy; size_t count; double scale; }
+class GraphCoordinates(ctypes.Structure):
+    _fields_ = [("xy", ctypes.POINTER(ctypes.c_double)),
+                ("count", ctypes.c_size_t),
+                ("scale", ctypes.c_double)]
+
+
+# size_t graph_shortest_path(Graph *g, uint32_t from, uint32_t to, bool bidirectional,
+#                            uint32_t *path, size_t cap, double *cost)
+lib.graph_shortest_path.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                                    ctypes.c_bool, ctypes.POINTER(ctypes.c_uint32),
+                                    ctypes.c_size_t, ctypes.POINTER(ctypes.c_double)]
+lib.graph_shortest_path.restype = ctypes.c_size_t
+
+# size_t graph_astar(Graph *g, uint32_t from, uint32_t to, GraphHeuristic heuristic, void *ctx,
+#                    uint32_t *path, size_t cap, double *cost)
+lib.graph_astar.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32, GraphHeuristic,
+                            ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32), ctypes.c_size_t,
+                            ctypes.POINTER(ctypes.c_double)]
+lib.graph_astar.restype = ctypes.c_size_t
+
+# double graph_euclidean_heuristic(uint32_t node, uint32_t target, void *ctx)
+euclidean_heuristic = GraphHeuristic(("graph_euclidean_heuristic", lib))
+
+# GraphPaths* graph_paths_open(const Graph *g, uint32_t from, uint32_t to, size_t max_nodes,
+#                              double max_cost)
+lib.graph_paths_open.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32,
+                                 ctypes.c_size_t, ctypes.c_double]
+lib.graph_paths_open.restype = ctypes.c_void_p
+
+# size_t graph_paths_next(GraphPaths *it, uint32_t *path, size_t cap, double *cost)
+lib.graph_paths_next.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32),
+                                 ctypes.c_size_t, ctypes.POINTER(ctypes.c_double)]
+lib.graph_paths_next.restype = ctypes.c_size_t
+
+# bool graph_paths_stale(const GraphPaths *it)
+lib.graph_paths_stale.argtypes = [ctypes.c_void_p]
+lib.graph_paths_stale.restype = ctypes.c_bool
+
+# void graph_paths_close(GraphPaths *it)
+lib.graph_paths_close.argtypes = [ctypes.c_void_p]
+lib.graph_paths_close.restype = None
+
+
+# typedef struct GraphFileInfo { uint32_t flags; size_t nodes, edges, self_loops, table_count; }
+class GraphFileInfo(ctypes.Structure):
+    _fields_ = [("flags", ctypes.c_uint32),
+                ("nodes", ctypes.c_size_t),
+                ("edges", ctypes.c_size_t),
+                ("self_loops", ctypes.c_size_t),
+                ("table_count", ctypes.c_size_t)]
+
+
+# bool graph_save(const Graph *g, const char *path, uint32_t flags, const char *const *tables,
+#                 size_t table_count)
+lib.graph_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint32,
+                           ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+lib.graph_save.restype = ctypes.c_bool
+
+# GraphFile* graph_file_open(const char *path)
+lib.graph_file_open.argtypes = [ctypes.c_char_p]
+lib.graph_file_open.restype = ctypes.c_void_p
+
+# void graph_file_info(const GraphFile *f, GraphFileInfo *info)
+lib.graph_file_info.argtypes = [ctypes.c_void_p, ctypes.POINTER(GraphFileInfo)]
+lib.graph_file_info.restype = None
+
+# const char* graph_file_table(const GraphFile *f, size_t table, size_t *size)
+lib.graph_file_table.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]
+lib.graph_file_table.restype = ctypes.c_void_p
+
+# bool graph_file_load(const GraphFile *f, Graph *g)
+lib.graph_file_load.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+lib.graph_file_load.restype = ctypes.c_bool
+
+# void graph_file_close(GraphFile *f)
+lib.graph_file_close.argtypes = [ctypes.c_void_p]
+lib.graph_file_close.restype = None
+
+# int graph_prop_column(Graph *g, const char *name, GraphPropType type)
+lib.graph_prop_column.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+lib.graph_prop_column.restype = ctypes.c_int
+
+# int graph_prop_find(const Graph *g, const char *name, GraphPropType *type)
+lib.graph_prop_find.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_int)]
+lib.graph_prop_find.restype = ctypes.c_int
+
+# size_t graph_prop_set_ints(Graph *g, int column, const uint32_t *nodes, const int64_t *values,
+#                            size_t count)
+lib.graph_prop_set_ints.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(ctypes.c_uint32),
+                                    ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t]
+lib.graph_prop_set_ints.restype = ctypes.c_size_t
+
+# size_t graph_prop_set_doubles(Graph *g, int column, const uint32_t *nodes, const double *values,
+#                               size_t count)
+lib.graph_prop_set_doubles.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                       ctypes.POINTER(ctypes.c_uint32),
+                                       ctypes.POINTER(ctypes.c_double), ctypes.c_size_t]
+lib.graph_prop_set_doubles.restype = ctypes.c_size_t
+
+# size_t graph_prop_set_strings(Graph *g, int column, const uint32_t *nodes,
+#                               const char *const *values, size_t count)
+lib.graph_prop_set_strings.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                       ctypes.POINTER(ctypes.c_uint32),
+                                       ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+lib.graph_prop_set_strings.restype = ctypes.c_size_t
+
+# bool graph_prop_unset(Graph *g, int column, uint32_t node)
+lib.graph_prop_unset.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32]
+lib.graph_prop_unset.restype = ctypes.c_bool
+
+# bool graph_prop_get_int(const Graph *g, int column, uint32_t node, int64_t *value)
+lib.graph_prop_get_int.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32,
+                                   ctypes.POINTER(ctypes.c_int64)]
+lib.graph_prop_get_int.restype = ctypes.c_bool
+
+# bool graph_prop_get_double(const Graph *g, int column, uint32_t node, double *value)
+lib.graph_prop_get_double.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32,
+                                      ctypes.POINTER(ctypes.c_double)]
+lib.graph_prop_get_double.restype = ctypes.c_bool
+
+# const char* graph_prop_get_string(const Graph *g, int column, uint32_t node)
+lib.graph_prop_get_string.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32]
+lib.graph_prop_get_string.restype = ctypes.c_char_p
+
+# size_t graph_prop_match_int_range(const Graph *g, int column, int64_t lo, int64_t hi,
+#                                   bool intersect, uint64_t *bits)
+lib.graph_prop_match_int_range.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int64,
+                                           ctypes.c_int64, ctypes.c_bool,
+                                           ctypes.POINTER(ctypes.c_uint64)]
+lib.graph_prop_match_int_range.restype = ctypes.c_size_t
+
+# size_t graph_prop_match_double_range(const Graph *g, int column, double lo, double hi,
+#                                      bool intersect, uint64_t *bits)
+lib.graph_prop_match_double_range.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_double,
+                                              ctypes.c_double, ctypes.c_bool,
+                                              ctypes.POINTER(ctypes.c_uint64)]
+lib.graph_prop_match_double_range.restype = ctypes.c_size_t
+
+# size_t graph_prop_match_int_in(const Graph *g, int column, const int64_t *values, size_t count,
+#                                bool intersect, uint64_t *bits)
+lib.graph_prop_match_int_in.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                        ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t,
+                                        ctypes.c_bool, ctypes.POINTER(ctypes.c_uint64)]
+lib.graph_prop_match_int_in.restype = ctypes.c_size_t
+
+# size_t graph_prop_match_string_in(const Graph *g, int column, const char *const *values,
+#                                   size_t count, bool intersect, uint64_t *bits)
+lib.graph_prop_match_string_in.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                           ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t,
+                                           ctypes.c_bool, ctypes.POINTER(ctypes.c_uint64)]
+lib.graph_prop_match_string_in.restype = ctypes.c_size_t
+
+# size_t graph_bitmap_nodes(const uint64_t *bits, size_t node_capacity, uint32_t *nodes)
+lib.graph_bitmap_nodes.argtypes = [ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t,
+                                   ctypes.POINTER(ctypes.c_uint32)]
+lib.graph_bitmap_nodes.restype = ctypes.c_size_t
+
+
+class Coordinates:
+    """
+    Node positions for the native straight-line A* heuristic
+    
+    Built once and reused across queries, so searches never call back into
+    Python. points[node_id] is an (x, y) pair or None if unknown; scale is
+    the cost per unit of distance and must not exceed the cheapest edge's
+    cost per unit, or A* may return a longer path.
+    """
+    
+    def __init__(self, points: Sequence[Optional[Tuple[float, float]]], scale: float = 1.0):
+        self._xy = (ctypes.c_double * (2 * len(points)))()
+        for node, point in enumerate(points):
+            x, y = point if point is not None else (math.nan, math.nan)
+            self._xy[2 * node] = x
+            self._xy[2 * node + 1] = y
+        self._struct = GraphCoordinates(self._xy, len(points), scale)
+    
+    @property
+    def pointer(self) -> ctypes.c_void_p:
+        return ctypes.cast(ctypes.byref(self._struct), ctypes.c_void_p)
+
+# ============================================================================
+# Python Wrapper Class
+# ============================================================================
+
+class GraphEngine:
+    """Python wrapper for the native graph engine"""
+    
+    # Per-thread path buffer, grown when a path doesn't fit
+    _paths = threading.local()
+    
+    def __init__(self):
+        """Create an empty graph"""
+        self._g = lib.graph_create()
+        if not self._g:
+            raise MemoryError("Failed to create graph")
+    
+    def __del__(self):
+        """Destroy the graph when the object is garbage collected"""
+        if hasattr(self, '_g') and self._g:
+            lib.graph_destroy(self._g)
+            self._g = None
+    
+    def clear(self):
+        """Remove all nodes and edges; IDs start from 0 again"""
+        lib.graph_clear(self._g)
+    
+    def add_node(self) -> int:
+        """
+        Add a node
+        
+        Returns:
+            The new node's ID (IDs of deleted nodes are not reused)
+        
+        Raises:
+            MemoryError: If the graph could not grow
+        """
+        node = lib.graph_add_node(self._g)
+        if node == NO_NODE:
+            raise MemoryError("Failed to add node")
+        return node
+    
+    def delete_node(self, node: int) -> bool:
+        """Delete a node and every edge touching it; False if it did not exist"""
+        return lib.graph_delete_node(self._g, node)
+    
+    def node_exists(self, node: int) -> bool:
+        """Check if a node ID is live"""
+        return lib.graph_node_exists(self._g, node)
+    
+    def add_edge(self, from_node: int, to_node: int, weight: float = 1.0) -> bool:
+        """
+        Add a directed edge, or replace the weight of an existing one
+        
+        A replaced edge moves to the end of the adjacency order, as if it
+        had been deleted and added again.
+        
+        Returns:
+            False if either node does not exist
+        
+        Raises:
+            MemoryError: If the graph could not grow
+        """
+        if not (self.node_exists(from_node) and self.node_exists(to_node)):
+            return False
+        if not lib.graph_add_edge(self._g, from_node, to_node, weight):
+            raise MemoryError("Failed to add edge")
+        return True
+    
+    def delete_edge(self, from_node: int, to_node: int) -> bool:
+        """Delete a directed edge; False if it did not exist"""
+        return lib.graph_delete_edge(self._g, from_node, to_node)
+    
+    def edge_weight(self, from_node: int, to_node: int) -> Optional[float]:
+        """Weight of the edge from_node -> to_node, or None if there is none"""
+        weight = ctypes.c_double()
+        if not lib.graph_edge_weight(self._g, from_node, to_node, ctypes.byref(weight)):
+            return None
+        return weight.value
+    
+    def _row(self, fill, node: int) -> Tuple[List[int], List[float]]:
+        """Copy one adjacency row out using C's degree-then-fill convention"""
+        degree = fill(self._g, node, None, None, 0)
+        if degree == 0:
+            return [], []
+        nodes = (ctypes.c_uint32 * degree)()
+        weights = (ctypes.c_double * degree)()
+        fill(self._g, node, nodes, weights, degree)
+        return list(nodes), list(weights)
+    
+    def neighbors(self, node: int) -> Tuple[List[int], List[float]]:
+        """
+        Outgoing neighbors in insertion order
+        
+        Returns:
+            (node IDs, matching edge weights); empty for a missing node
+        """
+        return self._row(lib.graph_neighbors, node)
+    
+    def in_neighbors(self, node: int) -> Tuple[List[int], List[float]]:
+        """Incoming neighbors in insertion order, as (node IDs, weights)"""
+        return self._row(lib.graph_in_neighbors, node)
+    
+    def out_degree(self, node: int) -> int:
+        """Number of outgoing edges"""
+        return lib.graph_out_degree(self._g, node)
+    
+    def in_degree(self, node: int) -> int:
+        """Number of incoming edges"""
+        return lib.graph_in_degree(self._g, node)
+    
+    def node_count(self) -> int:
+        """Number of live nodes"""
+        return lib.graph_node_count(self._g)
+    
+    def node_capacity(self) -> int:
+        """Number of node IDs issued (live or deleted)"""
+        return lib.graph_node_capacity(self._g)
+    
+    def edge_count(self) -> int:
+        """Number of directed edges"""
+        return lib.graph_edge_count(self._g)
+    
+    def compact(self):
+        """
+        Fold recent edits into the compressed adjacency arrays
+        
+        Raises:
+            MemoryError: If the new arrays could not be allocated
+        """
+        if not lib.graph_compact(self._g):
+            raise MemoryError("Failed to compact graph")
+    
+    def bfs(self, start: int, target: int = NO_NODE):
+        """
+        Breadth-first search until target is dequeued
+        
+        Args:
+            start: Start node ID
+            target: Node to stop at, or NO_NODE for a full traversal
+        
+        Returns:
+            (order, visited, parent, dist): order lists the discovered nodes
+            in discovery order, the first `visited` of which were dequeued;
+            parent and dist are indexed by node ID (NO_NODE / -1 when undiscovered)
+        """
+        n = max(self.node_capacity(), 1)
+        order = (ctypes.c_uint32 * n)()
+        parent = (ctypes.c_uint32 * n)()
+        dist = (ctypes.c_int32 * n)()
+        visited = ctypes.c_size_t()
+        found = lib.graph_bfs(self._g, start, target, order, parent, dist, ctypes.byref(visited))
+        return order[:found], visited.value, parent, dist
+    
+    def dfs(self, start: int, target: int = NO_NODE):
+        """
+        Depth-first preorder search, stopping at target
+        
+        Returns:
+            (order, found, parent): the visited nodes, whether target was
+            reached, and tree parents indexed by node ID
+        """
+        n = max(self.node_capacity(), 1)
+        order = (ctypes.c_uint32 * n)()
+        parent = (ctypes.c_uint32 * n)()
+        found = ctypes.c_bool()
+        count = lib.graph_dfs(self._g, start, target, order, parent, ctypes.byref(found))
+        return order[:count], found.value, parent
+    
+    def set_threads(self, threads: int):
+        """Worker threads for bfs_tree and degrees (0: one per CPU, 1: no pool)"""
+        lib.graph_set_threads(self._g, threads)
+    
+    def bfs_tree(self, start: int):
+        """
+        Whole-graph BFS on the parallel, direction-optimizing kernel
+        
+        Returns:
+            (order, parent, dist) as contiguous memoryviews: order holds the
+            reached nodes by distance and then by ID; parent and dist are
+            indexed by node ID (NO_NODE / -1 when unreachable). parent[v]
+            is a neighbor one hop closer to start, not necessarily the one
+            bfs() would pick. All empty if start does not exist.
+        
+        Raises:
+            MemoryError: If the kernel's work arrays could not be allocated
+        """
+        n = self.node_capacity()
+        if not self.node_exists(start):
+            return memoryview(b'').cast('I'), memoryview(b'').cast('I'), memoryview(b'').cast('i')
+        order = (ctypes.c_uint32 * n)()
+        parent = (ctypes.c_uint32 * n)()
+        dist = (ctypes.c_int32 * n)()
+        reached = lib.graph_bfs_tree(self._g, start, order, parent, dist)
+        if reached == 0:
+            raise MemoryError("Failed to run BFS")
+        return memoryview(order).cast('B').cast('I')[:reached], \
+            memoryview(parent).cast('B').cast('I'), memoryview(dist).cast('B').cast('i')
+    
+    def degrees(self):
+        """
+        Out- and in-degree of every node ID, copied from the engine's counters
+        
+        Returns:
+            (out, in) as contiguous memoryviews indexed by node ID
+        """
+        n = self.node_capacity()
+        out = (ctypes.c_uint32 * n)()
+        inward = (ctypes.c_uint32 * n)()
+        lib.graph_degrees(self._g, out, inward)
+        return memoryview(out).cast('B').cast('I'), memoryview(inward).cast('B').cast('I')
+    
+    def component_count(self) -> int:
+        """Number of weakly connected components (O(1) until an edge is deleted)"""
+        return lib.graph_component_count(self._g)
+    
+    def component(self, node: int) -> int:
+        """Smallest node ID in node's weakly connected component (NO_NODE if absent)"""
+        return lib.graph_component(self._g, node)
+    
+    def components(self):
+        """
+        Component label of every node ID
+        
+        Returns:
+            Contiguous memoryview indexed by node ID: the smallest node ID
+            in the node's component, NO_NODE for deleted IDs
+        """
+        labels = (ctypes.c_uint32 * self.node_capacity())()
+        lib.graph_components(self._g, labels)
+        return memoryview(labels).cast('B').cast('I')
+    
+    def _path_query(self, run) -> Tuple[List[int], float]:
+        """Run a path query into the thread's buffer, growing it to fit"""
+        buffer = getattr(self._paths, 'buffer', None)
+        if buffer is None:
+            buffer = self._paths.buffer = (ctypes.c_uint32 * 256)()
+        cost = ctypes.c_double()
+        length = run(buffer, len(buffer), ctypes.byref(cost))
+        if length > len(buffer):
+            buffer = self._paths.buffer = (ctypes.c_uint32 * length)()
+            length = run(buffer, len(buffer), ctypes.byref(cost))
+        if length == 0 and math.isnan(cost.value):
+            raise MemoryError("Failed to allocate a path search workspace")
+        return buffer[:length], cost.value
+    
+    def shortest_path(self, from_node: int, to_node: int,
+                      bidirectional: bool = False) -> Tuple[List[int], float]:
+        """
+        Dijkstra's algorithm on the native heap (weights must be >= 0)
+        
+        Args:
+            from_node: Start node ID
+            to_node: Target node ID
+            bidirectional: Search from both ends at once and meet in the middle
+        
+        Returns:
+            (path, cost): node IDs from start to target, or ([], inf) if
+            either node is missing or the target is unreachable
+        
+        Raises:
+            MemoryError: If the search workspace could not be allocated
+        """
+        return self._path_query(lambda path, cap, cost: lib.graph_shortest_path(
+            self._g, from_node, to_node, bidirectional, path, cap, cost))
+    
+    def astar(self, from_node: int, to_node: int,
+              heuristic: Union[Coordinates, Callable[[int, int], float]]) -> Tuple[List[int], float]:
+        """
+        A* search guided by a lower bound on the remaining cost
+        
+        Args:
+            from_node: Start node ID
+            to_node: Target node ID
+            heuristic: Coordinates for the native straight-line estimate, or
+                a function (node_id, target_id) -> float that never
+                overestimates (called from C once per reached node)
+        
+        Returns:
+            (path, cost) as for shortest_path
+        
+        Raises:
+            MemoryError: If the search workspace could not be allocated
+        """
+        if isinstance(heuristic, Coordinates):
+            function, ctx = euclidean_heuristic, heuristic.pointer
+        else:
+            function, ctx = GraphHeuristic(lambda node, target, _: heuristic(node, target)), None
+        return self._path_query(lambda path, cap, cost: lib.graph_astar(
+            self._g, from_node, to_node, function, ctx, path, cap, cost))
+    
+    def paths(self, from_node: int, to_node: int, max_nodes: int = 0,
+              max_cost: float = math.inf) -> Iterator[Tuple[List[int], float]]:
+        """
+        Stream the simple paths between two nodes, depth-first
+        
+        Paths are produced one at a time from a native stack, so memory
+        stays flat however many there are. Stop iterating (or close the
+        generator) to end the search early.
+        
+        Args:
+            from_node: Start node ID
+            to_node: Target node ID
+            max_nodes: Most nodes per path, endpoints included (0: no limit)
+            max_cost: Highest total weight (weights must be >= 0)
+        
+        Yields:
+            (path, cost) with path a list of node IDs
+        
+        Raises:
+            RuntimeError: If the graph changes during iteration
+            MemoryError: If the search stack could not grow
+        """
+        it = lib.graph_paths_open(self._g, from_node, to_node, max_nodes, max_cost)
+        if not it:
+            raise MemoryError("Failed to start path enumeration")
+        try:
+            buffer = (ctypes.c_uint32 * 64)()
+            cost = ctypes.c_double()
+            while True:
+                length = lib.graph_paths_next(it, buffer, len(buffer), ctypes.byref(cost))
+                if length > len(buffer):
+                    buffer = (ctypes.c_uint32 * (2 * length))()
+                    length = lib.graph_paths_next(it, buffer, len(buffer), ctypes.byref(cost))
+                if length == 0:
+                    if not math.isnan(cost.value):
+                        return
+                    if lib.graph_paths_stale(it):
+                        raise RuntimeError("Graph changed during path enumeration")
+                    raise MemoryError("Failed to grow the path stack")
+                yield buffer[:length], cost.value
+        finally:
+            lib.graph_paths_close(it)
+    
+    def save(self, path: str, tables: Sequence[bytes] = (), flags: int = 0):
+        """
+        Write the graph to a binary graph file (atomically replaced)
+        
+        Live nodes are renumbered 0 .. n-1 in ID order.
+        
+        Args:
+            path: File path
+            tables: Up to 4 string tables, each the NUL-terminated UTF-8
+                strings of every live node in ID order, concatenated
+            flags: Stored as given, for the caller
+        
+        Raises:
+            OSError: If the file cannot be written
+        """
+        packed = (ctypes.c_char_p * max(1, len(tables)))(*tables)
+        if not lib.graph_save(self._g, os.fsencode(path), flags, packed, len(tables)):
+            raise OSError(f"Cannot save graph file: {path}")
+    
+    # ------------------------------------------------------------------------
+    # Node properties: typed columns filtered natively into node bitmaps
+    # ------------------------------------------------------------------------
+    
+    def prop_column(self, name: str, kind: int) -> int:
+        """
+        Find or add the property column called name, of type kind
+        (PROP_INT, PROP_DOUBLE or PROP_STRING)
+        
+        Raises:
+            ValueError: If the column exists with another type
+        """
+        column = lib.graph_prop_column(self._g, name.encode('utf-8'), kind)
+        if column < 0:
+            raise ValueError(f"Property column {name!r} has another type (or out of memory)")
+        return column
+    
+    def prop_find(self, name: str) -> Optional[Tuple[int, int]]:
+        """(column, type) of the property column called name, or None"""
+        kind = ctypes.c_int()
+        column = lib.graph_prop_find(self._g, name.encode('utf-8'), ctypes.byref(kind))
+        return (column, kind.value) if column >= 0 else None
+    
+    def set_props(self, column: int, kind: int, nodes: Sequence[int], values: Sequence) -> int:
+        """
+        Set values[i] for nodes[i] in one call (kind must be the column's
+        type); nodes that don't exist are skipped
+        
+        Returns:
+            How many values were set
+        """
+        n = len(nodes)
+        ids = (ctypes.c_uint32 * n)(*nodes)
+        if kind == PROP_INT:
+            return lib.graph_prop_set_ints(self._g, column, ids, (ctypes.c_int64 * n)(*values), n)
+        if kind == PROP_DOUBLE:
+            return lib.graph_prop_set_doubles(self._g, column, ids,
+                                              (ctypes.c_double * n)(*values), n)
+        encoded = (ctypes.c_char_p * n)(*(v.encode('utf-8') for v in values))
+        return lib.graph_prop_set_strings(self._g, column, ids, encoded, n)
+    
+    def unset_prop(self, column: int, node: int) -> bool:
+        """Remove node's value from the column; False if it had none"""
+        return lib.graph_prop_unset(self._g, column, node)
+    
+    def get_prop(self, column: int, kind: int, node: int) -> Union[int, float, str, None]:
+        """Node's value in the column, or None"""
+        if kind == PROP_STRING:
+            value = lib.graph_prop_get_string(self._g, column, node)
+            return value.decode('utf-8') if value is not None else None
+        
+        if kind == PROP_INT:
+            out = ctypes.c_int64()
+            found = lib.graph_prop_get_int(self._g, column, node, ctypes.byref(out))
+        else:
+            out = ctypes.c_double()
+            found = lib.graph_prop_get_double(self._g, column, node, ctypes.byref(out))
+        return out.value if found else None
+    
+    def bitmap(self):
+        """A zeroed node bitmap for the filters, one bit per node ID"""
+        return (ctypes.c_uint64 * max(1, (self.node_capacity() + 63) // 64))()
+    
+    def filter_int_range(self, column: int, lo: int, hi: int, bits, intersect: bool = False) -> int:
+        """
+        Set bits for nodes with lo <= value <= hi in an integer column;
+        with intersect, only where bits are already set
+        
+        Returns:
+            The number of bits set
+        """
+        return lib.graph_prop_match_int_range(self._g, column, max(lo, INT64_MIN),
+                                              min(hi, INT64_MAX), intersect, bits)
+    
+    def filter_double_range(self, column: int, lo: float, hi: float, bits,
+                            intersect: bool = False) -> int:
+        """Like filter_int_range, for a double column (NaN never matches)"""
+        return lib.graph_prop_match_double_range(self._g, column, lo, hi, intersect, bits)
+    
+    def filter_int_in(self, column: int, values: Sequence[int], bits,
+                      intersect: bool = False) -> int:
+        """Set bits for nodes whose integer value is one of values"""
+        wanted = (ctypes.c_int64 * max(1, len(values)))(*values)
+        return lib.graph_prop_match_int_in(self._g, column, wanted, len(values), intersect, bits)
+    
+    def filter_string_in(self, column: int, values: Sequence[str], bits,
+                         intersect: bool = False) -> int:
+        """Set bits for nodes whose string value is one of values"""
+        wanted = (ctypes.c_char_p * max(1, len(values)))(*(v.encode('utf-8') for v in values))
+        return lib.graph_prop_match_string_in(self._g, column, wanted, len(values), intersect, bits)
+    
+    def bitmap_nodes(self, bits, count: int):
+        """
+        Node IDs of the set bits, ascending
+        
+        Args:
+            count: The bit count the last filter returned
+            
+        Returns:
+            Contiguous memoryview of node IDs
+        """
+        nodes = (ctypes.c_uint32 * max(1, count))()
+        n = lib.graph_bitmap_nodes(bits, self.node_capacity(), nodes)
+        return memoryview(nodes).cast('B').cast('I')[:n]
+    
+    def __repr__(self):
+        return f"GraphEngine(nodes={self.node_count()}, edges={self.edge_count()})"
+
+
+class GraphFile:
+    """
+    A binary graph file written by GraphEngine.save, memory-mapped
+    
+    String tables are read straight from the mapping and load_into decodes
+    the edges into an engine without going through Python.
+    """
+    
+    def __init__(self, path: str):
+        """
+        Raises:
+            OSError: If the file is missing or not a valid graph file
+        """
+        self._f = lib.graph_file_open(os.fsencode(path))
+        if not self._f:
+            raise OSError(f"Cannot open graph file: {path}")
+        self.info = GraphFileInfo()
+        lib.graph_file_info(self._f, ctypes.byref(self.info))
+    
+    def __del__(self):
+        self.close()
+    
+    def __enter__(self):
+        return self
+    
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+        return False
+    
+    def close(self):
+        """Unmap the file"""
+        if getattr(self, '_f', None):
+            lib.graph_file_close(self._f)
+            self._f = None
+    
+    def table(self, index: int) -> bytes:
+        """A string table as stored: one NUL-terminated string per node"""
+        size = ctypes.c_size_t()
+        data = lib.graph_file_table(self._f, index, ctypes.byref(size))
+        if data is None:
+            raise IndexError(f"No string table {index}")
+        return ctypes.string_at(data, size.value)
+    
+    def strings(self, index: int) -> List[str]:
+        """A string table decoded, one string per node in ID order"""
+        packed = self.table(index)
+        return packed[:-1].decode('utf-8').split('\0') if packed else []
+    
+    def load_into(self, engine: 'GraphEngine'):
+        """
+        Replace engine's nodes and edges with the file's (node i gets ID i)
+        
+        Raises:
+            ValueError: If the edge data is corrupt (engine is unchanged)
+        """
+        if not lib.graph_file_load(self._f, engine._g):
+            raise ValueError("Corrupt graph file or out of memory")
+
+
+# ============================================================================
+# Example Usage / Demo
+# ============================================================================
+
+if __name__ == "__main__":
+    print("=== Native Graph Engine Demo ===\n")
+    
+    g = GraphEngine()
+    ids = [g.add_node() for _ in range(5)]
+    for a, b, w in [(0, 1, 4), (0, 2, 2), (1, 3, 5), (2, 3, 8), (3, 4, 3)]:
+        g.add_edge(ids[a], ids[b], w)
+    print(f"✓ Built {g}")
+    print(f"✓ Neighbors of 0: {g.neighbors(0)}")
+    
+    order, visited, parent, dist = g.bfs(0)
+    print(f"✓ BFS order: {order}, distance to 4: {dist[4]}")
+    order, found, parent = g.dfs(0, 4)
+    print(f"✓ DFS order: {order}, reached 4: {found}")
+    order, parent, dist = g.bfs_tree(0)
+    print(f"✓ BFS tree: {order.tolist()}, parents: {parent.tolist()}")
+    out, inward = g.degrees()
+    print(f"✓ Out-degrees: {out.tolist()}, in-degrees: {inward.tolist()}")
+    print(f"✓ Components: {g.component_count()}, labels: {g.components().tolist()}")
+    print(f"✓ Dijkstra 0->4: {g.shortest_path(0, 4)}, "
+          f"bidirectional: {g.shortest_path(0, 4, bidirectional=True)}")
+    coords = Coordinates([(0, 0), (4, 0), (0, 2), (4, 2), (7, 2)])
+    print(f"✓ A* 0->4: {g.astar(0, 4, coords)}, "
+          f"with a callable: {g.astar(0, 4, lambda node, target: 0.0)}")
+    print(f"✓ All paths 0->4: {list(g.paths(0, 4))}, "
+          f"cost <= 12: {list(g.paths(0, 4, max_cost=12))}")
+    
+    path = os.path.join(SCRIPT_DIR, 'bin', 'graph_engine_demo.wgb')
+    g.save(path, [b'a\0b\0c\0d\0e\0'])
+    copy = GraphEngine()
+    with GraphFile(path) as f:
+        f.load_into(copy)
+        print(f"✓ Saved and loaded {copy}, names {f.strings(0)}, "
+              f"neighbors of 0: {copy.neighbors(0)}")
+    os.remove(path)
+    
+    age = g.prop_column("age", PROP_INT)
+    color = g.prop_column("color", PROP_STRING)
+    g.set_props(age, PROP_INT, ids, [31, 45, 27, 45, 60])
+    g.set_props(color, PROP_STRING, ids, ["red", "blue", "red", "green", "red"])
+    bits = g.bitmap()
+    g.filter_int_range(age, 30, 59, bits)
+    count = g.filter_string_in(color, ["red", "green"], bits, intersect=True)
+    print(f"✓ 30 <= age <= 59 and color in (red, green): {g.bitmap_nodes(bits, count).tolist()}")
+    
+    g.add_edge(0, 1, 9)
+    print(f"✓ Re-added 0->1 moves it last: {g.neighbors(0)}")
+    g.delete_node(3)
+    g.compact()
+    print(f"✓ After deleting node 3 and compacting: {g}, in-degree of 4: {g.in_degree(4)}")
@@ -119,9 +119,8 @@ def nlp_query():
         explanation = result.get('explanation', '')
         # Map action to backend
         if action == 'stats':
-            node_ids = graph.get_all_nodes()
-            edge_tuples = graph.get_all_edges()
-            return jsonify({'action': action, 'explanation': explanation, 'nodes': len(node_ids), 'edges': len(edge_tuples)})
+            stats = graph.get_stats()
+            return jsonify({'action': action, 'explanation': explanation, 'nodes': stats['nodes'], 'edges': stats['edges']})
         elif action == 'visualization':
             # Reuse visualization logic
             return get_visualization_data()
@@ -236,29 +235,13 @@ def get_stats():
             logger.error("Graph not initialized")
             return jsonify({'error': 'Graph not initialized'}), 400
         
-        node_ids = graph.get_all_nodes()
-        nodes = []
-        for node_id in node_ids:
-            node_data = graph.get_node(node_id)
-            if node_data:
-                nodes.append(node_data)
-        
-        # Get all edges as tuples and convert to dicts
-        edge_tuples = graph.get_all_edges()
-        edges = []
-        for edge in edge_tuples:
-            edge_dict = {
-                'from': edge[0],
-                'to': edge[1]
-            }
-            if len(edge) > 2 and edge[2] is not None:
-                edge_dict['weight'] = edge[2]
-            edges.append(edge_dict)
-        
-        logger.info(f"Stats: {len(nodes)} nodes, {len(edges)} edges")
+        # Maintained incrementally by the graph, so polling is O(1)
+        stats = graph.get_stats()
+        logger.info(f"Stats: {stats['nodes']} nodes, {stats['edges']} edges")
         return jsonify({
-            'node_count': len(nodes),
-            'edge_count': len(edges),
+            'node_count': stats['nodes'],
+            'edge_count': stats['edges'],
+            'component_count': stats['components'],
             'directed': graph.directed,
             'weighted': graph.weighted
         })
@@ -267,6 +250,22 @@ def get_stats():
         logger.error(traceback.format_exc())
         return jsonify({'error': f'Internal server error: {str(e)}'}), 500
 
+@app.route('/api/graph/db_metrics', methods=['GET'])
+def get_db_metrics():
+    """Get node store metrics: per-operation counts, latency and probe lengths"""
+    try:
+        logger.info("GET /api/graph/db_metrics")
+        if not graph:
+            logger.error("Graph not initialized")
+            return jsonify({'error': 'Graph not initialized'}), 400
+        
+        # Summed from per-thread counters; no table scan, so safe to poll
+        return jsonify(graph.db.stats_ex())
+    except Exception as e:
+        logger.error(f"Error in get_db_metrics: {str(e)}")
+        logger.error(traceback.format_exc())
+        return jsonify({'error': f'Internal server error: {str(e)}'}), 500
+
 @app.route('/api/graph/nodes', methods=['GET'])
 def get_all_nodes():
     """Get all nodes"""
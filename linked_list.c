@@ -1,10 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "linked_list.h"
+#include "list_sort.h"
 
-// Function to create a new node
-Node* createNode(int data) {
-    Node* newNode = (Node*)malloc(sizeof(Node));
+// Sorted runs kept by the bottom-up merge sort: bin i holds 2^i nodes
+#define SORT_BINS 64
+
+// Function to create a pool sized for list nodes
+NodePool* createListPool(int nodesPerBlock) {
+    return createNodePool(sizeof(Node), nodesPerBlock > 0 ? (size_t)nodesPerBlock : 0);
+}
+
+// Function to create a new node from a pool (or malloc without one)
+Node* createNodeIn(NodePool* pool, int data) {
+    Node* newNode = pool != NULL ? (Node*)poolAllocNode(pool) : (Node*)malloc(sizeof(Node));
     if (newNode == NULL) {
         printf("Memory allocation failed!\n");
         return NULL;
@@ -14,63 +23,78 @@ Node* createNode(int data) {
     return newNode;
 }
 
-// Function to insert at the end
-Node* insertEnd(Node* head, int data) {
-    Node* newNode = createNode(data);
-    if (newNode == NULL) return head;
-    
-    if (head == NULL) {
-        return newNode;
+// Function to give a node back to wherever it came from
+static void releaseNode(NodePool* pool, Node* node) {
+    if (pool != NULL) {
+        poolFreeNode(pool, node);
+    } else {
+        free(node);
     }
-    
-    Node* current = head;
-    while (current->next != NULL) {
-        current = current->next;
+}
+
+// Function to view a bare chain as a list handle, so the head-pointer
+// functions run the handle code. Walking for the tail and length costs
+// what those functions always did; without the walk the tail stands in
+// as head, which is all prepends and deletes look at.
+static List wrapChain(NodePool* pool, Node* head, int walk) {
+    List list = { head, head, 0, pool, 0 };
+    if (walk) {
+        for (Node* node = head; node != NULL; node = node->next) {
+            list.tail = node;
+            list.length++;
+        }
     }
-    current->next = newNode;
-    return head;
+    return list;
+}
+
+// Function to create a new node
+Node* createNode(int data) {
+    return createNodeIn(NULL, data);
+}
+
+// Function to insert at the end
+Node* insertEnd(Node* head, int data) {
+    return insertEndIn(NULL, head, data);
+}
+
+// Function to insert at the end, allocating from a pool
+Node* insertEndIn(NodePool* pool, Node* head, int data) {
+    List list = wrapChain(pool, head, 1);
+    listAppend(&list, data);
+    return list.head;
 }
 
 // Function to insert at the beginning
 Node* insertBegin(Node* head, int data) {
-    Node* newNode = createNode(data);
-    if (newNode == NULL) return head;
-    
-    newNode->next = head;
-    return newNode;
+    return insertBeginIn(NULL, head, data);
+}
+
+// Function to insert at the beginning, allocating from a pool
+Node* insertBeginIn(NodePool* pool, Node* head, int data) {
+    List list = wrapChain(pool, head, 0);
+    listPrepend(&list, data);
+    return list.head;
 }
 
 // Function to delete a node
 Node* deleteNode(Node* head, int data) {
+    return deleteNodeIn(NULL, head, data);
+}
+
+// Function to delete a node, returning it to its pool
+Node* deleteNodeIn(NodePool* pool, Node* head, int data) {
     if (head == NULL) {
         printf("List is empty!\n");
         return head;
     }
     
-    // If head needs to be deleted
-    if (head->data == data) {
-        Node* temp = head;
-        head = head->next;
-        free(temp);
+    List list = wrapChain(pool, head, 0);
+    if (listDelete(&list, data)) {
         printf("Element %d deleted successfully.\n", data);
-        return head;
+    } else {
+        printf("Element %d not found in the list!\n", data);
     }
-    
-    // Search for the node to delete
-    Node* current = head;
-    while (current->next != NULL) {
-        if (current->next->data == data) {
-            Node* temp = current->next;
-            current->next = temp->next;
-            free(temp);
-            printf("Element %d deleted successfully.\n", data);
-            return head;
-        }
-        current = current->next;
-    }
-    
-    printf("Element %d not found in the list!\n", data);
-    return head;
+    return list.head;
 }
 
 // Function to display the list
@@ -121,40 +145,14 @@ int search(Node* head, int target) {
 
 // Function to get list length
 int getListLength(Node* head) {
-    int count = 0;
-    Node* current = head;
-    while (current != NULL) {
-        count++;
-        current = current->next;
-    }
-    return count;
-}
-
-// Function to get the middle node (for merge sort)
-Node* getMidNode(Node* head) {
-    if (head == NULL) return head;
-    
-    Node* slow = head;
-    Node* fast = head;
-    Node* prev = NULL;
-    
-    while (fast != NULL && fast->next != NULL) {
-        prev = slow;
-        slow = slow->next;
-        fast = fast->next->next;
-    }
-    
-    if (prev != NULL) {
-        prev->next = NULL;
-    }
-    
-    return slow;
+    List list = wrapChain(NULL, head, 1);
+    return listLength(&list);
 }
 
 // Function to merge two sorted lists
 Node* merge(Node* l1, Node* l2) {
-    Node* dummy = createNode(0);
-    Node* current = dummy;
+    Node dummy = {0, NULL};
+    Node* current = &dummy;
     
     while (l1 != NULL && l2 != NULL) {
         if (l1->data <= l2->data) {
@@ -169,31 +167,78 @@ Node* merge(Node* l1, Node* l2) {
     
     current->next = (l1 != NULL) ? l1 : l2;
     
-    Node* result = dummy->next;
-    free(dummy);
-    return result;
+    return dummy.next;
 }
 
-// Function to sort using merge sort
+// Function to sort using merge sort, bottom-up: each node is merged into
+// a binary counter of sorted runs, so there is no recursion, no length
+// pass and no allocation. Earlier runs always merge first (stable).
 Node* mergeSort(Node* head) {
-    if (head == NULL || head->next == NULL) {
-        return head;
-    }
+    Node* bins[SORT_BINS] = {NULL};
+    int used = 0;
     
-    Node* mid = getMidNode(head);
-    
-    Node* left = mergeSort(head);
-    Node* right = mergeSort(mid);
+    while (head != NULL) {
+        Node* run = head;
+        head = head->next;
+        run->next = NULL;
+        
+        int i = 0;
+        while (i < SORT_BINS - 1 && bins[i] != NULL) {
+            run = merge(bins[i], run);
+            bins[i] = NULL;
+            i++;
+        }
+        bins[i] = run;
+        if (i >= used) {
+            used = i + 1;
+        }
+    }
     
-    return merge(left, right);
+    Node* result = NULL;
+    for (int i = 0; i < used; i++) {
+        result = merge(bins[i], result);
+    }
+    return result;
+}
+
+// Adapters for the shared parallel sort
+static void* sortGetNext(void* node) {
+    return ((Node*)node)->next;
 }
 
-// Function to sort using bubble sort
+static void sortSetNext(void* node, void* next) {
+    ((Node*)node)->next = (Node*)next;
+}
+
+static void* sortChain(void* head) {
+    return mergeSort((Node*)head);
+}
+
+static void* mergeChains(void* first, void* second) {
+    return merge((Node*)first, (Node*)second);
+}
+
+static const ListSortOps nodeSortOps = {sortGetNext, sortSetNext, sortChain, mergeChains};
+
+// Function to merge sort chunks of the list on several threads
+Node* mergeSortParallel(Node* head, int threads) {
+    return (Node*)parallelListSort(head, getListLength(head), threads, &nodeSortOps);
+}
+
+// Function to sort using bubble sort (merge sort once the list is long)
 Node* bubbleSort(Node* head) {
     if (head == NULL || head->next == NULL) {
         return head;
     }
     
+    int length = 0;
+    for (Node* node = head; node != NULL && length <= LIST_BUBBLE_SORT_MAX; node = node->next) {
+        length++;
+    }
+    if (length > LIST_BUBBLE_SORT_MAX) {
+        return mergeSort(head);
+    }
+    
     Node* current;
     int swapped;
     
@@ -217,25 +262,205 @@ Node* bubbleSort(Node* head) {
 
 // Function to free the list
 void freeList(Node* head) {
+    freeListIn(NULL, head);
+}
+
+// Function to free the list node by node into its pool
+void freeListIn(NodePool* pool, Node* head) {
     Node* current = head;
     while (current != NULL) {
         Node* temp = current;
         current = current->next;
-        free(temp);
+        releaseNode(pool, temp);
     }
 }
 
 // Function to insert an array of numbers creating matching nodes
 Node* insertArray(Node* head, int* arr, int size) {
+    return insertArrayIn(NULL, head, arr, size);
+}
+
+// Function to build a chain holding arr in one pass: one contiguous run
+// from a pool, or one malloc per node without one. NULL if out of memory.
+static Node* buildChain(NodePool* pool, int* arr, int size, Node** tail) {
+    if (pool != NULL) {
+        Node* run = (Node*)poolAllocRun(pool, (size_t)size);
+        if (run == NULL) {
+            return NULL;
+        }
+        for (int i = 0; i < size - 1; i++) {
+            run[i].data = arr[i];
+            run[i].next = &run[i + 1];
+        }
+        run[size - 1].data = arr[size - 1];
+        run[size - 1].next = NULL;
+        *tail = &run[size - 1];
+        return run;
+    }
+    
+    Node* chain = NULL;
+    Node* last = NULL;
+    for (int i = 0; i < size; i++) {
+        Node* newNode = createNodeIn(NULL, arr[i]);
+        if (newNode == NULL) {
+            freeListIn(NULL, chain);
+            return NULL;
+        }
+        if (last == NULL) {
+            chain = newNode;
+        } else {
+            last->next = newNode;
+        }
+        last = newNode;
+    }
+    *tail = last;
+    return chain;
+}
+
+// Function to insert an array of numbers, allocating from a pool
+Node* insertArrayIn(NodePool* pool, Node* head, int* arr, int size) {
     if (arr == NULL || size <= 0) {
         printf("Invalid array or size!\n");
         return head;
     }
     
-    for (int i = 0; i < size; i++) {
-        head = insertEnd(head, arr[i]);
+    // Find the tail once and append behind it
+    List list = wrapChain(pool, head, 1);
+    if (!listInsertArray(&list, arr, size)) {
+        printf("✗ Could not insert %d elements from array.\n", size);
+        return head;
     }
     
     printf("✓ Inserted %d elements from array.\n", size);
-    return head;
+    return list.head;
+}
+
+// Function to set up an empty list handle
+int initList(List* list, NodePool* pool) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->ownsPool = (pool == NULL);
+    list->pool = pool != NULL ? pool : createListPool(0);
+    return list->pool != NULL;
+}
+
+// Function to free a list handle's nodes (and its pool, if it owns one)
+void destroyList(List* list) {
+    if (list->ownsPool) {
+        destroyNodePool(list->pool);
+    } else {
+        freeListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->pool = NULL;
+}
+
+// Function to empty a list handle but keep it usable
+void listClear(List* list) {
+    if (list->ownsPool) {
+        resetNodePool(list->pool);
+    } else {
+        freeListIn(list->pool, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Function to append in O(1) behind the remembered tail
+int listAppend(List* list, int data) {
+    Node* newNode = createNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
+    
+    if (list->tail == NULL) {
+        list->head = newNode;
+    } else {
+        list->tail->next = newNode;
+    }
+    list->tail = newNode;
+    list->length++;
+    return 1;
+}
+
+// Function to insert at the front of a list handle
+int listPrepend(List* list, int data) {
+    Node* newNode = createNodeIn(list->pool, data);
+    if (newNode == NULL) return 0;
+    
+    newNode->next = list->head;
+    list->head = newNode;
+    if (list->tail == NULL) {
+        list->tail = newNode;
+    }
+    list->length++;
+    return 1;
+}
+
+// Function to append a whole array as one chain
+int listInsertArray(List* list, int* arr, int size) {
+    if (size == 0) return 1;
+    if (arr == NULL || size < 0) return 0;
+    
+    Node* chainTail;
+    Node* chain = buildChain(list->pool, arr, size, &chainTail);
+    if (chain == NULL) return 0;
+    
+    if (list->tail == NULL) {
+        list->head = chain;
+    } else {
+        list->tail->next = chain;
+    }
+    list->tail = chainTail;
+    list->length += size;
+    return 1;
+}
+
+// Function to delete the first node holding data from a list handle
+int listDelete(List* list, int data) {
+    Node* prev = NULL;
+    Node* current = list->head;
+    
+    while (current != NULL && current->data != data) {
+        prev = current;
+        current = current->next;
+    }
+    if (current == NULL) return 0;
+    
+    if (prev == NULL) {
+        list->head = current->next;
+    } else {
+        prev->next = current->next;
+    }
+    if (list->tail == current) {
+        list->tail = prev;
+    }
+    releaseNode(list->pool, current);
+    list->length--;
+    return 1;
+}
+
+// Function to get a list handle's length in O(1)
+int listLength(const List* list) {
+    return list->length;
+}
+
+// Function to merge sort a list handle's chain
+void listSort(List* list) {
+    list->head = mergeSort(list->head);
+    
+    // Nodes moved, so find the new tail
+    Node* tail = list->head;
+    while (tail != NULL && tail->next != NULL) {
+        tail = tail->next;
+    }
+    list->tail = tail;
+}
+
+// Function to reverse a list handle's chain
+void listReverse(List* list) {
+    list->tail = list->head;
+    list->head = reverseList(list->head);
 }
@@ -1,6 +1,8 @@
 #ifndef LINKED_LIST_H
 #define LINKED_LIST_H
 
+#include "node_pool.h"
+
 typedef struct Node {
     int data;
     struct Node* next;
@@ -14,12 +16,52 @@ Node* deleteNode(Node* head, int data);
 void display(Node* head, const char* label);
 void freeList(Node* head);
 
+// Pooled variants: nodes come from `pool` (NULL: malloc) and deleted nodes
+// go back to its freelist. Inserts return the list unchanged if a node
+// cannot be allocated. Free a pooled list node by node with freeListIn, or
+// all at once with destroyNodePool / resetNodePool.
+NodePool* createListPool(int nodesPerBlock);
+Node* createNodeIn(NodePool* pool, int data);
+Node* insertEndIn(NodePool* pool, Node* head, int data);
+Node* insertBeginIn(NodePool* pool, Node* head, int data);
+Node* insertArrayIn(NodePool* pool, Node* head, int* arr, int size);
+Node* deleteNodeIn(NodePool* pool, Node* head, int data);
+void freeListIn(NodePool* pool, Node* head);
+
+// List handle: remembers the tail and length, so appends and the length
+// are O(1). Nodes come from `pool`, or from a pool the handle creates and
+// owns when it is NULL. Calls return 1 on success and 0 if out of memory
+// (or, for listDelete, if the value is absent). Code may read the chain
+// from head, but must relink it only through the handle.
+typedef struct List {
+    Node* head;
+    Node* tail;
+    int length;
+    NodePool* pool;
+    int ownsPool;
+} List;
+
+int initList(List* list, NodePool* pool);
+void destroyList(List* list);
+void listClear(List* list);
+int listAppend(List* list, int data);
+int listPrepend(List* list, int data);
+int listInsertArray(List* list, int* arr, int size);  // One contiguous run
+int listDelete(List* list, int data);
+int listLength(const List* list);
+void listSort(List* list);
+void listReverse(List* list);
+
 // Search algorithm
 int search(Node* head, int target);
 
-// Sort algorithms
+// Sort algorithms. mergeSort is bottom-up, with no recursion or allocation;
+// mergeSortParallel sorts chunks on `threads` threads (0: one per CPU) and
+// merges them. bubbleSort hands lists longer than LIST_BUBBLE_SORT_MAX
+// (list_sort.h) to mergeSort.
 Node* bubbleSort(Node* head);
 Node* mergeSort(Node* head);
+Node* mergeSortParallel(Node* head, int threads);
 
 // Reverse algorithm
 Node* reverseList(Node* head);
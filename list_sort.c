@@ -0,0 +1,171 @@
+#include <pthread.h>
+#include <unistd.h>
+#include "list_sort.h"
+
+// One unit of work: sort a chunk, or merge two sorted neighbours
+typedef struct SortJob {
+    const ListSortOps* ops;
+    void* first;
+    void* second;
+    int isMerge;
+    void* result;
+} SortJob;
+
+static void runSortJob(SortJob* job) {
+    if (job->isMerge) {
+        job->result = job->ops->merge(job->first, job->second);
+    } else {
+        job->result = job->ops->sort(job->first);
+    }
+}
+
+// The workers of one sort: started once, then handed every level's jobs,
+// the chunk sorts first and each merge level after. The caller works
+// through the jobs alongside them.
+typedef struct SortPool {
+    pthread_t threads[LIST_SORT_MAX_THREADS];
+    int workers;                // Helpers that started
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // A level was posted, or stop
+    pthread_cond_t done;        // The level's last job finished
+    SortJob* jobs;
+    int count;                  // Jobs in the current level
+    int next;                   // Next job to claim
+    int finished;
+    int stop;
+} SortPool;
+
+// Claim and run the level's jobs until none is left; lock held on entry
+// and on return
+static void runClaimedJobs(SortPool* pool) {
+    while (pool->next < pool->count) {
+        SortJob* job = &pool->jobs[pool->next++];
+        pthread_mutex_unlock(&pool->lock);
+        runSortJob(job);
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->finished == pool->count) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+static void* sortWorker(void* arg) {
+    SortPool* pool = (SortPool*)arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->next >= pool->count) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) break;
+        runClaimedJobs(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Start up to `workers` helpers; if none can start, every job runs on the
+// caller
+static void startSortPool(SortPool* pool, int workers) {
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->jobs = NULL;
+    pool->count = 0;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->stop = 0;
+    pool->workers = 0;
+    while (pool->workers < workers &&
+           pthread_create(&pool->threads[pool->workers], NULL, sortWorker, pool) == 0) {
+        pool->workers++;
+    }
+}
+
+static void stopSortPool(SortPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+}
+
+// Run one level's jobs on the pool and wait until all have finished
+static void runSortJobs(SortPool* pool, SortJob* jobs, int count) {
+    pthread_mutex_lock(&pool->lock);
+    pool->jobs = jobs;
+    pool->count = count;
+    pool->next = 0;
+    pool->finished = 0;
+    pthread_cond_broadcast(&pool->start);
+    
+    runClaimedJobs(pool);
+    while (pool->finished < pool->count) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Sort a chain in chunks on several threads, then merge the chunks
+void* parallelListSort(void* head, int length, int threads, const ListSortOps* ops) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > LIST_SORT_MAX_THREADS) {
+        threads = LIST_SORT_MAX_THREADS;
+    }
+    if (threads > length / LIST_PARALLEL_SORT_MIN) {
+        threads = length / LIST_PARALLEL_SORT_MIN;
+    }
+    if (threads < 2) {
+        return ops->sort(head);
+    }
+    
+    SortJob jobs[LIST_SORT_MAX_THREADS];
+    void* runs[LIST_SORT_MAX_THREADS];
+    SortPool pool;
+    
+    // Cut the chain into chunks whose lengths differ by at most one
+    void* node = head;
+    for (int i = 0; i < threads; i++) {
+        int size = length / threads + (i < length % threads);
+        jobs[i] = (SortJob){ops, node, NULL, 0, NULL};
+        for (int k = 1; k < size; k++) {
+            node = ops->getNext(node);
+        }
+        void* next = ops->getNext(node);
+        ops->setNext(node, NULL);
+        node = next;
+    }
+    startSortPool(&pool, threads - 1);
+    runSortJobs(&pool, jobs, threads);
+    
+    int count = threads;
+    for (int i = 0; i < count; i++) {
+        runs[i] = jobs[i].result;
+    }
+    
+    // Merge neighbouring runs pairwise, earlier run first, until one is left
+    while (count > 1) {
+        int pairs = count / 2;
+        for (int i = 0; i < pairs; i++) {
+            jobs[i] = (SortJob){ops, runs[2 * i], runs[2 * i + 1], 1, NULL};
+        }
+        runSortJobs(&pool, jobs, pairs);
+        
+        for (int i = 0; i < pairs; i++) {
+            runs[i] = jobs[i].result;
+        }
+        if (count % 2 == 1) {
+            runs[pairs] = runs[count - 1];
+        }
+        count = pairs + count % 2;
+    }
+    stopSortPool(&pool);
+    return runs[0];
+}
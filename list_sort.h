@@ -0,0 +1,29 @@
+#ifndef LIST_SORT_H
+#define LIST_SORT_H
+
+// Parallel merge sort shared by the list libraries. A list cuts its chain
+// into one chunk per thread, sorts the chunks on worker threads with its
+// own sequential sort, then merges neighbouring chunks level by level on the
+// same workers. The result is stable, like the sequential sort.
+
+// Lists shorter than this (per thread) are sorted on the calling thread
+#define LIST_PARALLEL_SORT_MIN 16384
+#define LIST_SORT_MAX_THREADS 64
+
+// Bubble sorts hand lists longer than this to merge sort
+#define LIST_BUBBLE_SORT_MAX 32
+
+// How a list type links its nodes and sorts a NULL-terminated chain
+typedef struct ListSortOps {
+    void* (*getNext)(void* node);
+    void (*setNext)(void* node, void* next);
+    void* (*sort)(void* head);
+    void* (*merge)(void* first, void* second);  // Stable: ties keep first's nodes first
+} ListSortOps;
+
+// Sort a NULL-terminated chain of `length` nodes with up to `threads`
+// threads (0: one per online CPU). Falls back to ops->sort for short
+// lists, and runs any chunk whose thread cannot start on the caller.
+void* parallelListSort(void* head, int length, int threads, const ListSortOps* ops);
+
+#endif
@@ -0,0 +1,950 @@
+/*
+ * Self-checking tests for the list libraries and their node pool
+ *
+ * Each test prints a ✓ or ✗ line; the exit status is the number of
+ * failed tests. Library messages (allocation failures, "deleted" notes)
+ * are silenced while the calls that print them run.
+ *
+ * Usage:
+ *   list_test
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 list_test.c linked_list.c doubly_linked_list.c \
+ *     circular_linked_list.c unrolled_list.c node_pool.c list_sort.c -o list_test -ldl
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "linked_list.h"
+#include "doubly_linked_list.h"
+#include "circular_linked_list.h"
+#include "node_pool.h"
+#include "list_sort.h"
+#include "unrolled_list.h"
+
+static int failures;
+
+static void report(int ok, const char* what) {
+    printf("%s %s\n", ok ? "✓" : "✗", what);
+    if (!ok) {
+        failures++;
+    }
+}
+
+// Send stdout to /dev/null while on, for calls that print as they go
+static void quiet(int on) {
+    static int savedStdout = -1;
+    
+    fflush(stdout);
+    if (on && savedStdout < 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull < 0) {
+            return;
+        }
+        savedStdout = dup(STDOUT_FILENO);
+        dup2(devNull, STDOUT_FILENO);
+        close(devNull);
+    } else if (!on && savedStdout >= 0) {
+        dup2(savedStdout, STDOUT_FILENO);
+        close(savedStdout);
+        savedStdout = -1;
+    }
+}
+
+// A pool whose first block can never be allocated: every request fails
+static NodePool* createFailingPool(size_t nodeSize) {
+    return createNodePool(nodeSize, SIZE_MAX / 2);
+}
+
+// Does the chain hold exactly values[0..n)? Doubly linked chains must
+// also link back, and rings must close on their head.
+static int chainIs(Node* head, const int* values, int n) {
+    for (int i = 0; i < n; i++, head = head->next) {
+        if (head == NULL || head->data != values[i]) {
+            return 0;
+        }
+    }
+    return head == NULL;
+}
+
+static int dChainIs(DNode* head, const int* values, int n) {
+    DNode* prev = NULL;
+    for (int i = 0; i < n; i++, prev = head, head = head->next) {
+        if (head == NULL || head->data != values[i] || head->prev != prev) {
+            return 0;
+        }
+    }
+    return head == NULL;
+}
+
+static int cChainIs(CNode* head, const int* values, int n) {
+    CNode* node = head;
+    for (int i = 0; i < n; i++, node = node->next) {
+        if (node == NULL || node->data != values[i] || (i > 0 && node == head)) {
+            return 0;
+        }
+    }
+    return node == head;
+}
+
+// ========================================
+// Node pool
+// ========================================
+
+// Freed nodes are handed out again before fresh ones, latest first, also
+// through the list functions that free and allocate them
+static void poolReuseTest(void) {
+    NodePool* pool = createNodePool(sizeof(Node), 8);
+    int ok = pool != NULL;
+    
+    void* a = ok ? poolAllocNode(pool) : NULL;
+    void* b = ok ? poolAllocNode(pool) : NULL;
+    ok = ok && a != NULL && b != NULL && poolAllocNode(pool) != NULL;
+    if (ok) {
+        poolFreeNode(pool, a);
+        poolFreeNode(pool, b);
+        ok = poolNodesInUse(pool) == 1 && poolAllocNode(pool) == b && poolAllocNode(pool) == a;
+        ok = ok && poolNodesInUse(pool) == 3;
+    }
+    destroyNodePool(pool);
+    
+    const int values[] = {1, 2, 3, 4};
+    NodePool* listPool = createListPool(8);
+    Node* head = NULL;
+    for (int i = 0; ok && i < 4; i++) {
+        head = insertEndIn(listPool, head, values[i]);
+    }
+    Node* second = head != NULL ? head->next : NULL;
+    quiet(1);
+    head = deleteNodeIn(listPool, head, 2);
+    quiet(0);
+    head = insertBeginIn(listPool, head, 9);
+    const int reused[] = {9, 1, 3, 4};
+    ok = ok && head == second && chainIs(head, reused, 4) && poolNodesInUse(listPool) == 4;
+    Node* last = ok ? head->next->next->next : NULL;
+    freeListIn(listPool, head);
+    ok = ok && poolNodesInUse(listPool) == 0 && createNodeIn(listPool, 5) == last;
+    destroyNodePool(listPool);
+    
+    NodePool* dPool = createDListPool(8);
+    DNode* dHead = insertDArrayIn(dPool, NULL, (int*)values, 4);
+    DNode* dThird = dHead != NULL ? dHead->next->next : NULL;
+    dHead = deleteDNodeIn(dPool, dHead, 3);
+    dHead = insertDAfterIn(dPool, dHead, 1, 7);
+    const int dReused[] = {1, 7, 2, 4};
+    ok = ok && dHead != NULL && dHead->next == dThird && dChainIs(dHead, dReused, 4);
+    destroyNodePool(dPool);
+    
+    NodePool* cPool = createCListPool(8);
+    CNode* cHead = insertCArrayIn(cPool, NULL, (int*)values, 4);
+    CNode* cFirst = cHead;
+    cHead = deleteCNodeIn(cPool, cHead, 1);
+    cHead = insertCEndIn(cPool, cHead, 8);
+    const int cReused[] = {2, 3, 4, 8};
+    ok = ok && cHead != NULL && cHead->next->next->next == cFirst && cChainIs(cHead, cReused, 4);
+    destroyNodePool(cPool);
+    
+    report(ok, "Pool: freed nodes are reused first, latest first");
+}
+
+// A run that doesn't fit in the current block comes from a new one, and
+// the slots left behind in the old block go to the freelist
+static void poolRunTest(void) {
+    NodePool* pool = createNodePool(sizeof(Node), 8);
+    char* first = pool != NULL ? (char*)poolAllocNode(pool) : NULL;
+    char* second = first != NULL ? (char*)poolAllocNode(pool) : NULL;
+    int ok = second != NULL && poolAllocNode(pool) != NULL;
+    size_t slot = ok ? (size_t)(second - first) : 0;
+    
+    // 5 slots are left in the first block; a run of 10 needs a new one
+    char* run = ok ? (char*)poolAllocRun(pool, 10) : NULL;
+    ok = ok && run != NULL && (run < first || run >= first + 8 * slot);
+    
+    int leftover[8] = {0};
+    for (int i = 0; ok && i < 5; i++) {
+        char* node = (char*)poolAllocNode(pool);
+        size_t index = node >= first ? (size_t)(node - first) / slot : 8;
+        ok = index >= 3 && index < 8 && (size_t)(node - first) % slot == 0 && !leftover[index];
+        if (ok) {
+            leftover[index] = 1;
+        }
+    }
+    
+    // Then allocation goes on right behind the run, and a run that fits
+    // is carved from the same block
+    ok = ok && (char*)poolAllocNode(pool) == run + 10 * slot;
+    ok = ok && (char*)poolAllocRun(pool, 2) == run + 11 * slot;
+    ok = ok && poolAllocRun(pool, 0) == NULL && poolNodesInUse(pool) == 3 + 10 + 5 + 1 + 2;
+    destroyNodePool(pool);
+    
+    report(ok, "Pool: poolAllocRun moves the old block's leftover slots to the freelist");
+}
+
+// Reset keeps the largest block and hands its slots out from the front
+static void poolResetTest(void) {
+    enum { NODES = 30 };
+    NodePool* pool = createNodePool(sizeof(Node), 4);
+    void* nodes[NODES];
+    int ok = pool != NULL;
+    
+    // Blocks of 4, 8 and 16 hold 28 nodes; node 28 starts a block of 32
+    for (int i = 0; ok && i < NODES; i++) {
+        nodes[i] = poolAllocNode(pool);
+        ok = nodes[i] != NULL;
+    }
+    if (ok) {
+        poolFreeNode(pool, nodes[1]);
+        poolFreeNode(pool, nodes[5]);
+        resetNodePool(pool);
+        ok = poolNodesInUse(pool) == 0;
+    }
+    
+    // 32 adjacent slots, none of them a freed node from a dropped block
+    char* node = ok ? (char*)poolAllocNode(pool) : NULL;
+    ok = ok && node == (char*)nodes[NODES - 2];
+    size_t slot = ok ? (size_t)((char*)nodes[NODES - 1] - node) : 0;
+    for (int i = 1; ok && i < 32; i++) {
+        char* next = (char*)poolAllocNode(pool);
+        ok = next == node + slot;
+        node = next;
+    }
+    ok = ok && poolNodesInUse(pool) == 32;
+    destroyNodePool(pool);
+    
+    report(ok, "Pool: resetNodePool keeps the largest block and clears the freelist");
+}
+
+// When a node cannot be allocated, every insert returns the list as it was
+static void poolFailureTest(void) {
+    const int values[] = {1, 2, 3};
+    int extra[] = {7, 8};
+    
+    NodePool* failing = createFailingPool(sizeof(Node));
+    NodePool* pool = createListPool(0);
+    int ok = failing != NULL && pool != NULL;
+    ok = ok && poolAllocNode(failing) == NULL && poolAllocRun(failing, 2) == NULL;
+    ok = ok && poolNodesInUse(failing) == 0;
+    
+    Node* pooled = ok ? insertEndIn(pool, insertEndIn(pool, NULL, 1), 2) : NULL;
+    quiet(1);
+    Node* head = ok ? insertArrayIn(NULL, NULL, (int*)values, 3) : NULL;
+    ok = ok && createNodeIn(failing, 4) == NULL;
+    ok = ok && insertEndIn(failing, head, 4) == head && insertBeginIn(failing, head, 0) == head;
+    ok = ok && insertArrayIn(failing, head, extra, 2) == head;
+    ok = ok && insertEndIn(failing, NULL, 4) == NULL && insertArrayIn(failing, NULL, extra, 2) == NULL;
+    ok = ok && insertBeginIn(failing, pooled, 0) == pooled;
+    quiet(0);
+    const int pooledValues[] = {1, 2};
+    ok = ok && chainIs(head, values, 3) && chainIs(pooled, pooledValues, 2);
+    ok = ok && poolNodesInUse(failing) == 0 && poolNodesInUse(pool) == 2;
+    freeList(head);
+    destroyNodePool(failing);
+    destroyNodePool(pool);
+    
+    NodePool* dFailing = createFailingPool(sizeof(DNode));
+    DNode* dHead = insertDArray(NULL, (int*)values, 3);
+    quiet(1);
+    ok = ok && dFailing != NULL && createDNodeIn(dFailing, 4) == NULL;
+    ok = ok && insertDEndIn(dFailing, dHead, 4) == dHead && insertDBeginIn(dFailing, dHead, 0) == dHead;
+    ok = ok && insertDAfterIn(dFailing, dHead, 2, 4) == dHead;
+    ok = ok && insertDBeforeIn(dFailing, dHead, 1, 4) == dHead;
+    ok = ok && insertDBeforeIn(dFailing, dHead, 3, 4) == dHead;
+    ok = ok && insertDArrayIn(dFailing, dHead, extra, 2) == dHead;
+    quiet(0);
+    ok = ok && dChainIs(dHead, values, 3);
+    freeDList(dHead);
+    destroyNodePool(dFailing);
+    
+    NodePool* cFailing = createFailingPool(sizeof(CNode));
+    CNode* cHead = insertCArray(NULL, (int*)values, 3);
+    quiet(1);
+    ok = ok && cFailing != NULL && createCNodeIn(cFailing, 4) == NULL;
+    ok = ok && insertCEndIn(cFailing, cHead, 4) == cHead && insertCBeginIn(cFailing, cHead, 0) == cHead;
+    ok = ok && insertCAfterIn(cFailing, cHead, 3, 4) == cHead;
+    ok = ok && insertCArrayIn(cFailing, cHead, extra, 2) == cHead;
+    quiet(0);
+    ok = ok && cChainIs(cHead, values, 3);
+    freeCList(cHead);
+    destroyNodePool(cFailing);
+    
+    report(ok, "Pool: failed allocations return NULL and leave every list unchanged");
+}
+
+// ========================================
+// List handles
+// ========================================
+
+// Does a handle hold exactly values[0..n), with its tail on the last node
+// and its length right?
+static int listIs(const List* list, const int* values, int n) {
+    Node* last = NULL;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        last = node;
+    }
+    return list->tail == last && list->length == n && listLength(list) == n &&
+           chainIs(list->head, values, n);
+}
+
+static int dListIs(const DList* list, const int* values, int n) {
+    return list->tail == getTail(list->head) && list->length == n && dListLength(list) == n &&
+           dChainIs(list->head, values, n);
+}
+
+static int cListIs(const CList* list, const int* values, int n) {
+    int closed = list->head == NULL ? list->tail == NULL
+                                    : list->tail != NULL && list->tail->next == list->head;
+    return closed && list->length == n && cListLength(list) == n &&
+           cChainIs(list->head, values, n);
+}
+
+// The same edits on every handle type, each followed by a check of the
+// whole chain, the tail and the length. Out of memory is simulated by
+// pointing the handle at a pool that cannot allocate.
+static const int seq[] = {0, 1, 2, 3, 4, 5};
+static const int afterDeletes[] = {1, 2, 4};
+static const int afterArray[] = {1, 2, 4, 9, 3, 7};
+static const int sorted[] = {1, 2, 3, 4, 7, 9};
+static const int reversed[] = {10, 9, 7, 4, 3, 2, 1, 0};
+
+static void listHandleTest(NodePool* pool, const char* what) {
+    List list;
+    int added[] = {9, 3, 7};
+    int ok = initList(&list, pool) && listIs(&list, NULL, 0);
+    
+    for (int i = 1; ok && i <= 5; i++) {
+        ok = listAppend(&list, i) && listIs(&list, seq + 1, i);
+    }
+    ok = ok && listPrepend(&list, 0) && listIs(&list, seq, 6);
+    
+    const int afterHead[] = {1, 2, 3, 4, 5}, afterTail[] = {1, 2, 3, 4};
+    ok = ok && listDelete(&list, 0) && listIs(&list, afterHead, 5);
+    ok = ok && listDelete(&list, 5) && listIs(&list, afterTail, 4);
+    ok = ok && listDelete(&list, 3) && listIs(&list, afterDeletes, 3);
+    ok = ok && !listDelete(&list, 42) && listIs(&list, afterDeletes, 3);
+    
+    NodePool* failing = createFailingPool(sizeof(Node));
+    NodePool* own = list.pool;
+    list.pool = failing;
+    quiet(1);
+    ok = ok && failing != NULL && !listInsertArray(&list, added, 3);
+    ok = ok && !listAppend(&list, 8) && !listPrepend(&list, 8);
+    quiet(0);
+    list.pool = own;
+    destroyNodePool(failing);
+    ok = ok && listIs(&list, afterDeletes, 3);
+    
+    ok = ok && listInsertArray(&list, added, 3) && listIs(&list, afterArray, 6);
+    ok = ok && listInsertArray(&list, added, 0) && listIs(&list, afterArray, 6);
+    listSort(&list);
+    ok = ok && listIs(&list, sorted, 6);
+    listReverse(&list);
+    ok = ok && listIs(&list, reversed + 1, 6);
+    ok = ok && listAppend(&list, 0) && listPrepend(&list, 10) && listIs(&list, reversed, 8);
+    
+    for (int i = 0; ok && i < 8; i++) {
+        ok = listDelete(&list, reversed[i]) && listIs(&list, reversed + i + 1, 7 - i);
+    }
+    ok = ok && listAppend(&list, 5) && list.head == list.tail && listIs(&list, seq + 5, 1);
+    listClear(&list);
+    ok = ok && listIs(&list, NULL, 0) && listPrepend(&list, 5) && listIs(&list, seq + 5, 1);
+    destroyList(&list);
+    
+    char label[96];
+    snprintf(label, sizeof(label), "List handle (%s): tail and length follow every edit", what);
+    report(ok, label);
+}
+
+static void dListHandleTest(NodePool* pool, const char* what) {
+    DList list;
+    int added[] = {9, 3, 7};
+    int ok = initDList(&list, pool) && dListIs(&list, NULL, 0);
+    
+    for (int i = 1; ok && i <= 5; i++) {
+        ok = dListAppend(&list, i) && dListIs(&list, seq + 1, i);
+    }
+    ok = ok && dListPrepend(&list, 0) && dListIs(&list, seq, 6);
+    
+    const int afterHead[] = {1, 2, 3, 4, 5}, afterTail[] = {1, 2, 3, 4};
+    ok = ok && dListDelete(&list, 0) && dListIs(&list, afterHead, 5);
+    ok = ok && dListDelete(&list, 5) && dListIs(&list, afterTail, 4);
+    ok = ok && dListDelete(&list, 3) && dListIs(&list, afterDeletes, 3);
+    ok = ok && !dListDelete(&list, 42) && dListIs(&list, afterDeletes, 3);
+    
+    NodePool* failing = createFailingPool(sizeof(DNode));
+    NodePool* own = list.pool;
+    list.pool = failing;
+    quiet(1);
+    ok = ok && failing != NULL && !dListInsertArray(&list, added, 3);
+    ok = ok && !dListAppend(&list, 8) && !dListPrepend(&list, 8);
+    quiet(0);
+    list.pool = own;
+    destroyNodePool(failing);
+    ok = ok && dListIs(&list, afterDeletes, 3);
+    
+    ok = ok && dListInsertArray(&list, added, 3) && dListIs(&list, afterArray, 6);
+    ok = ok && dListInsertArray(&list, added, 0) && dListIs(&list, afterArray, 6);
+    dListSort(&list);
+    ok = ok && dListIs(&list, sorted, 6);
+    dListReverse(&list);
+    ok = ok && dListIs(&list, reversed + 1, 6);
+    ok = ok && dListAppend(&list, 0) && dListPrepend(&list, 10) && dListIs(&list, reversed, 8);
+    
+    for (int i = 0; ok && i < 8; i++) {
+        ok = dListDelete(&list, reversed[i]) && dListIs(&list, reversed + i + 1, 7 - i);
+    }
+    ok = ok && dListAppend(&list, 5) && list.head == list.tail && dListIs(&list, seq + 5, 1);
+    dListClear(&list);
+    ok = ok && dListIs(&list, NULL, 0) && dListPrepend(&list, 5) && dListIs(&list, seq + 5, 1);
+    destroyDList(&list);
+    
+    char label[96];
+    snprintf(label, sizeof(label), "DList handle (%s): tail, length and prev links follow every edit", what);
+    report(ok, label);
+}
+
+static void cListHandleTest(NodePool* pool, const char* what) {
+    CList list;
+    int added[] = {9, 3, 7};
+    int ok = initCList(&list, pool) && cListIs(&list, NULL, 0);
+    
+    for (int i = 1; ok && i <= 5; i++) {
+        ok = cListAppend(&list, i) && cListIs(&list, seq + 1, i);
+    }
+    ok = ok && cListPrepend(&list, 0) && cListIs(&list, seq, 6);
+    
+    const int afterHead[] = {1, 2, 3, 4, 5}, afterTail[] = {1, 2, 3, 4};
+    ok = ok && cListDelete(&list, 0) && cListIs(&list, afterHead, 5);
+    ok = ok && cListDelete(&list, 5) && cListIs(&list, afterTail, 4);
+    ok = ok && cListDelete(&list, 3) && cListIs(&list, afterDeletes, 3);
+    ok = ok && !cListDelete(&list, 42) && cListIs(&list, afterDeletes, 3);
+    
+    NodePool* failing = createFailingPool(sizeof(CNode));
+    NodePool* own = list.pool;
+    list.pool = failing;
+    quiet(1);
+    ok = ok && failing != NULL && !cListInsertArray(&list, added, 3);
+    ok = ok && !cListAppend(&list, 8) && !cListPrepend(&list, 8);
+    quiet(0);
+    list.pool = own;
+    destroyNodePool(failing);
+    ok = ok && cListIs(&list, afterDeletes, 3);
+    
+    ok = ok && cListInsertArray(&list, added, 3) && cListIs(&list, afterArray, 6);
+    ok = ok && cListInsertArray(&list, added, 0) && cListIs(&list, afterArray, 6);
+    cListSort(&list);
+    ok = ok && cListIs(&list, sorted, 6);
+    cListReverse(&list);
+    ok = ok && cListIs(&list, reversed + 1, 6);
+    ok = ok && cListAppend(&list, 0) && cListPrepend(&list, 10) && cListIs(&list, reversed, 8);
+    
+    for (int i = 0; ok && i < 8; i++) {
+        ok = cListDelete(&list, reversed[i]) && cListIs(&list, reversed + i + 1, 7 - i);
+    }
+    ok = ok && cListAppend(&list, 5) && list.head == list.tail && cListIs(&list, seq + 5, 1);
+    cListClear(&list);
+    ok = ok && cListIs(&list, NULL, 0) && cListPrepend(&list, 5) && cListIs(&list, seq + 5, 1);
+    destroyCList(&list);
+    
+    char label[96];
+    snprintf(label, sizeof(label), "CList handle (%s): tail, length and ring follow every edit", what);
+    report(ok, label);
+}
+
+// ========================================
+// Sorts
+// ========================================
+
+// Thread creation can be refused, to make the parallel sort run chunks
+// on the calling thread. list_sort.o binds to this definition.
+static int refuseThreads;
+static int refusedThreads;
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr,
+                   void* (*start)(void*), void* arg) {
+    typedef int (*CreateFunction)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+    static CreateFunction realCreate;
+    
+    if (refuseThreads) {
+        refusedThreads++;
+        return EAGAIN;
+    }
+    if (realCreate == NULL) {
+        realCreate = (CreateFunction)dlsym(RTLD_NEXT, "pthread_create");
+    }
+    return realCreate != NULL ? realCreate(thread, attr, start, arg) : EAGAIN;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// n values with plenty of ties, and the same values sorted by qsort
+static int* randomValues(int n, int** expected) {
+    int* values = (int*)malloc(((size_t)n + 1) * sizeof(int));
+    *expected = (int*)malloc(((size_t)n + 1) * sizeof(int));
+    for (int i = 0; values != NULL && *expected != NULL && i < n; i++) {
+        values[i] = rand() % (n / 4 + 2);
+        (*expected)[i] = values[i];
+    }
+    if (values != NULL && *expected != NULL) {
+        qsort(*expected, (size_t)n, sizeof(int), compareInts);
+    }
+    return values;
+}
+
+// Lists are built as one pool run, so node i of the input is base[i].
+// Sorts that relink must leave each node's value alone and keep equal
+// values in input order (stable); sorts that only swap values ("in
+// place") must leave every node where it was.
+enum { RELINKED, IN_PLACE };
+
+static int orderKept(const int* values, long index, long nextIndex, int nextData, int mode) {
+    if (mode == IN_PLACE) {
+        return nextIndex == index + 1;
+    }
+    return values[nextIndex] == nextData && (values[index] != nextData || nextIndex > index);
+}
+
+static int sortedList(Node* head, Node* base, const int* values, const int* expected, int n,
+                      int mode) {
+    int ok = chainIs(head, expected, n) && (n == 0 || mode == RELINKED || head == base);
+    for (Node* node = head; ok && node != NULL && node->next != NULL; node = node->next) {
+        ok = orderKept(values, node - base, node->next - base, node->next->data, mode);
+    }
+    return ok;
+}
+
+static int sortedDList(DNode* head, DNode* base, const int* values, const int* expected, int n,
+                       int mode) {
+    int ok = dChainIs(head, expected, n) && (n == 0 || mode == RELINKED || head == base);
+    for (DNode* node = head; ok && node != NULL && node->next != NULL; node = node->next) {
+        ok = orderKept(values, node - base, node->next - base, node->next->data, mode);
+    }
+    return ok;
+}
+
+static int sortedCList(CNode* head, CNode* base, const int* values, const int* expected, int n,
+                       int mode) {
+    int ok = cChainIs(head, expected, n) && (n == 0 || mode == RELINKED || head == base);
+    for (CNode* node = head; ok && node != NULL && node->next != head; node = node->next) {
+        ok = orderKept(values, node - base, node->next - base, node->next->data, mode);
+    }
+    return ok;
+}
+
+// Sort one random list of n values with each sort of each list type;
+// threads < 0 runs the sequential sorts, otherwise the parallel ones
+static int sortCase(int n, int threads) {
+    int* expected;
+    int* values = randomValues(n, &expected);
+    if (values == NULL || expected == NULL) {
+        free(values);
+        free(expected);
+        return 0;
+    }
+    
+    NodePool* pool = createListPool(0);
+    NodePool* dPool = createDListPool(0);
+    NodePool* cPool = createCListPool(0);
+    int ok = pool != NULL && dPool != NULL && cPool != NULL;
+    int bubbleMode = n <= LIST_BUBBLE_SORT_MAX ? IN_PLACE : RELINKED;
+    
+    quiet(1);
+    for (int round = 0; ok && round < (threads < 0 ? 2 : 1); round++) {
+        Node* base = insertArrayIn(pool, NULL, values, n);
+        DNode* dBase = insertDArrayIn(dPool, NULL, values, n);
+        CNode* cBase = insertCArrayIn(cPool, NULL, values, n);
+        Node* head = base;
+        DNode* dHead = dBase;
+        CNode* cHead = cBase;
+        int mode = RELINKED;
+        
+        if (threads >= 0) {
+            head = mergeSortParallel(head, threads);
+            dHead = mergeSortDParallel(dHead, threads);
+            cHead = mergeSortCParallel(cHead, threads);
+        } else if (round == 0) {
+            head = mergeSort(head);
+            dHead = mergeSortD(dHead);
+            cHead = mergeSortC(cHead);
+        } else {
+            head = bubbleSort(head);
+            dHead = bubbleSortD(dHead);
+            cHead = bubbleSortC(cHead);
+            mode = bubbleMode;
+        }
+        ok = sortedList(head, base, values, expected, n, mode) &&
+             sortedDList(dHead, dBase, values, expected, n, mode) &&
+             sortedCList(cHead, cBase, values, expected, n, mode);
+        resetNodePool(pool);
+        resetNodePool(dPool);
+        resetNodePool(cPool);
+    }
+    quiet(0);
+    
+    destroyNodePool(pool);
+    destroyNodePool(dPool);
+    destroyNodePool(cPool);
+    free(values);
+    free(expected);
+    return ok;
+}
+
+// Sequential sorts around the bubble sort limit and the merge sort's
+// power-of-two runs, against qsort. Past LIST_BUBBLE_SORT_MAX the bubble
+// sorts must relink like merge sort, not swap values.
+static void sortTest(void) {
+    const int sizes[] = {0, 1, 2, 3, 31, 32, 33, 63, 64, 65, 1000, 4097};
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        ok = sortCase(sizes[i], -1);
+    }
+    report(ok, "Sort: merge and bubble sorts match qsort, stable, prev links and rings intact");
+}
+
+// Parallel sorts over several chunk multiples and thread counts, then
+// again with every worker thread refused so chunks run on the caller
+static void parallelSortTest(void) {
+    const int sizes[] = {
+        LIST_PARALLEL_SORT_MIN * 2 - 1, LIST_PARALLEL_SORT_MIN * 2,
+        LIST_PARALLEL_SORT_MIN * 3 + 1, LIST_PARALLEL_SORT_MIN * 4
+    };
+    const int threads[] = {0, 2, 3, 4, LIST_SORT_MAX_THREADS};
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (size_t t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+            ok = sortCase(sizes[i], threads[t]);
+        }
+    }
+    report(ok, "Sort: parallel sorts match qsort and stay stable for 0..64 threads");
+    
+    refuseThreads = 1;
+    ok = sortCase(LIST_PARALLEL_SORT_MIN * 3 + 1, 3) && sortCase(LIST_PARALLEL_SORT_MIN * 4, 4);
+    refuseThreads = 0;
+    report(ok && refusedThreads > 0, "Sort: parallel sorts finish on the caller when threads cannot start");
+}
+
+// ========================================
+// Unrolled list
+// ========================================
+
+// Does the handle hold exactly values[0..n)? Every node must hold 1 to
+// UNROLLED_CAPACITY values, the tail must be the last node, and uListGet
+// must agree at every position and refuse the ones past either end.
+static int uListIs(const UList* list, const int* values, int n) {
+    const UNode* last = NULL;
+    int i = 0;
+    for (const UNode* node = list->head; node != NULL; last = node, node = node->next) {
+        if (node->count < 1 || node->count > UNROLLED_CAPACITY || i + node->count > n) {
+            return 0;
+        }
+        for (int j = 0; j < node->count; j++, i++) {
+            if (node->data[j] != values[i]) {
+                return 0;
+            }
+        }
+    }
+    
+    int value;
+    for (int p = 0; p < n; p++) {
+        if (!uListGet(list, p, &value) || value != values[p]) {
+            return 0;
+        }
+    }
+    return i == n && list->tail == last && list->length == n && uListLength(list) == n &&
+           !uListGet(list, n, &value) && !uListGet(list, -1, &value);
+}
+
+static int uNodes(const UList* list) {
+    int nodes = 0;
+    for (const UNode* node = list->head; node != NULL; node = node->next) {
+        nodes++;
+    }
+    return nodes;
+}
+
+// The reference the list is checked against: a plain array, and the
+// position of the first occurrence of a value in it, or -1
+static int refFind(const int* ref, int n, int value) {
+    for (int i = 0; i < n; i++) {
+        if (ref[i] == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void refInsert(int* ref, int* n, int at, int value) {
+    memmove(ref + at + 1, ref + at, (size_t)(*n - at) * sizeof(int));
+    ref[at] = value;
+    (*n)++;
+}
+
+static void refRemove(int* ref, int* n, int at) {
+    (*n)--;
+    memmove(ref + at, ref + at + 1, (size_t)(*n - at) * sizeof(int));
+}
+
+// Node splits and merges at the capacity boundaries, node by node
+static void uListNodeTest(NodePool* pool, const char* what) {
+    enum { CAP = UNROLLED_CAPACITY, MAX = 8 * UNROLLED_CAPACITY };
+    int ref[MAX];
+    int n = 0;
+    UList list;
+    int ok = initUList(&list, pool) && uListIs(&list, NULL, 0) && uNodes(&list) == 0;
+    
+    // Appends fill the tail node, then start another
+    for (int i = 0; ok && i <= CAP; i++) {
+        refInsert(ref, &n, n, i);
+        ok = uListAppend(&list, i) && uListIs(&list, ref, n);
+    }
+    ok = ok && uNodes(&list) == 2 && list.head->count == CAP && list.tail->count == 1;
+    
+    // A prepend onto a full head node starts a new head node
+    refInsert(ref, &n, 0, -1);
+    ok = ok && uListPrepend(&list, -1) && uListIs(&list, ref, n);
+    refInsert(ref, &n, 0, -2);
+    ok = ok && uListPrepend(&list, -2) && uListIs(&list, ref, n);
+    ok = ok && uNodes(&list) == 3 && list.head->count == 2;
+    
+    // An array tops up the tail node, then fills whole nodes
+    int added[2 * CAP + 3];
+    for (int i = 0; i < 2 * CAP + 3; i++) {
+        added[i] = 100 + i;
+        refInsert(ref, &n, n, added[i]);
+    }
+    ok = ok && uListInsertArray(&list, added, 2 * CAP + 3) && uListIs(&list, ref, n);
+    ok = ok && uListInsertArray(&list, added, 0) && uListIs(&list, ref, n);
+    ok = ok && uNodes(&list) == 5 && list.tail->count == 4;
+    
+    // Emptying a node frees it, the head and the tail included
+    for (int i = 0; ok && i < 2; i++) {
+        refRemove(ref, &n, 0);
+        ok = uListDelete(&list, -2 + i) && uListIs(&list, ref, n);
+    }
+    ok = ok && uNodes(&list) == 4 && !uListDelete(&list, -1) && uListIs(&list, ref, n);
+    for (int i = 3; ok && i >= 0; i--) {
+        int value = 100 + 2 * CAP - 1 + i;
+        refRemove(ref, &n, refFind(ref, n, value));
+        ok = uListDelete(&list, value) && uListIs(&list, ref, n);
+    }
+    ok = ok && uNodes(&list) == 3;
+    
+    // The tail node shrinks to its first 4 values, from the end
+    for (int value = 100 + 2 * CAP - 2; ok && value >= 100 + CAP + 3; value--) {
+        refRemove(ref, &n, refFind(ref, n, value));
+        ok = uListDelete(&list, value) && uListIs(&list, ref, n);
+    }
+    int third = list.tail->count;
+    ok = ok && third == 4 && uNodes(&list) == 3;
+    
+    // A node left under half full absorbs its successor once both fit in
+    // one: the first node shrinks from the front until the second's CAP
+    // values fit, which first happens at zero (it is freed instead)
+    for (int i = 0; ok && i < CAP; i++) {
+        int value = ref[0];
+        refRemove(ref, &n, 0);
+        ok = uListDelete(&list, value) && uListIs(&list, ref, n);
+        ok = ok && uNodes(&list) == (i < CAP - 1 ? 3 : 2);
+    }
+    
+    // Now a full node, then `third` values: the head merges once it drops
+    // below half full and to CAP - third or fewer
+    int merged = 0;
+    for (int i = 0; ok && !merged; i++) {
+        int value = ref[1];
+        refRemove(ref, &n, 1);
+        ok = uListDelete(&list, value) && uListIs(&list, ref, n);
+        merged = uNodes(&list) == 1;
+        int left = CAP - 1 - i;
+        ok = ok && merged == (left < CAP / 2 && left + third <= CAP);
+    }
+    ok = ok && merged && list.head == list.tail && list.head->count == n;
+    
+    // uListClear empties the handle and leaves it usable
+    uListClear(&list);
+    ok = ok && uListIs(&list, NULL, 0) && uListPrepend(&list, 5) && uListIs(&list, seq + 5, 1);
+    destroyUList(&list);
+    
+    char label[96];
+    snprintf(label, sizeof(label), "UList handle (%s): nodes split and merge at capacity", what);
+    report(ok, label);
+}
+
+// Random appends, prepends, arrays and deletes against the reference,
+// each followed by a check of every node; then sort and reverse. Out of
+// memory is simulated by pointing the handle at a pool that cannot
+// allocate: failed inserts must leave the list as it was.
+static void uListEditTest(NodePool* pool, const char* what) {
+    enum { MAX = 600, OPS = 3000 };
+    int ref[MAX + 32];
+    int n = 0;
+    UList list;
+    int ok = initUList(&list, pool);
+    NodePool* failing = createFailingPool(sizeof(UNode));
+    ok = ok && failing != NULL;
+    
+    for (int op = 0; ok && op < OPS; op++) {
+        int value = rand() % 64;
+        int kind = rand() % 8;
+        if (n > MAX - 32 && kind < 5) {
+            kind = 5 + kind % 3;
+        }
+        
+        if (kind < 2) {
+            refInsert(ref, &n, n, value);
+            ok = uListAppend(&list, value);
+        } else if (kind < 4) {
+            refInsert(ref, &n, 0, value);
+            ok = uListPrepend(&list, value);
+        } else if (kind == 4) {
+            int added[32];
+            int size = rand() % 32;
+            for (int i = 0; i < size; i++) {
+                added[i] = rand() % 64;
+                refInsert(ref, &n, n, added[i]);
+            }
+            ok = uListInsertArray(&list, added, size);
+        } else {
+            int at = refFind(ref, n, value);
+            if (at >= 0) {
+                refRemove(ref, &n, at);
+            }
+            ok = uListDelete(&list, value) == (at >= 0);
+        }
+        ok = ok && uListIs(&list, ref, n) && uListSearch(&list, value) == refFind(ref, n, value);
+        
+        // Now and then, inserts that need a node while none can be had
+        if (ok && op % 50 == 0 && n > 0) {
+            NodePool* own = list.pool;
+            int added[2 * UNROLLED_CAPACITY];
+            for (int i = 0; i < 2 * UNROLLED_CAPACITY; i++) {
+                added[i] = i;
+            }
+            list.pool = failing;
+            int room = UNROLLED_CAPACITY - list.tail->count;
+            ok = !uListInsertArray(&list, added, room + 1) && uListIs(&list, ref, n);
+            if (ok && list.head->count == UNROLLED_CAPACITY) {
+                ok = !uListPrepend(&list, 1) && uListIs(&list, ref, n);
+            }
+            list.pool = own;
+        }
+    }
+    
+    int sortedRef[MAX + 32];
+    memcpy(sortedRef, ref, (size_t)n * sizeof(int));
+    qsort(sortedRef, (size_t)n, sizeof(int), compareInts);
+    ok = ok && uListSort(&list) && uListIs(&list, sortedRef, n);
+    ok = ok && uNodes(&list) == (n + UNROLLED_CAPACITY - 1) / UNROLLED_CAPACITY;
+    for (int i = 0; i < n; i++) {
+        ref[i] = sortedRef[n - 1 - i];
+    }
+    uListReverse(&list);
+    ok = ok && uListIs(&list, ref, n);
+    
+    destroyUList(&list);
+    destroyNodePool(failing);
+    
+    char label[96];
+    snprintf(label, sizeof(label), "UList handle (%s): random edits, sort and reverse", what);
+    report(ok, label);
+}
+
+// uListSearch (one SIMD compare per node) against a linear scan. Lists
+// get partial nodes at the head (prepends), in the middle (deletes) and
+// at the end; deletes leave stale copies past a node's count, which must
+// not match, and neither must a node's count field.
+static void uListSearchTest(void) {
+    enum { CAP = UNROLLED_CAPACITY, MAX = 20 * UNROLLED_CAPACITY };
+    const int sizes[] = {0, 1, CAP - 1, CAP, CAP + 1, 2 * CAP, 3 * CAP + 5, MAX};
+    int ref[MAX];
+    int ok = 1;
+    
+    for (size_t s = 0; ok && s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+        int n = 0;
+        UList list;
+        ok = initUList(&list, NULL);
+        
+        // Values from 100 up, so no node count (1..CAP) is one of them
+        for (int i = 0; ok && i < size; i++) {
+            int value = 100 + rand() % (size / 2 + 2);
+            if (i % 3 == 0) {
+                refInsert(ref, &n, 0, value);
+                ok = uListPrepend(&list, value);
+            } else {
+                refInsert(ref, &n, n, value);
+                ok = uListAppend(&list, value);
+            }
+        }
+        for (int i = 0; ok && i < n; i += 5) {
+            int value = ref[i];
+            refRemove(ref, &n, refFind(ref, n, value));
+            ok = uListDelete(&list, value);
+        }
+        
+        // The last value of the last node goes too, leaving a stale copy
+        int last = n > 0 ? ref[n - 1] : 0;
+        if (ok && n > 0 && refFind(ref, n - 1, last) < 0) {
+            refRemove(ref, &n, n - 1);
+            ok = uListDelete(&list, last);
+        }
+        ok = ok && uListIs(&list, ref, n) && uListSearch(&list, last) == refFind(ref, n, last);
+        
+        for (int target = 0; ok && target < 100 + size / 2 + 4; target++) {
+            ok = uListSearch(&list, target) == refFind(ref, n, target);
+        }
+        destroyUList(&list);
+    }
+    report(ok, "UList search: SIMD node compares match a linear scan, hits and misses");
+}
+
+int main(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("List library tests\n");
+    printf("==================\n");
+    
+    poolReuseTest();
+    poolRunTest();
+    poolResetTest();
+    poolFailureTest();
+    
+    NodePool* pool = createListPool(0);
+    NodePool* dPool = createDListPool(0);
+    NodePool* cPool = createCListPool(0);
+    NodePool* uPool = createUListPool(0);
+    listHandleTest(NULL, "own pool");
+    listHandleTest(pool, "shared pool");
+    dListHandleTest(NULL, "own pool");
+    dListHandleTest(dPool, "shared pool");
+    cListHandleTest(NULL, "own pool");
+    cListHandleTest(cPool, "shared pool");
+    srand(2024);
+    uListNodeTest(NULL, "own pool");
+    uListNodeTest(uPool, "shared pool");
+    uListEditTest(NULL, "own pool");
+    uListEditTest(uPool, "shared pool");
+    uListSearchTest();
+    int drained = poolNodesInUse(pool) == 0 && poolNodesInUse(dPool) == 0 &&
+                  poolNodesInUse(cPool) == 0 && poolNodesInUse(uPool) == 0;
+    report(drained, "Handles on a shared pool give back every node");
+    destroyNodePool(pool);
+    destroyNodePool(dPool);
+    destroyNodePool(cPool);
+    destroyNodePool(uPool);
+    
+    sortTest();
+    parallelSortTest();
+    
+    printf("\n%s %d test(s) failed\n", failures == 0 ? "✓" : "✗", failures);
+    return failures;
+}
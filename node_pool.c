@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "node_pool.h"
+
+#define POOL_DEFAULT_BLOCK 256
+#define POOL_MAX_BLOCK 65536
+
+// A block of slots; slots start right after the header
+typedef struct PoolBlock {
+    struct PoolBlock* next;
+    size_t capacity;
+    max_align_t slots[];
+} PoolBlock;
+
+// A free slot holds the link to the next free slot
+typedef struct FreeSlot {
+    struct FreeSlot* next;
+} FreeSlot;
+
+struct NodePool {
+    size_t slotSize;
+    size_t nextCapacity;
+    PoolBlock* blocks;      // Newest first; the bump pointer is in blocks
+    char* bump;
+    char* bumpEnd;
+    FreeSlot* freeList;
+    size_t inUse;
+};
+
+// Create a pool of nodeSize-byte nodes
+NodePool* createNodePool(size_t nodeSize, size_t nodesPerBlock) {
+    if (nodeSize == 0) {
+        return NULL;
+    }
+    
+    NodePool* pool = (NodePool*)calloc(1, sizeof(NodePool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    
+    // A type's alignment divides its size, so the largest power of two
+    // dividing nodeSize (at most max_align_t's) keeps every slot aligned
+    size_t align = nodeSize & (~nodeSize + 1);
+    if (align > _Alignof(max_align_t)) {
+        align = _Alignof(max_align_t);
+    }
+    if (align < _Alignof(FreeSlot)) {
+        align = _Alignof(FreeSlot);
+    }
+    if (nodeSize < sizeof(FreeSlot)) {
+        nodeSize = sizeof(FreeSlot);
+    }
+    pool->slotSize = (nodeSize + align - 1) / align * align;
+    pool->nextCapacity = nodesPerBlock > 0 ? nodesPerBlock : POOL_DEFAULT_BLOCK;
+    return pool;
+}
+
+// Release every block, and with them every node
+void destroyNodePool(NodePool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    
+    PoolBlock* block = pool->blocks;
+    while (block != NULL) {
+        PoolBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(pool);
+}
+
+// Add a block of at least minCapacity slots and point the bump allocator
+// at it. Slots left in the old block move to the freelist.
+static int poolGrow(NodePool* pool, size_t minCapacity) {
+    size_t capacity = pool->nextCapacity > minCapacity ? pool->nextCapacity : minCapacity;
+    if (capacity > (SIZE_MAX - sizeof(PoolBlock)) / pool->slotSize) {
+        return 0;
+    }
+    
+    PoolBlock* block = (PoolBlock*)malloc(sizeof(PoolBlock) + capacity * pool->slotSize);
+    if (block == NULL) {
+        return 0;
+    }
+    block->capacity = capacity;
+    while (pool->bump != pool->bumpEnd) {
+        FreeSlot* slot = (FreeSlot*)pool->bump;
+        slot->next = pool->freeList;
+        pool->freeList = slot;
+        pool->bump += pool->slotSize;
+    }
+    block->next = pool->blocks;
+    pool->blocks = block;
+    pool->bump = (char*)block->slots;
+    pool->bumpEnd = pool->bump + capacity * pool->slotSize;
+    
+    if (capacity < POOL_MAX_BLOCK) {
+        pool->nextCapacity = capacity * 2 < POOL_MAX_BLOCK ? capacity * 2 : POOL_MAX_BLOCK;
+    }
+    return 1;
+}
+
+// Take a node: recently freed slots first, then fresh ones in address order
+void* poolAllocNode(NodePool* pool) {
+    void* node;
+    
+    if (pool->freeList != NULL) {
+        node = pool->freeList;
+        pool->freeList = pool->freeList->next;
+    } else {
+        if (pool->bump == pool->bumpEnd && !poolGrow(pool, 1)) {
+            return NULL;
+        }
+        node = pool->bump;
+        pool->bump += pool->slotSize;
+    }
+    pool->inUse++;
+    return node;
+}
+
+// Take count adjacent fresh slots in one step
+void* poolAllocRun(NodePool* pool, size_t count) {
+    if (count == 0) {
+        return NULL;
+    }
+    
+    size_t available = (size_t)(pool->bumpEnd - pool->bump) / pool->slotSize;
+    if (available < count && !poolGrow(pool, count)) {
+        return NULL;
+    }
+    
+    void* run = pool->bump;
+    pool->bump += count * pool->slotSize;
+    pool->inUse += count;
+    return run;
+}
+
+// Give a node back to the pool it came from
+void poolFreeNode(NodePool* pool, void* node) {
+    if (node == NULL) {
+        return;
+    }
+    
+    FreeSlot* slot = (FreeSlot*)node;
+    slot->next = pool->freeList;
+    pool->freeList = slot;
+    pool->inUse--;
+}
+
+// Forget every node and start allocating from the front of the largest block
+void resetNodePool(NodePool* pool) {
+    if (pool->blocks == NULL) {
+        return;
+    }
+    
+    // Keep only the largest block so reuse stays contiguous
+    PoolBlock* keep = pool->blocks;
+    for (PoolBlock* block = keep->next; block != NULL; block = block->next) {
+        if (block->capacity > keep->capacity) {
+            keep = block;
+        }
+    }
+    PoolBlock* block = pool->blocks;
+    while (block != NULL) {
+        PoolBlock* next = block->next;
+        if (block != keep) {
+            free(block);
+        }
+        block = next;
+    }
+    keep->next = NULL;
+    pool->blocks = keep;
+    pool->bump = (char*)keep->slots;
+    pool->bumpEnd = pool->bump + keep->capacity * pool->slotSize;
+    pool->freeList = NULL;
+    pool->inUse = 0;
+}
+
+// Number of nodes handed out and not yet freed
+size_t poolNodesInUse(const NodePool* pool) {
+    return pool->inUse;
+}
@@ -0,0 +1,31 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <stddef.h>
+
+// Fixed-size node allocator shared by the list libraries. Nodes are carved
+// out of large blocks in allocation order, so nodes created one after the
+// other sit next to each other in memory. Freed nodes go on a freelist and
+// are reused first; destroyNodePool releases every block at once.
+typedef struct NodePool NodePool;
+
+// nodesPerBlock sizes the first block (0: a default); later blocks double
+// up to a cap. Returns NULL if out of memory.
+NodePool* createNodePool(size_t nodeSize, size_t nodesPerBlock);
+void destroyNodePool(NodePool* pool);
+
+// Returns NULL when a new block cannot be allocated
+void* poolAllocNode(NodePool* pool);
+void poolFreeNode(NodePool* pool, void* node);
+
+// count fresh nodes side by side, each can be freed on its own later.
+// For node types holding a pointer the run is an array of nodes. NULL if
+// out of memory.
+void* poolAllocRun(NodePool* pool, size_t count);
+
+// Frees every node at once, keeping the largest block for reuse
+void resetNodePool(NodePool* pool);
+
+size_t poolNodesInUse(const NodePool* pool);
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "ring_buffer.h"
+
+// A cell at position pos is free for the producer of pos when its sequence
+// equals pos, and holds that producer's item for the consumer of pos when it
+// equals pos + 1. Consuming sets it to pos + capacity, the next lap's turn.
+
+// Create a ring with room for at least `capacity` items
+RingBuffer* createRingBuffer(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        if (size > SIZE_MAX / 2 / sizeof(RingCell)) return NULL;
+        size <<= 1;
+    }
+
+    RingBuffer* ring = NULL;
+    if (posix_memalign((void**)&ring, RING_CACHE_LINE, sizeof(RingBuffer)) != 0) {
+        return NULL;
+    }
+    void* cells = NULL;
+    if (posix_memalign(&cells, RING_CACHE_LINE, size * sizeof(RingCell)) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->cells = (RingCell*)cells;
+    ring->mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        ring->cells[i].sequence = i;
+        ring->cells[i].data = NULL;
+    }
+    ring->enqueuePos = 0;
+    ring->dequeuePos = 0;
+    return ring;
+}
+
+// Free a ring (items still queued are not freed)
+void destroyRingBuffer(RingBuffer* ring) {
+    if (ring == NULL) return;
+    free(ring->cells);
+    free(ring);
+}
+
+// Enqueue one item, claiming the next position once its cell is free
+int ringEnqueue(RingBuffer* ring, void* item) {
+    size_t pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+
+    for (;;) {
+        RingCell* cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->enqueuePos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->data = item;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+            // pos now holds the current counter; try again from there
+        } else if (diff < 0) {
+            return 0;   // Cell still holds last lap's item: full
+        } else {
+            pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Dequeue one item, claiming the next position once its cell is filled
+int ringDequeue(RingBuffer* ring, void** item) {
+    size_t pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+
+    for (;;) {
+        RingCell* cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->dequeuePos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *item = cell->data;
+                __atomic_store_n(&cell->sequence, pos + ring->mask + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;   // Producer of pos has not finished: empty
+        } else {
+            pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Count the cells from pos on (up to max) whose sequence is pos + i + offset,
+// i.e. ready for this side. Stops at the first cell that is not.
+static size_t readyRun(RingBuffer* ring, size_t pos, size_t max, size_t offset,
+                       intptr_t* firstDiff) {
+    size_t n = 0;
+    while (n < max) {
+        RingCell* cell = &ring->cells[(pos + n) & ring->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + n + offset);
+        if (n == 0) *firstDiff = diff;
+        if (diff != 0) break;
+        n++;
+    }
+    return n;
+}
+
+// Enqueue up to count items: find how many cells ahead are free, claim them
+// all with one compare-and-swap, then fill and publish them in order
+size_t ringEnqueueBatch(RingBuffer* ring, void* const* items, size_t count) {
+    if (count == 0) return 0;
+    if (count > ring->mask + 1) count = ring->mask + 1;
+    size_t pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+
+    for (;;) {
+        intptr_t diff = 0;
+        size_t n = readyRun(ring, pos, count, 0, &diff);
+
+        if (n > 0) {
+            if (__atomic_compare_exchange_n(&ring->enqueuePos, &pos, pos + n, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                for (size_t i = 0; i < n; i++) {
+                    RingCell* cell = &ring->cells[(pos + i) & ring->mask];
+                    cell->data = items[i];
+                    __atomic_store_n(&cell->sequence, pos + i + 1, __ATOMIC_RELEASE);
+                }
+                return n;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Dequeue up to count items the same way: claim the filled run, then read
+// and free each cell for the next lap
+size_t ringDequeueBatch(RingBuffer* ring, void** items, size_t count) {
+    if (count == 0) return 0;
+    if (count > ring->mask + 1) count = ring->mask + 1;
+    size_t pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+
+    for (;;) {
+        intptr_t diff = 0;
+        size_t n = readyRun(ring, pos, count, 1, &diff);
+
+        if (n > 0) {
+            if (__atomic_compare_exchange_n(&ring->dequeuePos, &pos, pos + n, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                for (size_t i = 0; i < n; i++) {
+                    RingCell* cell = &ring->cells[(pos + i) & ring->mask];
+                    items[i] = cell->data;
+                    __atomic_store_n(&cell->sequence, pos + i + ring->mask + 1,
+                                     __ATOMIC_RELEASE);
+                }
+                return n;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Get the number of slots
+size_t ringCapacity(const RingBuffer* ring) {
+    return ring->mask + 1;
+}
+
+// Get the number of queued items (claimed positions, so in-flight
+// operations count as done)
+size_t ringSizeApprox(const RingBuffer* ring) {
+    size_t tail = __atomic_load_n(&ring->dequeuePos, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&ring->enqueuePos, __ATOMIC_ACQUIRE);
+    size_t size = head - tail;
+    return size > ring->mask + 1 ? ring->mask + 1 : size;
+}
@@ -0,0 +1,46 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+
+// Bounded lock-free multi-producer multi-consumer queue of pointers. The
+// ring is an array of cells used circularly, like the circular list but
+// with the "next" link implied by position: each cell carries a sequence
+// number telling producers and consumers whose turn it is (Dmitry Vyukov's
+// bounded MPMC queue), so threads only race on the enqueue and dequeue
+// counters, which sit on separate cache lines.
+#define RING_CACHE_LINE 64
+
+typedef struct RingCell {
+    size_t sequence;
+    void* data;
+} RingCell;
+
+typedef struct RingBuffer {
+    size_t enqueuePos __attribute__((aligned(RING_CACHE_LINE)));
+    size_t dequeuePos __attribute__((aligned(RING_CACHE_LINE)));
+    RingCell* cells __attribute__((aligned(RING_CACHE_LINE)));
+    size_t mask;                    // Capacity - 1 (capacity is a power of two)
+} RingBuffer;
+
+// Capacity is rounded up to a power of two (at least 2). Returns NULL if
+// out of memory.
+RingBuffer* createRingBuffer(size_t capacity);
+void destroyRingBuffer(RingBuffer* ring);
+
+// Single items: return 1 on success, 0 if the ring is full (enqueue) or
+// empty (dequeue). Never block.
+int ringEnqueue(RingBuffer* ring, void* item);
+int ringDequeue(RingBuffer* ring, void** item);
+
+// Batches claim a run of cells with one atomic step and return how many
+// items were moved (0 to count); items keep their order within a batch.
+size_t ringEnqueueBatch(RingBuffer* ring, void* const* items, size_t count);
+size_t ringDequeueBatch(RingBuffer* ring, void** items, size_t count);
+
+// Utility functions. The size is a snapshot; it may be stale by the time
+// the caller reads it while other threads are active.
+size_t ringCapacity(const RingBuffer* ring);
+size_t ringSizeApprox(const RingBuffer* ring);
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Multi-threaded throughput benchmark for ring_buffer
+ *
+ * Runs N producers and N consumers against one ring for 1, 2, 4 ... N
+ * thread pairs and reports items/sec through the queue. Each point is run
+ * on the lock-free ring and on the same ring guarded by one mutex, for
+ * comparison. With -b, producers and consumers move items in batches of
+ * that many. Every run checks that each item came out exactly once and in
+ * order per producer.
+ *
+ * Usage:
+ *   ring_buffer_bench [-t max_pairs] [-s seconds] [-c capacity] [-b batch]
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 ring_buffer_bench.c ring_buffer.c -o ring_buffer_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "ring_buffer.h"
+
+#define MAX_PAIRS 64
+#define MAX_BATCH 256
+
+typedef struct {
+    int maxPairs;
+    double seconds;
+    size_t capacity;
+    int batch;
+} BenchConfig;
+
+// Items are (producer << 40) | (sequence + 1), so NULL never goes in
+typedef struct {
+    RingBuffer* ring;
+    pthread_mutex_t* lock;          // Set: every ring call holds it
+    const BenchConfig* config;
+    int id;
+    uint64_t items;                 // Producer: enqueued; consumer: dequeued
+    uint64_t lastSeen[MAX_PAIRS];   // Consumer: last sequence per producer
+    int outOfOrder;
+} Worker;
+
+static int running;
+static int producersLeft;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t enqueueSome(Worker* w, void** items, size_t count) {
+    if (w->lock == NULL) {
+        return count == 1 ? (size_t)ringEnqueue(w->ring, items[0])
+                          : ringEnqueueBatch(w->ring, items, count);
+    }
+    pthread_mutex_lock(w->lock);
+    size_t n = count == 1 ? (size_t)ringEnqueue(w->ring, items[0])
+                          : ringEnqueueBatch(w->ring, items, count);
+    pthread_mutex_unlock(w->lock);
+    return n;
+}
+
+static size_t dequeueSome(Worker* w, void** items, size_t count) {
+    if (w->lock == NULL) {
+        return count == 1 ? (size_t)ringDequeue(w->ring, items)
+                          : ringDequeueBatch(w->ring, items, count);
+    }
+    pthread_mutex_lock(w->lock);
+    size_t n = count == 1 ? (size_t)ringDequeue(w->ring, items)
+                          : ringDequeueBatch(w->ring, items, count);
+    pthread_mutex_unlock(w->lock);
+    return n;
+}
+
+static void* producerMain(void* arg) {
+    Worker* w = (Worker*)arg;
+    size_t batch = (size_t)w->config->batch;
+    void* items[MAX_BATCH];
+    uint64_t next = 0;
+
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        for (size_t i = 0; i < batch; i++) {
+            items[i] = (void*)(uintptr_t)(((uint64_t)w->id << 40) | (next + i + 1));
+        }
+        // Retry the rest of a partly accepted batch before making a new one
+        size_t done = 0;
+        while (done < batch && __atomic_load_n(&running, __ATOMIC_RELAXED)) {
+            size_t n = enqueueSome(w, items + done, batch - done);
+            if (n == 0) sched_yield();
+            done += n;
+        }
+        next += done;
+    }
+    w->items = next;
+    __atomic_sub_fetch(&producersLeft, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* consumerMain(void* arg) {
+    Worker* w = (Worker*)arg;
+    size_t batch = (size_t)w->config->batch;
+    void* items[MAX_BATCH];
+
+    for (;;) {
+        int last = __atomic_load_n(&producersLeft, __ATOMIC_ACQUIRE) == 0;
+        size_t n = dequeueSome(w, items, batch);
+        for (size_t i = 0; i < n; i++) {
+            uint64_t item = (uint64_t)(uintptr_t)items[i];
+            int producer = (int)(item >> 40);
+            uint64_t seq = item & ((1ULL << 40) - 1);
+            if (seq <= w->lastSeen[producer]) w->outOfOrder = 1;
+            w->lastSeen[producer] = seq;
+        }
+        w->items += n;
+        if (n == 0) {
+            // Every producer was done before this empty read: drained
+            if (last) break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Run one point; returns items/sec, or -1 if an item was lost or reordered
+static double runPoint(const BenchConfig* config, int pairs, int locked) {
+    RingBuffer* ring = createRingBuffer(config->capacity);
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    Worker* workers = (Worker*)calloc((size_t)pairs * 2, sizeof(Worker));
+    pthread_t threads[MAX_PAIRS * 2];
+    if (ring == NULL || workers == NULL) {
+        destroyRingBuffer(ring);
+        free(workers);
+        return -1;
+    }
+
+    __atomic_store_n(&running, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&producersLeft, pairs, __ATOMIC_RELAXED);
+    for (int i = 0; i < pairs * 2; i++) {
+        workers[i] = (Worker){ .ring = ring, .lock = locked ? &lock : NULL,
+                               .config = config, .id = i < pairs ? i : i - pairs };
+    }
+
+    double start = nowSeconds();
+    for (int i = 0; i < pairs * 2; i++) {
+        pthread_create(&threads[i], NULL, i < pairs ? producerMain : consumerMain, &workers[i]);
+    }
+    usleep((useconds_t)(config->seconds * 1e6));
+    __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < pairs * 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = nowSeconds() - start;
+
+    // Each producer's items must all have come out, each exactly once
+    uint64_t produced = 0, consumed = 0;
+    int ok = 1;
+    for (int p = 0; p < pairs; p++) {
+        uint64_t highest = 0;
+        for (int c = 0; c < pairs; c++) {
+            Worker* consumer = &workers[pairs + c];
+            if (consumer->lastSeen[p] > highest) highest = consumer->lastSeen[p];
+        }
+        if (highest != workers[p].items) ok = 0;
+        produced += workers[p].items;
+    }
+    for (int c = 0; c < pairs; c++) {
+        consumed += workers[pairs + c].items;
+        if (workers[pairs + c].outOfOrder) ok = 0;
+    }
+    if (produced != consumed) ok = 0;
+
+    destroyRingBuffer(ring);
+    free(workers);
+    return ok ? consumed / elapsed : -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-t max_pairs] [-s seconds] [-c capacity] [-b batch]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    BenchConfig config = { cpus > 1 ? (int)cpus / 2 : 1, 1.0, 1024, 1 };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:c:b:h")) != -1) {
+        switch (opt) {
+            case 't': config.maxPairs = atoi(optarg); break;
+            case 's': config.seconds = atof(optarg); break;
+            case 'c': config.capacity = (size_t)atol(optarg); break;
+            case 'b': config.batch = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.maxPairs < 1 || config.maxPairs > MAX_PAIRS || config.seconds <= 0 ||
+        config.capacity < 2 || config.batch < 1 || config.batch > MAX_BATCH) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RingBuffer* probe = createRingBuffer(config.capacity);
+    if (probe == NULL) {
+        fprintf(stderr, "✗ Memory allocation failed!\n");
+        return 1;
+    }
+    printf("ring_buffer: capacity %zu, batch %d, %.1fs per point, %ld CPUs\n\n",
+           ringCapacity(probe), config.batch, config.seconds, cpus);
+    destroyRingBuffer(probe);
+    printf("%-8s %14s %14s %10s\n", "pairs", "lock-free/s", "mutex/s", "speedup");
+
+    double base = 0;
+    for (int pairs = 1; ; pairs *= 2) {
+        if (pairs > config.maxPairs) pairs = config.maxPairs;
+        double lockFree = runPoint(&config, pairs, 0);
+        double locked = runPoint(&config, pairs, 1);
+        if (lockFree < 0 || locked < 0) {
+            fprintf(stderr, "✗ %d pairs: items lost, duplicated or out of order\n", pairs);
+            return 1;
+        }
+        if (base == 0) base = lockFree;
+        printf("%-8d %14.0f %14.0f %9.2fx\n", pairs, lockFree, locked, lockFree / base);
+        if (pairs == config.maxPairs) break;
+    }
+    return 0;
+}
@@ -1,323 +1,6365 @@
 /*
  * Simple In-Memory Database in C
- * 
+ *
  * Features:
- * - Key-value storage (string keys, string values)
- * - Hash table implementation
+ * - Key-value storage (string keys, binary-safe values of configurable size)
+ * - Hash table implementation with incremental resizing
+ * - Optional open-addressing engine (Swiss-table style, SIMD group probing)
  * - CRUD operations (Create, Read, Update, Delete)
  * - Python FFI compatible
- * - Thread-safe operations
- * 
+ * - Thread-safe operations: lock-free readers, striped writer locks
+ * - Snapshots: db_save writes an mmap-able image, db_open_mmap serves it
+ * - Optional write-ahead log with group commit, replay and compaction
+ * - Optional ordered index (B+tree) with prefix and range scan cursors
+ * - Per-key TTLs and a memory budget enforced by CLOCK eviction
+ * - Sharded mode: one Database per core, fed by lock-free SPSC queues
+ *
  * Compile as shared library:
- * gcc -shared -fPIC -Wall -Wextra -g -O2 simple_db.c -o libsimpledb.so
- * 
+ * gcc -shared -fPIC -pthread -Wall -Wextra -g -O2 simple_db.c -o libsimpledb.so
+ *
  * Or on macOS:
- * gcc -shared -fPIC -Wall -Wextra -g -O2 simple_db.c -o libsimpledb.dylib
+ * gcc -shared -fPIC -pthread -Wall -Wextra -g -O2 simple_db.c -o libsimpledb.dylib
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE  // pthread_setaffinity_np, CPU_SET
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "simple_db.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 // ============================================================================
 // CONFIGURATION
 // ============================================================================
 
-#define HASH_TABLE_SIZE 1024
-#define MAX_KEY_LENGTH 256
-#define MAX_VALUE_LENGTH 4096
+#define INITIAL_TABLE_SIZE 1024   // Default bucket count (power of two)
+#define MAX_LOAD_FACTOR 1         // Grow once entries exceed buckets * factor
+#define REHASH_STEP 4             // Buckets migrated per write during a resize
+#define MAX_KEY_LENGTH 256
+#define MAX_VALUE_LENGTH 4096     // Default value limit (values < this)
+#define MAX_VALUE_LIMIT (1u << 30) // Ceiling for db_set_max_value_length
+
+#define SWISS_GROUP_WIDTH 16      // Control bytes probed per SIMD compare
+#define SWISS_INLINE_BYTES 32     // Key (and small value) bytes kept in a slot
+#define SWISS_MAX_LOAD_NUM 7      // Resize once 7/8 of the slots are used
+#define SWISS_MAX_LOAD_DEN 8
+
+#define STRIPE_BITS 6             // 64 independently locked stripes
+#define DB_STRIPES (1u << STRIPE_BITS)
+#define RETIRE_BATCH 64           // Retired objects per reclamation attempt
+#define CACHE_LINE 64
+
+#define BATCH_WINDOW 16           // Keys hashed and prefetched ahead of probing
+
+#define SLAB_CLASSES 28           // Block sizes 16 .. MAX_VALUE_LENGTH bytes
+#define SLAB_MIN_CHUNK 4096       // First chunk of a stripe's arena
+#define SLAB_MAX_CHUNK (256 * 1024)
+
+#define WAL_FLUSH_INTERVAL_US 2000  // Default group-commit window
+#define WAL_BATCH_BYTES (64 * 1024) // Default early-flush threshold
+#define WAL_BACKLOG_BATCHES 4       // Writers stall beyond this many batches
+
+#define REAP_INTERVAL_MS 100        // Background expiry pass period
+#define REAP_SAMPLE 32              // Slots or buckets examined per stripe per pass
+
+#define SHARD_QUEUE_SLOTS 16        // Requests one client can queue on one shard
+#define SHARD_MAX_CLIENTS 256       // Client handles open at once
+#define SHARD_SPIN 4000             // Polls before an idle thread parks (multi-core)
+
+#define STATS_THREADS 256           // Threads with their own db_stats_ex block per database
+
+#define VERSION_TABLE_MIN 16        // First version table of a read view's stripe
+#define SAVE_BUFFER_BYTES (64 * 1024) // Records a snapshot save copies out per step
+
+// ============================================================================
+// DATA STRUCTURES
+// ============================================================================
+
+// Entry in the hash table, allocated as one slab block together with its
+// key. key and hash never change after insertion; value and next are swapped
+// atomically so lock-free readers always see a valid pointer. A NULL value
+// marks a key deleted from the snapshot underneath (see SNAPSHOT IMAGE).
+// Values may hold any bytes; value[value_len] is always a NUL.
+typedef struct Entry {
+    char *value;         // Slab block of value_cap bytes
+    uint64_t hash;       // Full hash: resizing never rehashes keys, and a
+                         // mismatch skips the key compare
+    struct Entry *next;  // For collision chaining
+    uint64_t expires;    // Wall-clock deadline in ms, 0 = no TTL
+    uint32_t value_cap;  // Updates up to value_cap - 1 bytes are done in place
+    uint32_t value_len;
+    uint32_t key_len;
+    uint8_t referenced;  // CLOCK bit: set by reads, cleared by the eviction hand
+    char key[];
+} Entry;
+
+// Bucket array; carries its own size so a reader never pairs one array with
+// another array's mask
+typedef struct BucketArray {
+    size_t size;          // Power of two
+    Entry *buckets[];
+} BucketArray;
+
+// Chained hash table
+//
+// The table grows by doubling. Instead of rehashing everything at once, the
+// previous bucket array is kept in old_table and drained a few buckets per
+// write (see rehash_step), so no single operation pays for the whole resize.
+typedef struct ChainTable {
+    BucketArray *table;      // Active buckets
+    BucketArray *old_table;  // Buckets still being migrated, or NULL
+    size_t rehash_index;     // Next old bucket to migrate
+} ChainTable;
+
+// Slot in the open-addressing table
+//
+// Keys shorter than the inline area live in the slot itself. If the value
+// fits too (key + value + two NULs <= SWISS_INLINE_BYTES) the entry needs no
+// allocation at all; otherwise the value, and for long keys the key, are
+// heap strings referenced from the tail of the inline area. A slot is one
+// cache line.
+typedef struct SwissSlot {
+    uint64_t hash;
+    uint64_t expires;     // As Entry
+    uint32_t value_len;
+    uint16_t key_len;
+    uint8_t flags;        // SLOT_* bits below
+    int8_t value_class;   // Slab class of a heap value, or -1 for a large block
+    uint8_t referenced;   // As Entry
+    union {
+        char bytes[SWISS_INLINE_BYTES];
+        struct {
+            char *key;                       // Valid when !SLOT_INLINE_KEY
+            char pad[SWISS_INLINE_BYTES - 2 * sizeof(char*)];
+            char *value;                     // Valid when !SLOT_INLINE_VALUE
+        } heap;
+    } data;
+} SwissSlot;
+
+_Static_assert(MAX_VALUE_LIMIT < UINT32_MAX, "value lengths are 32-bit");
+_Static_assert(sizeof(SwissSlot) == CACHE_LINE, "slots fill a cache line");
+
+#define SLOT_INLINE_KEY   0x1
+#define SLOT_INLINE_VALUE 0x2
+
+// Swiss-table style open addressing
+//
+// ctrl holds one byte per slot: EMPTY, DELETED, or the top 7 hash bits of the
+// entry stored there. Slots are probed a group of 16 at a time, matching the
+// 7-bit tag against all control bytes of the group in one SIMD compare, so a
+// lookup usually touches one control line and one slot. The header, control
+// bytes and slots are one allocation that is replaced wholesale on rehash.
+typedef struct SwissTable {
+    size_t capacity;      // Power of two, multiple of SWISS_GROUP_WIDTH
+    size_t growth_left;   // Inserts allowed before the next rehash
+    SwissSlot *slots;     // capacity slots
+    int8_t ctrl[];        // capacity control bytes, followed by the slots
+} SwissTable;
+
+// Per-stripe slab allocator for entries, keys and values
+//
+// Blocks are carved from large chunks in a fixed set of size classes and
+// freed blocks go on a per-class free list, so churn reuses the same memory
+// instead of fragmenting the general heap. Chunks are only returned as a
+// whole, by db_clear and db_destroy. Values too big for any class get a
+// block of their own, kept on a list so the arena still frees everything.
+typedef struct SlabChunk {
+    struct SlabChunk *next;
+    size_t size;
+} SlabChunk;
+
+typedef struct LargeBlock {
+    struct LargeBlock *prev, *next;
+    size_t size;                        // Usable bytes after the header
+} LargeBlock;
+
+typedef struct Arena {
+    SlabChunk *chunks;
+    LargeBlock *large;
+    char *bump;                         // Unused tail of the newest chunk
+    size_t bump_left;
+    size_t next_chunk;                  // Size of the next chunk to allocate
+    size_t in_use;                      // Bytes in blocks handed out or retired
+    void *free_list[SLAB_CLASSES];      // Each free block links to the next
+} Arena;
+
+// Memory waiting for every reader that might still see it to leave.
+// Slab blocks (block_size != 0) go back to the stripe's arena; anything
+// else is handed to release.
+typedef struct RetireItem {
+    void *ptr;
+    void (*release)(void *ptr);
+    uint64_t epoch;       // Global epoch when the object was unlinked
+    uint32_t block_size;
+} RetireItem;
+
+// One lock stripe: an independent table for the keys whose low hash bits
+// select it. Writers take the mutex and bump seq to odd while they modify
+// the stripe; readers take no lock and retry if seq moved under them.
+typedef struct Stripe {
+    pthread_mutex_t lock;
+    uint32_t seq;
+    size_t count;         // Live keys stored in this stripe
+    size_t shadowed;      // Snapshot keys overridden or deleted here
+    size_t ttl_keys;      // Keys here with a deadline
+    size_t clock_hand;    // Next bucket or slot the eviction sweep examines
+    size_t reap_hand;     // Next bucket or slot the expiry pass examines
+    uint64_t evictions;
+    uint64_t expirations;
+    ChainTable chain;     // Used by DB_ENGINE_CHAINED
+    SwissTable *swiss;    // Used by DB_ENGINE_SWISS
+    Arena *arena;
+    RetireItem *retired;
+    size_t retired_len;
+    size_t retired_cap;
+    size_t retired_bytes; // Arena bytes in the retire list
+} __attribute__((aligned(CACHE_LINE))) Stripe;
+
+// Lookup counters, kept apart from the stripes so readers bumping them
+// don't keep invalidating the line holding seq
+typedef struct StripeCounters {
+    uint64_t hits;
+    uint64_t misses;
+} __attribute__((aligned(CACHE_LINE))) StripeCounters;
+
+// One thread's db_stats_ex counters for one database. Only the owning
+// thread writes them, with a plain load and store; readers sum the blocks.
+typedef struct ThreadStats {
+    uint64_t ticks;       // Operations so far, for latency sampling
+    DBOpStats ops[DB_OP_KINDS];
+} __attribute__((aligned(CACHE_LINE))) ThreadStats;
+
+// On-disk snapshot, laid out so it can be served straight from a read-only
+// mapping:
+//
+//   SnapshotHeader | records ... | SnapshotSlot index[index_slots]
+//
+// Each record is uint32 key_len, uint32 value_len, key, NUL, value, NUL,
+// padded to 8 bytes. The index is a linear-probing hash table of record
+// offsets (0 = empty slot) kept at most half full. A slot's `expires` is
+// the key's deadline in wall-clock seconds (rounded up), or 0.
+#define SNAPSHOT_MAGIC "SDBSNAP1"
+#define SNAPSHOT_VERSION 2         // 2: 64-bit hashes in the index
+#define SNAPSHOT_HASH_DJB2 1       // hash_function the index was built with
+#define SNAPSHOT_HASH_WYHASH 2
+#define SNAPSHOT_RECORD_HEADER 8
+
+typedef struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t hash_id;
+    uint64_t count;           // Keys in the image
+    uint64_t index_offset;
+    uint64_t index_slots;     // Power of two
+    uint64_t file_size;
+    uint64_t reserved[2];
+} SnapshotHeader;
+
+typedef struct SnapshotSlot {
+    uint64_t hash;
+    uint32_t key_len;
+    uint32_t expires;         // Was reserved (always 0) before TTLs
+    uint64_t offset;
+} SnapshotSlot;
+
+// A mapped snapshot. It is never written; changes go to the stripes above
+// it (the overlay), which shadow its keys with new values or tombstones.
+typedef struct SnapshotImage {
+    const char *map;
+    size_t size;
+    const SnapshotSlot *index;
+    size_t mask;
+    size_t count;
+} SnapshotImage;
+
+// Write-ahead log. Each change is appended as one record:
+//
+//   uint32 checksum, uint32 key_len, uint32 value_len, uint8 op, 3 pad bytes,
+//   key, value
+//
+// WAL_OP_SET_EX records carry the key's deadline (uint64 ms) in front of
+// the value, counted in value_len. Evictions and expirations are logged as
+// deletes, so replay never brings those keys back.
+//
+// The checksum (FNV-1a over everything after it) lets replay stop at a
+// record torn by a crash. Writers append to `buf` under their stripe lock;
+// the flusher thread swaps it with `spare` and writes and syncs it unlocked,
+// so one fdatasync covers every record that arrived during the window.
+#define WAL_RECORD_HEADER 16
+
+enum { WAL_OP_SET = 1, WAL_OP_DELETE = 2, WAL_OP_CLEAR = 3, WAL_OP_SET_EX = 4 };
+
+typedef struct WalLog {
+    int fd;
+    pthread_mutex_t lock;
+    pthread_cond_t work;      // Signalled when there is something to flush
+    pthread_cond_t synced_cond;  // Broadcast after each sync
+    pthread_t flusher;
+    char *buf, *spare;
+    size_t len, cap, spare_cap;
+    uint64_t appended;        // Log bytes produced so far (the LSN)
+    uint64_t synced;          // Log bytes known to be on disk
+    uint64_t urgent;          // LSN db_wal_sync wants flushed now
+    struct timespec deadline; // When the oldest buffered record must go out
+    DBWalConfig config;
+    bool flushing;            // The flusher is writing outside the lock
+    bool closing;
+    bool failed;              // A write or sync failed; the log is unusable
+} WalLog;
+
+// Ordered index: a B+tree over copies of every live key, maintained next
+// to the hash table once enabled so scans can walk keys in order. Leaves
+// are chained left to right; internal nodes own copies of their separator
+// keys. Child i of an internal node holds keys in [keys[i-1], keys[i]).
+#define BTREE_MAX_KEYS 32
+#define BTREE_MIN_KEYS (BTREE_MAX_KEYS / 2)
+#define BTREE_MAX_DEPTH 16        // Far more than 2^64 keys would need
+
+typedef struct BTreeNode {
+    bool leaf;
+    int count;                                // Keys in use
+    char *keys[BTREE_MAX_KEYS + 1];           // One spare while splitting
+    struct BTreeNode *next;                   // Leaves: right sibling
+    struct BTreeNode *children[];             // Internal nodes: count + 1 used
+} BTreeNode;
+
+typedef struct OrderedIndex {
+    pthread_rwlock_t lock;    // Scans read; writers take it under a stripe lock
+    BTreeNode *root;
+    uint64_t version;         // Bumped by every change, so cursors know to re-seek
+} OrderedIndex;
+
+// Scan cursor. Between calls it remembers the last key returned, and the
+// leaf position it came from while the index version is unchanged.
+struct DBCursor {
+    Database *db;
+    char *value;              // Grown to fit the current record's value
+    size_t value_len, value_cap;
+    BTreeNode *leaf;          // Valid only while version matches the index
+    int pos;
+    uint64_t version;
+    bool started;             // key holds the last key returned
+    bool pending;             // key/value were fetched but not yet handed out
+    bool done;
+    bool prefix_mode;         // Stop at the first key without the prefix
+    bool has_end;
+    size_t bound_len;
+    char bound[MAX_KEY_LENGTH];   // Prefix, or exclusive end of the range
+    char start[MAX_KEY_LENGTH];
+    char key[MAX_KEY_LENGTH];
+};
+
+// Database structure
+struct Database {
+    DBEngine engine;
+    SnapshotImage *base;     // Mapped snapshot under the stripes, or NULL
+    WalLog *wal;             // Write-ahead log, or NULL
+    OrderedIndex *index;     // Ordered key index, or NULL
+    size_t max_value_len;    // Longest value writers accept
+    size_t stripe_budget;    // db_set_max_memory share of each stripe, 0 = none
+    pthread_mutex_t reaper_lock;
+    pthread_cond_t reaper_wake;
+    pthread_t reaper;        // Background expiry, started by the first TTL
+    bool reaper_running;
+    bool reaper_stop;
+    Stripe stripes[DB_STRIPES];
+    StripeCounters counters[DB_STRIPES];
+    ThreadStats *thread_stats[STATS_THREADS];  // By epoch record slot, created on first use
+    ThreadStats shared_stats;  // Slots past STATS_THREADS, updated with atomic adds
+    DBSnapshot *views;       // Open read views, newest first; changed with every stripe held
+    pthread_mutex_t save_lock;
+    struct SaveJob *save;    // db_save_background not yet collected, or NULL
+};
+
+// Read views (DBSnapshot): copy-on-write MVCC over the live tables
+//
+// Opening a view copies nothing. Instead, the first time a writer is about
+// to change a key while views are open, it saves the key's state as it was
+// (value and deadline, or absent) into every open view that has no version
+// of that key yet. A view reads a key from its saved version if there is
+// one and from the live table otherwise, so it sees the database as it was
+// when it opened, and costs memory only for the keys changed since.
+//
+// Versions are immutable once published. Each view keeps them per stripe,
+// added under that stripe's lock: an open-addressing table of pointers to
+// them for lookups (at most half full, replaced when it grows; readers
+// probe it without a lock) and a list of them, newest first, for scans.
+typedef struct SavedVersion {
+    uint64_t hash;
+    uint64_t expires;
+    uint32_t key_len;
+    uint32_t value_len;
+    bool present;               // The key existed when the view opened
+    bool emitted;               // The view's scan had already returned it
+    struct SavedVersion *older; // Next in the stripe's list
+    char data[];                // Key, NUL, value, NUL
+} SavedVersion;
+
+typedef struct VersionTable {
+    size_t mask;
+    SavedVersion *slots[];
+} VersionTable;
+
+typedef struct VersionMap {
+    VersionTable *table;        // NULL until the stripe's first version
+    SavedVersion *first;
+    size_t count;
+} VersionMap;
+
+// A view scans the live tables in db_scan's order (stripes, then the
+// mapped snapshot), skipping keys it holds versions of, then returns those
+// versions that were present and the live walk had not already passed
+// when they were saved. Writers read the scan's phase and position to
+// tell which side of it a key is on.
+#define VIEW_PHASE_BASE DB_STRIPES
+#define VIEW_PHASE_VERSIONS (DB_STRIPES + 1)
+#define VIEW_PHASE_DONE (DB_STRIPES + 2)
+
+struct DBSnapshot {
+    Database *db;
+    uint64_t now;               // Deadlines are judged as of the opening
+    size_t count;               // db_count at the opening
+    size_t bytes;               // Versions and tables
+    bool failed;                // A version couldn't be saved: reads are unreliable
+    DBSnapshot *next;
+    uint64_t scan_phase;        // Stripe, VIEW_PHASE_BASE, ... VIEW_PHASE_DONE
+    uint64_t scan_position;     // Bucket or group counter, or snapshot slot
+    size_t scan_map;            // VIEW_PHASE_VERSIONS: stripe whose versions are next
+    SavedVersion *scan_version; // and the next of them to look at
+    VersionMap maps[DB_STRIPES];
+};
+
+// A db_save_background: the view being written, on its own thread
+typedef struct SaveJob {
+    DBSnapshot *snapshot;
+    char *path;
+    pthread_t thread;
+    bool ok;
+} SaveJob;
+
+// Sleep/wake handshake for a thread that polls for work. The waiter sets
+// sleeping and re-checks for work before blocking; a producer publishes
+// its work and then checks sleeping, so one of the two always sees the
+// other (both sides order the pair with a full fence).
+typedef struct Parker {
+    int sleeping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} Parker;
+
+typedef enum ShardOp {
+    SHARD_SET,
+    SHARD_GET,
+    SHARD_DELETE,
+    SHARD_MSET,
+    SHARD_MGET,
+    SHARD_MDELETE
+} ShardOp;
+
+// One key of a batch, routed to its shard
+typedef struct ShardKey {
+    const char *key;
+    const char *value;    // SHARD_MSET
+    size_t key_len;
+    size_t value_len;
+    uint64_t hash;
+    size_t index;         // Position in the caller's batch
+} ShardKey;
+
+// A client's share of a batch for one shard. The client fills keys; for
+// SHARD_MGET the shard appends found values to `values`, growing it.
+typedef struct ShardBatch {
+    ShardKey *keys;
+    size_t len;
+    size_t cap;
+    char *values;
+    size_t values_len;
+    size_t values_cap;
+    size_t gathered;      // Client's read position in values
+} ShardBatch;
+
+// A request as queued; the shard runs it in place, stores *result and
+// completes it on the client
+typedef struct ShardRequest {
+    ShardOp op;
+    const char *key;
+    const char *value;
+    size_t key_len;
+    size_t value_len;
+    uint64_t hash;
+    char *buf;            // SHARD_GET: copy target
+    size_t size;
+    ShardBatch *batch;    // Batch ops
+    long *lengths;        // SHARD_MGET: per-key value lengths
+    long *result;
+    DBShardClient *client;
+} ShardRequest;
+
+// Bounded single-producer single-consumer ring. Each side owns one index
+// and keeps a cached copy of the other's, so it touches the shared line
+// only when its cached view says the ring is full (or empty).
+typedef struct SpscQueue {
+    size_t head __attribute__((aligned(CACHE_LINE)));  // Consumer
+    size_t tail_cache;
+    size_t tail __attribute__((aligned(CACHE_LINE)));  // Producer
+    size_t head_cache;
+    ShardRequest slots[SHARD_QUEUE_SLOTS] __attribute__((aligned(CACHE_LINE)));
+} SpscQueue;
+
+// One shard: a Database only its own thread touches, and one queue per
+// client slot feeding it
+typedef struct Shard {
+    Database *db;
+    ShardedDatabase *owner;
+    size_t index;
+    pthread_t thread;
+    bool started;
+    Parker parker;
+    SpscQueue *queues[SHARD_MAX_CLIENTS];
+} __attribute__((aligned(CACHE_LINE))) Shard;
+
+// A thread's handle on a sharded database. It is the only producer on its
+// queues, so a handle must not be used by two threads at once. Handles are
+// kept until the database is destroyed: a shard may still be waking one
+// just after its last request completed.
+struct DBShardClient {
+    ShardedDatabase *sdb;
+    size_t slot;
+    bool open;
+    uint32_t pending;     // Requests not yet completed
+    Parker parker;
+    ShardBatch *batches;  // One per shard
+    uint32_t *route;      // Batch ops: shard of each key
+    size_t route_cap;
+};
+
+struct ShardedDatabase {
+    Shard *shards;
+    size_t count;
+    int spin;             // Polls before parking; 0 on a single CPU
+    int stop;
+    pthread_mutex_t clients_lock;
+    size_t client_slots;  // Slots ever used; shards poll the queues below it
+    DBShardClient *clients[SHARD_MAX_CLIENTS];
+};
+
+// Shared fields are read by lock-free readers while writers update them;
+// plain fields they read with LOAD_RELAXED (the stripe counters, value
+// lengths, deadlines) are written with STORE_RELAXED
+#define LOAD_PTR(p)         __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define LOAD_RELAXED(p)     __atomic_load_n(&(p), __ATOMIC_RELAXED)
+#define STORE_RELAXED(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELAXED)
+#define PUBLISH(p, v)       __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+// ============================================================================
+// HASH FUNCTION
+// ============================================================================
+
+// Chosen at build time: -DSIMPLE_DB_HASH_DJB2 selects the original
+// byte-at-a-time DJB2; the default is a wyhash-style hash that reads 8 or
+// 16 bytes per step and mixes with a 64x64->128 bit multiply. Snapshots
+// record which one built their index.
+#if defined(SIMPLE_DB_HASH_DJB2)
+
+#define SNAPSHOT_HASH_ID SNAPSHOT_HASH_DJB2
+
+// DJB2 hash function (32-bit value; callers mask it to a table size)
+static uint64_t hash_function(const char *key, size_t len) {
+    uint32_t hash = 5381;
+    
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + (unsigned char)key[i]; // hash * 33 + c
+    }
+    
+    return hash;
+}
+
+#else
+
+#define SNAPSHOT_HASH_ID SNAPSHOT_HASH_WYHASH
+
+static const uint64_t wy_secret[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+    0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+// 128-bit product of *a and *b: low half to *a, high half to *b
+static inline void wy_mum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, la = (uint32_t)*a, hb = *b >> 32, lb = (uint32_t)*b;
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t mid = (ll >> 32) + (uint32_t)hl + (uint32_t)lh;
+    *a = (mid << 32) | (uint32_t)ll;
+    *b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t wy_read8(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t wy_read4(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// wyhash-style: short keys are read as up to four overlapping 4-byte words,
+// long ones 16 (or 48, three lanes) bytes per round
+static uint64_t hash_function(const char *key, size_t len) {
+    const unsigned char *p = (const unsigned char*)key;
+    uint64_t seed = wy_mix(wy_secret[0], wy_secret[1]);
+    uint64_t a, b;
+    
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (wy_read4(p) << 32) | wy_read4(p + mid);
+            b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t left = len;
+        if (left > 48) {
+            uint64_t lane1 = seed, lane2 = seed;
+            do {
+                seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+                lane1 = wy_mix(wy_read8(p + 16) ^ wy_secret[2], wy_read8(p + 24) ^ lane1);
+                lane2 = wy_mix(wy_read8(p + 32) ^ wy_secret[3], wy_read8(p + 40) ^ lane2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (left > 16) {
+            seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+        // Last 16 bytes of the key, overlapping what was already mixed
+        a = wy_read8(p + left - 16);
+        b = wy_read8(p + left - 8);
+    }
+    
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+}
+
+#endif
+
+// The stripe comes from a multiplicative mix of the whole hash (DJB2's low
+// bits are weak); the stripe's own table then indexes by the raw hash
+static inline Stripe* stripe_for(Database *db, uint64_t hash) {
+    return &db->stripes[(hash * 0x9E3779B97F4A7C15ull) >> (64 - STRIPE_BITS)];
+}
+
+static inline size_t local_hash(uint64_t hash) {
+    return (size_t)hash;
+}
+
+// ============================================================================
+// SLAB ALLOCATOR
+// ============================================================================
+
+// 16-byte steps up to 128, then four classes per doubling, so a block
+// wastes at most a quarter of its size. Entries with their keys reach 304.
+static const uint16_t slab_class_size[SLAB_CLASSES] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, MAX_VALUE_LENGTH
+};
+
+// Smallest class holding `size` bytes, or -1 if it's too large
+static inline int slab_class(size_t size) {
+    for (int i = 0; i < SLAB_CLASSES; i++) {
+        if (size <= slab_class_size[i]) return i;
+    }
+    return -1;
+}
+
+static Arena* arena_create(void) {
+    Arena *arena = (Arena*)calloc(1, sizeof(Arena));
+    if (arena) arena->next_chunk = SLAB_MIN_CHUNK;
+    return arena;
+}
+
+// Free every chunk at once; blocks need no individual bookkeeping
+static void arena_destroy(void *ptr) {
+    Arena *arena = (Arena*)ptr;
+    if (!arena) return;
+    
+    SlabChunk *chunk = arena->chunks;
+    while (chunk) {
+        SlabChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    LargeBlock *large = arena->large;
+    while (large) {
+        LargeBlock *next = large->next;
+        free(large);
+        large = next;
+    }
+    free(arena);
+}
+
+// Blocks beyond the largest class come straight from malloc, exactly sized
+static void* large_alloc(Arena *arena, size_t size, uint32_t *cap) {
+    if (size > (size_t)MAX_VALUE_LIMIT + 1) return NULL;
+    
+    LargeBlock *large = (LargeBlock*)malloc(sizeof(LargeBlock) + size);
+    if (!large) return NULL;
+    
+    large->prev = NULL;
+    large->next = arena->large;
+    large->size = size;
+    if (arena->large) arena->large->prev = large;
+    arena->large = large;
+    arena->in_use += size;
+    if (cap) *cap = (uint32_t)size;
+    return large + 1;
+}
+
+static void large_free(Arena *arena, void *ptr) {
+    LargeBlock *large = (LargeBlock*)ptr - 1;
+    if (large->prev) {
+        large->prev->next = large->next;
+    } else {
+        arena->large = large->next;
+    }
+    if (large->next) large->next->prev = large->prev;
+    arena->in_use -= large->size;
+    free(large);
+}
+
+// Allocate a block of at least `size` bytes; *cap receives the block size
+static void* arena_alloc(Arena *arena, size_t size, uint32_t *cap) {
+    int cls = slab_class(size);
+    if (cls < 0) return large_alloc(arena, size, cap);
+    
+    size_t block = slab_class_size[cls];
+    if (cap) *cap = (uint32_t)block;
+    
+    void *ptr = arena->free_list[cls];
+    if (ptr) {
+        arena->free_list[cls] = *(void**)ptr;
+        arena->in_use += block;
+        return ptr;
+    }
+    
+    if (arena->bump_left < block) {
+        // The rest of the current chunk is abandoned; chunks grow so that
+        // waste stays small relative to what's in use
+        size_t chunk_size = arena->next_chunk;
+        while (chunk_size - sizeof(SlabChunk) < block) chunk_size *= 2;
+        SlabChunk *chunk = (SlabChunk*)malloc(chunk_size);
+        if (!chunk) return NULL;
+        
+        chunk->next = arena->chunks;
+        chunk->size = chunk_size;
+        arena->chunks = chunk;
+        arena->bump = (char*)(chunk + 1);
+        arena->bump_left = chunk_size - sizeof(SlabChunk);
+        if (arena->next_chunk < SLAB_MAX_CHUNK) arena->next_chunk *= 2;
+    }
+    
+    ptr = arena->bump;
+    arena->bump += block;
+    arena->bump_left -= block;
+    arena->in_use += block;
+    return ptr;
+}
+
+// Bytes a block requested as `size` bytes really occupies
+static inline size_t block_bytes(size_t size) {
+    int cls = slab_class(size);
+    return cls < 0 ? size : slab_class_size[cls];
+}
+
+// Return a block of `size` bytes (any size in the same class) to its free list
+static void arena_free(Arena *arena, void *ptr, size_t size) {
+    int cls = slab_class(size);
+    if (cls < 0) {
+        large_free(arena, ptr);
+        return;
+    }
+    *(void**)ptr = arena->free_list[cls];
+    arena->free_list[cls] = ptr;
+    arena->in_use -= slab_class_size[cls];
+}
+
+// True if a block of `cap` bytes should be reused for `size` bytes in place.
+// A much smaller value moves to a smaller block so in-place updates can't
+// pin large blocks under tiny values.
+static inline bool block_reusable(uint32_t cap, size_t size) {
+    return size <= cap && (size > cap / 2 || cap == slab_class_size[0]);
+}
+
+// Copy len bytes (any bytes) into a fresh block and NUL-terminate them. The
+// block's last byte is always NUL too, so a reader racing an in-place
+// overwrite of a C-string value never runs off the end.
+static char* arena_strdup(Arena *arena, const char *str, size_t len, uint32_t *cap) {
+    char *copy = (char*)arena_alloc(arena, len + 1, cap);
+    if (!copy) return NULL;
+    
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    copy[*cap - 1] = '\0';
+    return copy;
+}
+
+// ============================================================================
+// EPOCH-BASED RECLAMATION
+// ============================================================================
+//
+// Readers never lock, so a writer can't free an entry, value or table the
+// moment it unlinks it. Each thread announces the global epoch it read when
+// it enters the database; retired objects are stamped with the epoch at the
+// time they were unlinked and freed only once every announced epoch is newer.
+// The registry is process-wide so one record serves every Database.
+
+typedef struct EpochRecord {
+    uint64_t epoch;               // 0 when the thread is outside the DB
+    int in_use;
+    unsigned nesting;
+    unsigned slot;                // Index of this record, for per-thread stats
+    struct EpochRecord *next;
+} __attribute__((aligned(CACHE_LINE))) EpochRecord;
+
+static EpochRecord *epoch_records;        // Lock-free push-only list
+static unsigned epoch_record_count;
+static uint64_t global_epoch = 1;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+// Per-thread state: epoch record and the buffer db_get copies values into
+static __thread EpochRecord *thread_record;
+static __thread char *thread_value_buf;
+static __thread size_t thread_value_cap;
+static __thread unsigned thread_probes;   // Probe length of the last find
+
+// Thread exit: hand the record back for reuse and drop the value buffer
+static void thread_state_release(void *arg) {
+    EpochRecord *record = (EpochRecord*)arg;
+    __atomic_store_n(&record->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->in_use, 0, __ATOMIC_RELEASE);
+    free(thread_value_buf);
+    thread_value_buf = NULL;
+    thread_value_cap = 0;
+}
+
+static void thread_key_create(void) {
+    pthread_key_create(&thread_key, thread_state_release);
+}
+
+static EpochRecord* epoch_record(void) {
+    if (thread_record) return thread_record;
+    
+    pthread_once(&thread_key_once, thread_key_create);
+    
+    // Reuse a record left behind by an exited thread
+    EpochRecord *record;
+    for (record = LOAD_PTR(epoch_records); record; record = record->next) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&record->in_use, &expected, 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    
+    if (!record) {
+        // Without a record the thread can't read safely; give up loudly
+        if (posix_memalign((void**)&record, CACHE_LINE, sizeof(EpochRecord)) != 0) {
+            fprintf(stderr, "simple_db: out of memory for thread state\n");
+            abort();
+        }
+        memset(record, 0, sizeof(*record));
+        record->in_use = 1;
+        record->slot = __atomic_fetch_add(&epoch_record_count, 1, __ATOMIC_RELAXED);
+        record->next = LOAD_PTR(epoch_records);
+        while (!__atomic_compare_exchange_n(&epoch_records, &record->next, record,
+                                            true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    
+    record->nesting = 0;
+    thread_record = record;
+    pthread_setspecific(thread_key, record);
+    return record;
+}
+
+static inline void epoch_enter(void) {
+    EpochRecord *record = epoch_record();
+    if (record->nesting++ == 0) {
+        uint64_t epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&record->epoch, epoch, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+static inline void epoch_exit(void) {
+    EpochRecord *record = thread_record;
+    if (--record->nesting == 0) {
+        __atomic_store_n(&record->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// Oldest epoch any thread is currently reading under
+static uint64_t epoch_min_active(void) {
+    uint64_t min = UINT64_MAX;
+    for (EpochRecord *record = LOAD_PTR(epoch_records); record; record = record->next) {
+        uint64_t epoch = __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < min) min = epoch;
+    }
+    return min;
+}
+
+// Free whatever in the stripe's retire list no reader can still reach.
+// Called with the stripe lock held.
+static void stripe_reclaim(Stripe *stripe) {
+    uint64_t safe = epoch_min_active();
+    size_t kept = 0;
+    
+    for (size_t i = 0; i < stripe->retired_len; i++) {
+        RetireItem *item = &stripe->retired[i];
+        if (item->epoch < safe) {
+            if (item->block_size) {
+                arena_free(stripe->arena, item->ptr, item->block_size);
+                stripe->retired_bytes -= block_bytes(item->block_size);
+            } else {
+                item->release(item->ptr);
+            }
+        } else {
+            stripe->retired[kept++] = *item;
+        }
+    }
+    stripe->retired_len = kept;
+}
+
+// Defer freeing `item.ptr` until current readers are done. Called with the
+// stripe lock held, after ptr has been unlinked from everything readers
+// can reach. If the retire list can't grow we wait for readers instead.
+static void retire_push(Stripe *stripe, RetireItem item) {
+    item.epoch = __atomic_fetch_add(&global_epoch, 1, __ATOMIC_SEQ_CST);
+    
+    if (stripe->retired_len == stripe->retired_cap) {
+        size_t cap = stripe->retired_cap ? stripe->retired_cap * 2 : RETIRE_BATCH;
+        RetireItem *grown = (RetireItem*)realloc(stripe->retired, cap * sizeof(RetireItem));
+        if (!grown) {
+            while (epoch_min_active() <= item.epoch) sched_yield();
+            if (item.block_size) {
+                arena_free(stripe->arena, item.ptr, item.block_size);
+            } else {
+                item.release(item.ptr);
+            }
+            return;
+        }
+        stripe->retired = grown;
+        stripe->retired_cap = cap;
+    }
+    
+    stripe->retired[stripe->retired_len++] = item;
+    if (item.block_size) stripe->retired_bytes += block_bytes(item.block_size);
+    if (stripe->retired_len >= RETIRE_BATCH && stripe->retired_len % RETIRE_BATCH == 0) {
+        stripe_reclaim(stripe);
+    }
+}
+
+static void stripe_retire(Stripe *stripe, void *ptr, void (*release)(void*)) {
+    if (ptr) retire_push(stripe, (RetireItem){ ptr, release, 0, 0 });
+}
+
+// Retire a slab block of `size` bytes from the stripe's arena
+static void stripe_retire_block(Stripe *stripe, void *ptr, size_t size) {
+    if (ptr) retire_push(stripe, (RetireItem){ ptr, NULL, 0, (uint32_t)size });
+}
+
+// Drop retired slab blocks without freeing them; used when the arena they
+// came from is itself retired or destroyed
+static void stripe_forget_blocks(Stripe *stripe) {
+    size_t kept = 0;
+    for (size_t i = 0; i < stripe->retired_len; i++) {
+        if (!stripe->retired[i].block_size) {
+            stripe->retired[kept++] = stripe->retired[i];
+        }
+    }
+    stripe->retired_len = kept;
+    stripe->retired_bytes = 0;
+}
+
+// Free the retire list unconditionally (db_destroy: no readers remain)
+static void stripe_drain_retired(Stripe *stripe) {
+    stripe_forget_blocks(stripe);
+    for (size_t i = 0; i < stripe->retired_len; i++) {
+        stripe->retired[i].release(stripe->retired[i].ptr);
+    }
+    free(stripe->retired);
+    stripe->retired = NULL;
+    stripe->retired_len = 0;
+    stripe->retired_cap = 0;
+}
+
+// Writer side of the stripe sequence lock
+static inline void stripe_write_begin(Stripe *stripe) {
+    pthread_mutex_lock(&stripe->lock);
+    __atomic_store_n(&stripe->seq, stripe->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void stripe_write_end(Stripe *stripe) {
+    __atomic_store_n(&stripe->seq, stripe->seq + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+// Reader side: wait out an in-progress write, then remember the sequence
+static inline uint32_t stripe_read_begin(Stripe *stripe) {
+    unsigned spins = 0;
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&stripe->seq, __ATOMIC_ACQUIRE)) & 1) {
+        if (++spins % 1024 == 0) sched_yield();
+    }
+    return seq;
+}
+
+// True if a writer touched the stripe since stripe_read_begin
+static inline bool stripe_read_retry(Stripe *stripe, uint32_t seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&stripe->seq, __ATOMIC_RELAXED) != seq;
+}
+
+// Copy a value into the calling thread's buffer (grown on demand)
+static const char* thread_copy(const char *value, size_t len) {
+    if (len + 1 > thread_value_cap) {
+        size_t cap = thread_value_cap ? thread_value_cap : 64;
+        while (cap < len + 1) cap *= 2;
+        char *grown = (char*)realloc(thread_value_buf, cap);
+        if (!grown) return NULL;
+        thread_value_buf = grown;
+        thread_value_cap = cap;
+    }
+    memcpy(thread_value_buf, value, len);
+    thread_value_buf[len] = '\0';
+    return thread_value_buf;
+}
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+// Create a new entry (entry and key share one block, the value has its own).
+// A NULL value creates a tombstone.
+static Entry* create_entry(Arena *arena, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t hash,
+                           uint64_t expires) {
+    Entry *entry = (Entry*)arena_alloc(arena, sizeof(Entry) + key_len + 1, NULL);
+    if (!entry) return NULL;
+    
+    entry->value = NULL;
+    entry->value_cap = 0;
+    entry->value_len = 0;
+    if (value) {
+        entry->value = arena_strdup(arena, value, value_len, &entry->value_cap);
+        if (!entry->value) {
+            arena_free(arena, entry, sizeof(Entry) + key_len + 1);
+            return NULL;
+        }
+        entry->value_len = (uint32_t)value_len;
+    }
+    
+    memcpy(entry->key, key, key_len);
+    entry->key[key_len] = '\0';
+    entry->key_len = (uint32_t)key_len;
+    entry->hash = hash;
+    entry->next = NULL;
+    entry->expires = expires;
+    entry->referenced = 0;  // Earned by a read
+    return entry;
+}
+
+// Retire an unlinked entry and its value
+static void retire_entry(Stripe *stripe, Entry *entry) {
+    stripe_retire_block(stripe, entry->value, entry->value_cap);
+    stripe_retire_block(stripe, entry, sizeof(Entry) + entry->key_len + 1);
+}
+
+// Smallest power of two >= n (and >= 1), or 0 if it doesn't fit a size_t
+static size_t round_up_pow2(size_t n) {
+    if (n > SIZE_MAX / 2 + 1) return 0;
+    
+    size_t size = 1;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// v with its bit order reversed (bit 0 becomes bit 63)
+static inline uint64_t reverse_bits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return __builtin_bswap64(v);
+}
+
+// Wall-clock time in ms. Deadlines are absolute wall-clock times so they
+// keep their meaning in the log and in snapshots across restarts; the
+// coarse clock is a few ms behind at most and costs no syscall.
+static uint64_t now_ms(void) {
+    struct timespec ts;
+#if defined(CLOCK_REALTIME_COARSE)
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// True if a key with this deadline (0 = none) has expired by `now`
+static inline bool deadline_passed(uint64_t expires, uint64_t now) {
+    return expires != 0 && expires <= now;
+}
+
+// ============================================================================
+// CHAINED ENGINE
+// ============================================================================
+
+static BucketArray* bucket_array_create(size_t size) {
+    BucketArray *array = (BucketArray*)calloc(1, sizeof(BucketArray) + size * sizeof(Entry*));
+    if (array) array->size = size;
+    return array;
+}
+
+static bool chain_init(ChainTable *ct, size_t size) {
+    ct->table = bucket_array_create(size);
+    ct->old_table = NULL;
+    ct->rehash_index = 0;
+    return ct->table != NULL;
+}
+
+// Move up to `steps` non-empty buckets from old_table into table.
+// Empty buckets are skipped cheaply but still bounded, so one call never
+// scans an unbounded stretch of a sparse old table.
+static void rehash_step(Stripe *stripe, size_t steps) {
+    ChainTable *ct = &stripe->chain;
+    BucketArray *old = ct->old_table;
+    if (!old) return;
+    
+    size_t empty_visits = steps * 10;
+    size_t mask = ct->table->size - 1;
+    
+    while (steps > 0 && ct->rehash_index < old->size) {
+        Entry *entry = old->buckets[ct->rehash_index];
+        if (!entry) {
+            ct->rehash_index++;
+            if (--empty_visits == 0) break;
+            continue;
+        }
+        
+        while (entry) {
+            Entry *next = entry->next;
+            size_t index = local_hash(entry->hash) & mask;
+            PUBLISH(entry->next, ct->table->buckets[index]);
+            PUBLISH(ct->table->buckets[index], entry);
+            entry = next;
+        }
+        PUBLISH(old->buckets[ct->rehash_index], NULL);
+        ct->rehash_index++;
+        steps--;
+    }
+    
+    if (ct->rehash_index >= old->size) {
+        PUBLISH(ct->old_table, NULL);
+        ct->rehash_index = 0;
+        stripe_retire(stripe, old, free);  // Empty by now; just the array
+    }
+}
+
+// Start growing the table once the load factor is exceeded. The new bucket
+// array becomes the insert target straight away; existing chains follow it
+// incrementally through rehash_step. Allocation failure just means we keep
+// running on the current table with longer chains.
+static void maybe_grow(Stripe *stripe) {
+    ChainTable *ct = &stripe->chain;
+    if (ct->old_table) return;  // Finish the current resize first
+    if (stripe->count + stripe->shadowed < ct->table->size * MAX_LOAD_FACTOR) return;
+    
+    BucketArray *new_table = bucket_array_create(ct->table->size * 2);
+    if (!new_table) return;
+    
+    ct->rehash_index = 0;
+    PUBLISH(ct->old_table, ct->table);
+    PUBLISH(ct->table, new_table);
+}
+
+// Find the chain slot that points at `key`, searching the bucket that is
+// still being drained as well as the active one. Returns the address of the
+// link (bucket head or previous entry's next) so callers can unlink in place.
+// Writer-only: the stripe lock must be held.
+static Entry** find_slot(ChainTable *ct, const char *key, size_t key_len, uint64_t hash) {
+    BucketArray *arrays[2] = { ct->old_table, ct->table };
+    unsigned probes = 0;
+    
+    for (int i = 0; i < 2; i++) {
+        if (!arrays[i]) continue;
+        
+        Entry **slot = &arrays[i]->buckets[local_hash(hash) & (arrays[i]->size - 1)];
+        while (*slot) {
+            probes++;
+            if ((*slot)->hash == hash && (*slot)->key_len == key_len &&
+                memcmp((*slot)->key, key, key_len) == 0) {
+                thread_probes = probes;
+                return slot;
+            }
+            slot = &(*slot)->next;
+        }
+    }
+    
+    thread_probes = probes;
+    return NULL;
+}
+
+// Lock-free lookup for readers. Chains can be relinked by a concurrent
+// resize, so a long walk re-checks the sequence and gives up early if it
+// moved; the caller then retries.
+static Entry* chain_read(Stripe *stripe, uint32_t seq, const char *key, size_t key_len,
+                         uint64_t hash) {
+    BucketArray *arrays[2] = { LOAD_PTR(stripe->chain.old_table), LOAD_PTR(stripe->chain.table) };
+    unsigned hops = 0;
+    
+    for (int i = 0; i < 2; i++) {
+        if (!arrays[i]) continue;
+        
+        Entry *entry = LOAD_PTR(arrays[i]->buckets[local_hash(hash) & (arrays[i]->size - 1)]);
+        while (entry) {
+            if (entry->hash == hash && entry->key_len == key_len &&
+                memcmp(entry->key, key, key_len) == 0) {
+                thread_probes = hops + 1;
+                return entry;
+            }
+            if (++hops % 32 == 0 && stripe_read_retry(stripe, seq)) return NULL;
+            entry = LOAD_PTR(entry->next);
+        }
+    }
+    
+    thread_probes = hops;
+    return NULL;
+}
+
+// Insert a key known to be absent at the head of its active bucket
+static bool chain_insert(ChainTable *ct, Arena *arena, const char *key, size_t key_len,
+                         const char *value, size_t value_len, uint64_t hash,
+                         uint64_t expires) {
+    Entry *new_entry = create_entry(arena, key, key_len, value, value_len, hash, expires);
+    if (!new_entry) return false;
+    
+    size_t index = local_hash(hash) & (ct->table->size - 1);
+    new_entry->next = ct->table->buckets[index];
+    PUBLISH(ct->table->buckets[index], new_entry);
+    return true;
+}
+
+// Collect chain statistics for one bucket array
+static void stats_buckets(const BucketArray *array, DBStats *stats) {
+    for (size_t i = 0; i < array->size; i++) {
+        Entry *entry = array->buckets[i];
+        if (entry) {
+            stats->used_buckets++;
+            
+            size_t chain_length = 0;
+            while (entry) {
+                chain_length++;
+                if (entry->next) {
+                    stats->total_collisions++;
+                }
+                entry = entry->next;
+            }
+            
+            if (chain_length > stats->max_chain_length) {
+                stats->max_chain_length = chain_length;
+            }
+        }
+    }
+}
+
+// Print one bucket array (helper for db_print)
+static void print_buckets(const BucketArray *array, size_t stripe, const char *label) {
+    for (size_t i = 0; i < array->size; i++) {
+        Entry *entry = array->buckets[i];
+        if (entry) {
+            printf("%s %zu.%zu:\n", label, stripe, i);
+            while (entry) {
+                if (entry->value) {
+                    printf("  \"%s\" => \"%.*s\"\n", entry->key,
+                           (int)entry->value_len, entry->value);
+                } else {
+                    printf("  \"%s\" (deleted from snapshot)\n", entry->key);
+                }
+                entry = entry->next;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// SWISS ENGINE
+// ============================================================================
+
+#define CTRL_EMPTY   ((int8_t)-128)  // 0x80: never used
+#define CTRL_DELETED ((int8_t)-2)    // 0xFE: tombstone, probing continues
+
+// Hash bits 25..31 select the control tag (the top of a 32-bit DJB2 value;
+// any 7 bits of the 64-bit hash would do), the low bits pick the home group
+static inline int8_t swiss_h2(uint64_t hash) {
+    return (int8_t)((hash >> 25) & 0x7f);
+}
+
+static inline size_t swiss_h1(uint64_t hash) {
+    return local_hash(hash);
+}
+
+// Bitmask with one bit per matching control byte (bit i = slot i of group).
+// SSE2 and NEON compare all 16 bytes at once; other targets use a loop.
+static inline uint32_t group_match(const int8_t *ctrl, int8_t tag) {
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint8_t bit_weights[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+    uint8x16_t eq = vceqq_s8(vld1q_s8(ctrl), vdupq_n_s8(tag));
+    uint8x16_t bits = vandq_u8(eq, vld1q_u8(bit_weights));
+    return (uint32_t)vaddv_u8(vget_low_u8(bits)) |
+           ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+        if (ctrl[i] == tag) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// Slots that are EMPTY or DELETED (both have the high bit set)
+static inline uint32_t group_match_free(const int8_t *ctrl) {
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+        if (ctrl[i] < 0) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+static inline int lowest_bit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
+static inline const char* slot_key(const SwissSlot *slot) {
+    return (slot->flags & SLOT_INLINE_KEY) ? slot->data.bytes : slot->data.heap.key;
+}
+
+static inline const char* slot_value(const SwissSlot *slot) {
+    if (slot->flags & SLOT_INLINE_VALUE) {
+        return slot->data.bytes + slot->key_len + 1;
+    }
+    return slot->data.heap.value;
+}
+
+// Block size of a heap value (writer-only). Slots keep just the slab class;
+// a large block records its own size.
+static inline uint32_t slot_value_cap(const SwissSlot *slot) {
+    if (slot->value_class >= 0) return slab_class_size[slot->value_class];
+    return (uint32_t)((const LargeBlock*)slot->data.heap.value - 1)->size;
+}
+
+// Release whatever slab blocks a slot owns. Readers may still be looking
+// at them, so they go through the stripe's retire list.
+static void slot_release(Stripe *stripe, SwissSlot *slot) {
+    if (!(slot->flags & SLOT_INLINE_KEY)) {
+        stripe_retire_block(stripe, slot->data.heap.key, slot->key_len + 1);
+    }
+    if (!(slot->flags & SLOT_INLINE_VALUE)) {
+        stripe_retire_block(stripe, slot->data.heap.value, slot_value_cap(slot));
+    }
+}
+
+// Store a value into a slot whose key is already in place. Values go inline
+// when they fit after the key; otherwise into a slab block, which needs the
+// key to be short enough to leave room for the value pointer. A block that
+// is already big enough is overwritten in place.
+static bool slot_store_value(Stripe *stripe, SwissSlot *slot, const char *value,
+                             size_t value_len) {
+    size_t key_len = slot->key_len;
+    bool inline_key = slot->flags & SLOT_INLINE_KEY;
+    bool heap_value = !(slot->flags & SLOT_INLINE_VALUE);
+    
+    if (inline_key && key_len + value_len + 2 <= SWISS_INLINE_BYTES) {
+        char *old = heap_value ? slot->data.heap.value : NULL;
+        uint32_t old_cap = heap_value ? slot_value_cap(slot) : 0;
+        memcpy(slot->data.bytes + key_len + 1, value, value_len);
+        slot->data.bytes[key_len + 1 + value_len] = '\0';
+        STORE_RELAXED(slot->flags, slot->flags | SLOT_INLINE_VALUE);
+        stripe_retire_block(stripe, old, old_cap);
+    } else if (heap_value && block_reusable(slot_value_cap(slot), value_len + 1)) {
+        memcpy(slot->data.heap.value, value, value_len);
+        slot->data.heap.value[value_len] = '\0';
+    } else {
+        uint32_t cap;
+        char *copy = arena_strdup(stripe->arena, value, value_len, &cap);
+        if (!copy) return false;
+        
+        // A long inline key overlaps the value pointer; move it out first
+        if (inline_key && key_len + 1 > SWISS_INLINE_BYTES - sizeof(char*)) {
+            uint32_t key_cap;
+            char *heap_key = arena_strdup(stripe->arena, slot->data.bytes, key_len, &key_cap);
+            if (!heap_key) {
+                arena_free(stripe->arena, copy, cap);
+                return false;
+            }
+            STORE_RELAXED(slot->data.heap.key, heap_key);
+            STORE_RELAXED(slot->flags, slot->flags & ~SLOT_INLINE_KEY);
+        } else if (heap_value) {
+            stripe_retire_block(stripe, slot->data.heap.value, slot_value_cap(slot));
+        }
+        STORE_RELAXED(slot->data.heap.value, copy);
+        slot->value_class = (int8_t)slab_class(cap);
+        STORE_RELAXED(slot->flags, slot->flags & ~SLOT_INLINE_VALUE);
+    }
+    
+    STORE_RELAXED(slot->value_len, (uint32_t)value_len);
+    return true;
+}
+
+// Fill a fresh slot with key and value
+static bool slot_fill(Stripe *stripe, SwissSlot *slot, const char *key, size_t key_len,
+                      const char *value, size_t value_len, uint64_t hash,
+                      uint64_t expires) {
+    slot->hash = hash;
+    slot->expires = expires;
+    slot->key_len = (uint16_t)key_len;
+    slot->value_class = 0;
+    slot->referenced = 0;
+    
+    // The heap value pointer lives in the last 8 inline bytes, so an inline
+    // key must end before it unless the value also ends up inline.
+    bool fits_with_value = key_len + value_len + 2 <= SWISS_INLINE_BYTES;
+    if (fits_with_value ||
+        key_len + 1 <= SWISS_INLINE_BYTES - sizeof(char*)) {
+        memcpy(slot->data.bytes, key, key_len);
+        slot->data.bytes[key_len] = '\0';
+        slot->flags = SLOT_INLINE_KEY | SLOT_INLINE_VALUE;
+    } else {
+        uint32_t key_cap;
+        slot->data.heap.key = arena_strdup(stripe->arena, key, key_len, &key_cap);
+        if (!slot->data.heap.key) return false;
+        slot->flags = SLOT_INLINE_VALUE;
+    }
+    
+    if (!slot_store_value(stripe, slot, value, value_len)) {
+        if (!(slot->flags & SLOT_INLINE_KEY)) {
+            arena_free(stripe->arena, slot->data.heap.key, key_len + 1);
+        }
+        return false;
+    }
+    return true;
+}
+
+static size_t swiss_max_load(size_t capacity) {
+    return capacity / SWISS_MAX_LOAD_DEN * SWISS_MAX_LOAD_NUM;
+}
+
+static SwissTable* swiss_create(size_t capacity) {
+    if (capacity < SWISS_GROUP_WIDTH) capacity = SWISS_GROUP_WIDTH;
+    
+    // Slots start after the control bytes, rounded up to their alignment
+    size_t slots_offset = (sizeof(SwissTable) + capacity + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    SwissTable *st = (SwissTable*)malloc(slots_offset + capacity * sizeof(SwissSlot));
+    if (!st) return NULL;
+    
+    memset(st->ctrl, CTRL_EMPTY, capacity);
+    st->capacity = capacity;
+    st->growth_left = swiss_max_load(capacity);
+    st->slots = (SwissSlot*)((char*)st + slots_offset);
+    return st;
+}
+
+// Probe sequence over groups: triangular steps visit every group exactly
+// once when the group count is a power of two. Writer-only.
+static SwissSlot* swiss_find(SwissTable *st, const char *key, size_t key_len, uint64_t hash) {
+    size_t group_mask = st->capacity / SWISS_GROUP_WIDTH - 1;
+    size_t group = swiss_h1(hash) & group_mask;
+    int8_t tag = swiss_h2(hash);
+    
+    for (size_t step = 1; step <= group_mask + 1; step++) {
+        const int8_t *ctrl = st->ctrl + group * SWISS_GROUP_WIDTH;
+        
+        uint32_t match = group_match(ctrl, tag);
+        while (match) {
+            SwissSlot *slot = &st->slots[group * SWISS_GROUP_WIDTH + lowest_bit(match)];
+            if (slot->hash == hash && slot->key_len == key_len &&
+                memcmp(slot_key(slot), key, key_len) == 0) {
+                thread_probes = (unsigned)step;
+                return slot;
+            }
+            match &= match - 1;
+        }
+        
+        // An EMPTY byte means the key was never pushed past this group
+        thread_probes = (unsigned)step;
+        if (group_match(ctrl, CTRL_EMPTY)) return NULL;
+        group = (group + step) & group_mask;
+    }
+    
+    return NULL;
+}
+
+// Lock-free lookup for readers. A slot can be rewritten while we look at
+// it, so its fields are copied out and the sequence re-checked before any
+// pointer taken from the slot is followed. Returns true with *out, *out_len
+// and *out_expires filled (value copied to the thread buffer when `copy` is
+// set); false with *out NULL if the key is absent, or *out non-NULL if the
+// reader must retry. `touch` sets the slot's CLOCK bit.
+static bool swiss_read(Stripe *stripe, uint32_t seq, const char *key, size_t key_len,
+                       uint64_t hash, bool copy, bool touch, const char **out,
+                       size_t *out_len, uint64_t *out_expires) {
+    static const char retry_marker = 0;
+    SwissTable *st = LOAD_PTR(stripe->swiss);
+    size_t group_mask = st->capacity / SWISS_GROUP_WIDTH - 1;
+    size_t group = swiss_h1(hash) & group_mask;
+    int8_t tag = swiss_h2(hash);
+    
+    *out = NULL;
+    for (size_t step = 1; step <= group_mask + 1; step++) {
+        const int8_t *ctrl = st->ctrl + group * SWISS_GROUP_WIDTH;
+        
+        uint32_t match = group_match(ctrl, tag);
+        while (match) {
+            SwissSlot *slot = &st->slots[group * SWISS_GROUP_WIDTH + lowest_bit(match)];
+            match &= match - 1;
+            
+            if (LOAD_RELAXED(slot->hash) != hash ||
+                LOAD_RELAXED(slot->key_len) != key_len) continue;
+            
+            uint8_t flags = LOAD_RELAXED(slot->flags);
+            char *heap_key = LOAD_RELAXED(slot->data.heap.key);
+            char *heap_value = LOAD_RELAXED(slot->data.heap.value);
+            size_t value_len = LOAD_RELAXED(slot->value_len);
+            uint64_t expires = LOAD_RELAXED(slot->expires);
+            if (stripe_read_retry(stripe, seq)) {
+                *out = &retry_marker;
+                return false;
+            }
+            
+            const char *found_key = (flags & SLOT_INLINE_KEY) ? slot->data.bytes : heap_key;
+            if (memcmp(found_key, key, key_len) != 0) continue;
+            
+            const char *value = (flags & SLOT_INLINE_VALUE)
+                                ? slot->data.bytes + key_len + 1 : heap_value;
+            thread_probes = (unsigned)step;
+            *out_len = value_len;
+            *out_expires = expires;
+            // Only written when clear, so hot keys don't dirty their line
+            if (touch && !LOAD_RELAXED(slot->referenced)) {
+                __atomic_store_n(&slot->referenced, 1, __ATOMIC_RELAXED);
+            }
+            if (!copy) {
+                *out = value;
+                return true;
+            }
+            
+            // Inline bytes may be overwritten mid-copy; clamp to the slot
+            // and let the final sequence check catch a torn copy. A heap
+            // block is only ever overwritten with a value that fits it.
+            if (flags & SLOT_INLINE_VALUE) {
+                size_t room = SWISS_INLINE_BYTES - key_len - 1;
+                if (value_len >= room) value_len = room - 1;
+            }
+            *out = thread_copy(value, value_len);
+            return *out != NULL;
+        }
+        
+        thread_probes = (unsigned)step;
+        if (group_match(ctrl, CTRL_EMPTY)) return false;
+        group = (group + step) & group_mask;
+    }
+    
+    return false;
+}
+
+// First free slot on the probe sequence for `hash` (table must have room)
+static size_t swiss_find_free(const SwissTable *st, uint64_t hash) {
+    size_t group_mask = st->capacity / SWISS_GROUP_WIDTH - 1;
+    size_t group = swiss_h1(hash) & group_mask;
+    
+    for (size_t step = 1; ; step++) {
+        uint32_t free_mask = group_match_free(st->ctrl + group * SWISS_GROUP_WIDTH);
+        if (free_mask) {
+            return group * SWISS_GROUP_WIDTH + lowest_bit(free_mask);
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+// Rebuild into a table of `capacity` slots. Slots are moved bitwise, so
+// inline data and slab pointers carry over without copying strings; only
+// the old arrays are retired.
+static bool swiss_rehash(Stripe *stripe, size_t capacity) {
+    SwissTable *st = stripe->swiss;
+    SwissTable *fresh = swiss_create(capacity);
+    if (!fresh) return false;
+    
+    for (size_t i = 0; i < st->capacity; i++) {
+        if (st->ctrl[i] < 0) continue;
+        
+        size_t pos = swiss_find_free(fresh, st->slots[i].hash);
+        fresh->ctrl[pos] = st->ctrl[i];
+        fresh->slots[pos] = st->slots[i];
+        fresh->growth_left--;
+    }
+    
+    PUBLISH(stripe->swiss, fresh);
+    stripe_retire(stripe, st, free);
+    return true;
+}
+
+// Insert a key known to be absent. Without `may_grow` (a memory budget
+// leaves no room for a bigger table) a full table is rebuilt at the same
+// size, which the caller makes worthwhile by keeping at most 3/4 of the
+// load in use.
+static bool swiss_insert(Stripe *stripe, const char *key, size_t key_len,
+                         const char *value, size_t value_len, uint64_t hash,
+                         uint64_t expires, bool may_grow) {
+    if (stripe->swiss->growth_left == 0) {
+        // Mostly tombstones: rebuild at the same size; otherwise double
+        size_t capacity = stripe->swiss->capacity;
+        if (stripe->count >= swiss_max_load(capacity) / 2 &&
+            (may_grow || stripe->count >= swiss_max_load(capacity))) capacity *= 2;
+        if (!swiss_rehash(stripe, capacity)) return false;
+    }
+    
+    SwissTable *st = stripe->swiss;
+    size_t pos = swiss_find_free(st, hash);
+    if (!slot_fill(stripe, &st->slots[pos], key, key_len, value, value_len, hash, expires)) {
+        return false;
+    }
+    
+    // Reusing a tombstone doesn't consume growth budget
+    if (st->ctrl[pos] == CTRL_EMPTY) st->growth_left--;
+    PUBLISH(st->ctrl[pos], swiss_h2(hash));
+    return true;
+}
+
+static void swiss_erase(Stripe *stripe, SwissSlot *slot) {
+    SwissTable *st = stripe->swiss;
+    size_t pos = (size_t)(slot - st->slots);
+    const int8_t *group_ctrl = st->ctrl + (pos & ~(size_t)(SWISS_GROUP_WIDTH - 1));
+    
+    slot_release(stripe, slot);
+    
+    // If this group still has an EMPTY byte, probes already stop here, so
+    // the slot can become EMPTY again instead of a tombstone.
+    if (group_match(group_ctrl, CTRL_EMPTY)) {
+        PUBLISH(st->ctrl[pos], CTRL_EMPTY);
+        st->growth_left++;
+    } else {
+        PUBLISH(st->ctrl[pos], CTRL_DELETED);
+    }
+}
+
+static void swiss_stats(const SwissTable *st, DBStats *stats) {
+    size_t group_mask = st->capacity / SWISS_GROUP_WIDTH - 1;
+    
+    stats->total_buckets += st->capacity;
+    for (size_t i = 0; i < st->capacity; i++) {
+        if (st->ctrl[i] < 0) continue;
+        stats->used_buckets++;
+        
+        // Replay the probe sequence to see how far this entry was pushed
+        size_t home = swiss_h1(st->slots[i].hash) & group_mask;
+        size_t target = i / SWISS_GROUP_WIDTH;
+        size_t probes = 1;
+        for (size_t group = home, step = 1; group != target; step++) {
+            group = (group + step) & group_mask;
+            probes++;
+        }
+        
+        if (probes > 1) stats->total_collisions++;
+        if (probes > stats->max_chain_length) stats->max_chain_length = probes;
+    }
+}
+
+// ============================================================================
+// SNAPSHOT IMAGE
+// ============================================================================
+
+// Look `key` up in a mapped snapshot. Returns the value (NUL-terminated,
+// inside the mapping), its length and its deadline in ms, or NULL; *index
+// receives the index slot it was found in. Expired keys are still
+// returned; callers decide. Offsets are bounds-checked here rather than at
+// open, so opening stays O(1) in the image size.
+static const char* snapshot_probe(const SnapshotImage *image, const char *key,
+                                  size_t key_len, uint64_t hash, size_t *value_len,
+                                  uint64_t *expires, size_t *index) {
+    for (size_t i = hash & image->mask, probes = 0; probes <= image->mask;
+         i = (i + 1) & image->mask, probes++) {
+        const SnapshotSlot *slot = &image->index[i];
+        if (slot->offset == 0) return NULL;
+        if (slot->hash != hash || slot->key_len != key_len) continue;
+        
+        uint64_t offset = slot->offset;
+        if (offset > image->size - SNAPSHOT_RECORD_HEADER) return NULL;
+        
+        uint32_t lengths[2];
+        memcpy(lengths, image->map + offset, sizeof(lengths));
+        const char *record_key = image->map + offset + SNAPSHOT_RECORD_HEADER;
+        if ((uint64_t)lengths[0] + lengths[1] + 2 > image->size - offset - SNAPSHOT_RECORD_HEADER) {
+            return NULL;
+        }
+        
+        if (lengths[0] == key_len && memcmp(record_key, key, key_len) == 0) {
+            if (value_len) *value_len = lengths[1];
+            if (expires) *expires = (uint64_t)slot->expires * 1000;
+            if (index) *index = i;
+            return record_key + key_len + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char* snapshot_find(const SnapshotImage *image, const char *key,
+                                 size_t key_len, uint64_t hash, size_t *value_len,
+                                 uint64_t *expires) {
+    return snapshot_probe(image, key, key_len, hash, value_len, expires, NULL);
+}
+
+static bool snapshot_has(const Database *db, const char *key, size_t key_len, uint64_t hash) {
+    return db->base && snapshot_find(db->base, key, key_len, hash, NULL, NULL);
+}
+
+static void snapshot_close(void *ptr) {
+    SnapshotImage *image = (SnapshotImage*)ptr;
+    if (!image) return;
+    
+    munmap((void*)image->map, image->size);
+    free(image);
+}
+
+// Map and validate a snapshot file
+static SnapshotImage* snapshot_map(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (map == MAP_FAILED) return NULL;
+    
+    const SnapshotHeader *header = (const SnapshotHeader*)map;
+    uint64_t slots = header->index_slots;
+    bool valid = memcmp(header->magic, SNAPSHOT_MAGIC, 8) == 0 &&
+                 header->version == SNAPSHOT_VERSION &&
+                 header->hash_id == SNAPSHOT_HASH_ID &&
+                 header->file_size == size &&
+                 slots != 0 && (slots & (slots - 1)) == 0 &&
+                 header->index_offset % 8 == 0 &&
+                 header->index_offset >= sizeof(SnapshotHeader) &&
+                 header->index_offset <= size &&
+                 slots <= (size - header->index_offset) / sizeof(SnapshotSlot) &&
+                 header->count <= (slots - 1) / 2;  // The writer's load factor
+    
+    SnapshotImage *image = valid ? (SnapshotImage*)malloc(sizeof(SnapshotImage)) : NULL;
+    if (!image) {
+        munmap(map, size);
+        return NULL;
+    }
+    
+    image->map = (const char*)map;
+    image->size = size;
+    image->index = (const SnapshotSlot*)(image->map + header->index_offset);
+    image->mask = slots - 1;
+    image->count = header->count;
+    madvise(map, size, MADV_RANDOM);
+    return image;
+}
+
+// Index slots for a snapshot of count keys, keeping the index at most half
+// full, or 0 if that many keys can't be indexed
+static size_t snapshot_slots(uint64_t count) {
+    return count < SIZE_MAX / 4 ? round_up_pow2(count * 2 + 1) : 0;
+}
+
+// Accumulates records and the index while db_save writes a snapshot
+typedef struct SnapshotWriter {
+    FILE *fp;
+    SnapshotSlot *index;
+    size_t mask;
+    uint64_t offset;
+    uint64_t count;
+    bool ok;
+} SnapshotWriter;
+
+static void snapshot_emit(SnapshotWriter *w, const char *key, size_t key_len,
+                          const char *value, size_t value_len, uint64_t hash,
+                          uint64_t expires) {
+    static const char padding[8] = {0};
+    uint32_t lengths[2] = { (uint32_t)key_len, (uint32_t)value_len };
+    size_t record = SNAPSHOT_RECORD_HEADER + key_len + value_len + 2;
+    size_t pad = (8 - record % 8) % 8;
+    
+    w->ok = w->ok &&
+            fwrite(lengths, sizeof(lengths), 1, w->fp) == 1 &&
+            fwrite(key, 1, key_len + 1, w->fp) == key_len + 1 &&
+            fwrite(value, 1, value_len + 1, w->fp) == value_len + 1 &&
+            fwrite(padding, 1, pad, w->fp) == pad;
+    
+    size_t i = hash & w->mask;
+    while (w->index[i].offset != 0) i = (i + 1) & w->mask;
+    uint32_t expires_s = (uint32_t)((expires + 999) / 1000);
+    w->index[i] = (SnapshotSlot){ hash, (uint32_t)key_len, expires_s, w->offset };
+    
+    w->offset += record + pad;
+    w->count++;
+}
+
+// ============================================================================
+// WRITE-AHEAD LOG
+// ============================================================================
+
+#if defined(__APPLE__)
+#define fdatasync fsync
+#endif
+
+// FNV-1a, continued across the parts of a record
+static uint32_t wal_checksum(uint32_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char*)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Fill in a record header; the checksum covers the rest of the header and
+// the key, deadline (if `expires` is given) and value bytes
+static void wal_record_header(char *header, uint8_t op, const char *key, size_t key_len,
+                              const uint64_t *expires, const char *value, size_t value_len) {
+    size_t prefix = expires ? sizeof(*expires) : 0;
+    uint32_t lengths[2] = { (uint32_t)key_len, (uint32_t)(prefix + value_len) };
+    memset(header, 0, WAL_RECORD_HEADER);
+    memcpy(header + 4, lengths, sizeof(lengths));
+    header[12] = (char)op;
+    
+    uint32_t h = wal_checksum(2166136261u, header + 4, WAL_RECORD_HEADER - 4);
+    h = wal_checksum(h, key, key_len);
+    h = wal_checksum(h, expires, prefix);
+    h = wal_checksum(h, value, value_len);
+    memcpy(header, &h, sizeof(h));
+}
+
+static bool wal_write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void wal_deadline(struct timespec *ts, unsigned interval_us) {
+    clock_gettime(CLOCK_REALTIME, ts);  // pthread_cond_timedwait's clock
+    ts->tv_nsec += (long)(interval_us % 1000000) * 1000;
+    ts->tv_sec += interval_us / 1000000 + ts->tv_nsec / 1000000000;
+    ts->tv_nsec %= 1000000000;
+}
+
+// Append one record and return the LSN that covers it, or 0 if the log has
+// failed. Called with the stripe lock held, so each key's records reach the
+// log in the order its changes were made. A WAL_OP_SET_EX record stores
+// `expires` ahead of the value.
+static uint64_t wal_append(WalLog *wal, uint8_t op, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t expires) {
+    char header[WAL_RECORD_HEADER];
+    const uint64_t *deadline = op == WAL_OP_SET_EX ? &expires : NULL;
+    size_t prefix = deadline ? sizeof(expires) : 0;
+    wal_record_header(header, op, key, key_len, deadline, value, value_len);
+    size_t record = WAL_RECORD_HEADER + key_len + prefix + value_len;
+    uint64_t lsn = 0;
+    
+    pthread_mutex_lock(&wal->lock);
+    
+    // Backpressure: don't let the buffer run far ahead of the disk
+    while (wal->len >= wal->config.batch_bytes * WAL_BACKLOG_BATCHES && !wal->failed) {
+        pthread_cond_signal(&wal->work);
+        pthread_cond_wait(&wal->synced_cond, &wal->lock);
+    }
+    
+    if (!wal->failed && wal->len + record > wal->cap) {
+        size_t cap = wal->cap ? wal->cap : wal->config.batch_bytes;
+        while (cap < wal->len + record) cap *= 2;
+        char *buf = (char*)realloc(wal->buf, cap);
+        if (buf) {
+            wal->buf = buf;
+            wal->cap = cap;
+        }
+    }
+    
+    if (!wal->failed && wal->len + record <= wal->cap) {
+        if (wal->len == 0) {
+            // First record of a group: the window starts now
+            wal_deadline(&wal->deadline, wal->config.flush_interval_us);
+            pthread_cond_signal(&wal->work);
+        }
+        char *p = wal->buf + wal->len;
+        memcpy(p, header, WAL_RECORD_HEADER);
+        memcpy(p + WAL_RECORD_HEADER, key, key_len);
+        memcpy(p + WAL_RECORD_HEADER + key_len, &expires, prefix);
+        memcpy(p + WAL_RECORD_HEADER + key_len + prefix, value, value_len);
+        wal->len += record;
+        wal->appended += record;
+        lsn = wal->appended;
+        if (wal->len >= wal->config.batch_bytes) pthread_cond_signal(&wal->work);
+    }
+    
+    pthread_mutex_unlock(&wal->lock);
+    return lsn;
+}
+
+// Block until everything up to `lsn` is on disk. False if the log failed.
+static bool wal_wait(WalLog *wal, uint64_t lsn) {
+    pthread_mutex_lock(&wal->lock);
+    while (wal->synced < lsn && !wal->failed) {
+        pthread_cond_wait(&wal->synced_cond, &wal->lock);
+    }
+    bool ok = wal->synced >= lsn;
+    pthread_mutex_unlock(&wal->lock);
+    return ok;
+}
+
+// Background group commit. A group is written once its window expires, it
+// reaches batch_bytes, db_wal_sync asks for it, or the log is closing;
+// writers keep filling the other buffer meanwhile.
+static void* wal_flusher(void *arg) {
+    WalLog *wal = (WalLog*)arg;
+    
+    pthread_mutex_lock(&wal->lock);
+    for (;;) {
+        while (wal->len == 0 && !wal->closing) {
+            pthread_cond_wait(&wal->work, &wal->lock);
+        }
+        while (wal->len > 0 && wal->len < wal->config.batch_bytes &&
+               !wal->closing && wal->urgent <= wal->synced &&
+               pthread_cond_timedwait(&wal->work, &wal->lock, &wal->deadline) != ETIMEDOUT) {
+            // Window still open
+        }
+        if (wal->len == 0) {
+            if (wal->closing) break;
+            continue;
+        }
+        
+        char *out = wal->buf;
+        size_t out_len = wal->len, out_cap = wal->cap;
+        wal->buf = wal->spare;
+        wal->cap = wal->spare_cap;
+        wal->spare = out;
+        wal->spare_cap = out_cap;
+        wal->len = 0;
+        uint64_t target = wal->appended;
+        wal->flushing = true;
+        pthread_mutex_unlock(&wal->lock);
+        
+        bool ok = !wal->failed &&
+                  wal_write_all(wal->fd, out, out_len) &&
+                  fdatasync(wal->fd) == 0;
+        
+        pthread_mutex_lock(&wal->lock);
+        wal->flushing = false;
+        if (!ok) {
+            wal->failed = true;
+        } else if (target > wal->synced) {
+            wal->synced = target;
+        }
+        pthread_cond_broadcast(&wal->synced_cond);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    return NULL;
+}
+
+// ============================================================================
+// ORDERED INDEX
+// ============================================================================
+
+static BTreeNode* btree_node_create(bool leaf) {
+    // Leaves have no child array
+    size_t size = sizeof(BTreeNode) + (leaf ? 0 : (BTREE_MAX_KEYS + 2) * sizeof(BTreeNode*));
+    BTreeNode *node = (BTreeNode*)calloc(1, size);
+    if (node) node->leaf = leaf;
+    return node;
+}
+
+static void btree_free(BTreeNode *node) {
+    for (int i = 0; i < node->count; i++) free(node->keys[i]);
+    if (!node->leaf) {
+        for (int i = 0; i <= node->count; i++) btree_free(node->children[i]);
+    }
+    free(node);
+}
+
+// First position whose key is >= key (or > key with `after`)
+static int btree_search(const BTreeNode *node, const char *key, bool after) {
+    int lo = 0, hi = node->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(node->keys[mid], key);
+        if (cmp < 0 || (after && cmp == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static inline void btree_shift(void *array, int from, int count, int by, size_t elem) {
+    char *base = (char*)array;
+    memmove(base + (from + by) * elem, base + from * elem, (size_t)count * elem);
+}
+
+// Leaf that holds `key` (or would), and the path of internal nodes and
+// child slots leading to it
+static BTreeNode* btree_descend(const OrderedIndex *index, const char *key,
+                                BTreeNode **path, int *slots, int *depth) {
+    BTreeNode *node = index->root;
+    *depth = 0;
+    while (!node->leaf) {
+        int i = btree_search(node, key, true);
+        path[*depth] = node;
+        slots[*depth] = i;
+        (*depth)++;
+        node = node->children[i];
+    }
+    return node;
+}
+
+// Leaf and position of the first key >= key (> key with `after`). The
+// position may be past the leaf's last key; callers follow `next`.
+static BTreeNode* btree_seek(const OrderedIndex *index, const char *key, bool after, int *pos) {
+    BTreeNode *node = index->root;
+    while (!node->leaf) node = node->children[btree_search(node, key, true)];
+    *pos = btree_search(node, key, after);
+    return node;
+}
+
+// Add a copy of key. False if it is already present or memory ran out.
+static bool btree_insert(OrderedIndex *index, const char *key) {
+    BTreeNode *path[BTREE_MAX_DEPTH];
+    int slots[BTREE_MAX_DEPTH], depth;
+    BTreeNode *node = btree_descend(index, key, path, slots, &depth);
+    
+    int pos = btree_search(node, key, false);
+    if (pos < node->count && strcmp(node->keys[pos], key) == 0) return false;
+    
+    // Allocate everything a split cascade needs up front, so running out of
+    // memory leaves the tree untouched: one node per full level, a new root
+    // if every level is full, and the leaf's separator copy
+    int splits = 0;
+    while (splits <= depth &&
+           (splits == 0 ? node : path[depth - splits])->count == BTREE_MAX_KEYS) {
+        splits++;
+    }
+    BTreeNode *spare[BTREE_MAX_DEPTH + 1];
+    char *copy = strdup(key);
+    char *separator = NULL;
+    bool ok = copy != NULL;
+    for (int i = 0; i < splits && ok; i++) {
+        spare[i] = btree_node_create(i == 0);
+        ok = spare[i] != NULL;
+        if (!ok) splits = i;
+    }
+    BTreeNode *new_root = NULL;
+    if (ok && splits > depth) ok = (new_root = btree_node_create(false)) != NULL;
+    if (ok && splits > 0) {
+        // After the insert, the leaf's right half starts at BTREE_MIN_KEYS
+        const char *first = pos < BTREE_MIN_KEYS ? node->keys[BTREE_MIN_KEYS - 1]
+                          : pos == BTREE_MIN_KEYS ? key : node->keys[BTREE_MIN_KEYS];
+        ok = (separator = strdup(first)) != NULL;
+    }
+    if (!ok) {
+        for (int i = 0; i < splits; i++) free(spare[i]);
+        free(new_root);
+        free(copy);
+        return false;
+    }
+    
+    btree_shift(node->keys, pos, node->count - pos, 1, sizeof(char*));
+    node->keys[pos] = copy;
+    node->count++;
+    
+    // Split upwards while a node overflows
+    for (int level = 0; node->count > BTREE_MAX_KEYS; level++) {
+        BTreeNode *right = spare[level];
+        char *up;
+        
+        if (node->leaf) {
+            // The right half's first key is copied up as the separator
+            right->count = node->count - BTREE_MIN_KEYS;
+            memcpy(right->keys, node->keys + BTREE_MIN_KEYS, right->count * sizeof(char*));
+            node->count = BTREE_MIN_KEYS;
+            right->next = node->next;
+            node->next = right;
+            up = separator;
+        } else {
+            // The middle key moves up
+            up = node->keys[BTREE_MIN_KEYS];
+            right->count = node->count - BTREE_MIN_KEYS - 1;
+            memcpy(right->keys, node->keys + BTREE_MIN_KEYS + 1, right->count * sizeof(char*));
+            memcpy(right->children, node->children + BTREE_MIN_KEYS + 1,
+                   (right->count + 1) * sizeof(BTreeNode*));
+            node->count = BTREE_MIN_KEYS;
+        }
+        
+        if (level == depth) {
+            new_root->keys[0] = up;
+            new_root->children[0] = node;
+            new_root->children[1] = right;
+            new_root->count = 1;
+            index->root = new_root;
+            break;
+        }
+        
+        BTreeNode *parent = path[depth - 1 - level];
+        int slot = slots[depth - 1 - level];
+        btree_shift(parent->keys, slot, parent->count - slot, 1, sizeof(char*));
+        btree_shift(parent->children, slot + 1, parent->count - slot, 1, sizeof(BTreeNode*));
+        parent->keys[slot] = up;
+        parent->children[slot + 1] = right;
+        parent->count++;
+        node = parent;
+    }
+    
+    return true;
+}
+
+// Fix up node (at path[depth]) after a removal left it below half full:
+// borrow a key from a sibling with keys to spare, else merge with one and
+// repeat for the parent, which lost a key
+static void btree_rebalance(OrderedIndex *index, BTreeNode *node, BTreeNode **path,
+                            int *slots, int depth) {
+    while (depth > 0 && node->count < BTREE_MIN_KEYS) {
+        BTreeNode *parent = path[depth - 1];
+        int i = slots[depth - 1];
+        BTreeNode *left = i > 0 ? parent->children[i - 1] : NULL;
+        BTreeNode *right = i < parent->count ? parent->children[i + 1] : NULL;
+        
+        if (left && left->count > BTREE_MIN_KEYS) {
+            if (node->leaf) {
+                // The moved key becomes the new lower bound of node
+                char *separator = strdup(left->keys[left->count - 1]);
+                if (!separator) return;  // Underfull is still a valid tree
+                btree_shift(node->keys, 0, node->count, 1, sizeof(char*));
+                node->keys[0] = left->keys[--left->count];
+                free(parent->keys[i - 1]);
+                parent->keys[i - 1] = separator;
+            } else {
+                btree_shift(node->keys, 0, node->count, 1, sizeof(char*));
+                btree_shift(node->children, 0, node->count + 1, 1, sizeof(BTreeNode*));
+                node->keys[0] = parent->keys[i - 1];
+                node->children[0] = left->children[left->count];
+                parent->keys[i - 1] = left->keys[--left->count];
+            }
+            node->count++;
+            return;
+        }
+        
+        if (right && right->count > BTREE_MIN_KEYS) {
+            if (node->leaf) {
+                char *separator = strdup(right->keys[1]);
+                if (!separator) return;
+                node->keys[node->count] = right->keys[0];
+                btree_shift(right->keys, 1, right->count - 1, -1, sizeof(char*));
+                free(parent->keys[i]);
+                parent->keys[i] = separator;
+            } else {
+                node->keys[node->count] = parent->keys[i];
+                node->children[node->count + 1] = right->children[0];
+                parent->keys[i] = right->keys[0];
+                btree_shift(right->keys, 1, right->count - 1, -1, sizeof(char*));
+                btree_shift(right->children, 1, right->count, -1, sizeof(BTreeNode*));
+            }
+            node->count++;
+            right->count--;
+            return;
+        }
+        
+        // Merge children j and j + 1; together they fit in one node
+        int j = left ? i - 1 : i;
+        BTreeNode *a = parent->children[j], *b = parent->children[j + 1];
+        if (a->leaf) {
+            free(parent->keys[j]);
+            memcpy(a->keys + a->count, b->keys, b->count * sizeof(char*));
+            a->count += b->count;
+            a->next = b->next;
+        } else {
+            a->keys[a->count] = parent->keys[j];
+            memcpy(a->keys + a->count + 1, b->keys, b->count * sizeof(char*));
+            memcpy(a->children + a->count + 1, b->children, (b->count + 1) * sizeof(BTreeNode*));
+            a->count += b->count + 1;
+        }
+        free(b);
+        btree_shift(parent->keys, j + 1, parent->count - j - 1, -1, sizeof(char*));
+        btree_shift(parent->children, j + 2, parent->count - j - 1, -1, sizeof(BTreeNode*));
+        parent->count--;
+        
+        node = parent;
+        depth--;
+    }
+    
+    // A root left with one child is replaced by it
+    BTreeNode *root = index->root;
+    if (!root->leaf && root->count == 0) {
+        index->root = root->children[0];
+        free(root);
+    }
+}
+
+// Remove key. False if it wasn't present.
+static bool btree_remove(OrderedIndex *index, const char *key) {
+    BTreeNode *path[BTREE_MAX_DEPTH];
+    int slots[BTREE_MAX_DEPTH], depth;
+    BTreeNode *node = btree_descend(index, key, path, slots, &depth);
+    
+    int pos = btree_search(node, key, false);
+    if (pos == node->count || strcmp(node->keys[pos], key) != 0) return false;
+    
+    free(node->keys[pos]);
+    btree_shift(node->keys, pos + 1, node->count - pos - 1, -1, sizeof(char*));
+    node->count--;
+    btree_rebalance(index, node, path, slots, depth);
+    return true;
+}
+
+// Drop every key, leaving an empty tree. The root node is kept (an
+// internal node is big enough to serve as the empty leaf), so this can't
+// fail.
+static void btree_clear(OrderedIndex *index) {
+    BTreeNode *root = index->root;
+    for (int i = 0; i < root->count; i++) free(root->keys[i]);
+    if (!root->leaf) {
+        for (int i = 0; i <= root->count; i++) btree_free(root->children[i]);
+    }
+    root->leaf = true;
+    root->count = 0;
+    root->next = NULL;
+}
+
+// Keep the index in step with a key becoming present or absent. Called
+// under the key's stripe lock, so the index sees each key's changes in
+// order; a missing key after running out of memory only hides it from
+// scans.
+// Writers hand in keys by length, not necessarily NUL-terminated, so the
+// tree gets a terminated copy
+static void index_add(Database *db, const char *key, size_t key_len) {
+    OrderedIndex *index = db->index;
+    if (!index) return;
+    
+    char copy[MAX_KEY_LENGTH];
+    memcpy(copy, key, key_len);
+    copy[key_len] = '\0';
+    
+    pthread_rwlock_wrlock(&index->lock);
+    if (btree_insert(index, copy)) index->version++;
+    pthread_rwlock_unlock(&index->lock);
+}
+
+static void index_remove(Database *db, const char *key, size_t key_len) {
+    OrderedIndex *index = db->index;
+    if (!index) return;
+    
+    char copy[MAX_KEY_LENGTH];
+    memcpy(copy, key, key_len);
+    copy[key_len] = '\0';
+    
+    pthread_rwlock_wrlock(&index->lock);
+    if (btree_remove(index, copy)) index->version++;
+    pthread_rwlock_unlock(&index->lock);
+}
+
+static void index_destroy(OrderedIndex *index) {
+    if (!index) return;
+    
+    btree_free(index->root);
+    pthread_rwlock_destroy(&index->lock);
+    free(index);
+}
+
+// ============================================================================
+// READ VIEW VERSIONS
+// ============================================================================
+
+// The version of `key` a view saved in one stripe, or NULL. Lock-free:
+// tables are replaced whole when they grow and a version never changes
+// once published.
+static const SavedVersion* version_find(const VersionMap *map, const char *key,
+                                        size_t key_len, uint64_t hash) {
+    const VersionTable *table = LOAD_PTR(map->table);
+    if (!table) return NULL;
+    
+    for (size_t i = local_hash(hash) & table->mask; ; i = (i + 1) & table->mask) {
+        const SavedVersion *version = LOAD_PTR(table->slots[i]);
+        if (!version) return NULL;
+        if (version->hash == hash && version->key_len == key_len &&
+            memcmp(version->data, key, key_len) == 0) return version;
+    }
+}
+
+static void version_place(VersionTable *table, SavedVersion *version) {
+    size_t i = local_hash(version->hash) & table->mask;
+    while (table->slots[i]) i = (i + 1) & table->mask;
+    PUBLISH(table->slots[i], version);
+}
+
+// Save a key's state for a view: its value and deadline, or absent if
+// value is NULL. Stripe lock held. The table is kept at most half full;
+// when it grows the bigger copy replaces it and the old one is retired.
+static bool version_add(DBSnapshot *view, Stripe *stripe, VersionMap *map,
+                        const char *key, size_t key_len, uint64_t hash,
+                        const char *value, size_t value_len, uint64_t expires,
+                        bool emitted) {
+    VersionTable *table = map->table;
+    if (!table || (map->count + 1) * 2 > table->mask + 1) {
+        size_t size = table ? (table->mask + 1) * 2 : VERSION_TABLE_MIN;
+        VersionTable *grown = (VersionTable*)calloc(1, sizeof(VersionTable) +
+                                                    size * sizeof(SavedVersion*));
+        if (!grown) return false;
+        grown->mask = size - 1;
+        for (SavedVersion *version = map->first; version; version = version->older) {
+            version_place(grown, version);
+        }
+        
+        PUBLISH(map->table, grown);
+        __atomic_fetch_add(&view->bytes, size * sizeof(SavedVersion*), __ATOMIC_RELAXED);
+        if (table) {
+            __atomic_fetch_sub(&view->bytes, (table->mask + 1) * sizeof(SavedVersion*),
+                               __ATOMIC_RELAXED);
+            stripe_retire(stripe, table, free);
+        }
+        table = grown;
+    }
+    
+    if (!value) value_len = 0;
+    size_t bytes = sizeof(SavedVersion) + key_len + value_len + 2;
+    SavedVersion *version = (SavedVersion*)malloc(bytes);
+    if (!version) return false;
+    
+    version->hash = hash;
+    version->expires = expires;
+    version->key_len = (uint32_t)key_len;
+    version->value_len = (uint32_t)value_len;
+    version->present = value != NULL;
+    version->emitted = emitted;
+    version->older = map->first;
+    memcpy(version->data, key, key_len);
+    version->data[key_len] = '\0';
+    if (value) memcpy(version->data + key_len + 1, value, value_len);
+    version->data[key_len + 1 + value_len] = '\0';
+    
+    version_place(table, version);
+    PUBLISH(map->first, version);
+    map->count++;
+    __atomic_fetch_add(&view->bytes, bytes, __ATOMIC_RELAXED);
+    return true;
+}
+
+// Free a view's versions and tables. Nothing else may be using it.
+static void view_free(DBSnapshot *snap) {
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        SavedVersion *version = snap->maps[i].first;
+        while (version) {
+            SavedVersion *older = version->older;
+            free(version);
+            version = older;
+        }
+        free(snap->maps[i].table);
+    }
+    free(snap);
+}
+
+// Whether a view's scan has already walked past a key of stripe `index`,
+// or past snapshot index slot `base_slot` for a key the mapped snapshot
+// supplies. The scan moves within a stripe only under its lock, and over
+// a snapshot slot only under the lock of the slot's key, which the caller
+// holds.
+static bool view_scan_passed(const DBSnapshot *view, size_t index, uint64_t hash,
+                             bool in_base, size_t base_slot) {
+    uint64_t own = in_base ? VIEW_PHASE_BASE : index;
+    uint64_t phase = __atomic_load_n(&view->scan_phase, __ATOMIC_ACQUIRE);
+    if (phase != own) return phase > own;
+    
+    uint64_t position = __atomic_load_n(&view->scan_position, __ATOMIC_ACQUIRE);
+    if (in_base) return base_slot < position;
+    // Buckets and groups are visited in reversed-bit order of their index
+    return reverse_bits(local_hash(hash)) < reverse_bits(position);
+}
+
+// Called by a writer about to change `key` (stripe lock held, sequence
+// odd): every open view without a version of the key gets one holding its
+// state now, i.e. as the view first saw it. A view that can't get one is
+// marked failed. Returns at once while no view is open.
+static void views_preserve(Database *db, Stripe *stripe, const char *key, size_t key_len,
+                           uint64_t hash) {
+    if (!db->views) return;
+    
+    const char *value = NULL;
+    size_t value_len = 0, base_slot = 0;
+    uint64_t expires = 0;
+    bool in_base = false;
+    unsigned probes = thread_probes;  // The writer's own lookup is what its stats count
+    
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissSlot *slot = swiss_find(stripe->swiss, key, key_len, hash);
+        if (slot) {
+            value = slot_value(slot);
+            value_len = slot->value_len;
+            expires = slot->expires;
+        }
+    } else {
+        Entry **link = find_slot(&stripe->chain, key, key_len, hash);
+        if (link) {
+            value = (*link)->value;  // NULL: tombstone
+            value_len = (*link)->value_len;
+            expires = (*link)->expires;
+        } else if (db->base) {
+            value = snapshot_probe(db->base, key, key_len, hash, &value_len, &expires,
+                                   &base_slot);
+            in_base = value != NULL;
+        }
+    }
+    thread_probes = probes;
+    
+    size_t index = (size_t)(stripe - db->stripes);
+    for (DBSnapshot *view = db->views; view; view = view->next) {
+        VersionMap *map = &view->maps[index];
+        if (LOAD_RELAXED(view->failed) || version_find(map, key, key_len, hash)) continue;
+        
+        bool present = value && !deadline_passed(expires, view->now);
+        bool emitted = present && view_scan_passed(view, index, hash, in_base, base_slot);
+        if (!version_add(view, stripe, map, key, key_len, hash, present ? value : NULL,
+                         value_len, expires, emitted)) {
+            __atomic_store_n(&view->failed, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// ============================================================================
+// STRIPE OPERATIONS
+// ============================================================================
+
+// One lock-free attempt at reading `key` from the stripe under sequence
+// `seq`: false if a writer got in the way and the caller must retry.
+// Otherwise *result is the value (copied into the calling thread's buffer
+// with `copy` set) or NULL, with its length and deadline, which is not
+// checked here. `touch` sets the key's CLOCK bit. Caller is in an epoch.
+static bool stripe_read(Database *db, Stripe *stripe, uint32_t seq, const char *key,
+                        size_t key_len, uint64_t hash, bool copy, bool touch,
+                        const char **result, size_t *value_len, uint64_t *expires) {
+    *expires = 0;
+    
+    if (db->engine == DB_ENGINE_SWISS) {
+        const char *value;
+        bool found = swiss_read(stripe, seq, key, key_len, hash, copy, touch,
+                                &value, value_len, expires);
+        *result = found ? value : NULL;
+        if (!found && value) return false;  // Slot changed under us
+    } else {
+        Entry *entry = chain_read(stripe, seq, key, key_len, hash);
+        SnapshotImage *base = LOAD_PTR(db->base);
+        const char *value = NULL;
+        *value_len = 0;
+        
+        if (entry) {
+            value = LOAD_PTR(entry->value);  // NULL: tombstone
+            *value_len = LOAD_RELAXED(entry->value_len);
+            *expires = LOAD_RELAXED(entry->expires);
+            // The length must belong to this block before copying that
+            // many bytes out of it
+            if (value && copy && stripe_read_retry(stripe, seq)) return false;
+            if (value && touch && !LOAD_RELAXED(entry->referenced)) {
+                __atomic_store_n(&entry->referenced, 1, __ATOMIC_RELAXED);
+            }
+        } else if (base) {
+            value = snapshot_find(base, key, key_len, hash, value_len, expires);
+        }
+        *result = value && copy ? thread_copy(value, *value_len) : value;
+    }
+    
+    return !stripe_read_retry(stripe, seq);
+}
+
+// Look up `key` without taking the stripe lock. With `copy` set the value is
+// copied into the calling thread's buffer (the pointer returned stays valid
+// until that thread's next db_get); otherwise only presence is reported.
+// *value_len receives the value's length either way. Keys past their
+// deadline read as missing until a sweep removes them. With a memory
+// budget set, a hit also sets the key's CLOCK bit.
+static const char* stripe_lookup(Database *db, const char *key, size_t key_len,
+                                 uint64_t hash, bool copy, size_t *value_len) {
+    Stripe *stripe = stripe_for(db, hash);
+    bool touch = LOAD_RELAXED(db->stripe_budget) != 0;
+    const char *result;
+    uint64_t expires;
+    
+    epoch_enter();
+    while (!stripe_read(db, stripe, stripe_read_begin(stripe), key, key_len, hash, copy,
+                        touch, &result, value_len, &expires)) {
+        // Retry with a fresh sequence
+    }
+    epoch_exit();
+    
+    if (result && deadline_passed(expires, now_ms())) result = NULL;
+    return result;
+}
+
+// ============================================================================
+// OPERATION STATISTICS
+// ============================================================================
+//
+// db_stats_ex counters. A thread finds its block through the slot of its
+// epoch record, so a block has one writer at a time and is reused by the
+// next thread to take the record over; threads past STATS_THREADS share
+// one block and pay for atomic adds. The find functions leave the probe
+// length of the last lookup in thread_probes.
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Log-linear latency bucket (see DBOpStats): exact below 16 ns, then the
+// power of two and the next 3 bits below it
+static inline size_t latency_bucket(uint64_t ns) {
+    if (ns < 16) return (size_t)ns;
+    unsigned octave = 63 - (unsigned)__builtin_clzll(ns);
+    size_t bucket = 16 + (size_t)(octave - 4) * 8 + (size_t)((ns >> (octave - 3)) & 7);
+    return bucket < DB_LATENCY_BUCKETS ? bucket : DB_LATENCY_BUCKETS - 1;
+}
+
+// The calling thread's block for db, created on its first operation
+static ThreadStats* thread_stats_block(Database *db, bool *shared) {
+    unsigned slot = epoch_record()->slot;
+    
+    *shared = false;
+    if (slot < STATS_THREADS) {
+        ThreadStats *stats = LOAD_PTR(db->thread_stats[slot]);
+        if (stats) return stats;
+        if (posix_memalign((void**)&stats, CACHE_LINE, sizeof(ThreadStats)) == 0) {
+            memset(stats, 0, sizeof(*stats));
+            PUBLISH(db->thread_stats[slot], stats);
+            return stats;
+        }
+    }
+    *shared = true;
+    return &db->shared_stats;
+}
+
+static inline void stats_bump(uint64_t *counter, bool shared) {
+    if (shared) {
+        __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(counter, LOAD_RELAXED(*counter) + 1, __ATOMIC_RELAXED);
+    }
+}
+
+// One operation in flight: its stats block, and its start time if it is
+// one of the 1 in DB_LATENCY_SAMPLE that get timed
+typedef struct OpSample {
+    ThreadStats *stats;
+    bool shared;
+    uint64_t start;
+} OpSample;
+
+static inline void op_begin(Database *db, OpSample *sample) {
+    sample->stats = thread_stats_block(db, &sample->shared);
+    uint64_t tick = sample->shared ? __atomic_fetch_add(&sample->stats->ticks, 1, __ATOMIC_RELAXED)
+                                   : sample->stats->ticks++;
+    sample->start = tick % DB_LATENCY_SAMPLE == 0 ? now_ns() : 0;
+    thread_probes = 0;
+}
+
+static inline void op_end(OpSample *sample, int kind, bool found) {
+    DBOpStats *op = &sample->stats->ops[kind];
+    
+    if (sample->start) {
+        stats_bump(&op->latency[latency_bucket(now_ns() - sample->start)], sample->shared);
+        stats_bump(&op->sampled, sample->shared);
+    }
+    unsigned probes = thread_probes;
+    stats_bump(&op->probes[probes < DB_PROBE_BUCKETS ? probes : DB_PROBE_BUCKETS - 1],
+               sample->shared);
+    stats_bump(&op->count, sample->shared);
+    if (found) stats_bump(&op->found, sample->shared);
+}
+
+// stripe_lookup for the db_get family, counted as a hit or a miss. The
+// stripe counters are bumped with a plain load and store rather than an
+// atomic add, which costs about as much as the rest of a cached lookup;
+// two threads hitting one stripe at the same instant can lose a count.
+// The per-thread counters behind db_stats_ex are exact.
+static const char* counted_lookup(Database *db, const char *key, size_t key_len,
+                                  uint64_t hash, size_t *value_len) {
+    OpSample sample;
+    op_begin(db, &sample);
+    const char *value = stripe_lookup(db, key, key_len, hash, true, value_len);
+    op_end(&sample, DB_OP_GET, value != NULL);
+    
+    StripeCounters *counters = &db->counters[stripe_for(db, hash) - db->stripes];
+    uint64_t *counter = value ? &counters->hits : &counters->misses;
+    __atomic_store_n(counter, LOAD_RELAXED(*counter) + 1, __ATOMIC_RELAXED);
+    return value;
+}
+
+// Log a change just made under the stripe lock. *lsn keeps the highest LSN
+// seen, so a batch can wait for all of its records at once. A set with a
+// deadline is logged as WAL_OP_SET_EX.
+static inline void stripe_log(Database *db, uint8_t op, const char *key, size_t key_len,
+                              const char *value, size_t value_len, uint64_t expires,
+                              uint64_t *lsn) {
+    if (!db->wal) return;
+    
+    if (!value) value = "";
+    if (op == WAL_OP_SET && expires) op = WAL_OP_SET_EX;
+    uint64_t end = wal_append(db->wal, op, key, key_len, value, value_len, expires);
+    if (end > *lsn) *lsn = end;
+}
+
+// Keep ttl_keys in step with a key's deadline changing from `old` to `expires`
+static inline void stripe_track_ttl(Stripe *stripe, uint64_t old, uint64_t expires) {
+    if (old && !expires) {
+        STORE_RELAXED(stripe->ttl_keys, stripe->ttl_keys - 1);
+    } else if (!old && expires) {
+        STORE_RELAXED(stripe->ttl_keys, stripe->ttl_keys + 1);
+    }
+}
+
+// Remove the live entry *link points at: unlink it, or keep it as a
+// tombstone if it shadows a snapshot key, so the snapshot value stays hidden
+static void chain_remove(Database *db, Stripe *stripe, Entry **link) {
+    Entry *entry = *link;
+    stripe_track_ttl(stripe, entry->expires, 0);
+    STORE_RELAXED(stripe->count, stripe->count - 1);
+    
+    if (snapshot_has(db, entry->key, entry->key_len, entry->hash)) {
+        char *old_value = entry->value;
+        PUBLISH(entry->value, NULL);
+        stripe_retire_block(stripe, old_value, entry->value_cap);
+        entry->value_cap = 0;
+        STORE_RELAXED(entry->value_len, 0);
+        STORE_RELAXED(entry->expires, 0);
+    } else {
+        PUBLISH(*link, entry->next);
+        retire_entry(stripe, entry);
+    }
+}
+
+// Remove a key found by a sweep, index and log included
+static void drop_entry(Database *db, Stripe *stripe, Entry **link, uint64_t *lsn) {
+    Entry *entry = *link;
+    views_preserve(db, stripe, entry->key, entry->key_len, entry->hash);
+    index_remove(db, entry->key, entry->key_len);
+    stripe_log(db, WAL_OP_DELETE, entry->key, entry->key_len, NULL, 0, 0, lsn);
+    chain_remove(db, stripe, link);
+}
+
+static void drop_slot(Database *db, Stripe *stripe, SwissSlot *slot, uint64_t *lsn) {
+    views_preserve(db, stripe, slot_key(slot), slot->key_len, slot->hash);
+    index_remove(db, slot_key(slot), slot->key_len);
+    stripe_log(db, WAL_OP_DELETE, slot_key(slot), slot->key_len, NULL, 0, 0, lsn);
+    stripe_track_ttl(stripe, slot->expires, 0);
+    swiss_erase(stripe, slot);
+    STORE_RELAXED(stripe->count, stripe->count - 1);
+}
+
+// Buckets (chained) or slots (Swiss) a sweep hand cycles through
+static size_t stripe_positions(const Database *db, const Stripe *stripe) {
+    return db->engine == DB_ENGINE_SWISS ? stripe->swiss->capacity : stripe->chain.table->size;
+}
+
+// Bytes the memory budget charges to a stripe: slab blocks in use (retired
+// ones are as good as freed) plus its table
+static size_t stripe_memory(const Database *db, const Stripe *stripe) {
+    size_t bytes = stripe->arena->in_use - stripe->retired_bytes;
+    
+    if (db->engine == DB_ENGINE_SWISS) {
+        bytes += stripe->swiss->capacity * (sizeof(SwissSlot) + 1);
+    } else {
+        bytes += stripe->chain.table->size * sizeof(Entry*);
+        if (stripe->chain.old_table) bytes += stripe->chain.old_table->size * sizeof(Entry*);
+    }
+    return bytes;
+}
+
+// Examine the bucket or slot under *hand and move the hand on. Expired
+// keys are dropped. With `evict` set, the first key whose CLOCK bit is
+// already clear is evicted and the bits of keys passed over are cleared,
+// so a key read since the hand last came by survives another turn. Keys
+// still waiting in a resize's old table are left for a later turn. Returns
+// the number of keys dropped. Called with the stripe lock held.
+static size_t sweep_step(Database *db, Stripe *stripe, size_t *hand, bool evict,
+                         uint64_t now, uint64_t *lsn) {
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissTable *st = stripe->swiss;
+        size_t pos = *hand & (st->capacity - 1);
+        *hand = pos + 1;
+        if (st->ctrl[pos] < 0) return 0;
+        
+        SwissSlot *slot = &st->slots[pos];
+        if (deadline_passed(slot->expires, now)) {
+            drop_slot(db, stripe, slot, lsn);
+            stripe->expirations++;
+            return 1;
+        }
+        if (!evict) return 0;
+        if (LOAD_RELAXED(slot->referenced)) {
+            __atomic_store_n(&slot->referenced, 0, __ATOMIC_RELAXED);
+            return 0;
+        }
+        drop_slot(db, stripe, slot, lsn);
+        stripe->evictions++;
+        return 1;
+    }
+    
+    BucketArray *table = stripe->chain.table;
+    size_t index = *hand & (table->size - 1);
+    *hand = index + 1;
+    
+    Entry **link = &table->buckets[index];
+    size_t dropped = 0;
+    bool evicted = false;
+    while (*link) {
+        Entry *entry = *link;
+        if (!entry->value) {
+            link = &entry->next;  // Tombstone
+            continue;
+        }
+        
+        if (deadline_passed(entry->expires, now)) {
+            drop_entry(db, stripe, link, lsn);
+            stripe->expirations++;
+        } else if (evict && !evicted && !LOAD_RELAXED(entry->referenced)) {
+            drop_entry(db, stripe, link, lsn);
+            stripe->evictions++;
+            evicted = true;
+        } else {
+            if (evict) __atomic_store_n(&entry->referenced, 0, __ATOMIC_RELAXED);
+            link = &entry->next;
+            continue;
+        }
+        dropped++;
+        // An unlinked entry was replaced by its successor; a tombstone stays
+        if (*link == entry) link = &entry->next;
+    }
+    return dropped;
+}
+
+// Evict until the stripe fits its share of the memory budget again and
+// holds at most `keep` keys. Two full turns of the hand clear every bit,
+// so they find any victim there is; each write pays for the keys it
+// displaces, O(1) amortized. A Swiss table left a quarter full is halved
+// on the way, so a lowered budget isn't spent on empty slots, unless a
+// read view is open: its scan could return keys twice after a shrink.
+static void stripe_evict(Database *db, Stripe *stripe, size_t keep, uint64_t *lsn) {
+    size_t budget = LOAD_RELAXED(db->stripe_budget);
+    if (budget == 0) return;
+    
+    uint64_t now = now_ms();
+    size_t turns = 2 * stripe_positions(db, stripe);
+    for (size_t i = 0; i < turns && stripe->count > 0 &&
+         (stripe->count > keep || stripe_memory(db, stripe) > budget); i++) {
+        SwissTable *st = stripe->swiss;
+        if (db->engine == DB_ENGINE_SWISS && st->capacity > SWISS_GROUP_WIDTH &&
+            stripe->count <= swiss_max_load(st->capacity) / 4 && !db->views &&
+            swiss_rehash(stripe, st->capacity / 2)) continue;
+        sweep_step(db, stripe, &stripe->clock_hand, true, now, lsn);
+    }
+}
+
+// Before a Swiss insert: if the table is full and doubling it would break
+// the budget, evict down to 3/4 of the load so swiss_insert can rebuild in
+// place with room to spare. Returns whether the table may grow instead.
+static bool swiss_make_room(Database *db, Stripe *stripe, uint64_t *lsn) {
+    size_t budget = LOAD_RELAXED(db->stripe_budget);
+    SwissTable *st = stripe->swiss;
+    if (budget == 0 || st->growth_left > 0) return true;
+    if (stripe_memory(db, stripe) + st->capacity * (sizeof(SwissSlot) + 1) <= budget) return true;
+    
+    stripe_evict(db, stripe, swiss_max_load(st->capacity) / 4 * 3, lsn);
+    return false;
+}
+
+static void reaper_start(Database *db);
+
+// Insert or update under the stripe lock (lengths already validated).
+// `expires` is the key's new deadline, 0 for none.
+static bool stripe_set(Database *db, const char *key, size_t key_len, const char *value,
+                       size_t value_len, uint64_t hash, uint64_t expires, uint64_t *lsn) {
+    Stripe *stripe = stripe_for(db, hash);
+    bool ok = true;
+    
+    stripe_write_begin(stripe);
+    views_preserve(db, stripe, key, key_len, hash);
+    
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissSlot *slot = swiss_find(stripe->swiss, key, key_len, hash);
+        if (slot) {
+            if ((ok = slot_store_value(stripe, slot, value, value_len))) {
+                stripe_track_ttl(stripe, slot->expires, expires);
+                STORE_RELAXED(slot->expires, expires);
+            }
+        } else if ((ok = swiss_insert(stripe, key, key_len, value, value_len, hash, expires,
+                                      swiss_make_room(db, stripe, lsn)))) {
+            STORE_RELAXED(stripe->count, stripe->count + 1);
+            stripe_track_ttl(stripe, 0, expires);
+            index_add(db, key, key_len);
+        }
+    } else {
+        rehash_step(stripe, REHASH_STEP);
+        
+        Entry **slot = find_slot(&stripe->chain, key, key_len, hash);
+        
+        // Check if key already exists (update case)
+        if (slot) {
+            Entry *entry = *slot;
+            bool was_tombstone = entry->value == NULL;
+            
+            if (block_reusable(entry->value_cap, value_len + 1)) {
+                // Fits the current block: overwrite in place. Readers copying
+                // it concurrently see the sequence change and retry.
+                memcpy(entry->value, value, value_len);
+                entry->value[value_len] = '\0';
+                STORE_RELAXED(entry->value_len, (uint32_t)value_len);
+            } else {
+                // Readers may still hold the old block
+                uint32_t cap;
+                char *new_value = arena_strdup(stripe->arena, value, value_len, &cap);
+                char *old_value = entry->value;
+                uint32_t old_cap = entry->value_cap;
+                if (new_value) {
+                    entry->value_cap = cap;
+                    STORE_RELAXED(entry->value_len, (uint32_t)value_len);
+                    PUBLISH(entry->value, new_value);
+                    stripe_retire_block(stripe, old_value, old_cap);
+                }
+                ok = new_value != NULL;
+            }
+            if (ok) {
+                stripe_track_ttl(stripe, entry->expires, expires);
+                STORE_RELAXED(entry->expires, expires);
+            }
+            if (ok && was_tombstone) {
+                STORE_RELAXED(stripe->count, stripe->count + 1);
+                index_add(db, key, key_len);
+            }
+        } else if ((ok = chain_insert(&stripe->chain, stripe->arena, key, key_len,
+                                      value, value_len, hash, expires))) {
+            // Inserted at the beginning of the chain
+            STORE_RELAXED(stripe->count, stripe->count + 1);
+            stripe_track_ttl(stripe, 0, expires);
+            if (snapshot_has(db, key, key_len, hash)) {
+                stripe->shadowed++;  // Already indexed through the snapshot
+            } else {
+                index_add(db, key, key_len);
+            }
+            maybe_grow(stripe);
+        }
+    }
+    
+    if (ok) {
+        stripe_log(db, WAL_OP_SET, key, key_len, value, value_len, expires, lsn);
+        stripe_evict(db, stripe, SIZE_MAX, lsn);
+    }
+    stripe_write_end(stripe);
+    
+    if (ok && expires) reaper_start(db);
+    return ok;
+}
+
+// Delete under the stripe lock. An expired key is removed all the same but
+// reported as not found.
+static bool stripe_delete(Database *db, const char *key, size_t key_len, uint64_t hash,
+                          uint64_t *lsn) {
+    Stripe *stripe = stripe_for(db, hash);
+    uint64_t expires = 0;
+    bool removed = false;
+    
+    stripe_write_begin(stripe);
+    
+    // Views are only told about keys that are there to remove
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissSlot *slot = swiss_find(stripe->swiss, key, key_len, hash);
+        if (slot) {
+            views_preserve(db, stripe, key, key_len, hash);
+            expires = slot->expires;
+            stripe_track_ttl(stripe, expires, 0);
+            swiss_erase(stripe, slot);
+            STORE_RELAXED(stripe->count, stripe->count - 1);
+            removed = true;
+        }
+    } else {
+        rehash_step(stripe, REHASH_STEP);
+        
+        Entry **slot = find_slot(&stripe->chain, key, key_len, hash);
+        
+        if (slot && (*slot)->value) {
+            views_preserve(db, stripe, key, key_len, hash);
+            expires = (*slot)->expires;
+            chain_remove(db, stripe, slot);
+            removed = true;
+        } else if (!slot && db->base &&
+                   snapshot_find(db->base, key, key_len, hash, NULL, &expires)) {
+            // A tombstone hides the snapshot value
+            views_preserve(db, stripe, key, key_len, hash);
+            if (chain_insert(&stripe->chain, stripe->arena, key, key_len, NULL, 0, hash, 0)) {
+                stripe->shadowed++;
+                maybe_grow(stripe);
+                removed = true;
+            }
+        }
+    }
+    
+    bool expired = removed && deadline_passed(expires, now_ms());
+    if (removed) {
+        index_remove(db, key, key_len);
+        stripe_log(db, WAL_OP_DELETE, key, key_len, NULL, 0, 0, lsn);
+        if (expired) stripe->expirations++;
+    }
+    stripe_write_end(stripe);
+    return removed && !expired;  // false: key not found
+}
+
+// stripe_set and stripe_delete for the public calls, counted for
+// db_stats_ex. Log replay goes straight to the stripe functions. The time
+// covers the table update, not a wait for the log to sync.
+static bool counted_set(Database *db, const char *key, size_t key_len, const char *value,
+                        size_t value_len, uint64_t hash, uint64_t expires, uint64_t *lsn) {
+    OpSample sample;
+    op_begin(db, &sample);
+    bool ok = stripe_set(db, key, key_len, value, value_len, hash, expires, lsn);
+    op_end(&sample, DB_OP_SET, ok);
+    return ok;
+}
+
+static bool counted_delete(Database *db, const char *key, size_t key_len, uint64_t hash,
+                           uint64_t *lsn) {
+    OpSample sample;
+    op_begin(db, &sample);
+    bool removed = stripe_delete(db, key, key_len, hash, lsn);
+    op_end(&sample, DB_OP_DELETE, removed);
+    return removed;
+}
+
+// Background expiry: each pass looks at REAP_SAMPLE buckets or slots of
+// every stripe holding keys with a deadline, where the previous pass left
+// off, and takes another look at once while a quarter of them turn out to
+// have expired. Readers already treat expired keys as missing; this is
+// what gives their memory back when nobody touches them again.
+static size_t stripe_reap(Database *db, Stripe *stripe) {
+    if (LOAD_RELAXED(stripe->ttl_keys) == 0) return 0;
+    
+    size_t dropped = 0;
+    uint64_t now = now_ms(), lsn = 0;
+    
+    stripe_write_begin(stripe);
+    if (db->engine == DB_ENGINE_CHAINED) rehash_step(stripe, REHASH_STEP);
+    for (size_t i = 0; i < REAP_SAMPLE && stripe->ttl_keys > 0; i++) {
+        dropped += sweep_step(db, stripe, &stripe->reap_hand, false, now, &lsn);
+    }
+    stripe_write_end(stripe);
+    return dropped;
+}
+
+static void* reaper_main(void *arg) {
+    Database *db = (Database*)arg;
+    
+    pthread_mutex_lock(&db->reaper_lock);
+    while (!db->reaper_stop) {
+        pthread_mutex_unlock(&db->reaper_lock);
+        for (size_t i = 0; i < DB_STRIPES; i++) {
+            for (int round = 0; round < 16; round++) {
+                if (stripe_reap(db, &db->stripes[i]) <= REAP_SAMPLE / 4) break;
+            }
+        }
+        
+        pthread_mutex_lock(&db->reaper_lock);
+        struct timespec deadline;
+        wal_deadline(&deadline, REAP_INTERVAL_MS * 1000);
+        while (!db->reaper_stop &&
+               pthread_cond_timedwait(&db->reaper_wake, &db->reaper_lock, &deadline) != ETIMEDOUT) {
+            // Sleep until the next pass
+        }
+    }
+    pthread_mutex_unlock(&db->reaper_lock);
+    
+    return NULL;
+}
+
+// Start the expiry thread once the first key with a TTL arrives. If it
+// can't be started, expired keys still read as missing; they just stay in
+// memory until written, deleted or swept by eviction.
+static void reaper_start(Database *db) {
+    if (LOAD_PTR(db->reaper_running)) return;
+    
+    pthread_mutex_lock(&db->reaper_lock);
+    if (!db->reaper_running && !db->reaper_stop &&
+        pthread_create(&db->reaper, NULL, reaper_main, db) == 0) {
+        PUBLISH(db->reaper_running, true);
+    }
+    pthread_mutex_unlock(&db->reaper_lock);
+}
+
+// Start pulling in the memory a lookup of `hash` will touch first: the
+// stripe header and the bucket head or control group. Must be called inside
+// an epoch, since it reads the current table pointer.
+static inline void stripe_prefetch(Database *db, uint64_t hash) {
+    Stripe *stripe = stripe_for(db, hash);
+    
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissTable *st = LOAD_PTR(stripe->swiss);
+        size_t group = (swiss_h1(hash) & (st->capacity / SWISS_GROUP_WIDTH - 1)) * SWISS_GROUP_WIDTH;
+        __builtin_prefetch(st->ctrl + group);
+        __builtin_prefetch(&st->slots[group]);
+    } else {
+        BucketArray *table = LOAD_PTR(stripe->chain.table);
+        __builtin_prefetch(&table->buckets[local_hash(hash) & (table->size - 1)]);
+    }
+}
+
+// One key of a batch, hashed ahead of its probe
+typedef struct BatchKey {
+    const char *key;
+    size_t len;
+    uint64_t hash;
+} BatchKey;
+
+// Walk up to `window` packed NUL-terminated keys starting at *cursor, hash
+// them and issue their prefetches so the probes that follow overlap the
+// cache misses instead of paying them one at a time
+static void batch_prepare(Database *db, const char **cursor, BatchKey *batch, size_t window) {
+    epoch_enter();
+    for (size_t i = 0; i < window; i++) {
+        batch[i].key = *cursor;
+        batch[i].len = strlen(*cursor);
+        batch[i].hash = hash_function(*cursor, batch[i].len);
+        *cursor += batch[i].len + 1;
+        stripe_prefetch(db, batch[i].hash);
+    }
+    
+    // By now the bucket heads are arriving; fetch the first entry of each
+    // chain too (its key lives in the same block)
+    if (db->engine == DB_ENGINE_CHAINED) {
+        for (size_t i = 0; i < window; i++) {
+            BucketArray *table = LOAD_PTR(stripe_for(db, batch[i].hash)->chain.table);
+            Entry *head = LOAD_PTR(table->buckets[local_hash(batch[i].hash) & (table->size - 1)]);
+            if (head) __builtin_prefetch(head);
+        }
+    }
+    epoch_exit();
+}
+
+// With wait_durable set, hold a writer until its change is on disk. Called
+// after the stripe lock is released, so the wait doesn't stall the stripe.
+static bool wal_durable(Database *db, uint64_t lsn) {
+    if (!db->wal || !db->wal->config.wait_durable || lsn == 0) return true;
+    return wal_wait(db->wal, lsn);
+}
+
+// Call visit for every live key, snapshot keys nothing shadows included,
+// stopping early if it returns false. Keys expired by `now` are skipped
+// (0 skips none). All stripe locks must be held.
+typedef bool (*KeyVisitor)(void *ctx, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t hash,
+                           uint64_t expires);
+
+static bool foreach_locked(Database *db, KeyVisitor visit, void *ctx, uint64_t now) {
+    for (size_t s = 0; s < DB_STRIPES; s++) {
+        Stripe *stripe = &db->stripes[s];
+        
+        if (db->engine == DB_ENGINE_SWISS) {
+            SwissTable *st = stripe->swiss;
+            for (size_t i = 0; i < st->capacity; i++) {
+                if (st->ctrl[i] < 0) continue;
+                const SwissSlot *slot = &st->slots[i];
+                if (deadline_passed(slot->expires, now)) continue;
+                if (!visit(ctx, slot_key(slot), slot->key_len, slot_value(slot),
+                           slot->value_len, slot->hash, slot->expires)) return false;
+            }
+        } else {
+            BucketArray *arrays[2] = { stripe->chain.old_table, stripe->chain.table };
+            for (int a = 0; a < 2; a++) {
+                if (!arrays[a]) continue;
+                for (size_t i = 0; i < arrays[a]->size; i++) {
+                    for (Entry *entry = arrays[a]->buckets[i]; entry; entry = entry->next) {
+                        if (!entry->value || deadline_passed(entry->expires, now)) continue;
+                        if (!visit(ctx, entry->key, entry->key_len, entry->value,
+                                   entry->value_len, entry->hash, entry->expires)) return false;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Snapshot keys nothing in the overlay shadows
+    const SnapshotImage *base = db->base;
+    for (size_t i = 0; base && i <= base->mask; i++) {
+        const SnapshotSlot *slot = &base->index[i];
+        if (slot->offset == 0) continue;
+        
+        const char *key = base->map + slot->offset + SNAPSHOT_RECORD_HEADER;
+        size_t value_len;
+        uint64_t expires;
+        const char *value = snapshot_find(base, key, slot->key_len, slot->hash,
+                                          &value_len, &expires);
+        if (value && !deadline_passed(expires, now) &&
+            !find_slot(&stripe_for(db, slot->hash)->chain, key, slot->key_len, slot->hash) &&
+            !visit(ctx, key, slot->key_len, value, value_len, slot->hash, expires)) return false;
+    }
+    
+    return true;
+}
+
+// db_clear with views open: every key is about to change
+static bool preserve_visit(void *ctx, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t hash,
+                           uint64_t expires) {
+    (void)value; (void)value_len; (void)expires;
+    Database *db = (Database*)ctx;
+    views_preserve(db, stripe_for(db, hash), key, key_len, hash);
+    return true;
+}
+
+// ============================================================================
+// PUBLIC API FUNCTIONS
+// ============================================================================
+
+// Create a new database using `engine`, with room for `capacity` entries
+// before the first resize
+Database* db_create_ex(DBEngine engine, size_t capacity) {
+    Database *db;
+    if (posix_memalign((void**)&db, CACHE_LINE, sizeof(Database)) != 0) return NULL;
+    memset(db, 0, sizeof(Database));
+    
+    if (engine != DB_ENGINE_SWISS) engine = DB_ENGINE_CHAINED;
+    db->engine = engine;
+    db->max_value_len = MAX_VALUE_LENGTH - 1;
+    pthread_mutex_init(&db->reaper_lock, NULL);
+    pthread_cond_init(&db->reaper_wake, NULL);
+    pthread_mutex_init(&db->save_lock, NULL);
+    
+    // Capacity is spread evenly over the stripes
+    size_t per_stripe = capacity / DB_STRIPES + 1;
+    size_t chain_size = round_up_pow2(per_stripe / MAX_LOAD_FACTOR);
+    if (chain_size < INITIAL_TABLE_SIZE / DB_STRIPES) chain_size = INITIAL_TABLE_SIZE / DB_STRIPES;
+    size_t swiss_slots = round_up_pow2(per_stripe / SWISS_MAX_LOAD_NUM * SWISS_MAX_LOAD_DEN + 1);
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        Stripe *stripe = &db->stripes[i];
+        pthread_mutex_init(&stripe->lock, NULL);
+        
+        bool ok;
+        if (engine == DB_ENGINE_SWISS) {
+            stripe->swiss = swiss_create(swiss_slots);
+            ok = stripe->swiss != NULL;
+        } else {
+            ok = chain_init(&stripe->chain, chain_size);
+        }
+        stripe->arena = arena_create();
+        ok = ok && stripe->arena != NULL;
+        
+        if (!ok) {
+            db_destroy(db);
+            return NULL;
+        }
+    }
+    
+    return db;
+}
+
+// Create a new database with room for `capacity` entries before the first
+// resize. The bucket count is rounded up to a power of two.
+Database* db_create_with_capacity(size_t capacity) {
+    return db_create_ex(DB_ENGINE_CHAINED, capacity);
+}
+
+// Create a new database
+Database* db_create(void) {
+    return db_create_ex(DB_ENGINE_CHAINED, INITIAL_TABLE_SIZE);
+}
+
+// Destroy database and free all memory. No other thread may be using it;
+// a background save is waited for, and views still open are freed.
+// Entries live in the stripe arenas, so nothing is freed entry by entry.
+void db_destroy(Database *db) {
+    if (!db) return;
+    
+    db_save_wait(db);
+    pthread_mutex_destroy(&db->save_lock);
+    while (db->views) {
+        DBSnapshot *view = db->views;
+        db->views = view->next;
+        view_free(view);
+    }
+    
+    pthread_mutex_lock(&db->reaper_lock);
+    db->reaper_stop = true;
+    pthread_cond_signal(&db->reaper_wake);
+    pthread_mutex_unlock(&db->reaper_lock);
+    if (db->reaper_running) pthread_join(db->reaper, NULL);
+    pthread_cond_destroy(&db->reaper_wake);
+    pthread_mutex_destroy(&db->reaper_lock);
+    
+    db_wal_close(db);
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        Stripe *stripe = &db->stripes[i];
+        
+        stripe_drain_retired(stripe);
+        free(stripe->swiss);
+        free(stripe->chain.table);
+        free(stripe->chain.old_table);
+        arena_destroy(stripe->arena);
+        pthread_mutex_destroy(&stripe->lock);
+    }
+    
+    for (size_t i = 0; i < STATS_THREADS; i++) free(db->thread_stats[i]);
+    snapshot_close(db->base);
+    index_destroy(db->index);
+    free(db);
+}
+
+// Hash `key` the way the database does, for the _hashed variants below
+uint64_t db_hash(const char *key) {
+    if (!key) return 0;
+    
+    return hash_function(key, strlen(key));
+}
+
+// Accept values up to max_len bytes from now on (MAX_VALUE_LENGTH - 1 by
+// default, at most MAX_VALUE_LIMIT). Values already stored are unaffected.
+bool db_set_max_value_length(Database *db, size_t max_len) {
+    if (!db || max_len > MAX_VALUE_LIMIT) return false;
+    
+    __atomic_store_n(&db->max_value_len, max_len, __ATOMIC_RELAXED);
+    return true;
+}
+
+// Keep the keys and values stored within about max_bytes from now on,
+// evicting as needed (0 removes the limit). Each stripe gets an equal
+// share and evicts on its own, so the budget is approximate: it counts the
+// slab blocks and tables the data lives in, not allocator overhead.
+bool db_set_max_memory(Database *db, size_t max_bytes) {
+    if (!db) return false;
+    
+    size_t budget = max_bytes / DB_STRIPES;
+    if (max_bytes && budget == 0) budget = 1;
+    __atomic_store_n(&db->stripe_budget, budget, __ATOMIC_RELAXED);
+    
+    // Bring every stripe under the new budget now rather than at its next write
+    uint64_t lsn = 0;
+    for (size_t i = 0; i < DB_STRIPES && budget; i++) {
+        stripe_write_begin(&db->stripes[i]);
+        stripe_evict(db, &db->stripes[i], SIZE_MAX, &lsn);
+        stripe_write_end(&db->stripes[i]);
+    }
+    return wal_durable(db, lsn);
+}
+
+// Validate lengths, store, and wait for the log if the WAL asks for it
+static bool db_store(Database *db, const char *key, size_t key_len, const char *value,
+                     size_t value_len, uint64_t hash, uint64_t expires) {
+    if (key_len >= MAX_KEY_LENGTH || value_len > LOAD_RELAXED(db->max_value_len)) {
+        return false;
+    }
+    
+    uint64_t lsn = 0;
+    bool ok = counted_set(db, key, key_len, value, value_len, hash, expires, &lsn);
+    return ok && wal_durable(db, lsn);
+}
+
+// Insert or update a key-value pair
+bool db_set(Database *db, const char *key, const char *value) {
+    if (!db || !key || !value) return false;
+    
+    size_t key_len = strlen(key);
+    return db_store(db, key, key_len, value, strlen(value), hash_function(key, key_len), 0);
+}
+
+// db_set for a caller that already holds db_hash(key). Any other hash
+// files the key where lookups won't find it.
+bool db_set_hashed(Database *db, const char *key, const char *value, uint64_t hash) {
+    if (!db || !key || !value) return false;
+    
+    return db_store(db, key, strlen(key), value, strlen(value), hash, 0);
+}
+
+// Insert or update with explicit lengths. The value may hold any bytes,
+// NULs included; the key may not contain NUL, since key listings and scans
+// hand keys out as C strings. Neither needs to be NUL-terminated.
+bool db_set_n(Database *db, const char *key, size_t key_len, const char *value,
+              size_t value_len) {
+    if (!db || !key || (!value && value_len > 0)) return false;
+    if (key_len >= MAX_KEY_LENGTH || memchr(key, '\0', key_len)) return false;
+    
+    return db_store(db, key, key_len, value ? value : "", value_len,
+                    hash_function(key, key_len), 0);
+}
+
+// Insert or update a key that expires ttl_ms milliseconds from now.
+// Reads treat it as missing from then on; its memory is reclaimed by a
+// background thread, started on first use, within a few passes.
+bool db_set_ex(Database *db, const char *key, const char *value, uint64_t ttl_ms) {
+    if (!db || !key || !value) return false;
+    
+    return db_set_ex_n(db, key, strlen(key), value, strlen(value), ttl_ms);
+}
+
+// db_set_ex with explicit lengths, as db_set_n. ttl_ms must be positive.
+bool db_set_ex_n(Database *db, const char *key, size_t key_len, const char *value,
+                 size_t value_len, uint64_t ttl_ms) {
+    if (!db || !key || (!value && value_len > 0) || ttl_ms == 0) return false;
+    if (key_len >= MAX_KEY_LENGTH || memchr(key, '\0', key_len)) return false;
+    
+    // Snapshots keep deadlines as 32-bit seconds
+    const uint64_t latest = (uint64_t)UINT32_MAX * 1000;
+    uint64_t now = now_ms();
+    uint64_t expires = ttl_ms < latest - now ? now + ttl_ms : latest;
+    return db_store(db, key, key_len, value ? value : "", value_len,
+                    hash_function(key, key_len), expires);
+}
+
+// Milliseconds until key expires, -1 if it has no TTL, -2 if it is missing
+long long db_ttl(Database *db, const char *key) {
+    if (!db || !key) return -2;
+    
+    size_t key_len = strlen(key);
+    if (key_len >= MAX_KEY_LENGTH) return -2;
+    
+    uint64_t hash = hash_function(key, key_len), expires = 0;
+    Stripe *stripe = stripe_for(db, hash);
+    bool found = false;
+    
+    pthread_mutex_lock(&stripe->lock);
+    if (db->engine == DB_ENGINE_SWISS) {
+        SwissSlot *slot = swiss_find(stripe->swiss, key, key_len, hash);
+        if (slot) {
+            found = true;
+            expires = slot->expires;
+        }
+    } else {
+        Entry **slot = find_slot(&stripe->chain, key, key_len, hash);
+        if (slot) {
+            found = (*slot)->value != NULL;
+            expires = (*slot)->expires;
+        } else if (db->base) {
+            found = snapshot_find(db->base, key, key_len, hash, NULL, &expires) != NULL;
+        }
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    
+    if (!found) return -2;
+    if (!expires) return -1;
+    uint64_t now = now_ms();
+    return expires > now ? (long long)(expires - now) : -2;
+}
+
+// Get a value by key
+//
+// The value is copied into a buffer owned by the calling thread, so a
+// concurrent db_set or db_delete can't free it from under the caller. The
+// pointer stays valid until the same thread's next db_get.
+const char* db_get(Database *db, const char *key) {
+    if (!db || !key) return NULL;
+    
+    size_t key_len = strlen(key), value_len;
+    return counted_lookup(db, key, key_len, hash_function(key, key_len), &value_len);  // NULL: key not found
+}
+
+// db_get for a caller that already holds db_hash(key)
+const char* db_get_hashed(Database *db, const char *key, uint64_t hash) {
+    if (!db || !key) return NULL;
+    
+    size_t value_len;
+    return counted_lookup(db, key, strlen(key), hash, &value_len);  // NULL: key not found
+}
+
+// db_get with an explicit key length; *value_len receives the value's
+// length. The copy is followed by a NUL, so text values can also be used
+// as C strings.
+const char* db_get_n(Database *db, const char *key, size_t key_len, size_t *value_len) {
+    if (!db || !key || !value_len || key_len >= MAX_KEY_LENGTH) return NULL;
+    
+    return counted_lookup(db, key, key_len, hash_function(key, key_len), value_len);  // NULL: key not found
+}
+
+// Copy a value into a caller-provided buffer (truncated to size - 1 bytes
+// and NUL-terminated). Returns the full value length, or -1 if not found.
+long db_get_copy(Database *db, const char *key, char *buf, size_t size) {
+    if (!db || !key) return -1;
+    
+    size_t key_len = strlen(key), len;
+    const char *value = counted_lookup(db, key, key_len, hash_function(key, key_len), &len);
+    if (!value) return -1;
+    
+    if (buf && size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(buf, value, n);
+        buf[n] = '\0';
+    }
+    return (long)len;
+}
+
+// Delete a key-value pair
+bool db_delete(Database *db, const char *key) {
+    if (!db || !key) return false;
+    
+    return db_delete_n(db, key, strlen(key));
+}
+
+// db_delete with an explicit key length
+bool db_delete_n(Database *db, const char *key, size_t key_len) {
+    if (!db || !key || key_len >= MAX_KEY_LENGTH) return false;
+    
+    uint64_t lsn = 0;
+    bool found = counted_delete(db, key, key_len, hash_function(key, key_len), &lsn);
+    return found && wal_durable(db, lsn);  // false: key not found
+}
+
+// Check if a key exists
+bool db_exists(Database *db, const char *key) {
+    if (!db || !key) return false;
+    
+    size_t key_len = strlen(key), value_len;
+    return stripe_lookup(db, key, key_len, hash_function(key, key_len), false, &value_len) != NULL;
+}
+
+// ============================================================================
+// BATCH OPERATIONS
+// ============================================================================
+//
+// Keys and values are passed packed: n NUL-terminated strings back to back
+// in one buffer. A batch costs one call from Python, and keys are hashed and
+// prefetched BATCH_WINDOW at a time before any of them is probed.
+
+// Insert or update n pairs. Pairs with an over-long key or value are
+// skipped. Returns the number stored.
+size_t db_mset(Database *db, const char *keys, const char *values, size_t n) {
+    if (!db || !keys || !values) return 0;
+    
+    BatchKey batch[BATCH_WINDOW];
+    size_t stored = 0, max_value_len = LOAD_RELAXED(db->max_value_len);
+    uint64_t lsn = 0;
+    
+    for (size_t base = 0; base < n; base += BATCH_WINDOW) {
+        size_t window = n - base < BATCH_WINDOW ? n - base : BATCH_WINDOW;
+        batch_prepare(db, &keys, batch, window);
+        
+        for (size_t i = 0; i < window; i++) {
+            const char *value = values;
+            size_t value_len = strlen(value);
+            values += value_len + 1;
+            
+            if (batch[i].len >= MAX_KEY_LENGTH || value_len > max_value_len) continue;
+            if (counted_set(db, batch[i].key, batch[i].len, value, value_len,
+                            batch[i].hash, 0, &lsn)) stored++;
+        }
+    }
+    
+    // One wait covers the whole batch
+    return wal_durable(db, lsn) ? stored : 0;
+}
+
+// Look up n keys. Found values are copied to `out` back to back, each
+// NUL-terminated; lengths[i] receives the value length or -1 if key i is
+// missing, so values holding NUL bytes come back intact. Returns the bytes needed for all values. If that exceeds
+// out_size, values that didn't fit are left out and the caller should
+// retry with a larger buffer.
+size_t db_mget(Database *db, const char *keys, size_t n, char *out, size_t out_size,
+               long *lengths) {
+    if (!db || !keys || !lengths) return 0;
+    
+    BatchKey batch[BATCH_WINDOW];
+    size_t used = 0;
+    
+    for (size_t base = 0; base < n; base += BATCH_WINDOW) {
+        size_t window = n - base < BATCH_WINDOW ? n - base : BATCH_WINDOW;
+        batch_prepare(db, &keys, batch, window);
+        
+        for (size_t i = 0; i < window; i++) {
+            size_t len;
+            const char *value = counted_lookup(db, batch[i].key, batch[i].len,
+                                               batch[i].hash, &len);
+            if (!value) {
+                lengths[base + i] = -1;
+                continue;
+            }
+            
+            if (out && used + len + 1 <= out_size) {
+                memcpy(out + used, value, len + 1);
+            }
+            lengths[base + i] = (long)len;
+            used += len + 1;
+        }
+    }
+    
+    return used;
+}
+
+// Delete n keys. Returns the number that existed.
+size_t db_mdelete(Database *db, const char *keys, size_t n) {
+    if (!db || !keys) return 0;
+    
+    BatchKey batch[BATCH_WINDOW];
+    size_t deleted = 0;
+    uint64_t lsn = 0;
+    
+    for (size_t base = 0; base < n; base += BATCH_WINDOW) {
+        size_t window = n - base < BATCH_WINDOW ? n - base : BATCH_WINDOW;
+        batch_prepare(db, &keys, batch, window);
+        
+        for (size_t i = 0; i < window; i++) {
+            if (batch[i].len < MAX_KEY_LENGTH &&
+                counted_delete(db, batch[i].key, batch[i].len, batch[i].hash, &lsn)) deleted++;
+        }
+    }
+    
+    return wal_durable(db, lsn) ? deleted : 0;
+}
+
+// Get the number of entries
+size_t db_count(Database *db) {
+    if (!db) return 0;
+    
+    // Snapshot keys count unless a stripe shadows them
+    SnapshotImage *base = LOAD_PTR(db->base);
+    size_t count = base ? base->count : 0;
+    size_t shadowed = 0;
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        count += LOAD_RELAXED(db->stripes[i].count);
+        shadowed += LOAD_RELAXED(db->stripes[i].shadowed);
+    }
+    return count > shadowed ? count - shadowed : 0;
+}
+
+// Clear all entries (the current table size is kept). Each stripe's table
+// and arena are swapped for empty ones; the old arena is released whole
+// once readers are done, without walking the entries. A mapped snapshot is
+// dropped too. All stripes are held at once so readers never see snapshot
+// keys reappear in a half-cleared database.
+void db_clear(Database *db) {
+    if (!db) return;
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        stripe_write_begin(&db->stripes[i]);
+    }
+    if (db->views) foreach_locked(db, preserve_visit, db, 0);
+    
+    if (db->base) {
+        SnapshotImage *base = db->base;
+        PUBLISH(db->base, NULL);
+        for (size_t i = 0; i < DB_STRIPES; i++) db->stripes[i].shadowed = 0;
+        stripe_retire(&db->stripes[0], base, snapshot_close);
+    }
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        Stripe *stripe = &db->stripes[i];
+        
+        Arena *arena = arena_create();
+        void *fresh = NULL;
+        if (arena) {
+            fresh = db->engine == DB_ENGINE_SWISS
+                    ? (void*)swiss_create(stripe->swiss->capacity)
+                    : (void*)bucket_array_create(stripe->chain.table->size);
+        }
+        
+        if (fresh) {
+            // Blocks waiting in the retire list die with their arena
+            stripe_forget_blocks(stripe);
+            
+            if (db->engine == DB_ENGINE_SWISS) {
+                SwissTable *old = stripe->swiss;
+                PUBLISH(stripe->swiss, (SwissTable*)fresh);
+                stripe_retire(stripe, old, free);
+            } else {
+                ChainTable *ct = &stripe->chain;
+                BucketArray *old = ct->table;
+                BucketArray *old_old = ct->old_table;
+                PUBLISH(ct->old_table, NULL);
+                PUBLISH(ct->table, (BucketArray*)fresh);
+                ct->rehash_index = 0;
+                stripe_retire(stripe, old, free);
+                stripe_retire(stripe, old_old, free);
+            }
+            
+            stripe_retire(stripe, stripe->arena, arena_destroy);
+            stripe->arena = arena;
+            STORE_RELAXED(stripe->count, 0);
+            STORE_RELAXED(stripe->ttl_keys, 0);
+            stripe_reclaim(stripe);  // Usually frees the old arena right away
+        } else {
+            free(arena);
+        }
+    }
+    
+    if (db->index) {
+        pthread_rwlock_wrlock(&db->index->lock);
+        btree_clear(db->index);
+        db->index->version++;
+        pthread_rwlock_unlock(&db->index->lock);
+    }
+    
+    uint64_t lsn = 0;
+    if (db->wal) lsn = wal_append(db->wal, WAL_OP_CLEAR, "", 0, "", 0, 0);
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        stripe_write_end(&db->stripes[i]);
+    }
+    wal_durable(db, lsn);
+}
+
+// Get all keys (caller must free the returned array)
+//
+// The returned pointers refer to the database's own key storage and are
+// only valid while no other thread modifies the database. Kept for
+// existing callers; db_scan walks the keys without either drawback.
+char** db_keys(Database *db, size_t *count) {
+    if (!db || !count) return NULL;
+    
+    *count = 0;
+    size_t total = db_count(db);
+    if (total == 0) return NULL;
+    
+    char **keys = (char**)malloc(sizeof(char*) * total);
+    if (!keys) return NULL;
+    
+    uint64_t now = now_ms();
+    size_t idx = 0;
+    for (size_t s = 0; s < DB_STRIPES && idx < total; s++) {
+        Stripe *stripe = &db->stripes[s];
+        pthread_mutex_lock(&stripe->lock);
+        
+        if (db->engine == DB_ENGINE_SWISS) {
+            SwissTable *st = stripe->swiss;
+            for (size_t i = 0; i < st->capacity && idx < total; i++) {
+                if (st->ctrl[i] >= 0 && !deadline_passed(st->slots[i].expires, now)) {
+                    keys[idx++] = (char*)slot_key(&st->slots[i]);
+                }
+            }
+        } else {
+            BucketArray *arrays[2] = { stripe->chain.old_table, stripe->chain.table };
+            for (int a = 0; a < 2; a++) {
+                if (!arrays[a]) continue;
+                for (size_t i = 0; i < arrays[a]->size; i++) {
+                    for (Entry *entry = arrays[a]->buckets[i]; entry && idx < total; entry = entry->next) {
+                        if (entry->value && !deadline_passed(entry->expires, now)) {
+                            keys[idx++] = entry->key;
+                        }
+                    }
+                }
+            }
+        }
+        
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    
+    // Snapshot keys the overlay doesn't shadow; they point into the mapping
+    const SnapshotImage *base = db->base;
+    for (size_t i = 0; base && i <= base->mask && idx < total; i++) {
+        const SnapshotSlot *slot = &base->index[i];
+        if (slot->offset == 0) continue;
+        
+        if (deadline_passed((uint64_t)slot->expires * 1000, now)) continue;
+        char *key = (char*)base->map + slot->offset + SNAPSHOT_RECORD_HEADER;
+        Stripe *stripe = stripe_for(db, slot->hash);
+        pthread_mutex_lock(&stripe->lock);
+        if (!find_slot(&stripe->chain, key, slot->key_len, slot->hash)) keys[idx++] = key;
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    
+    *count = idx;
+    return keys;
+}
+
+// Get database statistics
+DBStats db_stats(Database *db) {
+    DBStats stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    if (!db) return stats;
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        Stripe *stripe = &db->stripes[i];
+        stats.hits += __atomic_load_n(&db->counters[i].hits, __ATOMIC_RELAXED);
+        stats.misses += __atomic_load_n(&db->counters[i].misses, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&stripe->lock);
+        
+        stats.total_entries += stripe->count;
+        stats.evictions += stripe->evictions;
+        stats.expirations += stripe->expirations;
+        stats.memory_used += stripe_memory(db, stripe);
+        if (db->engine == DB_ENGINE_SWISS) {
+            swiss_stats(stripe->swiss, &stats);
+        } else {
+            stats.total_buckets += stripe->chain.table->size;
+            if (stripe->chain.old_table) {
+                stats_buckets(stripe->chain.old_table, &stats);
+            }
+            stats_buckets(stripe->chain.table, &stats);
+        }
+        
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    
+    stats.total_entries = db_count(db);  // Includes snapshot keys
+    return stats;
+}
+
+static void stats_merge(DBStatsEx *stats, const ThreadStats *block) {
+    for (int kind = 0; kind < DB_OP_KINDS; kind++) {
+        const uint64_t *from = (const uint64_t*)&block->ops[kind];
+        uint64_t *to = (uint64_t*)&stats->ops[kind];
+        for (size_t i = 0; i < sizeof(DBOpStats) / sizeof(uint64_t); i++) {
+            to[i] += __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Extended statistics: the per-thread operation counters and histograms
+// summed, plus the totals the stripes keep. Unlike db_stats nothing walks
+// the buckets, so it is cheap enough to poll. Counts from threads still
+// running may be a few operations apart from each other.
+bool db_stats_ex(Database *db, DBStatsEx *stats) {
+    if (!db || !stats) return false;
+    memset(stats, 0, sizeof(*stats));
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        Stripe *stripe = &db->stripes[i];
+        pthread_mutex_lock(&stripe->lock);
+        stats->evictions += stripe->evictions;
+        stats->expirations += stripe->expirations;
+        stats->memory_used += stripe_memory(db, stripe);
+        stats->total_buckets += db->engine == DB_ENGINE_SWISS ? stripe->swiss->capacity
+                                                              : stripe->chain.table->size;
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    stats->total_entries = db_count(db);
+    
+    stats_merge(stats, &db->shared_stats);
+    for (size_t i = 0; i < STATS_THREADS; i++) {
+        const ThreadStats *block = LOAD_PTR(db->thread_stats[i]);
+        if (block) stats_merge(stats, block);
+    }
+    return true;
+}
+
+// Lowest latency in ns that lands in `bucket` (see latency_bucket)
+uint64_t db_latency_bucket_ns(size_t bucket) {
+    if (bucket < 16) return bucket;
+    if (bucket >= DB_LATENCY_BUCKETS) bucket = DB_LATENCY_BUCKETS - 1;
+    size_t octave = 4 + (bucket - 16) / 8;
+    return (uint64_t)(8 + (bucket - 16) % 8) << (octave - 3);
+}
+
+// Latency at `percentile` (0-100) of the sampled operations: the middle
+// of the bucket holding it
+uint64_t db_latency_percentile(const DBOpStats *op, double percentile) {
+    if (!op || op->sampled == 0) return 0;
+    
+    uint64_t total = 0;
+    for (size_t i = 0; i < DB_LATENCY_BUCKETS; i++) total += op->latency[i];
+    double rank = percentile / 100.0 * (double)total;
+    
+    uint64_t seen = 0;
+    size_t bucket = 0;
+    for (size_t i = 0; i < DB_LATENCY_BUCKETS; i++) {
+        if (op->latency[i] == 0) continue;
+        bucket = i;
+        seen += op->latency[i];
+        if ((double)seen >= rank) break;
+    }
+    uint64_t low = db_latency_bucket_ns(bucket);
+    if (bucket + 1 >= DB_LATENCY_BUCKETS) return low;
+    return low + (db_latency_bucket_ns(bucket + 1) - low) / 2;
+}
+
+// Print database contents (for debugging)
+void db_print(Database *db) {
+    if (!db) return;
+    
+    printf("Database contents (%zu entries):\n", db_count(db));
+    printf("═══════════════════════════════════════\n");
+    
+    for (size_t s = 0; s < DB_STRIPES; s++) {
+        Stripe *stripe = &db->stripes[s];
+        pthread_mutex_lock(&stripe->lock);
+        
+        if (db->engine == DB_ENGINE_SWISS) {
+            SwissTable *st = stripe->swiss;
+            for (size_t i = 0; i < st->capacity; i++) {
+                if (st->ctrl[i] >= 0) {
+                    printf("Slot %zu.%zu:\n  \"%s\" => \"%.*s\"\n", s, i,
+                           slot_key(&st->slots[i]), (int)st->slots[i].value_len,
+                           slot_value(&st->slots[i]));
+                }
+            }
+        } else {
+            if (stripe->chain.old_table) {
+                print_buckets(stripe->chain.old_table, s, "Old bucket");
+            }
+            print_buckets(stripe->chain.table, s, "Bucket");
+        }
+        
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    
+    if (db->base) {
+        printf("Snapshot: %zu keys mapped read-only underneath\n", db->base->count);
+    }
+    
+    printf("═══════════════════════════════════════\n");
+}
+
+// ============================================================================
+// INCREMENTAL SCAN
+// ============================================================================
+
+// A cursor is a phase (stripe 0..63, then the snapshot) in the top bits and
+// a position within it below. In a stripe the position is a bucket (or
+// Swiss group) counter incremented from its high bit down, as Redis SCAN
+// does: a bucket of a table of 2^n splits into buckets of the doubled
+// table that all come after it in that order, so a resize between calls
+// never makes the scan skip a key, at worst repeat a few.
+#define SCAN_PHASE_SHIFT 57
+#define SCAN_POSITION_MASK ((1ull << SCAN_PHASE_SHIFT) - 1)
+
+typedef struct {
+    char *out;
+    size_t size;
+    size_t used;
+    size_t records;
+    bool full;              // A record didn't fit; the step is undone
+    DBSnapshot *view;       // Skip keys this view holds versions of
+    bool with_meta;         // Put a ScanMeta in front of each record
+} ScanBuffer;
+
+// Record prefix for internal scans that need more than key and value; the
+// DBScanRecord header follows it
+typedef struct {
+    uint64_t hash;
+    uint64_t expires;
+} ScanMeta;
+
+// Copy one record into `out` as a DBScanRecord header, then key, NUL,
+// value, NUL. The caller has checked that DB_SCAN_RECORD_SIZE bytes fit.
+static size_t scan_put_record(char *out, const char *key, size_t key_len,
+                              const char *value, size_t value_len) {
+    DBScanRecord header = { (uint32_t)key_len, (uint32_t)value_len };
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, key, key_len);
+    out[key_len] = '\0';
+    memcpy(out + key_len + 1, value, value_len);
+    out[key_len + 1 + value_len] = '\0';
+    return DB_SCAN_RECORD_SIZE(key_len, value_len);
+}
+
+// The position after v in a table with index mask `mask`; 0 once it wraps
+static inline uint64_t scan_advance(uint64_t v, uint64_t mask) {
+    v |= ~mask;
+    return reverse_bits(reverse_bits(v) + 1);
+}
+
+static void scan_emit(ScanBuffer *sb, const char *key, size_t key_len,
+                      const char *value, size_t value_len, uint64_t hash,
+                      uint64_t expires) {
+    if (sb->view) {
+        Database *db = sb->view->db;
+        const VersionMap *map = &sb->view->maps[stripe_for(db, hash) - db->stripes];
+        if (version_find(map, key, key_len, hash)) return;
+    }
+    
+    size_t meta = sb->with_meta ? sizeof(ScanMeta) : 0;
+    if (sb->full || sb->used + meta + DB_SCAN_RECORD_SIZE(key_len, value_len) > sb->size) {
+        sb->full = true;
+        return;
+    }
+    if (meta) {
+        ScanMeta record = { hash, expires };
+        memcpy(sb->out + sb->used, &record, meta);
+        sb->used += meta;
+    }
+    sb->used += scan_put_record(sb->out + sb->used, key, key_len, value, value_len);
+    sb->records++;
+}
+
+static void scan_bucket(const BucketArray *array, size_t index, uint64_t now, ScanBuffer *sb) {
+    for (const Entry *entry = array->buckets[index]; entry; entry = entry->next) {
+        if (!entry->value || deadline_passed(entry->expires, now)) continue;
+        scan_emit(sb, entry->key, entry->key_len, entry->value, entry->value_len,
+                  entry->hash, entry->expires);
+    }
+}
+
+// One step over a chained stripe: bucket v of the smaller table and, while
+// a resize is running, every bucket of the larger table it maps to.
+// Stripe lock held.
+static uint64_t scan_chain_step(const ChainTable *ct, uint64_t v, uint64_t now, ScanBuffer *sb) {
+    const BucketArray *small = ct->table, *large = ct->old_table;
+    if (!large) {
+        scan_bucket(small, v & (small->size - 1), now, sb);
+        return scan_advance(v, small->size - 1);
+    }
+    if (small->size > large->size) {
+        const BucketArray *swap = small;
+        small = large;
+        large = swap;
+    }
+    
+    uint64_t m0 = small->size - 1, m1 = large->size - 1;
+    scan_bucket(small, v & m0, now, sb);
+    do {
+        scan_bucket(large, v & m1, now, sb);
+        v = scan_advance(v, m1);
+    } while (v & (m0 ^ m1));
+    return v;
+}
+
+// One step over a Swiss stripe: the keys whose home group is v, found
+// along v's probe sequence up to the first group with an EMPTY byte, the
+// same place a lookup stops. Stripe lock held.
+static uint64_t scan_swiss_step(const SwissTable *st, uint64_t v, uint64_t now, ScanBuffer *sb) {
+    size_t group_mask = st->capacity / SWISS_GROUP_WIDTH - 1;
+    size_t home = v & group_mask, group = home;
+    
+    for (size_t step = 1; step <= group_mask + 1; step++) {
+        const int8_t *ctrl = st->ctrl + group * SWISS_GROUP_WIDTH;
+        for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+            if (ctrl[i] < 0) continue;
+            const SwissSlot *slot = &st->slots[group * SWISS_GROUP_WIDTH + i];
+            if ((swiss_h1(slot->hash) & group_mask) != home ||
+                deadline_passed(slot->expires, now)) continue;
+            scan_emit(sb, slot_key(slot), slot->key_len, slot_value(slot), slot->value_len,
+                      slot->hash, slot->expires);
+        }
+        if (group_match(ctrl, CTRL_EMPTY)) break;
+        group = (group + step) & group_mask;
+    }
+    return scan_advance(v, group_mask);
+}
+
+// One slot of the mapped snapshot, unless the overlay shadows its key.
+// Returns the next slot, or 0 past the end. A view's scan position moves
+// past the slot under the lock of its key's stripe.
+static uint64_t scan_snapshot_step(Database *db, uint64_t v, uint64_t now, ScanBuffer *sb) {
+    epoch_enter();
+    const SnapshotImage *base = LOAD_PTR(db->base);
+    uint64_t next = base && v < base->mask ? v + 1 : 0;
+    const SnapshotSlot *slot = base && v <= base->mask ? &base->index[v] : NULL;
+    
+    if (slot && slot->offset != 0) {
+        const char *key = base->map + slot->offset + SNAPSHOT_RECORD_HEADER;
+        size_t value_len;
+        uint64_t expires;
+        const char *value = snapshot_find(base, key, slot->key_len, slot->hash,
+                                          &value_len, &expires);
+        Stripe *stripe = stripe_for(db, slot->hash);
+        pthread_mutex_lock(&stripe->lock);
+        if (value && !deadline_passed(expires, now) &&
+            !find_slot(&stripe->chain, key, slot->key_len, slot->hash)) {
+            scan_emit(sb, key, slot->key_len, value, value_len, slot->hash, expires);
+        }
+        if (sb->view && !sb->full) {
+            __atomic_store_n(&sb->view->scan_position, v + 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    epoch_exit();
+    return next;
+}
+
+// Incremental scan over every key, in hash order. Pass *cursor = 0 to
+// start; each call copies about max_records DBScanRecord records into
+// `out`, sets *cursor to where the next call resumes and sets *done once
+// the scan is complete (the cursor is then 0 again). Nothing is allocated
+// and no state is kept between calls.
+//
+// Keys present for the whole scan are returned at least once, even if
+// tables resize in between; a key may repeat after a resize, and keys
+// added or removed during the scan may or may not appear. A bucket's
+// records are returned together, so a call can return a few more than
+// max_records, or fewer when the next bucket doesn't fit in out_size. It
+// returns 0 with *cursor unchanged and *done false if not even the first
+// bucket fits, on the first call as on any other: retry with a larger
+// buffer.
+size_t db_scan(Database *db, uint64_t *cursor, char *out, size_t out_size,
+               size_t max_records, bool *done) {
+    if (!db || !cursor || !out || !done) return 0;
+    
+    ScanBuffer sb = { out, out_size, 0, 0, false, NULL, false };
+    uint64_t now = now_ms();
+    uint64_t c = *cursor;
+    *done = false;
+    // Empty buckets cost a step too; bound them so one call stays short,
+    // but walk on until a record is found so that 0 means none fit
+    size_t steps = max_records * 16 + 64;
+    
+    while (sb.records < max_records && (steps > 0 || sb.records == 0)) {
+        if (steps > 0) steps--;
+        uint64_t phase = c >> SCAN_PHASE_SHIFT, v = c & SCAN_POSITION_MASK, next;
+        if (phase > DB_STRIPES) {
+            c = 0;
+            *done = true;
+            break;
+        }
+        
+        size_t used = sb.used, records = sb.records;
+        if (phase == DB_STRIPES) {
+            next = scan_snapshot_step(db, v, now, &sb);
+        } else {
+            Stripe *stripe = &db->stripes[phase];
+            pthread_mutex_lock(&stripe->lock);
+            next = db->engine == DB_ENGINE_SWISS
+                   ? scan_swiss_step(stripe->swiss, v, now, &sb)
+                   : scan_chain_step(&stripe->chain, v, now, &sb);
+            pthread_mutex_unlock(&stripe->lock);
+        }
+        if (sb.full) {
+            sb.used = used;
+            sb.records = records;
+            // Nothing fit: report no progress, even over empty buckets
+            if (records == 0) c = *cursor;
+            break;
+        }
+        
+        c = next ? (phase << SCAN_PHASE_SHIFT) | next : (phase + 1) << SCAN_PHASE_SHIFT;
+        if (phase == DB_STRIPES && !next) {
+            c = 0;
+            *done = true;
+            break;
+        }
+    }
+    
+    *cursor = c;
+    return sb.records;
+}
+
+// ============================================================================
+// READ VIEWS
+// ============================================================================
+
+// Open a read view of the database as it is now. Every stripe is held
+// just long enough to register the view, so no write is half done; from
+// then on writers save what they overwrite (see views_preserve).
+DBSnapshot* db_snapshot_begin(Database *db) {
+    if (!db) return NULL;
+    
+    DBSnapshot *snap = (DBSnapshot*)calloc(1, sizeof(DBSnapshot));
+    if (!snap) return NULL;
+    snap->db = db;
+    snap->bytes = sizeof(DBSnapshot);
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        pthread_mutex_lock(&db->stripes[i].lock);
+    }
+    snap->now = now_ms();
+    snap->count = db_count(db);
+    snap->next = db->views;
+    db->views = snap;
+    for (size_t i = DB_STRIPES; i-- > 0; ) {
+        pthread_mutex_unlock(&db->stripes[i].lock);
+    }
+    return snap;
+}
+
+// Close a view and free what it saved. Writers stop saving for it once
+// every stripe has been held to unlink it.
+void db_snapshot_end(DBSnapshot *snapshot) {
+    if (!snapshot) return;
+    
+    Database *db = snapshot->db;
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        pthread_mutex_lock(&db->stripes[i].lock);
+    }
+    DBSnapshot **link = &db->views;
+    while (*link != snapshot) link = &(*link)->next;
+    *link = snapshot->next;
+    for (size_t i = DB_STRIPES; i-- > 0; ) {
+        pthread_mutex_unlock(&db->stripes[i].lock);
+    }
+    
+    view_free(snapshot);
+}
+
+// Read `key` as of the view's opening, without locks: a key with a saved
+// version reads from it; any other key hasn't changed since, so the live
+// table has it as it was. A writer saves the version inside its write
+// section, so a live read that raced with one retries and finds it.
+const char* db_snapshot_get_n(DBSnapshot *snapshot, const char *key, size_t key_len,
+                              size_t *value_len) {
+    if (!snapshot || !key || !value_len || key_len >= MAX_KEY_LENGTH) return NULL;
+    
+    Database *db = snapshot->db;
+    uint64_t hash = hash_function(key, key_len), expires;
+    Stripe *stripe = stripe_for(db, hash);
+    const VersionMap *map = &snapshot->maps[stripe - db->stripes];
+    const SavedVersion *version;
+    const char *result;
+    
+    epoch_enter();
+    for (;;) {
+        uint32_t seq = stripe_read_begin(stripe);
+        if ((version = version_find(map, key, key_len, hash)) != NULL) break;
+        if (stripe_read(db, stripe, seq, key, key_len, hash, true, false, &result,
+                        value_len, &expires)) break;
+    }
+    if (version) {
+        *value_len = version->value_len;
+        expires = version->expires;
+        result = version->present ? thread_copy(version->data + key_len + 1, *value_len) : NULL;
+    }
+    epoch_exit();
+    
+    if (LOAD_RELAXED(snapshot->failed)) return NULL;
+    if (result && deadline_passed(expires, snapshot->now)) result = NULL;
+    return result;
+}
+
+const char* db_snapshot_get(DBSnapshot *snapshot, const char *key) {
+    if (!key) return NULL;
+    
+    size_t value_len;
+    return db_snapshot_get_n(snapshot, key, strlen(key), &value_len);
+}
+
+// End the scan's current phase. A stripe's phase ends under its lock, so
+// its writers never see the position reset.
+static void view_scan_next_phase(DBSnapshot *snap, uint64_t phase) {
+    if (phase < DB_STRIPES) __atomic_store_n(&snap->scan_position, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&snap->scan_phase, phase + 1, __ATOMIC_RELEASE);
+    if (phase + 1 == VIEW_PHASE_VERSIONS) {
+        // Versions saved from here on were all passed already
+        snap->scan_map = 0;
+        snap->scan_version = LOAD_PTR(snap->maps[0].first);
+    }
+}
+
+// Move the view's scan on by about max_records records, as db_scan does
+// for its cursor: the live stripes and mapped snapshot without the keys
+// the view has versions of, then the versions the live walk didn't
+// return. Stops before a step that doesn't fit.
+static void view_scan(DBSnapshot *snap, ScanBuffer *sb, size_t max_records) {
+    Database *db = snap->db;
+    size_t steps = max_records * 16 + 64;
+    
+    // As in db_scan, the step bound only applies once a record is found
+    while (sb->records < max_records && (steps > 0 || sb->records == 0)) {
+        if (steps > 0) steps--;
+        uint64_t phase = snap->scan_phase, v = snap->scan_position;
+        if (LOAD_RELAXED(snap->failed)) {
+            __atomic_store_n(&snap->scan_phase, VIEW_PHASE_DONE, __ATOMIC_RELEASE);
+            phase = VIEW_PHASE_DONE;
+        }
+        if (phase == VIEW_PHASE_DONE) break;
+        
+        size_t used = sb->used, records = sb->records;
+        sb->view = snap;
+        if (phase < DB_STRIPES) {
+            Stripe *stripe = &db->stripes[phase];
+            pthread_mutex_lock(&stripe->lock);
+            uint64_t next = db->engine == DB_ENGINE_SWISS
+                            ? scan_swiss_step(stripe->swiss, v, snap->now, sb)
+                            : scan_chain_step(&stripe->chain, v, snap->now, sb);
+            if (!sb->full && next) {
+                __atomic_store_n(&snap->scan_position, next, __ATOMIC_RELEASE);
+            } else if (!sb->full) {
+                view_scan_next_phase(snap, phase);
+            }
+            pthread_mutex_unlock(&stripe->lock);
+        } else if (phase == VIEW_PHASE_BASE) {
+            uint64_t next = scan_snapshot_step(db, v, snap->now, sb);
+            if (!sb->full && next) {
+                __atomic_store_n(&snap->scan_position, next, __ATOMIC_RELEASE);
+            } else if (!sb->full) {
+                view_scan_next_phase(snap, phase);
+            }
+        } else {
+            SavedVersion *version = snap->scan_version;
+            if (!version) {
+                if (++snap->scan_map == DB_STRIPES) {
+                    view_scan_next_phase(snap, phase);
+                } else {
+                    snap->scan_version = LOAD_PTR(snap->maps[snap->scan_map].first);
+                }
+                continue;
+            }
+            if (version->present && !version->emitted &&
+                !deadline_passed(version->expires, snap->now)) {
+                sb->view = NULL;
+                scan_emit(sb, version->data, version->key_len,
+                          version->data + version->key_len + 1, version->value_len,
+                          version->hash, version->expires);
+            }
+            if (!sb->full) snap->scan_version = version->older;
+        }
+        
+        if (sb->full) {
+            sb->used = used;
+            sb->records = records;
+            break;
+        }
+    }
+    sb->view = NULL;
+}
+
+// Scan the view, as db_scan does the database but with the view keeping
+// the cursor: each key present at the opening is returned exactly once,
+// whatever writers do meanwhile. *done turns true once it is complete.
+size_t db_snapshot_scan(DBSnapshot *snapshot, char *out, size_t out_size,
+                        size_t max_records, bool *done) {
+    if (!snapshot || !out || !done) return 0;
+    
+    ScanBuffer sb = { out, out_size, 0, 0, false, NULL, false };
+    view_scan(snapshot, &sb, max_records);
+    *done = snapshot->scan_phase == VIEW_PHASE_DONE;
+    return sb.records;
+}
+
+size_t db_snapshot_count(const DBSnapshot *snapshot) {
+    return snapshot ? snapshot->count : 0;
+}
+
+// Bytes the view holds on to: its versions and their tables
+size_t db_snapshot_memory(const DBSnapshot *snapshot) {
+    return snapshot ? __atomic_load_n(&snapshot->bytes, __ATOMIC_RELAXED) : 0;
+}
+
+bool db_snapshot_ok(const DBSnapshot *snapshot) {
+    return snapshot && !__atomic_load_n(&snapshot->failed, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// ORDERED SCANS
+// ============================================================================
+
+static bool index_visit(void *ctx, const char *key, size_t key_len,
+                        const char *value, size_t value_len, uint64_t hash,
+                        uint64_t expires) {
+    (void)key_len; (void)value; (void)value_len; (void)hash; (void)expires;
+    // Keys are unique, so a failed insert means memory ran out
+    return btree_insert((OrderedIndex*)ctx, key);
+}
+
+// Keep an ordered index of the keys from now on, built from the current
+// contents (mapped snapshot included). Until it is enabled scans return
+// NULL and writers pay nothing; afterwards every insert and delete also
+// updates the index under its write lock. Calling it again is a no-op.
+bool db_enable_ordered_index(Database *db) {
+    if (!db) return false;
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        pthread_mutex_lock(&db->stripes[i].lock);
+    }
+    
+    bool ok = db->index != NULL;
+    if (!ok) {
+        OrderedIndex *index = (OrderedIndex*)calloc(1, sizeof(OrderedIndex));
+        BTreeNode *root = btree_node_create(true);
+        ok = index && root;
+        if (ok) {
+            pthread_rwlock_init(&index->lock, NULL);
+            index->root = root;
+            ok = foreach_locked(db, index_visit, index, now_ms());
+            if (ok) {
+                PUBLISH(db->index, index);
+            } else {
+                index_destroy(index);
+            }
+        } else {
+            free(index);
+            free(root);
+        }
+    }
+    
+    for (size_t i = DB_STRIPES; i-- > 0; ) {
+        pthread_mutex_unlock(&db->stripes[i].lock);
+    }
+    return ok;
+}
+
+static DBCursor* cursor_create(Database *db, const char *start, const char *bound,
+                               bool prefix_mode) {
+    if (!db || !LOAD_PTR(db->index)) return NULL;
+    if (start && strlen(start) >= MAX_KEY_LENGTH) return NULL;
+    if (bound && strlen(bound) >= MAX_KEY_LENGTH) return NULL;
+    
+    DBCursor *cursor = (DBCursor*)calloc(1, sizeof(DBCursor));
+    if (!cursor) return NULL;
+    
+    cursor->db = db;
+    cursor->prefix_mode = prefix_mode;
+    if (start) strcpy(cursor->start, start);
+    if (bound) {
+        strcpy(cursor->bound, bound);
+        cursor->bound_len = strlen(bound);
+        cursor->has_end = true;
+    }
+    return cursor;
+}
+
+// Load the next record into cursor->key and cursor->value. The index lock
+// is held only to step to the next key; the value is then read from the
+// hash table like db_get, and keys deleted in between are skipped.
+static bool cursor_advance(DBCursor *cursor) {
+    OrderedIndex *index = LOAD_PTR(cursor->db->index);
+    
+    while (!cursor->done) {
+        pthread_rwlock_rdlock(&index->lock);
+        
+        if (!cursor->leaf || cursor->version != index->version) {
+            // The tree changed since the last call: find our place again
+            cursor->leaf = cursor->started
+                           ? btree_seek(index, cursor->key, true, &cursor->pos)
+                           : btree_seek(index, cursor->start, false, &cursor->pos);
+            cursor->version = index->version;
+        }
+        while (cursor->leaf && cursor->pos >= cursor->leaf->count) {
+            cursor->leaf = cursor->leaf->next;
+            cursor->pos = 0;
+        }
+        
+        const char *key = cursor->leaf ? cursor->leaf->keys[cursor->pos] : NULL;
+        bool in_range = key && (!cursor->has_end ||
+                                (cursor->prefix_mode
+                                 ? strncmp(key, cursor->bound, cursor->bound_len) == 0
+                                 : strcmp(key, cursor->bound) < 0));
+        if (in_range) {
+            strcpy(cursor->key, key);
+            cursor->pos++;
+            cursor->started = true;
+        }
+        
+        pthread_rwlock_unlock(&index->lock);
+        
+        if (!in_range) {
+            cursor->done = true;
+            break;
+        }
+        
+        size_t key_len = strlen(cursor->key), value_len;
+        const char *value = stripe_lookup(cursor->db, cursor->key, key_len,
+                                          hash_function(cursor->key, key_len), true, &value_len);
+        if (!value) continue;
+        
+        if (value_len + 1 > cursor->value_cap) {
+            size_t cap = cursor->value_cap ? cursor->value_cap : 64;
+            while (cap < value_len + 1) cap *= 2;
+            char *grown = (char*)realloc(cursor->value, cap);
+            if (!grown) return false;
+            cursor->value = grown;
+            cursor->value_cap = cap;
+        }
+        memcpy(cursor->value, value, value_len + 1);
+        cursor->value_len = value_len;
+        return true;
+    }
+    
+    return false;
+}
+
+// Open a cursor over every key starting with `prefix`, in key order (byte
+// order, as strcmp). Returns NULL if the ordered index isn't enabled.
+DBCursor* db_scan_prefix(Database *db, const char *prefix) {
+    if (!prefix) return NULL;
+    return cursor_create(db, prefix, prefix, true);
+}
+
+// Open a cursor over keys in [start, end), in key order. NULL for either
+// bound leaves that side open. Returns NULL if the ordered index isn't
+// enabled.
+DBCursor* db_scan_range(Database *db, const char *start, const char *end) {
+    return cursor_create(db, start, end, false);
+}
+
+// Step to the next record. key and value point into the cursor and stay
+// valid until the next call on it. Like db_get, this reuses the calling
+// thread's db_get buffer. The cursor sees changes made while it is open
+// from its current position onward, and costs O(log n) per record only
+// after the index changed under it; otherwise each step is O(1).
+bool db_cursor_next(DBCursor *cursor, const char **key, const char **value) {
+    if (!cursor) return false;
+    if (!cursor->pending && !cursor_advance(cursor)) return false;
+    
+    cursor->pending = false;
+    if (key) *key = cursor->key;
+    if (value) *value = cursor->value;
+    return true;
+}
+
+// Fetch up to max_records DBScanRecord records into `out`, back to back.
+// Returns the number fetched; *done turns true once the scan has run out.
+// A record that didn't fit is returned by the next call, so 0 with *done
+// false means `out` is too small for it.
+size_t db_cursor_fetch(DBCursor *cursor, char *out, size_t out_size, size_t max_records,
+                       bool *done) {
+    if (!cursor || !out || !done) return 0;
+    
+    size_t fetched = 0, used = 0;
+    while (fetched < max_records) {
+        if (!cursor->pending && !cursor_advance(cursor)) break;
+        cursor->pending = true;
+        
+        size_t key_len = strlen(cursor->key), value_len = cursor->value_len;
+        if (used + DB_SCAN_RECORD_SIZE(key_len, value_len) > out_size) break;
+        used += scan_put_record(out + used, cursor->key, key_len, cursor->value, value_len);
+        cursor->pending = false;
+        fetched++;
+    }
+    
+    *done = cursor->done;
+    return fetched;
+}
+
+// Continue the scan after `key`, typically the last key of the previous
+// page. Keys before the scan's start still aren't returned.
+void db_cursor_seek_after(DBCursor *cursor, const char *key) {
+    if (!cursor || !key || strlen(key) >= MAX_KEY_LENGTH) return;
+    
+    cursor->started = strcmp(key, cursor->start) >= 0;
+    if (cursor->started) strcpy(cursor->key, key);
+    cursor->leaf = NULL;
+    cursor->pending = false;
+    cursor->done = false;
+}
+
+// Close a cursor
+void db_cursor_close(DBCursor *cursor) {
+    if (cursor) free(cursor->value);
+    free(cursor);
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+// `path` with ".tmp" appended: snapshots are written there, then renamed
+static char* snapshot_tmp_path(const char *path) {
+    size_t path_len = strlen(path);
+    char *tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return NULL;
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+    return tmp_path;
+}
+
+// Write every live key's record to `tmp_path`, filling in w's index. All
+// stripe locks must be held.
+static bool snapshot_visit(void *ctx, const char *key, size_t key_len,
+                           const char *value, size_t value_len, uint64_t hash,
+                           uint64_t expires) {
+    SnapshotWriter *w = (SnapshotWriter*)ctx;
+    snapshot_emit(w, key, key_len, value, value_len, hash, expires);
+    return w->ok;
+}
+
+static void snapshot_collect(Database *db, SnapshotWriter *w, const char *tmp_path) {
+    size_t slots = snapshot_slots(db_count(db));
+    *w = (SnapshotWriter){ fopen(tmp_path, "wb"), NULL, slots - 1, sizeof(SnapshotHeader), 0, true };
+    w->index = (SnapshotSlot*)calloc(slots, sizeof(SnapshotSlot));
+    w->ok = slots != 0 && w->fp && w->index &&
+            fseek(w->fp, sizeof(SnapshotHeader), SEEK_SET) == 0;
+    
+    if (w->ok) foreach_locked(db, snapshot_visit, w, now_ms());
+}
+
+// Append the index and header, sync, and rename the file over `path`.
+// Needs no locks; releases the writer either way.
+static bool snapshot_commit(SnapshotWriter *w, const char *tmp_path, const char *path) {
+    size_t slots = w->mask + 1;
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+    header.version = SNAPSHOT_VERSION;
+    header.hash_id = SNAPSHOT_HASH_ID;
+    header.count = w->count;
+    header.index_offset = w->offset;
+    header.index_slots = slots;
+    header.file_size = w->offset + slots * sizeof(SnapshotSlot);
+    
+    w->ok = w->ok &&
+            fwrite(w->index, sizeof(SnapshotSlot), slots, w->fp) == slots &&
+            fseek(w->fp, 0, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof(header), 1, w->fp) == 1 &&
+            fflush(w->fp) == 0 &&
+            fsync(fileno(w->fp)) == 0;
+    if (w->fp && fclose(w->fp) != 0) w->ok = false;
+    w->ok = w->ok && rename(tmp_path, path) == 0;
+    
+    if (!w->ok) remove(tmp_path);
+    free(w->index);
+    return w->ok;
+}
+
+// Write the keys of a view to `path` as a snapshot image, consuming its
+// scan. The file is written next to `path` and renamed over it once
+// complete and synced, so a crash never leaves a torn snapshot. Only the
+// few writers that meet the scan wait, briefly, for a stripe lock.
+bool db_snapshot_save(DBSnapshot *snapshot, const char *path) {
+    if (!snapshot || !path || snapshot->scan_phase != 0 || snapshot->scan_position != 0) {
+        return false;
+    }
+    
+    char *tmp_path = snapshot_tmp_path(path);
+    if (!tmp_path) return false;
+    
+    size_t slots = snapshot_slots(snapshot->count);
+    SnapshotWriter w = { fopen(tmp_path, "wb"), NULL, slots - 1, sizeof(SnapshotHeader), 0, true };
+    w.index = (SnapshotSlot*)calloc(slots, sizeof(SnapshotSlot));
+    size_t cap = SAVE_BUFFER_BYTES;
+    char *buf = (char*)malloc(cap);
+    w.ok = slots != 0 && w.fp && w.index && buf && fseek(w.fp, sizeof(SnapshotHeader), SEEK_SET) == 0;
+    
+    while (w.ok && snapshot->scan_phase != VIEW_PHASE_DONE) {
+        ScanBuffer sb = { buf, cap, 0, 0, false, NULL, true };
+        view_scan(snapshot, &sb, cap / 64);
+        
+        const char *record = buf;
+        for (size_t i = 0; i < sb.records && w.ok; i++) {
+            ScanMeta meta;
+            DBScanRecord header;
+            memcpy(&meta, record, sizeof(meta));
+            memcpy(&header, record + sizeof(meta), sizeof(header));
+            const char *key = record + sizeof(meta) + sizeof(header);
+            snapshot_emit(&w, key, header.key_len, key + header.key_len + 1, header.value_len,
+                          meta.hash, meta.expires);
+            record += sizeof(meta) + DB_SCAN_RECORD_SIZE(header.key_len, header.value_len);
+        }
+        
+        // A value bigger than the buffer: grow it and take the step again
+        if (sb.records == 0 && snapshot->scan_phase != VIEW_PHASE_DONE) {
+            char *grown = (char*)realloc(buf, cap * 2);
+            w.ok = grown != NULL;
+            if (grown) {
+                buf = grown;
+                cap *= 2;
+            }
+        }
+    }
+    w.ok = w.ok && !LOAD_RELAXED(snapshot->failed);
+    free(buf);
+    
+    bool ok = snapshot_commit(&w, tmp_path, path);
+    free(tmp_path);
+    return ok;
+}
+
+// Write every live key to `path` as a snapshot image, from a read view
+// opened for the purpose: the image holds the database as it was when the
+// call began, and neither readers nor writers are held up while it is
+// written.
+bool db_save(Database *db, const char *path) {
+    if (!db || !path) return false;
+    
+    DBSnapshot *snapshot = db_snapshot_begin(db);
+    if (!snapshot) return false;
+    
+    bool ok = db_snapshot_save(snapshot, path);
+    db_snapshot_end(snapshot);
+    return ok;
+}
+
+static void* save_main(void *arg) {
+    SaveJob *job = (SaveJob*)arg;
+    job->ok = db_snapshot_save(job->snapshot, job->path);
+    return NULL;
+}
+
+// db_save on a thread of its own. The view is opened before returning, so
+// the image holds the database as of this call, however long the write
+// takes. One save at a time: false while the previous one is still to be
+// collected with db_save_wait.
+bool db_save_background(Database *db, const char *path) {
+    if (!db || !path) return false;
+    
+    DBSnapshot *snapshot = db_snapshot_begin(db);
+    if (!snapshot) return false;
+    
+    pthread_mutex_lock(&db->save_lock);
+    SaveJob *job = db->save ? NULL : (SaveJob*)calloc(1, sizeof(SaveJob));
+    bool ok = job && (job->path = strdup(path)) != NULL;
+    if (ok) {
+        job->snapshot = snapshot;
+        ok = pthread_create(&job->thread, NULL, save_main, job) == 0;
+    }
+    if (ok) {
+        db->save = job;
+    } else if (job) {
+        free(job->path);
+        free(job);
+    }
+    pthread_mutex_unlock(&db->save_lock);
+    
+    if (!ok) db_snapshot_end(snapshot);
+    return ok;
+}
+
+// Wait for the db_save_background in progress. Returns whether it wrote
+// its image; false too if none was started.
+bool db_save_wait(Database *db) {
+    if (!db) return false;
+    
+    pthread_mutex_lock(&db->save_lock);
+    SaveJob *job = db->save;
+    db->save = NULL;
+    pthread_mutex_unlock(&db->save_lock);
+    if (!job) return false;
+    
+    pthread_join(job->thread, NULL);
+    db_snapshot_end(job->snapshot);
+    bool ok = job->ok;
+    free(job->path);
+    free(job);
+    return ok;
+}
+
+// Open a snapshot written by db_save. The file is mapped, not read: lookups
+// are served from the mapping, so opening costs the same for any size.
+// Changes go to an in-memory overlay (chained engine) and reach the file
+// only through the next db_save.
+Database* db_open_mmap(const char *path) {
+    if (!path) return NULL;
+    
+    SnapshotImage *image = snapshot_map(path);
+    if (!image) return NULL;
+    
+    Database *db = db_create();
+    if (!db) {
+        snapshot_close(image);
+        return NULL;
+    }
+    
+    db->base = image;
+    return db;
+}
+
+// Apply the records in an open log to db and return the length of the
+// valid prefix. Replay stops at the first record that is truncated or fails
+// its checksum: that is where a crash interrupted the last write.
+static off_t wal_replay(Database *db, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    if (st.st_size == 0) return 0;
+    
+    size_t size = (size_t)st.st_size;
+    const char *map = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+    madvise((void*)map, size, MADV_SEQUENTIAL);
+    
+    size_t pos = 0;
+    while (size - pos >= WAL_RECORD_HEADER) {
+        const char *record = map + pos;
+        uint32_t checksum, lengths[2];
+        memcpy(&checksum, record, sizeof(checksum));
+        memcpy(lengths, record + 4, sizeof(lengths));
+        uint8_t op = (uint8_t)record[12];
+        
+        if (lengths[0] >= MAX_KEY_LENGTH || lengths[1] > MAX_VALUE_LIMIT ||
+            size - pos - WAL_RECORD_HEADER < (size_t)lengths[0] + lengths[1]) break;
+        
+        const char *data = record + WAL_RECORD_HEADER;
+        char header[WAL_RECORD_HEADER];
+        wal_record_header(header, op, data, lengths[0], NULL, data + lengths[0], lengths[1]);
+        if (memcmp(header, record, WAL_RECORD_HEADER) != 0) break;
+        
+        // Keys and values are applied straight from the mapping; the value
+        // limit is a write-time policy, so whatever was logged replays
+        const char *key = data, *value = data + lengths[0];
+        uint64_t unused = 0;
+        if (op == WAL_OP_SET) {
+            stripe_set(db, key, lengths[0], value, lengths[1],
+                       hash_function(key, lengths[0]), 0, &unused);
+        } else if (op == WAL_OP_SET_EX && lengths[1] >= sizeof(uint64_t)) {
+            // A deadline that passed while the database was down still
+            // replays; the key just reads as missing until it is reaped
+            uint64_t expires;
+            memcpy(&expires, value, sizeof(expires));
+            stripe_set(db, key, lengths[0], value + sizeof(expires),
+                       lengths[1] - sizeof(expires), hash_function(key, lengths[0]),
+                       expires, &unused);
+        } else if (op == WAL_OP_DELETE) {
+            stripe_delete(db, key, lengths[0], hash_function(key, lengths[0]), &unused);
+        } else if (op == WAL_OP_CLEAR) {
+            db_clear(db);
+        } else {
+            break;
+        }
+        pos += WAL_RECORD_HEADER + lengths[0] + lengths[1];
+    }
+    
+    munmap((void*)map, size);
+    return (off_t)pos;
+}
+
+// Replay the log at `path` (created if missing) into db, then log every
+// later change to it. Changes are buffered and written by a background
+// thread in groups: one write and fdatasync per flush_interval_us or
+// batch_bytes, whichever comes first. Without wait_durable a crash can lose
+// the last window of changes; with it, writers return only once their
+// change is synced. config may be NULL for the defaults.
+//
+// Call before other threads use db. To recover a compacted database, open
+// its snapshot with db_open_mmap and then the log with db_wal_open.
+bool db_wal_open(Database *db, const char *path, const DBWalConfig *config) {
+    if (!db || !path || db->wal) return false;
+    
+    WalLog *wal = (WalLog*)calloc(1, sizeof(WalLog));
+    if (!wal) return false;
+    if (config) wal->config = *config;
+    if (wal->config.flush_interval_us == 0) wal->config.flush_interval_us = WAL_FLUSH_INTERVAL_US;
+    if (wal->config.batch_bytes == 0) wal->config.batch_bytes = WAL_BATCH_BYTES;
+    
+    wal->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (wal->fd < 0) {
+        free(wal);
+        return false;
+    }
+    
+    // db->wal is still NULL, so replayed changes aren't logged again
+    off_t valid = wal_replay(db, wal->fd);
+    bool ok = valid >= 0 && ftruncate(wal->fd, valid) == 0;
+    
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->work, NULL);
+    pthread_cond_init(&wal->synced_cond, NULL);
+    ok = ok && pthread_create(&wal->flusher, NULL, wal_flusher, wal) == 0;
+    
+    if (!ok) {
+        pthread_cond_destroy(&wal->synced_cond);
+        pthread_cond_destroy(&wal->work);
+        pthread_mutex_destroy(&wal->lock);
+        close(wal->fd);
+        free(wal);
+        return false;
+    }
+    
+    db->wal = wal;
+    return true;
+}
+
+// Flush and sync everything logged so far, without waiting for the group
+// window. Returns false if there is no log or it failed.
+bool db_wal_sync(Database *db) {
+    if (!db || !db->wal) return false;
+    
+    WalLog *wal = db->wal;
+    pthread_mutex_lock(&wal->lock);
+    uint64_t target = wal->appended;
+    if (target > wal->urgent) wal->urgent = target;
+    pthread_cond_signal(&wal->work);
+    pthread_mutex_unlock(&wal->lock);
+    
+    return wal_wait(wal, target);
+}
+
+// Flush what is buffered, stop the flusher and close the log. No other
+// thread may be using db. db_destroy calls this.
+void db_wal_close(Database *db) {
+    if (!db || !db->wal) return;
+    
+    WalLog *wal = db->wal;
+    pthread_mutex_lock(&wal->lock);
+    wal->closing = true;
+    pthread_cond_signal(&wal->work);
+    pthread_mutex_unlock(&wal->lock);
+    pthread_join(wal->flusher, NULL);
+    
+    close(wal->fd);
+    pthread_cond_destroy(&wal->synced_cond);
+    pthread_cond_destroy(&wal->work);
+    pthread_mutex_destroy(&wal->lock);
+    free(wal->buf);
+    free(wal->spare);
+    free(wal);
+    db->wal = NULL;
+}
+
+// Fold the log into a new snapshot: write every live key to `snapshot_path`
+// as db_save does, then empty the log. Writers wait until both are done, so
+// nothing is logged between the two. A crash in between leaves the new
+// snapshot and the old log, and replaying a log over a snapshot that already
+// holds its changes gives the same result. Without a log this is db_save.
+bool db_compact(Database *db, const char *snapshot_path) {
+    if (!db || !snapshot_path) return false;
+    
+    char *tmp_path = snapshot_tmp_path(snapshot_path);
+    if (!tmp_path) return false;
+    
+    for (size_t i = 0; i < DB_STRIPES; i++) {
+        pthread_mutex_lock(&db->stripes[i].lock);
+    }
+    
+    SnapshotWriter w;
+    snapshot_collect(db, &w, tmp_path);
+    bool ok = snapshot_commit(&w, tmp_path, snapshot_path);
+    
+    WalLog *wal = db->wal;
+    if (ok && wal) {
+        pthread_mutex_lock(&wal->lock);
+        // A write in flight would land after the truncation, torn
+        while (wal->flushing) pthread_cond_wait(&wal->synced_cond, &wal->lock);
+        // Buffered records are in the snapshot too. They are left for the
+        // flusher: replaying them is harmless, and the log stays complete
+        // if the truncation doesn't reach the disk.
+        ok = ftruncate(wal->fd, 0) == 0;
+        pthread_mutex_unlock(&wal->lock);
+    }
+    
+    for (size_t i = DB_STRIPES; i-- > 0; ) {
+        pthread_mutex_unlock(&db->stripes[i].lock);
+    }
+    
+    free(tmp_path);
+    return ok;
+}
+
+// ============================================================================
+// SHARDED DATABASE
+// ============================================================================
+//
+// The keyspace is split across N Databases, each owned by one thread pinned
+// to its own core. Callers never touch a shard: they hand it requests over
+// a SPSC queue (one per client handle and shard) and wait for completion,
+// so shards share nothing on the hot path: no lock, counter or cache line
+// is written by two cores. Batches are split by shard, queued on all of
+// them before waiting, and gathered back in the caller's order.
+//
+// Idle threads on either side poll for a while, then park on a condition
+// variable; on a single CPU they park at once, since polling would only
+// keep the other side from running.
+
+static void parker_init(Parker *parker) {
+    parker->sleeping = 0;
+    pthread_mutex_init(&parker->lock, NULL);
+    pthread_cond_init(&parker->wake, NULL);
+}
+
+static void parker_destroy(Parker *parker) {
+    pthread_cond_destroy(&parker->wake);
+    pthread_mutex_destroy(&parker->lock);
+}
+
+// Block until woken, unless ready(arg) already holds once sleeping is set
+static void parker_wait(Parker *parker, bool (*ready)(void *arg), void *arg) {
+    __atomic_store_n(&parker->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (ready(arg)) {
+        __atomic_store_n(&parker->sleeping, 0, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    pthread_mutex_lock(&parker->lock);
+    while (__atomic_load_n(&parker->sleeping, __ATOMIC_RELAXED)) {
+        pthread_cond_wait(&parker->wake, &parker->lock);
+    }
+    pthread_mutex_unlock(&parker->lock);
+}
+
+// Wake a parked thread after publishing work for it. Costs one fence and
+// one load when it isn't parked.
+static void parker_wake(Parker *parker) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&parker->sleeping, __ATOMIC_RELAXED)) return;
+    
+    pthread_mutex_lock(&parker->lock);
+    __atomic_store_n(&parker->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_cond_signal(&parker->wake);
+    pthread_mutex_unlock(&parker->lock);
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Producer side: claim the next slot, waiting while the ring is full
+static ShardRequest* spsc_reserve(SpscQueue *queue, Parker *consumer) {
+    size_t tail = queue->tail;
+    while (tail - queue->head_cache >= SHARD_QUEUE_SLOTS) {
+        queue->head_cache = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (tail - queue->head_cache >= SHARD_QUEUE_SLOTS) {
+            parker_wake(consumer);
+            sched_yield();
+        }
+    }
+    return &queue->slots[tail & (SHARD_QUEUE_SLOTS - 1)];
+}
+
+static inline void spsc_publish(SpscQueue *queue) {
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+// Consumer side: the oldest request, or NULL if the ring is empty
+static inline ShardRequest* spsc_front(SpscQueue *queue) {
+    size_t head = queue->head;
+    if (head == queue->tail_cache) {
+        queue->tail_cache = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        if (head == queue->tail_cache) return NULL;
+    }
+    return &queue->slots[head & (SHARD_QUEUE_SLOTS - 1)];
+}
+
+static inline void spsc_pop(SpscQueue *queue) {
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+}
+
+// Shard of a key. The multiplier differs from stripe_for's, so keys of one
+// shard still spread over all of its stripes.
+static inline size_t shard_for(const ShardedDatabase *sdb, uint64_t hash) {
+    uint64_t mixed = (hash * 0xD6E8FEB86659FD93ull) >> 32;
+    return (size_t)((mixed * sdb->count) >> 32);
+}
+
+static void shard_complete(DBShardClient *client) {
+    if (__atomic_sub_fetch(&client->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        parker_wake(&client->parker);
+    }
+}
+
+// Append a found value to an SHARD_MGET batch. Out of memory, the key is
+// reported missing.
+static bool batch_append_value(ShardBatch *batch, const char *value, size_t len) {
+    if (batch->values_len + len > batch->values_cap) {
+        size_t cap = batch->values_cap ? batch->values_cap : 4096;
+        while (cap < batch->values_len + len) cap *= 2;
+        char *values = (char*)realloc(batch->values, cap);
+        if (!values) return false;
+        batch->values = values;
+        batch->values_cap = cap;
+    }
+    memcpy(batch->values + batch->values_len, value, len);
+    batch->values_len += len;
+    return true;
+}
+
+// Run one request against the shard's own Database
+static long shard_execute(Shard *shard, ShardRequest *req) {
+    Database *db = shard->db;
+    ShardBatch *batch = req->batch;
+    uint64_t lsn = 0;
+    size_t len, done = 0;
+    
+    switch (req->op) {
+        case SHARD_SET:
+            return db_store(db, req->key, req->key_len, req->value, req->value_len,
+                            req->hash, 0);
+        
+        case SHARD_GET: {
+            const char *value = counted_lookup(db, req->key, req->key_len, req->hash, &len);
+            if (!value) return -1;
+            if (req->buf && req->size > 0) {
+                size_t n = len < req->size - 1 ? len : req->size - 1;
+                memcpy(req->buf, value, n);
+                req->buf[n] = '\0';
+            }
+            return (long)len;
+        }
+        
+        case SHARD_DELETE:
+            return counted_delete(db, req->key, req->key_len, req->hash, &lsn) &&
+                   wal_durable(db, lsn);
+        
+        case SHARD_MSET: {
+            size_t max_value_len = LOAD_RELAXED(db->max_value_len);
+            for (size_t i = 0; i < batch->len; i++) {
+                ShardKey *k = &batch->keys[i];
+                if (k->key_len >= MAX_KEY_LENGTH || k->value_len > max_value_len) continue;
+                if (counted_set(db, k->key, k->key_len, k->value, k->value_len, k->hash, 0,
+                                &lsn)) done++;
+            }
+            return wal_durable(db, lsn) ? (long)done : 0;
+        }
+        
+        case SHARD_MGET:
+            for (size_t base = 0; base < batch->len; base += BATCH_WINDOW) {
+                size_t end = base + BATCH_WINDOW < batch->len ? base + BATCH_WINDOW : batch->len;
+                epoch_enter();
+                for (size_t i = base; i < end; i++) stripe_prefetch(db, batch->keys[i].hash);
+                epoch_exit();
+                
+                for (size_t i = base; i < end; i++) {
+                    ShardKey *k = &batch->keys[i];
+                    const char *value = counted_lookup(db, k->key, k->key_len, k->hash, &len);
+                    bool kept = value && batch_append_value(batch, value, len);
+                    req->lengths[k->index] = kept ? (long)len : -1;
+                }
+            }
+            return 0;
+        
+        case SHARD_MDELETE:
+            for (size_t i = 0; i < batch->len; i++) {
+                ShardKey *k = &batch->keys[i];
+                if (k->key_len < MAX_KEY_LENGTH &&
+                    counted_delete(db, k->key, k->key_len, k->hash, &lsn)) done++;
+            }
+            return wal_durable(db, lsn) ? (long)done : 0;
+    }
+    return 0;
+}
+
+static bool shard_has_work(void *arg) {
+    Shard *shard = (Shard*)arg;
+    ShardedDatabase *sdb = shard->owner;
+    
+    if (__atomic_load_n(&sdb->stop, __ATOMIC_RELAXED)) return true;
+    size_t slots = __atomic_load_n(&sdb->client_slots, __ATOMIC_ACQUIRE);
+    for (size_t c = 0; c < slots; c++) {
+        if (spsc_front(shard->queues[c])) return true;
+    }
+    return false;
+}
+
+// Best effort: with more shards than CPUs they share cores round-robin
+static void shard_pin(size_t index) {
+#ifdef __linux__
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 1) return;
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % (size_t)cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+#endif
+}
+
+// Shard thread: drain every client queue in turn, park when all are empty
+static void* shard_main(void *arg) {
+    Shard *shard = (Shard*)arg;
+    ShardedDatabase *sdb = shard->owner;
+    shard_pin(shard->index);
+    
+    for (int idle = 0; ; ) {
+        size_t served = 0;
+        size_t slots = __atomic_load_n(&sdb->client_slots, __ATOMIC_ACQUIRE);
+        for (size_t c = 0; c < slots; c++) {
+            SpscQueue *queue = shard->queues[c];
+            ShardRequest *req;
+            while ((req = spsc_front(queue))) {
+                DBShardClient *client = req->client;
+                *req->result = shard_execute(shard, req);
+                spsc_pop(queue);
+                shard_complete(client);
+                served++;
+            }
+        }
+        
+        if (served) {
+            idle = 0;
+        } else if (__atomic_load_n(&sdb->stop, __ATOMIC_RELAXED)) {
+            break;
+        } else if (++idle < sdb->spin) {
+            cpu_relax();
+        } else {
+            idle = 0;
+            parker_wait(&shard->parker, shard_has_work, shard);
+        }
+    }
+    
+    return NULL;
+}
+
+// Queue a request on a shard. The caller counts it in client->pending first.
+static void shard_submit(DBShardClient *client, size_t index, const ShardRequest *req) {
+    Shard *shard = &client->sdb->shards[index];
+    SpscQueue *queue = shard->queues[client->slot];
+    
+    ShardRequest *slot = spsc_reserve(queue, &shard->parker);
+    *slot = *req;
+    slot->client = client;
+    spsc_publish(queue);
+    parker_wake(&shard->parker);
+}
+
+static bool client_done(void *arg) {
+    DBShardClient *client = (DBShardClient*)arg;
+    return __atomic_load_n(&client->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+// Wait for every request the client has queued
+static void client_wait(DBShardClient *client) {
+    int spins = 0;
+    while (!client_done(client)) {
+        if (spins++ < client->sdb->spin) {
+            cpu_relax();
+        } else {
+            parker_wait(&client->parker, client_done, client);
+        }
+    }
+}
+
+// Run one single-key request and wait for its result
+static long client_call(DBShardClient *client, ShardRequest *req) {
+    long result = 0;
+    req->result = &result;
+    req->hash = hash_function(req->key, req->key_len);
+    
+    client->pending = 1;
+    shard_submit(client, shard_for(client->sdb, req->hash), req);
+    client_wait(client);
+    return result;
+}
+
+// Split n packed keys (and, for SHARD_MSET, values) by shard, queue one
+// request on every shard that got any and wait for all of them. Results
+// land in results[shard]; returns false if out of memory.
+static bool client_fan_out(DBShardClient *client, ShardOp op, const char *keys,
+                           const char *values, size_t n, long *lengths, long *results) {
+    ShardedDatabase *sdb = client->sdb;
+    
+    if (n > client->route_cap) {
+        uint32_t *route = (uint32_t*)realloc(client->route, n * sizeof(uint32_t));
+        if (!route) return false;
+        client->route = route;
+        client->route_cap = n;
+    }
+    for (size_t s = 0; s < sdb->count; s++) {
+        client->batches[s].len = 0;
+        client->batches[s].values_len = 0;
+        client->batches[s].gathered = 0;
+    }
+    
+    for (size_t i = 0; i < n; i++) {
+        ShardKey k = { keys, NULL, strlen(keys), 0, 0, i };
+        keys += k.key_len + 1;
+        k.hash = hash_function(k.key, k.key_len);
+        if (values) {
+            k.value = values;
+            k.value_len = strlen(values);
+            values += k.value_len + 1;
+        }
+        
+        uint32_t s = (uint32_t)shard_for(sdb, k.hash);
+        ShardBatch *batch = &client->batches[s];
+        if (batch->len == batch->cap) {
+            size_t cap = batch->cap ? batch->cap * 2 : 64;
+            ShardKey *grown = (ShardKey*)realloc(batch->keys, cap * sizeof(ShardKey));
+            if (!grown) return false;
+            batch->keys = grown;
+            batch->cap = cap;
+        }
+        batch->keys[batch->len++] = k;
+        client->route[i] = s;
+    }
+    
+    uint32_t queued = 0;
+    for (size_t s = 0; s < sdb->count; s++) {
+        results[s] = 0;
+        if (client->batches[s].len) queued++;
+    }
+    client->pending = queued;
+    for (size_t s = 0; s < sdb->count; s++) {
+        if (!client->batches[s].len) continue;
+        ShardRequest req = { .op = op, .batch = &client->batches[s], .lengths = lengths,
+                             .result = &results[s] };
+        shard_submit(client, s, &req);
+    }
+    client_wait(client);
+    return true;
+}
+
+// Sum of per-shard results of a batch; results has one slot per shard
+static size_t client_batch(DBShardClient *client, ShardOp op, const char *keys,
+                           const char *values, size_t n, long *lengths) {
+    long *results = (long*)malloc(client->sdb->count * sizeof(long));
+    size_t total = 0;
+    
+    if (results && client_fan_out(client, op, keys, values, n, lengths, results)) {
+        for (size_t s = 0; s < client->sdb->count; s++) total += (size_t)results[s];
+    }
+    free(results);
+    return total;
+}
+
+static void client_free(DBShardClient *client, size_t shards) {
+    if (!client) return;
+    
+    for (size_t s = 0; client->batches && s < shards; s++) {
+        free(client->batches[s].keys);
+        free(client->batches[s].values);
+    }
+    free(client->batches);
+    free(client->route);
+    parker_destroy(&client->parker);
+    free(client);
+}
+
+// Create a database split into `shards` shards (0: one per online CPU),
+// each with its own thread. `capacity` is the expected total number of
+// keys, spread evenly over the shards.
+ShardedDatabase* db_sharded_create(DBEngine engine, size_t shards, size_t capacity) {
+    if (shards == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        shards = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (shards > UINT32_MAX) return NULL;
+    
+    ShardedDatabase *sdb = (ShardedDatabase*)calloc(1, sizeof(ShardedDatabase));
+    if (!sdb) return NULL;
+    
+    sdb->shards = (Shard*)aligned_alloc(CACHE_LINE, shards * sizeof(Shard));
+    if (!sdb->shards) {
+        free(sdb);
+        return NULL;
+    }
+    memset(sdb->shards, 0, shards * sizeof(Shard));
+    sdb->count = shards;
+    sdb->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHARD_SPIN : 0;
+    pthread_mutex_init(&sdb->clients_lock, NULL);
+    
+    bool ok = true;
+    for (size_t i = 0; i < shards; i++) {
+        Shard *shard = &sdb->shards[i];
+        shard->owner = sdb;
+        shard->index = i;
+        parker_init(&shard->parker);
+        shard->db = db_create_ex(engine, (capacity + shards - 1) / shards);
+        ok = ok && shard->db &&
+             (shard->started = pthread_create(&shard->thread, NULL, shard_main, shard) == 0);
+    }
+    
+    if (!ok) {
+        db_sharded_destroy(sdb);
+        return NULL;
+    }
+    return sdb;
+}
+
+// Stop the shard threads and free everything, client handles included.
+// No client may be in a call.
+void db_sharded_destroy(ShardedDatabase *sdb) {
+    if (!sdb) return;
+    
+    __atomic_store_n(&sdb->stop, 1, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < sdb->count; i++) {
+        Shard *shard = &sdb->shards[i];
+        if (shard->started) {
+            parker_wake(&shard->parker);
+            pthread_join(shard->thread, NULL);
+        }
+    }
+    
+    for (size_t c = 0; c < sdb->client_slots; c++) {
+        client_free(sdb->clients[c], sdb->count);
+    }
+    for (size_t i = 0; i < sdb->count; i++) {
+        Shard *shard = &sdb->shards[i];
+        for (size_t c = 0; c < sdb->client_slots; c++) free(shard->queues[c]);
+        parker_destroy(&shard->parker);
+        db_destroy(shard->db);
+    }
+    
+    pthread_mutex_destroy(&sdb->clients_lock);
+    free(sdb->shards);
+    free(sdb);
+}
+
+// Open a handle for the calling thread. Returns NULL once
+// SHARD_MAX_CLIENTS handles are open, or out of memory.
+DBShardClient* db_sharded_client_open(ShardedDatabase *sdb) {
+    if (!sdb) return NULL;
+    
+    pthread_mutex_lock(&sdb->clients_lock);
+    DBShardClient *client = NULL;
+    for (size_t c = 0; c < sdb->client_slots && !client; c++) {
+        if (!sdb->clients[c]->open) client = sdb->clients[c];
+    }
+    
+    size_t slot = sdb->client_slots;
+    if (!client && slot < SHARD_MAX_CLIENTS) {
+        client = (DBShardClient*)calloc(1, sizeof(DBShardClient));
+        if (client) {
+            client->sdb = sdb;
+            client->slot = slot;
+            parker_init(&client->parker);
+            client->batches = (ShardBatch*)calloc(sdb->count, sizeof(ShardBatch));
+        }
+        
+        // The slot's queues exist before the shards are told about it
+        bool ok = client && client->batches;
+        for (size_t i = 0; ok && i < sdb->count; i++) {
+            SpscQueue *queue = (SpscQueue*)aligned_alloc(CACHE_LINE, sizeof(SpscQueue));
+            if (queue) memset(queue, 0, sizeof(SpscQueue));
+            sdb->shards[i].queues[slot] = queue;
+            ok = queue != NULL;
+        }
+        
+        if (ok) {
+            sdb->clients[slot] = client;
+            __atomic_store_n(&sdb->client_slots, slot + 1, __ATOMIC_RELEASE);
+        } else {
+            for (size_t i = 0; i < sdb->count; i++) {
+                free(sdb->shards[i].queues[slot]);
+                sdb->shards[i].queues[slot] = NULL;
+            }
+            client_free(client, sdb->count);
+            client = NULL;
+        }
+    }
+    
+    if (client) client->open = true;
+    pthread_mutex_unlock(&sdb->clients_lock);
+    return client;
+}
+
+// Give a handle back; a later db_sharded_client_open may reuse it
+void db_sharded_client_close(DBShardClient *client) {
+    if (!client) return;
+    
+    pthread_mutex_lock(&client->sdb->clients_lock);
+    client->open = false;
+    pthread_mutex_unlock(&client->sdb->clients_lock);
+}
+
+// Insert or update a key (lengths as db_set_n)
+bool db_sharded_set(DBShardClient *client, const char *key, size_t key_len,
+                    const char *value, size_t value_len) {
+    if (!client || !key || (!value && value_len > 0)) return false;
+    if (key_len >= MAX_KEY_LENGTH || memchr(key, '\0', key_len)) return false;
+    
+    ShardRequest req = { .op = SHARD_SET, .key = key, .key_len = key_len,
+                         .value = value ? value : "", .value_len = value_len };
+    return client_call(client, &req) != 0;
+}
+
+// Copy a value into buf as db_get_copy does. Returns the full value
+// length, or -1 if not found.
+long db_sharded_get(DBShardClient *client, const char *key, size_t key_len,
+                    char *buf, size_t size) {
+    if (!client || !key || key_len >= MAX_KEY_LENGTH) return -1;
+    
+    ShardRequest req = { .op = SHARD_GET, .key = key, .key_len = key_len,
+                         .buf = buf, .size = size };
+    return client_call(client, &req);
+}
+
+// Delete a key; false if it wasn't there
+bool db_sharded_delete(DBShardClient *client, const char *key, size_t key_len) {
+    if (!client || !key || key_len >= MAX_KEY_LENGTH) return false;
+    
+    ShardRequest req = { .op = SHARD_DELETE, .key = key, .key_len = key_len };
+    return client_call(client, &req) != 0;
+}
+
+// db_mset across the shards, which store their parts in parallel
+size_t db_sharded_mset(DBShardClient *client, const char *keys, const char *values,
+                       size_t n) {
+    if (!client || !keys || !values || n == 0) return 0;
+    
+    return client_batch(client, SHARD_MSET, keys, values, n, NULL);
+}
+
+// db_mget across the shards: every shard looks up its keys in parallel,
+// then the values are packed into `out` in key order. Same contract as
+// db_mget.
+size_t db_sharded_mget(DBShardClient *client, const char *keys, size_t n, char *out,
+                       size_t out_size, long *lengths) {
+    if (!client || !keys || !lengths || n == 0) return 0;
+    
+    for (size_t i = 0; i < n; i++) lengths[i] = -1;
+    client_batch(client, SHARD_MGET, keys, NULL, n, lengths);
+    
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (lengths[i] < 0) continue;
+        
+        size_t len = (size_t)lengths[i];
+        ShardBatch *batch = &client->batches[client->route[i]];
+        if (out && used + len + 1 <= out_size) {
+            memcpy(out + used, batch->values + batch->gathered, len);
+            out[used + len] = '\0';
+        }
+        batch->gathered += len;
+        used += len + 1;
+    }
+    return used;
+}
 
-// ============================================================================
-// DATA STRUCTURES
-// ============================================================================
+// db_mdelete across the shards
+size_t db_sharded_mdelete(DBShardClient *client, const char *keys, size_t n) {
+    if (!client || !keys || n == 0) return 0;
+    
+    return client_batch(client, SHARD_MDELETE, keys, NULL, n, NULL);
+}
 
-// Entry in the hash table
-typedef struct Entry {
-    char *key;
-    char *value;
-    struct Entry *next;  // For collision chaining
-} Entry;
+// Keys over all shards. Shards count their own keys, so this reads them
+// directly instead of queueing a request.
+size_t db_sharded_count(ShardedDatabase *sdb) {
+    if (!sdb) return 0;
+    
+    size_t count = 0;
+    for (size_t i = 0; i < sdb->count; i++) count += db_count(sdb->shards[i].db);
+    return count;
+}
 
-// Database structure
-typedef struct Database {
-    Entry *table[HASH_TABLE_SIZE];
-    size_t count;  // Number of entries
-} Database;
+// Shard i's Database, or NULL past the last one. It may be used directly
+// (db_stats, db_save, db_wal_open ...): a Database is safe to share, its
+// thread is just no longer the only one touching it.
+Database* db_sharded_shard(ShardedDatabase *sdb, size_t i) {
+    return sdb && i < sdb->count ? sdb->shards[i].db : NULL;
+}
 
-// Statistics structure
-typedef struct DBStats {
-    size_t total_entries;
-    size_t total_collisions;
-    size_t max_chain_length;
-    size_t used_buckets;
-} DBStats;
+#ifdef BUILD_STANDALONE
 
-// ============================================================================
-// HASH FUNCTION
-// ============================================================================
+// Insert, read back, update and delete 100000 keys on one engine
+static bool bulk_test(DBEngine engine, const char *name) {
+    printf("Bulk test (%s engine): Adding 100000 entries...\n", name);
+    Database *big = db_create_ex(engine, 0);
+    Database *presized = db_create_ex(engine, 100000);
+    if (!big || !presized) {
+        fprintf(stderr, "Failed to create database\n");
+        return false;
+    }
+    
+    size_t initial_buckets = db_stats(presized).total_buckets;
+    for (int i = 0; i < 100000; i++) {
+        char key[48], value[64];
+        // Every 7th key is long enough to spill out of an inline slot
+        snprintf(key, sizeof(key), i % 7 ? "key_%d" : "a_rather_long_key_name_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        db_set(big, key, value);
+        db_set(presized, key, value);
+    }
+    
+    size_t missing = 0;
+    for (int i = 0; i < 100000; i++) {
+        char key[48], value[64];
+        snprintf(key, sizeof(key), i % 7 ? "key_%d" : "a_rather_long_key_name_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        const char *got = db_get(big, key);
+        if (!got || strcmp(got, value) != 0) missing++;
+        if (i % 2 == 0) {
+            db_delete(big, key);
+        } else if (i % 3 == 0) {
+            // Grow the value past the inline area and back again
+            db_set(big, key, "a value that is far too long to be stored inline");
+            db_set(big, key, value);
+        }
+    }
+    for (int i = 1; i < 100000; i += 2) {
+        char key[48], value[64];
+        snprintf(key, sizeof(key), i % 7 ? "key_%d" : "a_rather_long_key_name_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        const char *got = db_get(big, key);
+        if (!got || strcmp(got, value) != 0) missing++;
+    }
+    
+    DBStats stats = db_stats(big);
+    printf("%s All entries readable during resize (%zu missing)\n",
+           missing == 0 ? "✓" : "✗", missing);
+    printf("  Count after deleting half: %zu entries\n", db_count(big));
+    printf("  Buckets: %zu, max chain length: %zu\n",
+           stats.total_buckets, stats.max_chain_length);
+    printf("  Pre-sized buckets: %zu -> %zu (no resize needed)\n\n",
+           initial_buckets, db_stats(presized).total_buckets);
+    
+    bool ok = missing == 0 && db_count(presized) == 100000;
+    db_destroy(big);
+    db_destroy(presized);
+    return ok;
+}
 
-// DJB2 hash function
-static uint32_t hash_function(const char *str) {
-    uint32_t hash = 5381;
-    int c;
+// Batch calls must agree with the single-key ones, including for values
+// that don't fit the output buffer on the first try
+static bool batch_test(DBEngine engine, const char *name) {
+    printf("Batch test (%s engine): mset/mget/mdelete of 1000 keys...\n", name);
+    Database *db = db_create_ex(engine, 0);
+    char *keys = (char*)malloc(1000 * 32);
+    char *values = (char*)malloc(1000 * 32);
+    long *lengths = (long*)malloc(1001 * sizeof(long));
+    char *out = (char*)malloc(1000 * 32);
+    if (!db || !keys || !values || !lengths || !out) {
+        fprintf(stderr, "Failed to allocate batch test\n");
+        return false;
+    }
+    
+    size_t keys_len = 0, values_len = 0;
+    for (int i = 0; i < 1000; i++) {
+        keys_len += snprintf(keys + keys_len, 32, "batch_%d", i) + 1;
+        values_len += snprintf(values + values_len, 32, "value_%d", i) + 1;
+    }
     
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
+    bool ok = db_mset(db, keys, values, 1000) == 1000 && db_count(db) == 1000;
+    ok = ok && db_mdelete(db, keys, 500) == 500 && db_count(db) == 500;
+    
+    // Probe the 500 survivors plus one missing key, first with a tiny buffer
+    memcpy(keys + keys_len, "missing", 8);
+    const char *tail = keys;
+    for (int i = 0; i < 500; i++) tail += strlen(tail) + 1;
+    size_t needed = db_mget(db, tail, 501, out, 16, lengths);
+    ok = ok && needed > 16 && db_mget(db, tail, 501, out, needed, lengths) == needed;
+    
+    const char *value = out;
+    for (int i = 0; ok && i < 500; i++) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "value_%d", 500 + i);
+        ok = lengths[i] == (long)strlen(expected) && strcmp(value, expected) == 0;
+        value += lengths[i] + 1;
     }
+    ok = ok && lengths[500] == -1;
     
-    return hash % HASH_TABLE_SIZE;
+    printf("%s Batch results match single-key operations\n\n", ok ? "✓" : "✗");
+    free(keys);
+    free(values);
+    free(lengths);
+    free(out);
+    db_destroy(db);
+    return ok;
 }
 
-// ============================================================================
-// INTERNAL HELPER FUNCTIONS
-// ============================================================================
+// True if key holds exactly the len bytes at want
+static bool blob_matches(Database *db, const char *key, size_t key_len,
+                         const char *want, size_t len) {
+    size_t got_len;
+    const char *got = db_get_n(db, key, key_len, &got_len);
+    return got && got_len == len && memcmp(got, want, len) == 0 && got[len] == '\0';
+}
 
-// Create a new entry
-static Entry* create_entry(const char *key, const char *value) {
-    Entry *entry = (Entry*)malloc(sizeof(Entry));
-    if (!entry) return NULL;
+// Binary values of every storage size class, through updates, the limit,
+// the log and a snapshot
+static bool blob_test(DBEngine engine, const char *name) {
+    printf("Blob test (%s engine): binary values from 0 bytes to 1 MB...\n", name);
+    static const size_t sizes[] = { 0, 3, 20, 200, 4095, 70000, 1 << 20 };
+    const size_t n = sizeof(sizes) / sizeof(sizes[0]);
+    char path[64], snap_path[80];
+    snprintf(path, sizeof(path), "/tmp/simple_db_blob_%d.wal", (int)getpid());
+    snprintf(snap_path, sizeof(snap_path), "%s.snap", path);
+    remove(path);
     
-    entry->key = strdup(key);
-    entry->value = strdup(value);
-    entry->next = NULL;
+    char *blob = (char*)malloc((1 << 20) + n);
+    Database *db = db_create_ex(engine, 0);
+    if (!blob || !db) {
+        fprintf(stderr, "Failed to allocate blob test\n");
+        return false;
+    }
+    for (size_t i = 0; i < (1 << 20) + n; i++) blob[i] = (char)(i * 7 % 251);  // NULs included
     
-    if (!entry->key || !entry->value) {
-        free(entry->key);
-        free(entry->value);
-        free(entry);
-        return NULL;
+    // Over the default limit until it is raised; keys are slices of a
+    // longer buffer, so nothing relies on a terminator
+    const char *keys = "blob_0blob_1blob_2blob_3blob_4blob_5blob_6";
+    bool ok = !db_set_n(db, keys + 30, 6, blob, 4096) &&
+              db_set_n(db, keys, 6, blob, 4095) &&
+              !db_set_n(db, "nul\0key", 7, blob, 1) &&
+              db_set_max_value_length(db, 1 << 20) &&
+              !db_set_max_value_length(db, (size_t)MAX_VALUE_LIMIT + 1);
+    ok = ok && db_wal_open(db, path, NULL);
+    for (size_t i = 0; ok && i < n; i++) {
+        ok = db_set_n(db, keys + 6 * i, 6, blob + i, sizes[i]);
     }
     
-    return entry;
+    // Grow and shrink in place and across inline, slab and large blocks
+    for (size_t i = 0; ok && i < n; i++) {
+        size_t other = sizes[n - 1 - i];
+        ok = db_set_n(db, keys + 6 * i, 6, blob, other) &&
+             blob_matches(db, keys + 6 * i, 6, blob, other) &&
+             db_set_n(db, keys + 6 * i, 6, blob + i, sizes[i]);
+    }
+    for (size_t i = 0; ok && i < n; i++) {
+        ok = blob_matches(db, keys + 6 * i, 6, blob + i, sizes[i]);
+    }
+    ok = ok && db_get_copy(db, "blob_6", NULL, 0) == 1 << 20 &&
+         db_delete_n(db, keys + 12, 6) && !db_exists(db, "blob_2");
+    db_destroy(db);
+    
+    // Replay the log, then save and map a snapshot of the result
+    db = ok ? db_create_ex(engine, 0) : NULL;
+    ok = db && db_wal_open(db, path, NULL) && db_count(db) == n - 1;
+    ok = ok && db_save(db, snap_path);
+    db_destroy(db);
+    db = ok ? db_open_mmap(snap_path) : NULL;
+    for (size_t i = 0; db && ok && i < n; i++) {
+        ok = i == 2 ? !db_get_n(db, keys + 6 * i, 6, &(size_t){0})
+                    : blob_matches(db, keys + 6 * i, 6, blob + i, sizes[i]);
+    }
+    ok = ok && db;
+    db_destroy(db);
+    
+    remove(path);
+    remove(snap_path);
+    free(blob);
+    printf("%s Binary values round trip through updates, log and snapshot\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// Free an entry
-static void free_entry(Entry *entry) {
-    if (entry) {
-        free(entry->key);
-        free(entry->value);
-        free(entry);
+// Save, map, overlay writes on top, and save the merged view again
+static bool snapshot_test(void) {
+    printf("Snapshot test: save 10000 keys, open mapped, overlay writes...\n");
+    char path[64], merged_path[80];
+    snprintf(path, sizeof(path), "/tmp/simple_db_test_%d.snap", (int)getpid());
+    snprintf(merged_path, sizeof(merged_path), "%s.merged", path);
+    
+    Database *db = db_create();
+    char key[32], value[64];
+    for (int i = 0; i < 10000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        db_set(db, key, value);
+    }
+    bool ok = db_save(db, path);
+    db_destroy(db);
+    
+    // A count the index couldn't hold is refused rather than trusted
+    int fd = ok ? open(path, O_RDWR) : -1;
+    off_t count_at = offsetof(SnapshotHeader, count);
+    uint64_t count = 0, corrupt = 0;
+    ok = fd >= 0 && pread(fd, &count, sizeof(count), count_at) == sizeof(count);
+    corrupt = count | 0xc400000000000000ull;
+    ok = ok && pwrite(fd, &corrupt, sizeof(corrupt), count_at) == sizeof(corrupt);
+    db = ok ? db_open_mmap(path) : NULL;
+    ok = ok && db == NULL && pwrite(fd, &count, sizeof(count), count_at) == sizeof(count);
+    if (fd >= 0) close(fd);
+    ok = ok && round_up_pow2(SIZE_MAX / 2 + 1) == SIZE_MAX / 2 + 1 &&
+         round_up_pow2(SIZE_MAX / 2 + 2) == 0;
+    
+    db = ok ? db_open_mmap(path) : NULL;
+    ok = db && db_count(db) == 10000;
+    for (int i = 0; ok && i < 10000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        const char *got = db_get(db, key);
+        ok = got && strcmp(got, value) == 0;
+    }
+    
+    // Overwrite 0..999, delete 1000..1999 (and recreate 1000), add 100 new
+    for (int i = 0; ok && i < 2000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        ok = i < 1000 ? db_set(db, key, "changed") : db_delete(db, key);
+    }
+    ok = ok && !db_delete(db, "key_1500") && db_set(db, "key_1000", "back");
+    for (int i = 0; ok && i < 100; i++) {
+        snprintf(key, sizeof(key), "new_%d", i);
+        ok = db_set(db, key, "fresh");
     }
+    ok = ok && db_count(db) == 10000 - 1000 + 1 + 100;
+    ok = ok && strcmp(db_get(db, "key_5"), "changed") == 0 &&
+         !db_exists(db, "key_1500") && strcmp(db_get(db, "key_1000"), "back") == 0 &&
+         strcmp(db_get(db, "key_9999"), "value_9999") == 0;
+    
+    size_t key_count = 0;
+    char **keys = ok ? db_keys(db, &key_count) : NULL;
+    ok = ok && key_count == db_count(db);
+    free(keys);
+    
+    ok = ok && db_save(db, merged_path);
+    db_destroy(db);
+    
+    db = ok ? db_open_mmap(merged_path) : NULL;
+    ok = db && db_count(db) == 9101 && !db_exists(db, "key_1999") &&
+         strcmp(db_get(db, "new_7"), "fresh") == 0 &&
+         strcmp(db_get(db, "key_42"), "changed") == 0;
+    if (db) db_clear(db);
+    ok = ok && db_count(db) == 0 && !db_exists(db, "key_9999");
+    db_destroy(db);
+    
+    remove(path);
+    remove(merged_path);
+    printf("%s Snapshot round trip with overlay\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// ============================================================================
-// PUBLIC API FUNCTIONS
-// ============================================================================
-
-// Create a new database
-Database* db_create(void) {
-    Database *db = (Database*)calloc(1, sizeof(Database));
-    if (!db) return NULL;
+// Log changes, reopen and replay; cut the log mid-record; compact into a
+// snapshot and recover from snapshot plus log
+static bool wal_test(DBEngine engine, const char *name) {
+    printf("WAL test (%s engine): log, replay, torn tail, compaction...\n", name);
+    char path[64], snap_path[80];
+    snprintf(path, sizeof(path), "/tmp/simple_db_test_%d.wal", (int)getpid());
+    snprintf(snap_path, sizeof(snap_path), "%s.snap", path);
+    remove(path);
     
-    db->count = 0;
-    return db;
+    Database *db = db_create_ex(engine, 0);
+    bool ok = db && db_wal_open(db, path, NULL);
+    db_set(db, "gone", "before clear");
+    db_clear(db);
+    
+    // Keys 0..4999; every 5th deleted, every 3rd rewritten
+    char key[32], value[64];
+    for (int i = 0; ok && i < 5000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        ok = db_set(db, key, value);
+    }
+    for (int i = 0; ok && i < 5000; i += 3) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        ok = db_set(db, key, "rewritten");
+    }
+    for (int i = 0; ok && i < 5000; i += 5) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        ok = db_delete(db, key);
+    }
+    db_destroy(db);  // Flushes the log
+    
+    db = ok ? db_create_ex(engine, 0) : NULL;
+    ok = db && db_wal_open(db, path, NULL) && db_count(db) == 4000 && !db_exists(db, "gone");
+    for (int i = 0; ok && i < 5000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        const char *got = db_get(db, key);
+        const char *want = i % 5 == 0 ? NULL : i % 3 == 0 ? "rewritten" : value;
+        ok = want ? got && strcmp(got, want) == 0 : !got;
+    }
+    db_destroy(db);
+    
+    // A crash mid-write leaves a partial record: replay drops it
+    struct stat st;
+    ok = ok && stat(path, &st) == 0;
+    off_t logged = ok ? st.st_size : 0;
+    FILE *fp = ok ? fopen(path, "ab") : NULL;
+    ok = fp && fwrite("\x11\x22\x33\x44\x05\0\0\0\x09", 1, 9, fp) == 9;
+    if (fp) fclose(fp);
+    
+    DBWalConfig durable = { 500, 0, true };
+    db = ok ? db_create_ex(engine, 0) : NULL;
+    ok = db && db_wal_open(db, path, &durable) && db_count(db) == 4000 &&
+         stat(path, &st) == 0 && st.st_size == logged;
+    
+    // With wait_durable, a returned db_set is already in the file
+    ok = ok && db_set(db, "durable", "yes") && stat(path, &st) == 0 && st.st_size > logged;
+    ok = ok && db_compact(db, snap_path) && stat(path, &st) == 0 && st.st_size == 0;
+    ok = ok && db_set(db, "after", "compaction") && db_delete(db, "key_1");
+    db_destroy(db);
+    
+    db = ok ? db_open_mmap(snap_path) : NULL;
+    ok = db && db_wal_open(db, path, NULL) && db_count(db) == 4001 &&
+         strcmp(db_get(db, "durable"), "yes") == 0 &&
+         strcmp(db_get(db, "after"), "compaction") == 0 &&
+         !db_exists(db, "key_1") && strcmp(db_get(db, "key_3"), "rewritten") == 0;
+    db_destroy(db);
+    
+    remove(path);
+    remove(snap_path);
+    printf("%s Log replayed, torn record dropped, compacted log recovered\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// Destroy database and free all memory
-void db_destroy(Database *db) {
-    if (!db) return;
+// Count the records a cursor returns, checking they come in strictly
+// increasing key order
+static size_t scan_count(DBCursor *cursor, bool *ordered) {
+    char last[MAX_KEY_LENGTH] = "";
+    const char *key, *value;
+    size_t n = 0;
     
-    for (size_t i = 0; i < HASH_TABLE_SIZE; i++) {
-        Entry *entry = db->table[i];
-        while (entry) {
-            Entry *next = entry->next;
-            free_entry(entry);
-            entry = next;
-        }
+    while (db_cursor_next(cursor, &key, &value)) {
+        if (n > 0 && strcmp(last, key) >= 0) *ordered = false;
+        strcpy(last, key);
+        n++;
     }
-    
-    free(db);
+    db_cursor_close(cursor);
+    return n;
 }
 
-// Insert or update a key-value pair
-bool db_set(Database *db, const char *key, const char *value) {
-    if (!db || !key || !value) return false;
+// Build the ordered index half way through a load, then check prefix and
+// range scans, paging, deletes during a scan, and a snapshot underneath
+static bool index_test(DBEngine engine, const char *name) {
+    printf("Ordered index test (%s engine): prefix, range and paged scans...\n", name);
+    Database *db = db_create_ex(engine, 0);
+    char key[32], value[32];
+    bool ok = db != NULL, ordered = true;
     
-    // Validate lengths
-    if (strlen(key) >= MAX_KEY_LENGTH || strlen(value) >= MAX_VALUE_LENGTH) {
-        return false;
+    // Keys arrive in scrambled order
+    for (int i = 0; ok && i < 20000; i++) {
+        if (i == 10000) ok = db_enable_ordered_index(db);
+        int k = (int)((i * 7919L) % 20000);
+        snprintf(key, sizeof(key), "user:%05d", k);
+        snprintf(value, sizeof(value), "u%d", k);
+        ok = ok && db_set(db, key, value);
+        if (k < 5000) {
+            snprintf(key, sizeof(key), "item:%05d", k);
+            ok = ok && db_set(db, key, "i");
+        }
+    }
+    for (int k = 0; ok && k < 20000; k += 3) {
+        snprintf(key, sizeof(key), "user:%05d", k);
+        ok = db_delete(db, key);
     }
     
-    uint32_t index = hash_function(key);
-    Entry *entry = db->table[index];
+    size_t users = 20000 - 6667;
+    ok = ok && scan_count(db_scan_prefix(db, "user:"), &ordered) == users;
+    ok = ok && scan_count(db_scan_range(db, "item:01000", "item:02000"), &ordered) == 1000;
+    ok = ok && scan_count(db_scan_range(db, NULL, NULL), &ordered) == users + 5000;
+    ok = ok && scan_count(db_scan_prefix(db, "nothing"), &ordered) == 0;
     
-    // Check if key already exists (update case)
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            // Update existing value
-            char *new_value = strdup(value);
-            if (!new_value) return false;
-            
-            free(entry->value);
-            entry->value = new_value;
-            return true;
+    // Pages of up to 100 records, each from a fresh cursor resumed after
+    // the previous page's last key
+    char page[8192], last[MAX_KEY_LENGTH] = "";
+    size_t paged = 0, got;
+    bool done = false;
+    do {
+        DBCursor *cursor = db_scan_prefix(db, "user:");
+        if (paged > 0) db_cursor_seek_after(cursor, last);
+        got = db_cursor_fetch(cursor, page, sizeof(page), 100, &done);
+        const char *p = page;
+        for (size_t i = 0; i < got; i++) {
+            DBScanRecord header;
+            memcpy(&header, p, sizeof(header));
+            const char *key = p + sizeof(header);
+            if (strcmp(key, last) <= 0) ordered = false;
+            strcpy(last, key);
+            p += DB_SCAN_RECORD_SIZE(header.key_len, header.value_len);
         }
-        entry = entry->next;
+        paged += got;
+        db_cursor_close(cursor);
+    } while (got == 100 && !done);
+    ok = ok && paged == users;
+    
+    // A record too big for the buffer: 0 and not done, then it comes whole
+    DBCursor *small = db_scan_prefix(db, "user:");
+    ok = ok && db_cursor_fetch(small, page, sizeof(DBScanRecord), 10, &done) == 0 && !done;
+    ok = ok && db_cursor_fetch(small, page, sizeof(page), 1, &done) == 1 && !done &&
+         strcmp(page + sizeof(DBScanRecord), "user:00001") == 0;
+    db_cursor_close(small);
+    small = db_scan_prefix(db, "nothing");
+    ok = ok && db_cursor_fetch(small, page, sizeof(page), 10, &done) == 0 && done;
+    db_cursor_close(small);
+    
+    // Delete the key after each one returned: the cursor re-seeks and
+    // never returns a deleted key
+    DBCursor *cursor = db_scan_prefix(db, "item:");
+    const char *k, *v;
+    size_t seen = 0;
+    while (ok && cursor && db_cursor_next(cursor, &k, &v)) {
+        int n = atoi(k + 5);
+        snprintf(key, sizeof(key), "item:%05d", n + 1);
+        db_delete(db, key);
+        seen++;
     }
+    db_cursor_close(cursor);
+    ok = ok && seen == 2500;
     
-    // Insert new entry at the beginning of the chain
-    Entry *new_entry = create_entry(key, value);
-    if (!new_entry) return false;
+    db_clear(db);
+    ok = ok && scan_count(db_scan_range(db, NULL, NULL), &ordered) == 0;
+    
+    // Snapshot keys are indexed too, and overlay writes keep the index right
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/simple_db_index_%d.snap", (int)getpid());
+    for (int i = 0; ok && i < 1000; i++) {
+        snprintf(key, sizeof(key), "snap:%04d", i);
+        ok = db_set(db, key, "s");
+    }
+    ok = ok && db_save(db, path);
+    db_destroy(db);
     
-    new_entry->next = db->table[index];
-    db->table[index] = new_entry;
-    db->count++;
+    db = ok ? db_open_mmap(path) : NULL;
+    ok = db && db_enable_ordered_index(db) && db_delete(db, "snap:0500") &&
+         db_set(db, "snap:0500x", "new") && db_set(db, "snap:0001", "changed");
+    ok = ok && scan_count(db_scan_prefix(db, "snap:"), &ordered) == 1000;
+    cursor = ok ? db_scan_range(db, "snap:0500", "snap:0501") : NULL;
+    ok = ok && db_cursor_next(cursor, &k, &v) && strcmp(k, "snap:0500x") == 0 &&
+         strcmp(v, "new") == 0 && !db_cursor_next(cursor, &k, &v);
+    db_cursor_close(cursor);
+    db_destroy(db);
+    remove(path);
     
+    ok = ok && ordered;
+    printf("%s Scans in key order, paged, stable under deletes\n\n", ok ? "✓" : "✗");
+    return ok;
+}
+
+// Count each scan_<n> record in seen[n]; false if a value is wrong
+static bool scan_tally(const char *out, size_t n, unsigned char *seen, size_t limit) {
+    for (size_t i = 0; i < n; i++) {
+        DBScanRecord header;
+        memcpy(&header, out, sizeof(header));
+        const char *key = out + sizeof(header), *value = key + header.key_len + 1;
+        out += DB_SCAN_RECORD_SIZE(header.key_len, header.value_len);
+        
+        char expected[32];
+        size_t k = (size_t)atol(key + 5);
+        snprintf(expected, sizeof(expected), "value_%zu", k);
+        if (strncmp(key, "scan_", 5) != 0 || k >= limit || header.key_len != strlen(key) ||
+            header.value_len != strlen(expected) || strcmp(value, expected) != 0) {
+            return false;
+        }
+        if (seen[k] < 255) seen[k]++;
+    }
     return true;
 }
 
-// Get a value by key
-const char* db_get(Database *db, const char *key) {
-    if (!db || !key) return NULL;
+// A scan returns every key that was present throughout, while the tables
+// grow under it, and covers a mapped snapshot without its shadowed keys
+static bool scan_test(DBEngine engine, const char *name) {
+    printf("Scan test (%s engine): 20000 keys, 20000 more added mid-scan...\n", name);
+    enum { BASE = 20000, ADDED = 20000 };
+    Database *db = db_create_ex(engine, 0);
+    unsigned char *seen = (unsigned char*)calloc(BASE + ADDED, 1);
+    char *out = (char*)malloc(4096);
+    if (!db || !seen || !out) {
+        fprintf(stderr, "Failed to allocate scan test\n");
+        return false;
+    }
+    
+    char key[32], value[32];
+    bool ok = true;
+    for (size_t i = 0; ok && i < BASE; i++) {
+        snprintf(key, sizeof(key), "scan_%zu", i);
+        snprintf(value, sizeof(value), "value_%zu", i);
+        ok = db_set(db, key, value);
+    }
     
-    uint32_t index = hash_function(key);
-    Entry *entry = db->table[index];
+    // Nothing fits in 4 bytes: no progress and not done, so the caller can
+    // grow the buffer even on the first call
+    uint64_t cursor = 0;
+    bool done = true;
+    ok = ok && db_scan(db, &cursor, out, 4, 10, &done) == 0 && cursor == 0 && !done;
     
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            return entry->value;
+    size_t calls = 0, added = 0;
+    do {
+        size_t n = db_scan(db, &cursor, out, 4096, 100, &done);
+        ok = ok && scan_tally(out, n, seen, BASE + ADDED);
+        for (int j = 0; j < 500 && added < ADDED; j++, added++) {
+            snprintf(key, sizeof(key), "scan_%zu", BASE + added);
+            snprintf(value, sizeof(value), "value_%zu", BASE + added);
+            ok = ok && db_set(db, key, value);
         }
-        entry = entry->next;
+        calls++;
+    } while (ok && !done && calls < 100000);
+    
+    size_t missing = 0, repeated = 0;
+    for (size_t i = 0; i < BASE; i++) {
+        if (seen[i] == 0) missing++;
+        if (seen[i] > 1) repeated++;
+    }
+    ok = ok && done && cursor == 0 && missing == 0;
+    printf("  %zu calls, %zu of the original keys repeated after resizes\n", calls, repeated);
+    
+    // Mapped snapshot with overlay deletes and writes: each key exactly once
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/simple_db_scan_%d.snap", (int)getpid());
+    ok = ok && db_save(db, path);
+    db_destroy(db);
+    db = ok ? db_open_mmap(path) : NULL;
+    ok = db != NULL;
+    for (size_t i = 0; ok && i < 100; i++) {
+        snprintf(key, sizeof(key), "scan_%zu", i * 7);
+        ok = db_delete(db, key);
+        snprintf(key, sizeof(key), "scan_%zu", i * 7 + 1);
+        snprintf(value, sizeof(value), "value_%zu", i * 7 + 1);
+        ok = ok && db_set(db, key, value);
+    }
+    
+    memset(seen, 0, BASE + ADDED);
+    size_t total = 0;
+    cursor = 0;
+    do {
+        size_t n = db_scan(db, &cursor, out, 4096, 100, &done);
+        ok = ok && scan_tally(out, n, seen, BASE + ADDED);
+        total += n;
+    } while (ok && !done);
+    for (size_t i = 0; ok && i < BASE + ADDED; i++) {
+        ok = seen[i] == (i % 7 == 0 && i < 700 ? 0 : 1);
     }
+    ok = ok && total == db_count(db);
+    
+    // Values holding NUL bytes come back whole, with their lengths
+    if (db) db_destroy(db);
+    db = db_create_ex(engine, 0);
+    ok = ok && db && db_set_n(db, "bin", 3, "x\0y", 3);
+    cursor = 0;
+    size_t n = ok ? db_scan(db, &cursor, out, 4096, 100, &done) : 0;
+    DBScanRecord header = { 0, 0 };
+    memcpy(&header, out, sizeof(header));
+    ok = ok && n == 1 && done && header.key_len == 3 && header.value_len == 3 &&
+         memcmp(out + sizeof(header), "bin\0x\0y\0", 8) == 0;
     
-    return NULL;  // Key not found
+    if (db) db_destroy(db);
+    remove(path);
+    free(seen);
+    free(out);
+    printf("%s Scan saw every key, across resizes and a mapped snapshot\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// Delete a key-value pair
-bool db_delete(Database *db, const char *key) {
-    if (!db || !key) return false;
+// A read view keeps returning the keys as they were while they are
+// overwritten, deleted and added between scan pages, each exactly once;
+// a background save captures the moment it was called
+static bool view_test(DBEngine engine, const char *name) {
+    printf("View test (%s engine): scan 10000 keys while rewriting them...\n", name);
+    enum { KEYS = 10000 };
+    Database *db = db_create_ex(engine, 0);
+    unsigned char *seen = (unsigned char*)calloc(KEYS, 1);
+    char *out = (char*)malloc(4096);
+    if (!db || !seen || !out) {
+        fprintf(stderr, "Failed to allocate view test\n");
+        return false;
+    }
     
-    uint32_t index = hash_function(key);
-    Entry *entry = db->table[index];
-    Entry *prev = NULL;
+    char key[32], value[32];
+    bool ok = true;
+    for (size_t i = 0; ok && i < KEYS; i++) {
+        snprintf(key, sizeof(key), "scan_%zu", i);
+        snprintf(value, sizeof(value), "value_%zu", i);
+        ok = db_set(db, key, value);
+    }
     
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            // Remove entry from chain
-            if (prev) {
-                prev->next = entry->next;
+    DBSnapshot *view = db_snapshot_begin(db);
+    ok = ok && view && db_snapshot_count(view) == KEYS;
+    bool done = false;
+    size_t pages = 0, changed = 0;
+    while (ok && !done) {
+        size_t n = db_snapshot_scan(view, out, 4096, 100, &done);
+        ok = scan_tally(out, n, seen, KEYS);
+        // Rewrite, delete or add a slice of keys: the view must not notice
+        for (int j = 0; j < 50 && changed < KEYS; j++, changed++) {
+            snprintf(key, sizeof(key), "scan_%zu", (changed * 7919) % KEYS);
+            if (changed % 3 == 0) {
+                ok = ok && db_delete(db, key);
             } else {
-                db->table[index] = entry->next;
+                ok = ok && db_set(db, key, changed % 3 == 1 ? "changed" : "changed, and long enough to move");
             }
-            
-            free_entry(entry);
-            db->count--;
-            return true;
+            snprintf(key, sizeof(key), "added_%zu", changed);
+            ok = ok && db_set(db, key, "new");
         }
-        prev = entry;
-        entry = entry->next;
+        pages++;
+    }
+    for (size_t i = 0; ok && i < KEYS; i++) ok = seen[i] == 1;
+    
+    ok = ok && strcmp(db_snapshot_get(view, "scan_0"), "value_0") == 0 &&
+         strcmp(db_snapshot_get(view, "scan_7919"), "value_7919") == 0 &&
+         !db_snapshot_get(view, "added_0") && !db_exists(db, "scan_0") &&
+         db_snapshot_ok(view);
+    printf("  %zu pages, %zu keys changed, %zu bytes kept for the view\n", pages, changed,
+           db_snapshot_memory(view));
+    db_snapshot_end(view);
+    
+    // The image is of the call, not of whatever was written while it ran
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/simple_db_view_%d.snap", (int)getpid());
+    size_t count = db_count(db);
+    ok = ok && db_save_background(db, path) && !db_save_background(db, path);
+    for (size_t i = 0; ok && i < 1000; i++) {
+        snprintf(key, sizeof(key), "later_%zu", i);
+        ok = db_set(db, key, "late");
     }
+    ok = ok && db_save_wait(db) && !db_save_wait(db);
+    db_destroy(db);
     
-    return false;  // Key not found
+    db = ok ? db_open_mmap(path) : NULL;
+    ok = db && db_count(db) == count && !db_exists(db, "later_0") &&
+         strcmp(db_get(db, "added_9"), "new") == 0;
+    if (db) db_destroy(db);
+    remove(path);
+    free(seen);
+    free(out);
+    printf("%s View saw the keys as they were, each once; background save consistent\n\n",
+           ok ? "✓" : "✗");
+    return ok;
 }
 
-// Check if a key exists
-bool db_exists(Database *db, const char *key) {
-    return db_get(db, key) != NULL;
-}
+// Writers own disjoint key ranges and keep rewriting them (short and long
+// values, deletes and re-inserts) while readers check every value they see
+#define CONC_THREADS 4
+#define CONC_KEYS 20000
 
-// Get the number of entries
-size_t db_count(Database *db) {
-    return db ? db->count : 0;
-}
+typedef struct {
+    Database *db;
+    int id;
+    size_t bad;
+} ConcArg;
 
-// Clear all entries
-void db_clear(Database *db) {
-    if (!db) return;
+// Keys with a TTL read as missing once it passes, are reaped in the
+// background, and keep their deadlines through the log and snapshots
+static bool ttl_test(DBEngine engine, const char *name) {
+    printf("TTL test (%s engine): lazy and background expiry, persistence...\n", name);
+    char path[64], snap_path[80], key[32];
+    snprintf(path, sizeof(path), "/tmp/simple_db_ttl_%d.wal", (int)getpid());
+    snprintf(snap_path, sizeof(snap_path), "%s.snap", path);
+    remove(path);
     
-    for (size_t i = 0; i < HASH_TABLE_SIZE; i++) {
-        Entry *entry = db->table[i];
-        while (entry) {
-            Entry *next = entry->next;
-            free_entry(entry);
-            entry = next;
-        }
-        db->table[i] = NULL;
+    // 2000 short-lived keys next to 1000 permanent ones
+    Database *db = db_create_ex(engine, 0);
+    bool ok = db && db_wal_open(db, path, NULL);
+    for (int i = 0; ok && i < 3000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        ok = i < 2000 ? db_set_ex(db, key, "short", 50) : db_set(db, key, "forever");
     }
+    ok = ok && db_set_ex(db, "long", "lived", 60000) &&
+         db_set_ex(db, "cleared", "soon", 50) && db_set(db, "cleared", "kept") &&
+         !db_set_ex(db, "zero", "ttl", 0);
+    long long ttl = db_ttl(db, "long");
+    ok = ok && ttl > 59000 && ttl <= 60000 && db_ttl(db, "cleared") == -1 &&
+         db_ttl(db, "key_2000") == -1 && db_ttl(db, "missing") == -2 &&
+         db_get(db, "key_0") && db_count(db) == 3002;
+    
+    // Lazy: expired keys read as missing straight away
+    usleep(80 * 1000);
+    ok = ok && !db_get(db, "key_0") && !db_exists(db, "key_1") &&
+         db_ttl(db, "key_2") == -2 && !db_delete(db, "key_3") &&
+         strcmp(db_get(db, "cleared"), "kept") == 0;
+    
+    // Background: the reaper removes the rest within a few passes
+    for (int i = 0; i < 50 && db_count(db) > 1002; i++) usleep(50 * 1000);
+    size_t key_count = 0;
+    free(db_keys(db, &key_count));
+    DBStats stats = db_stats(db);
+    ok = ok && db_count(db) == 1002 && key_count == 1002 &&
+         stats.expirations == 2000 && stats.misses == 1 && stats.hits >= 2;
+    printf("  Reaped %llu expired keys, %zu left\n",
+           (unsigned long long)stats.expirations, db_count(db));
+    db_destroy(db);
     
-    db->count = 0;
+    // The log holds the deadlines and the reaper's deletes
+    db = ok ? db_create_ex(engine, 0) : NULL;
+    ok = db && db_wal_open(db, path, NULL) && db_count(db) == 1002 &&
+         db_ttl(db, "long") > 59000 && db_ttl(db, "cleared") == -1 && !db_exists(db, "key_5");
+    
+    // Snapshots keep deadlines to the second
+    ok = ok && db_save(db, snap_path);
+    db_destroy(db);
+    db = ok ? db_open_mmap(snap_path) : NULL;
+    ttl = db ? db_ttl(db, "long") : 0;
+    ok = db && ttl > 58000 && ttl <= 61000 && db_ttl(db, "key_2999") == -1 &&
+         strcmp(db_get(db, "long"), "lived") == 0 && db_count(db) == 1002;
+    db_destroy(db);
+    
+    remove(path);
+    remove(snap_path);
+    printf("%s Expired keys hidden, reaped, and deadlines persisted\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// Get all keys (caller must free the returned array)
-char** db_keys(Database *db, size_t *count) {
-    if (!db || !count) return NULL;
+// Under a memory budget, writes evict keys that weren't read recently and
+// the data stays within the budget
+static bool eviction_test(DBEngine engine, const char *name) {
+    printf("Eviction test (%s engine): 50000 writes into a 2 MB budget...\n", name);
+    Database *db = db_create_ex(engine, 0);
+    bool ok = db && db_set_max_memory(db, 2 << 20) && db_set(db, "hot", "key");
     
-    *count = db->count;
-    if (db->count == 0) return NULL;
+    char key[32], value[101];
+    memset(value, 'v', 100);
+    value[100] = '\0';
+    for (int i = 0; ok && i < 50000; i++) {
+        snprintf(key, sizeof(key), "key_%d", i);
+        ok = db_set(db, key, value);
+        // Reading the hot key keeps its CLOCK bit set ahead of the hand
+        if (ok && i % 50 == 0) ok = db_get(db, "hot") != NULL;
+    }
     
-    char **keys = (char**)malloc(sizeof(char*) * db->count);
-    if (!keys) return NULL;
+    DBStats stats = db_stats(db);
+    ok = ok && stats.evictions > 0 && stats.memory_used <= (2 << 20) &&
+         db_count(db) == 50001 - stats.evictions && db_exists(db, "hot") &&
+         db_exists(db, "key_49999");
+    printf("  %zu keys kept in %zu bytes, %llu evicted\n", db_count(db), stats.memory_used,
+           (unsigned long long)stats.evictions);
     
-    size_t idx = 0;
-    for (size_t i = 0; i < HASH_TABLE_SIZE; i++) {
-        Entry *entry = db->table[i];
-        while (entry) {
-            keys[idx++] = entry->key;
-            entry = entry->next;
-        }
+    // A lower budget applies at once; no budget stops evicting
+    ok = ok && db_set_max_memory(db, 1 << 20) && db_stats(db).memory_used <= (1 << 20);
+    ok = ok && db_set_max_memory(db, 0);
+    size_t before = db_count(db);
+    for (int i = 0; ok && i < 10000; i++) {
+        snprintf(key, sizeof(key), "more_%d", i);
+        ok = db_set(db, key, value);
     }
+    ok = ok && db_count(db) == before + 10000;
+    db_destroy(db);
     
-    return keys;
+    printf("%s Memory stayed within budget, recently read key kept\n\n", ok ? "✓" : "✗");
+    return ok;
 }
 
-// Get database statistics
-DBStats db_stats(Database *db) {
-    DBStats stats = {0, 0, 0, 0};
-    if (!db) return stats;
-    
-    stats.total_entries = db->count;
+static void* conc_worker(void *p) {
+    ConcArg *arg = (ConcArg*)p;
+    char key[48], value[96];
     
-    for (size_t i = 0; i < HASH_TABLE_SIZE; i++) {
-        Entry *entry = db->table[i];
-        if (entry) {
-            stats.used_buckets++;
-            
-            size_t chain_length = 0;
-            while (entry) {
-                chain_length++;
-                if (entry->next) {
-                    stats.total_collisions++;
-                }
-                entry = entry->next;
-            }
+    for (int round = 0; round < 3; round++) {
+        for (int i = arg->id; i < CONC_KEYS; i += CONC_THREADS) {
+            snprintf(key, sizeof(key), i % 7 ? "key_%d" : "a_rather_long_key_name_%d", i);
+            snprintf(value, sizeof(value), round == 1 ? "value_%d_that_no_longer_fits_inline" : "value_%d", i);
+            db_set(arg->db, key, value);
+            if (round == 1 && i % 5 == 0) db_delete(arg->db, key);
             
-            if (chain_length > stats.max_chain_length) {
-                stats.max_chain_length = chain_length;
-            }
+            // Read someone else's key: absent or a well-formed value for it
+            int other = (i + 1) % CONC_KEYS;
+            snprintf(key, sizeof(key), other % 7 ? "key_%d" : "a_rather_long_key_name_%d", other);
+            const char *got = db_get(arg->db, key);
+            int n;
+            if (got && (sscanf(got, "value_%d", &n) != 1 || n != other)) arg->bad++;
         }
     }
-    
-    return stats;
+    return NULL;
 }
 
-// Print database contents (for debugging)
-void db_print(Database *db) {
-    if (!db) return;
+static bool concurrent_test(DBEngine engine, const char *name) {
+    printf("Concurrent test (%s engine): %d threads...\n", name, CONC_THREADS);
+    Database *db = db_create_ex(engine, 0);
+    if (!db) return false;
     
-    printf("Database contents (%zu entries):\n", db->count);
-    printf("═══════════════════════════════════════\n");
+    pthread_t threads[CONC_THREADS];
+    ConcArg args[CONC_THREADS];
+    for (int t = 0; t < CONC_THREADS; t++) {
+        args[t] = (ConcArg){ db, t, 0 };
+        pthread_create(&threads[t], NULL, conc_worker, &args[t]);
+    }
     
-    for (size_t i = 0; i < HASH_TABLE_SIZE; i++) {
-        Entry *entry = db->table[i];
-        if (entry) {
-            printf("Bucket %zu:\n", i);
-            while (entry) {
-                printf("  \"%s\" => \"%s\"\n", entry->key, entry->value);
-                entry = entry->next;
-            }
-        }
+    size_t bad = 0;
+    for (int t = 0; t < CONC_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        bad += args[t].bad;
     }
     
-    printf("═══════════════════════════════════════\n");
+    bool ok = bad == 0 && db_count(db) == CONC_KEYS;
+    printf("%s %zu bad reads, %zu entries\n\n", ok ? "✓" : "✗", bad, db_count(db));
+    db_destroy(db);
+    return ok;
 }
 
-// ============================================================================
-// STANDALONE TEST PROGRAM
-// ============================================================================
+// Sharded mode: one client per thread, keys and batches routed to shard
+// threads; every thread reads back its own writes through batches
+typedef struct {
+    ShardedDatabase *sdb;
+    int id;
+    size_t bad;
+} ShardArg;
 
-#ifdef BUILD_STANDALONE
+static void* shard_worker(void *p) {
+    ShardArg *arg = (ShardArg*)p;
+    DBShardClient *client = db_sharded_client_open(arg->sdb);
+    char keys[64 * 32], values[64 * 32], out[64 * 32];
+    long lengths[64];
+    if (!client) {
+        arg->bad++;
+        return NULL;
+    }
+    
+    for (int base = arg->id * 5120; base < (arg->id + 1) * 5120; base += 64) {
+        size_t keys_len = 0, values_len = 0;
+        for (int i = 0; i < 64; i++) {
+            keys_len += snprintf(keys + keys_len, 32, "shard_%d", base + i) + 1;
+            values_len += snprintf(values + values_len, 32, "value_%d", base + i) + 1;
+        }
+        if (db_sharded_mset(client, keys, values, 64) != 64) arg->bad++;
+        if (db_sharded_mget(client, keys, 64, out, sizeof(out), lengths) != values_len ||
+            memcmp(out, values, values_len) != 0) arg->bad++;
+    }
+    
+    db_sharded_client_close(client);
+    return NULL;
+}
+
+static bool sharded_test(DBEngine engine, const char *name) {
+    printf("Sharded test (%s engine): 4 shards, %d client threads...\n", name, CONC_THREADS);
+    ShardedDatabase *sdb = db_sharded_create(engine, 4, 0);
+    DBShardClient *client = db_sharded_client_open(sdb);
+    if (!sdb || !client) {
+        fprintf(stderr, "Failed to create sharded database\n");
+        return false;
+    }
+    
+    // Single-key calls, a binary value among them
+    char key[32], value[32], buf[32];
+    bool ok = true;
+    for (int i = 0; ok && i < 1000; i++) {
+        int key_len = snprintf(key, sizeof(key), "key_%d", i);
+        int value_len = snprintf(value, sizeof(value), "value_%d", i);
+        ok = db_sharded_set(client, key, key_len, value, value_len) &&
+             db_sharded_get(client, key, key_len, buf, sizeof(buf)) == value_len &&
+             strcmp(buf, value) == 0;
+    }
+    ok = ok && db_sharded_set(client, "blob", 4, "a\0b", 3) &&
+         db_sharded_get(client, "blob", 4, buf, sizeof(buf)) == 3 && memcmp(buf, "a\0b", 4) == 0;
+    ok = ok && db_sharded_delete(client, "blob", 4) && !db_sharded_delete(client, "blob", 4) &&
+         db_sharded_get(client, "blob", 4, buf, sizeof(buf)) == -1;
+    ok = ok && db_sharded_count(sdb) == 1000;
+    for (size_t i = 0; ok && i < 4; i++) {
+        ok = db_count(db_sharded_shard(sdb, i)) > 150;  // Keys spread over every shard
+    }
+    ok = ok && db_sharded_shard(sdb, 4) == NULL;
+    
+    // A batch gathered in key order; too small a buffer reports the size needed
+    const char probe[] = "key_3\0missing\0key_999\0key_0";
+    long lengths[4];
+    char out[64];
+    size_t needed = db_sharded_mget(client, probe, 4, out, 8, lengths);
+    ok = ok && needed == 26 && db_sharded_mget(client, probe, 4, out, sizeof(out), lengths) == 26;
+    ok = ok && lengths[0] == 7 && lengths[1] == -1 && lengths[2] == 9 && lengths[3] == 7 &&
+         memcmp(out, "value_3\0value_999\0value_0", 26) == 0;
+    ok = ok && db_sharded_mdelete(client, probe, 4) == 3 && db_sharded_count(sdb) == 997;
+    
+    // A closed handle is handed out again
+    db_sharded_client_close(client);
+    ok = ok && db_sharded_client_open(sdb) == client;
+    
+    pthread_t threads[CONC_THREADS];
+    ShardArg args[CONC_THREADS];
+    for (int t = 0; t < CONC_THREADS; t++) {
+        args[t] = (ShardArg){ sdb, t, 0 };
+        pthread_create(&threads[t], NULL, shard_worker, &args[t]);
+    }
+    size_t bad = 0;
+    for (int t = 0; t < CONC_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        bad += args[t].bad;
+    }
+    ok = ok && bad == 0 && db_sharded_count(sdb) == 997 + CONC_THREADS * 5120;
+    
+    printf("%s %zu bad batches, %zu entries over 4 shards\n\n", ok ? "✓" : "✗", bad,
+           db_sharded_count(sdb));
+    db_sharded_destroy(sdb);
+    return ok;
+}
 
 int main(void) {
     printf("Simple In-Memory Database - Standalone Test\n");
@@ -358,6 +6400,15 @@ int main(void) {
     printf("exists(name) => %s\n", db_exists(db, "name") ? "true" : "false");
     printf("exists(missing) => %s\n\n", db_exists(db, "missing") ? "true" : "false");
     
+    // Test precomputed-hash variants
+    printf("Testing hashed GET/SET...\n");
+    uint64_t name_hash = db_hash("name");
+    db_set_hashed(db, "zip", "10001", db_hash("zip"));
+    printf("get_hashed(name) => %s\n", db_get_hashed(db, "name", name_hash));
+    printf("get(zip) => %s\n", db_get(db, "zip"));
+    db_delete(db, "zip");
+    printf("\n");
+    
     // Test COUNT operation
     printf("Count: %zu entries\n\n", db_count(db));
     
@@ -406,14 +6457,42 @@ int main(void) {
     stats = db_stats(db);
     printf("Final Statistics:\n");
     printf("  Total entries: %zu\n", stats.total_entries);
-    printf("  Used buckets: %zu / %d (%.1f%%)\n", 
-           stats.used_buckets, HASH_TABLE_SIZE,
-           (100.0 * stats.used_buckets) / HASH_TABLE_SIZE);
+    printf("  Used buckets: %zu / %zu (%.1f%%)\n", 
+           stats.used_buckets, stats.total_buckets,
+           (100.0 * stats.used_buckets) / stats.total_buckets);
     printf("  Total collisions: %zu\n", stats.total_collisions);
     printf("  Max chain length: %zu\n", stats.max_chain_length);
     printf("  Avg chain length: %.2f\n\n", 
            stats.used_buckets > 0 ? (double)stats.total_entries / stats.used_buckets : 0);
     
+    // Bulk tests: both engines must grow instead of probing long chains,
+    // and stay consistent under concurrent writers and readers
+    if (!bulk_test(DB_ENGINE_CHAINED, "chained") ||
+        !bulk_test(DB_ENGINE_SWISS, "swiss") ||
+        !batch_test(DB_ENGINE_CHAINED, "chained") ||
+        !batch_test(DB_ENGINE_SWISS, "swiss") ||
+        !blob_test(DB_ENGINE_CHAINED, "chained") ||
+        !blob_test(DB_ENGINE_SWISS, "swiss") ||
+        !snapshot_test() ||
+        !wal_test(DB_ENGINE_CHAINED, "chained") ||
+        !wal_test(DB_ENGINE_SWISS, "swiss") ||
+        !index_test(DB_ENGINE_CHAINED, "chained") ||
+        !index_test(DB_ENGINE_SWISS, "swiss") ||
+        !scan_test(DB_ENGINE_CHAINED, "chained") ||
+        !scan_test(DB_ENGINE_SWISS, "swiss") ||
+        !view_test(DB_ENGINE_CHAINED, "chained") ||
+        !view_test(DB_ENGINE_SWISS, "swiss") ||
+        !ttl_test(DB_ENGINE_CHAINED, "chained") ||
+        !ttl_test(DB_ENGINE_SWISS, "swiss") ||
+        !eviction_test(DB_ENGINE_CHAINED, "chained") ||
+        !eviction_test(DB_ENGINE_SWISS, "swiss") ||
+        !concurrent_test(DB_ENGINE_CHAINED, "chained") ||
+        !concurrent_test(DB_ENGINE_SWISS, "swiss") ||
+        !sharded_test(DB_ENGINE_CHAINED, "chained") ||
+        !sharded_test(DB_ENGINE_SWISS, "swiss")) {
+        return 1;
+    }
+    
     // Test CLEAR operation
     printf("Testing CLEAR operation...\n");
     db_clear(db);
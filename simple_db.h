@@ -0,0 +1,237 @@
+#ifndef SIMPLE_DB_H
+#define SIMPLE_DB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Opaque database handle
+typedef struct Database Database;
+
+// Storage engine, chosen when the database is created
+typedef enum DBEngine {
+    DB_ENGINE_CHAINED = 0,  // Separate chaining, incremental resize (default)
+    DB_ENGINE_SWISS = 1     // Open addressing over a flat slot array
+} DBEngine;
+
+// Statistics structure
+//
+// For the Swiss engine a "bucket" is a slot: used_buckets counts full slots,
+// total_collisions counts entries displaced from their home group, and
+// max_chain_length is the longest probe sequence in groups.
+//
+// hits and misses count db_get-style lookups; evictions counts keys dropped
+// to stay under db_set_max_memory, expirations keys removed once their TTL
+// passed. memory_used is what the budget is checked against.
+typedef struct DBStats {
+    size_t total_entries;
+    size_t total_collisions;
+    size_t max_chain_length;
+    size_t used_buckets;
+    size_t total_buckets;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t expirations;
+    size_t memory_used;
+} DBStats;
+
+// Extended statistics (db_stats_ex). Each thread counts into its own block
+// and the blocks are summed on read, so the hot path never shares a cache
+// line and nothing walks the table. Every get, set and delete is counted
+// and its probe length recorded (chain entries compared for the chained
+// engine, groups probed for Swiss); one in DB_LATENCY_SAMPLE is also timed.
+//
+// Latency buckets are log-linear: 1 ns wide below 16 ns, then every power
+// of two split into 8, so a bucket is at most 1/8 as wide as its lower
+// bound (db_latency_bucket_ns) and the top one ends near 17 s.
+#define DB_OP_GET 0
+#define DB_OP_SET 1
+#define DB_OP_DELETE 2
+#define DB_OP_KINDS 3
+#define DB_LATENCY_BUCKETS 256
+#define DB_LATENCY_SAMPLE 64
+#define DB_PROBE_BUCKETS 16     // Probe lengths 0-14; the last bucket is 15 or more
+
+typedef struct DBOpStats {
+    uint64_t count;
+    uint64_t found;             // Gets that hit, sets stored, deletes that removed a key
+    uint64_t sampled;           // Operations timed into latency
+    uint64_t latency[DB_LATENCY_BUCKETS];
+    uint64_t probes[DB_PROBE_BUCKETS];
+} DBOpStats;
+
+typedef struct DBStatsEx {
+    size_t total_entries;
+    size_t total_buckets;
+    size_t memory_used;
+    uint64_t evictions;
+    uint64_t expirations;
+    DBOpStats ops[DB_OP_KINDS]; // Indexed by DB_OP_*
+} DBStatsEx;
+
+// Write-ahead log settings (see db_wal_open). Zero fields take the defaults.
+typedef struct DBWalConfig {
+    unsigned flush_interval_us;  // Longest a record waits for its group commit (2000)
+    size_t batch_bytes;          // Flush early once this much is buffered (64 KB)
+    bool wait_durable;           // db_set/db_delete return only once synced
+} DBWalConfig;
+
+// Lifecycle
+Database* db_create(void);
+Database* db_create_with_capacity(size_t capacity);
+Database* db_create_ex(DBEngine engine, size_t capacity);
+void db_destroy(Database *db);
+
+// Persistence: db_save writes a snapshot image; db_open_mmap maps one and
+// serves reads from it, with later writes kept in memory on top. Saving
+// works from a read view (below), so writers carry on meanwhile;
+// db_save_background does it on a thread of its own, one at a time, and
+// db_save_wait joins it and returns whether it succeeded.
+bool db_save(Database *db, const char *path);
+bool db_save_background(Database *db, const char *path);
+bool db_save_wait(Database *db);
+Database* db_open_mmap(const char *path);
+
+// Write-ahead log: db_wal_open replays `path` into db, then appends every
+// later change to it; a background thread group-commits the appends.
+// db_compact folds the log into a new snapshot and empties it.
+bool db_wal_open(Database *db, const char *path, const DBWalConfig *config);
+bool db_wal_sync(Database *db);
+void db_wal_close(Database *db);
+bool db_compact(Database *db, const char *snapshot_path);
+
+// CRUD operations (safe to call from any number of threads)
+bool db_set(Database *db, const char *key, const char *value);
+const char* db_get(Database *db, const char *key);
+long db_get_copy(Database *db, const char *key, char *buf, size_t size);
+bool db_delete(Database *db, const char *key);
+bool db_exists(Database *db, const char *key);
+
+// Length-aware variants: keys are key_len bytes without NULs, values any
+// value_len bytes. db_get_n returns the same thread-owned copy as db_get
+// (always followed by a NUL) and sets *value_len.
+bool db_set_n(Database *db, const char *key, size_t key_len, const char *value,
+              size_t value_len);
+const char* db_get_n(Database *db, const char *key, size_t key_len, size_t *value_len);
+bool db_delete_n(Database *db, const char *key, size_t key_len);
+
+// Longest value accepted by later writes: 4095 bytes unless raised, up to 1 GB
+bool db_set_max_value_length(Database *db, size_t max_len);
+
+// Expiry: keys set with a TTL read as missing once it passes and are
+// removed in the background. db_ttl returns the milliseconds left, -1 for
+// a key without a TTL, or -2 for a missing key. A plain set clears the TTL.
+bool db_set_ex(Database *db, const char *key, const char *value, uint64_t ttl_ms);
+bool db_set_ex_n(Database *db, const char *key, size_t key_len, const char *value,
+                 size_t value_len, uint64_t ttl_ms);
+long long db_ttl(Database *db, const char *key);
+
+// Memory budget: once the keys and values stored exceed max_bytes, writes
+// evict keys not read recently (CLOCK). 0, the default, means no limit.
+bool db_set_max_memory(Database *db, size_t max_bytes);
+
+// Precomputed hashes: db_hash returns the hash the database would compute
+// for key, so callers that already hold it skip hashing again
+uint64_t db_hash(const char *key);
+bool db_set_hashed(Database *db, const char *key, const char *value, uint64_t hash);
+const char* db_get_hashed(Database *db, const char *key, uint64_t hash);
+
+// Batch operations: keys and values are n NUL-terminated strings packed
+// back to back in one buffer
+size_t db_mset(Database *db, const char *keys, const char *values, size_t n);
+size_t db_mget(Database *db, const char *keys, size_t n, char *out, size_t out_size,
+               long *lengths);
+size_t db_mdelete(Database *db, const char *keys, size_t n);
+
+// Scan record layout, shared by db_scan, db_snapshot_scan and
+// db_cursor_fetch: a DBScanRecord header, then the key and the value, each
+// followed by a NUL, so values may hold NUL bytes. Records are packed back
+// to back without padding; memcpy the header out before reading it.
+typedef struct {
+    uint32_t key_len;
+    uint32_t value_len;
+} DBScanRecord;
+#define DB_SCAN_RECORD_SIZE(key_len, value_len) \
+    (sizeof(DBScanRecord) + (size_t)(key_len) + (size_t)(value_len) + 2)
+
+// Incremental scan: start with *cursor = 0 and call until *done is true.
+// Each call copies about max_records records into out; keys present
+// throughout are returned at least once, even across resizes. 0 records
+// with *done false means the next bucket didn't fit: retry with a larger
+// buffer. No allocation and no state between calls.
+size_t db_scan(Database *db, uint64_t *cursor, char *out, size_t out_size,
+               size_t max_records, bool *done);
+
+// Read views: db_snapshot_begin freezes the database as it is now for one
+// reader, without copying it or blocking writers for longer than it takes
+// to take note. Changed keys keep their old state for each open view, so a
+// view costs memory in proportion to the churn while it is open; end views
+// promptly. db_snapshot_get returns the same thread-owned copy as db_get.
+// A view is scanned once, in DBScanRecord records; *done turns true at the end.
+// As with db_scan, 0 records with *done false means the next bucket didn't
+// fit. db_snapshot_ok is false if a version was lost to an allocation
+// failure; such a view reads as empty. A view must not be used by two
+// threads at once, nor after db_snapshot_end.
+typedef struct DBSnapshot DBSnapshot;
+DBSnapshot* db_snapshot_begin(Database *db);
+void db_snapshot_end(DBSnapshot *snapshot);
+const char* db_snapshot_get(DBSnapshot *snapshot, const char *key);
+const char* db_snapshot_get_n(DBSnapshot *snapshot, const char *key, size_t key_len,
+                              size_t *value_len);
+size_t db_snapshot_scan(DBSnapshot *snapshot, char *out, size_t out_size,
+                        size_t max_records, bool *done);
+bool db_snapshot_save(DBSnapshot *snapshot, const char *path);  // Before any scan
+size_t db_snapshot_count(const DBSnapshot *snapshot);   // db_count at the start
+size_t db_snapshot_memory(const DBSnapshot *snapshot);  // Bytes of saved versions
+bool db_snapshot_ok(const DBSnapshot *snapshot);
+
+// Ordered scans: once the index is enabled, cursors walk the keys with a
+// given prefix or in a range in key order, each step O(1) amortized.
+// db_cursor_fetch packs DBScanRecord records; as with db_scan, 0 records
+// with *done false means the next record didn't fit.
+typedef struct DBCursor DBCursor;
+bool db_enable_ordered_index(Database *db);
+DBCursor* db_scan_prefix(Database *db, const char *prefix);
+DBCursor* db_scan_range(Database *db, const char *start, const char *end);
+bool db_cursor_next(DBCursor *cursor, const char **key, const char **value);
+size_t db_cursor_fetch(DBCursor *cursor, char *out, size_t out_size, size_t max_records,
+                       bool *done);
+void db_cursor_seek_after(DBCursor *cursor, const char *key);
+void db_cursor_close(DBCursor *cursor);
+
+// Sharded mode: the keyspace is split over `shards` Databases, each served
+// by its own thread pinned to a core and fed over lock-free SPSC queues.
+// Every calling thread opens its own client handle; a handle must not be
+// used by two threads at once. Keys are key_len bytes as in db_set_n;
+// batches use the packed format of db_mset/db_mget/db_mdelete.
+typedef struct ShardedDatabase ShardedDatabase;
+typedef struct DBShardClient DBShardClient;
+ShardedDatabase* db_sharded_create(DBEngine engine, size_t shards, size_t capacity);
+void db_sharded_destroy(ShardedDatabase *sdb);
+DBShardClient* db_sharded_client_open(ShardedDatabase *sdb);
+void db_sharded_client_close(DBShardClient *client);
+bool db_sharded_set(DBShardClient *client, const char *key, size_t key_len,
+                    const char *value, size_t value_len);
+long db_sharded_get(DBShardClient *client, const char *key, size_t key_len,
+                    char *buf, size_t size);
+bool db_sharded_delete(DBShardClient *client, const char *key, size_t key_len);
+size_t db_sharded_mset(DBShardClient *client, const char *keys, const char *values,
+                       size_t n);
+size_t db_sharded_mget(DBShardClient *client, const char *keys, size_t n, char *out,
+                       size_t out_size, long *lengths);
+size_t db_sharded_mdelete(DBShardClient *client, const char *keys, size_t n);
+size_t db_sharded_count(ShardedDatabase *sdb);
+Database* db_sharded_shard(ShardedDatabase *sdb, size_t i);
+
+// Utility functions
+size_t db_count(Database *db);
+void db_clear(Database *db);
+char** db_keys(Database *db, size_t *count);  // Pointers into live entries; prefer db_scan
+DBStats db_stats(Database *db);
+bool db_stats_ex(Database *db, DBStatsEx *stats);
+uint64_t db_latency_bucket_ns(size_t bucket);   // Lower bound of a latency bucket
+uint64_t db_latency_percentile(const DBOpStats *op, double percentile);  // ns, 0 if none sampled
+void db_print(Database *db);
+
+#endif
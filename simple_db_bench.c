@@ -0,0 +1,413 @@
+/*
+ * Multi-threaded throughput benchmark for simple_db
+ *
+ * Runs a mixed get/set workload over a preloaded key space with 1, 2, 4 ...
+ * N threads and reports ops/sec and speedup. Each point is also run with
+ * every operation wrapped in one global mutex, which is how callers had to
+ * share a Database before the striped locks, for comparison. With -S the
+ * same workload also runs against a ShardedDatabase of that many shards,
+ * each thread through its own client handle. With -b, reads are issued as
+ * mget batches of that many keys (each key counts as one op).
+ *
+ * With -l it measures db_set latency instead: max_threads writers, run
+ * without a write-ahead log, with one (group commit in the background), and
+ * with one in wait_durable mode, reporting p50/p99/p99.9 for each.
+ *
+ * Usage:
+ *   simple_db_bench [-t max_threads] [-k keys] [-s seconds] [-r read_pct]
+ *                   [-e chained|swiss] [-S shards] [-b batch] [-l] [-w wal_path]
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 simple_db_bench.c simple_db.c -o simple_db_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "simple_db.h"
+
+typedef struct {
+    int max_threads;
+    size_t keys;
+    double seconds;
+    int read_pct;
+    DBEngine engine;
+    size_t shards;                  // 0: no sharded column
+    int batch;                      // Keys per read; > 1 uses mget
+    bool latency;
+    const char *wal_path;
+} BenchConfig;
+
+typedef struct {
+    Database *db;
+    ShardedDatabase *sdb;           // Set: go through a client handle instead
+    const BenchConfig *config;
+    pthread_mutex_t *global_lock;   // NULL: call the DB directly
+    uint64_t seed;
+    uint64_t ops;
+    uint32_t *samples;              // Latency mode: ns per db_set
+    size_t sample_count;
+    size_t sample_cap;
+} Worker;
+
+static volatile int running;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64: cheap per-thread random numbers, no shared state
+static inline uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#define MAX_BATCH 256
+
+// One read of config->batch random keys: db_get_copy, or mget for batches
+static void read_keys(Worker *w, DBShardClient *client, uint64_t r, char *keys,
+                      char *out, long *lengths) {
+    int n = w->config->batch;
+    if (n <= 1) {
+        char key[32], buf[64];
+        int len = snprintf(key, sizeof(key), "key_%zu", (size_t)(r >> 8) % w->config->keys);
+        if (client) {
+            db_sharded_get(client, key, len, buf, sizeof(buf));
+        } else {
+            db_get_copy(w->db, key, buf, sizeof(buf));
+        }
+        return;
+    }
+    
+    size_t used = 0;
+    for (int i = 0; i < n; i++) {
+        size_t k = (size_t)(next_random(&w->seed) >> 8) % w->config->keys;
+        used += snprintf(keys + used, 32, "key_%zu", k) + 1;
+    }
+    if (client) {
+        db_sharded_mget(client, keys, n, out, MAX_BATCH * 64, lengths);
+    } else {
+        db_mget(w->db, keys, n, out, MAX_BATCH * 64, lengths);
+    }
+}
+
+static void* worker_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    char key[32], value[32];
+    char *keys = (char*)malloc(MAX_BATCH * 32);
+    char *out = (char*)malloc(MAX_BATCH * 64);
+    long lengths[MAX_BATCH];
+    DBShardClient *client = w->sdb ? db_sharded_client_open(w->sdb) : NULL;
+    uint64_t ops = 0;
+    if (!keys || !out || (w->sdb && !client)) {
+        free(keys);
+        free(out);
+        return NULL;
+    }
+    
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        // Check the clock rarely; batches of 256 ops
+        for (int i = 0; i < 256; i++) {
+            uint64_t r = next_random(&w->seed);
+            size_t k = (size_t)(r >> 8) % w->config->keys;
+            bool read = (int)(r & 0x7f) * 100 / 128 < w->config->read_pct;
+            
+            if (w->global_lock) pthread_mutex_lock(w->global_lock);
+            if (read) {
+                read_keys(w, client, r, keys, out, lengths);
+                ops += w->config->batch - 1;
+            } else {
+                int key_len = snprintf(key, sizeof(key), "key_%zu", k);
+                int value_len = snprintf(value, sizeof(value), "value_%zu_%u", k,
+                                         (unsigned)(r & 0xff));
+                if (client) {
+                    db_sharded_set(client, key, key_len, value, value_len);
+                } else {
+                    db_set(w->db, key, value);
+                }
+            }
+            if (w->global_lock) pthread_mutex_unlock(w->global_lock);
+        }
+        ops += 256;
+    }
+    
+    db_sharded_client_close(client);
+    free(keys);
+    free(out);
+    w->ops = ops;
+    return NULL;
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Latency mode: time every db_set; samples past the buffer are dropped
+static void* writer_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    char key[32], value[32];
+    uint64_t ops = 0;
+    
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        uint64_t r = next_random(&w->seed);
+        size_t k = (size_t)(r >> 8) % w->config->keys;
+        snprintf(key, sizeof(key), "key_%zu", k);
+        snprintf(value, sizeof(value), "value_%zu_%u", k, (unsigned)(r & 0xff));
+        
+        uint64_t start = now_ns();
+        db_set(w->db, key, value);
+        uint64_t elapsed = now_ns() - start;
+        
+        if (w->sample_count < w->sample_cap) {
+            w->samples[w->sample_count++] = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+        }
+        ops++;
+    }
+    
+    w->ops = ops;
+    return NULL;
+}
+
+// Run `threads` workers for the configured time and return ops/sec
+static double run_point(Database *db, ShardedDatabase *sdb, const BenchConfig *config,
+                        int threads, pthread_mutex_t *global_lock) {
+    pthread_t *tids = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    Worker *workers = (Worker*)calloc(threads, sizeof(Worker));
+    if (!tids || !workers) {
+        free(tids);
+        free(workers);
+        return 0;
+    }
+    
+    running = 1;
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){ db, sdb, config, global_lock, 0x9E3779B97F4A7C15ull * (t + 1),
+                               0, NULL, 0, 0 };
+        pthread_create(&tids[t], NULL, worker_main, &workers[t]);
+    }
+    
+    double start = now_seconds();
+    usleep((useconds_t)(config->seconds * 1e6));
+    __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+    
+    uint64_t total = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        total += workers[t].ops;
+    }
+    double elapsed = now_seconds() - start;
+    
+    free(tids);
+    free(workers);
+    return total / elapsed;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint32_t *sorted, size_t n, double p) {
+    if (n == 0) return 0;
+    size_t i = (size_t)(p / 100.0 * (n - 1));
+    return sorted[i] / 1000.0;
+}
+
+// One latency row: a fresh preloaded database, optionally logging to
+// config->wal_path, with max_threads writers
+static bool run_latency(const BenchConfig *config, const char *label, const DBWalConfig *wal) {
+    Database *db = db_create_ex(config->engine, config->keys);
+    if (!db) return false;
+    
+    char key[32], value[32];
+    for (size_t k = 0; k < config->keys; k++) {
+        snprintf(key, sizeof(key), "key_%zu", k);
+        snprintf(value, sizeof(value), "value_%zu", k);
+        db_set(db, key, value);
+    }
+    
+    remove(config->wal_path);
+    if (wal && !db_wal_open(db, config->wal_path, wal)) {
+        fprintf(stderr, "Failed to open WAL at %s\n", config->wal_path);
+        db_destroy(db);
+        return false;
+    }
+    
+    int threads = config->max_threads;
+    pthread_t *tids = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    Worker *workers = (Worker*)calloc(threads, sizeof(Worker));
+    size_t cap = 1 << 22;
+    bool ok = tids && workers;
+    for (int t = 0; ok && t < threads; t++) {
+        workers[t] = (Worker){ db, NULL, config, NULL, 0x9E3779B97F4A7C15ull * (t + 1), 0,
+                               (uint32_t*)malloc(cap * sizeof(uint32_t)), 0, cap };
+        ok = workers[t].samples != NULL;
+    }
+    
+    if (ok) {
+        running = 1;
+        for (int t = 0; t < threads; t++) {
+            pthread_create(&tids[t], NULL, writer_main, &workers[t]);
+        }
+        double start = now_seconds();
+        usleep((useconds_t)(config->seconds * 1e6));
+        __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+        
+        uint64_t ops = 0;
+        size_t n = 0;
+        for (int t = 0; t < threads; t++) {
+            pthread_join(tids[t], NULL);
+            ops += workers[t].ops;
+            n += workers[t].sample_count;
+        }
+        double elapsed = now_seconds() - start;
+        
+        // Percentiles over every thread's samples
+        uint32_t *all = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+        size_t used = 0;
+        for (int t = 0; all && t < threads; t++) {
+            memcpy(all + used, workers[t].samples, workers[t].sample_count * sizeof(uint32_t));
+            used += workers[t].sample_count;
+        }
+        if (all) {
+            qsort(all, used, sizeof(uint32_t), compare_u32);
+            printf("%-20s %12.0f %10.1f %10.1f %10.1f %10.1f\n", label, ops / elapsed,
+                   percentile_us(all, used, 50), percentile_us(all, used, 99),
+                   percentile_us(all, used, 99.9), used ? all[used - 1] / 1000.0 : 0);
+        }
+        ok = all != NULL;
+        free(all);
+    }
+    
+    for (int t = 0; workers && t < threads; t++) free(workers[t].samples);
+    free(tids);
+    free(workers);
+    db_destroy(db);
+    remove(config->wal_path);
+    return ok;
+}
+
+static int latency_main(const BenchConfig *config) {
+    printf("simple_db write latency: %s engine, %zu keys, %d writer(s), %.1fs per row\n",
+           config->engine == DB_ENGINE_SWISS ? "swiss" : "chained",
+           config->keys, config->max_threads, config->seconds);
+    printf("%-20s %12s %10s %10s %10s %10s\n", "mode", "sets/s", "p50 us", "p99 us",
+           "p99.9 us", "max us");
+    
+    DBWalConfig async = { 0, 0, false };
+    DBWalConfig durable = { 0, 0, true };
+    bool ok = run_latency(config, "no WAL", NULL) &&
+              run_latency(config, "WAL group commit", &async) &&
+              run_latency(config, "WAL wait_durable", &durable);
+    return ok ? 0 : 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-t max_threads] [-k keys] [-s seconds] "
+                    "[-r read_pct] [-e chained|swiss] [-S shards] [-b batch] [-l] "
+                    "[-w wal_path]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    BenchConfig config = { cpus > 0 ? (int)cpus : 1, 1000000, 1.0, 90, DB_ENGINE_CHAINED,
+                           0, 1, false, "/tmp/simple_db_bench.wal" };
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "t:k:s:r:e:S:b:lw:h")) != -1) {
+        switch (opt) {
+            case 't': config.max_threads = atoi(optarg); break;
+            case 'k': config.keys = (size_t)atol(optarg); break;
+            case 's': config.seconds = atof(optarg); break;
+            case 'r': config.read_pct = atoi(optarg); break;
+            case 'e':
+                config.engine = strcmp(optarg, "swiss") == 0 ? DB_ENGINE_SWISS : DB_ENGINE_CHAINED;
+                break;
+            case 'S': config.shards = (size_t)atol(optarg); break;
+            case 'b': config.batch = atoi(optarg); break;
+            case 'l': config.latency = true; break;
+            case 'w': config.wal_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.max_threads < 1 || config.keys == 0 || config.seconds <= 0 ||
+        config.batch < 1 || config.batch > MAX_BATCH) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    if (config.latency) return latency_main(&config);
+    
+    Database *db = db_create_ex(config.engine, config.keys);
+    if (!db) {
+        fprintf(stderr, "Failed to create database\n");
+        return 1;
+    }
+    
+    ShardedDatabase *sdb = NULL;
+    DBShardClient *loader = NULL;
+    if (config.shards) {
+        sdb = db_sharded_create(config.engine, config.shards, config.keys);
+        loader = db_sharded_client_open(sdb);
+        if (!loader) {
+            fprintf(stderr, "Failed to create sharded database\n");
+            return 1;
+        }
+    }
+    
+    char key[32], value[32];
+    for (size_t k = 0; k < config.keys; k++) {
+        int key_len = snprintf(key, sizeof(key), "key_%zu", k);
+        int value_len = snprintf(value, sizeof(value), "value_%zu", k);
+        db_set(db, key, value);
+        if (loader) db_sharded_set(loader, key, key_len, value, value_len);
+    }
+    db_sharded_client_close(loader);
+    
+    printf("simple_db throughput: %s engine, %zu keys, %d%% reads, %d key(s) per read, "
+           "%.1fs per point\n", config.engine == DB_ENGINE_SWISS ? "swiss" : "chained",
+           config.keys, config.read_pct, config.batch, config.seconds);
+    printf("%8s %16s %9s %18s %9s", "threads", "striped ops/s", "speedup",
+           "global-lock ops/s", "speedup");
+    if (sdb) printf(" %17s %9s", "sharded ops/s", "speedup");
+    printf("\n");
+    
+    pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+    double base_striped = 0, base_global = 0, base_sharded = 0;
+    for (int threads = 1; ; threads = threads * 2 > config.max_threads && threads < config.max_threads
+                                      ? config.max_threads : threads * 2) {
+        double striped = run_point(db, NULL, &config, threads, NULL);
+        double global = run_point(db, NULL, &config, threads, &global_lock);
+        double sharded = sdb ? run_point(NULL, sdb, &config, threads, NULL) : 0;
+        if (threads == 1) {
+            base_striped = striped;
+            base_global = global;
+            base_sharded = sharded;
+        }
+        
+        printf("%8d %16.0f %8.2fx %18.0f %8.2fx", threads,
+               striped, base_striped > 0 ? striped / base_striped : 0,
+               global, base_global > 0 ? global / base_global : 0);
+        if (sdb) printf(" %17.0f %8.2fx", sharded, base_sharded > 0 ? sharded / base_sharded : 0);
+        printf("\n");
+        if (threads >= config.max_threads) break;
+    }
+    
+    db_sharded_destroy(sdb);
+    db_destroy(db);
+    return 0;
+}
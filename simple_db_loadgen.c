@@ -0,0 +1,383 @@
+/*
+ * Load generator for simple_db_server
+ *
+ * Opens -c connections, one thread each, preloads the key space with
+ * pipelined SETs, then for the configured time sends batches of -P
+ * commands (a read_pct mix of GET and SET over random keys) and waits for
+ * all their replies before the next batch. Reports requests/sec and
+ * p50/p99/p99.9/max of the batch round trip, which is the latency every
+ * request in the batch saw.
+ *
+ * Usage:
+ *   simple_db_loadgen [-H host] [-p port] [-c connections] [-P pipeline]
+ *                     [-s seconds] [-r read_pct] [-k keys] [-v value_size]
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 simple_db_loadgen.c -o simple_db_loadgen
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+typedef struct {
+    const char *host;
+    const char *port;
+    int connections;
+    int pipeline;
+    double seconds;
+    int read_pct;
+    size_t keys;
+    size_t value_size;
+} LoadConfig;
+
+typedef struct {
+    const LoadConfig *config;
+    uint64_t seed;
+    uint64_t requests;
+    uint64_t errors;
+    uint32_t *samples;              // ns per batch round trip
+    size_t sample_count;
+    size_t sample_cap;
+    bool failed;
+} Client;
+
+// Replies read so far on one connection
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} ReplyBuffer;
+
+static volatile int running;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// xorshift64: cheap per-thread random numbers, no shared state
+static inline uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static int connect_to(const LoadConfig *config) {
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res;
+    if (getaddrinfo(config->host, config->port, &hints, &res) != 0) return -1;
+    
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Length of the complete reply at p, or 0 if more bytes are needed. Only
+// the reply types GET and SET produce (+, -, :, $) are expected.
+static size_t reply_length(const char *p, size_t avail) {
+    const char *end = memchr(p, '\n', avail);
+    if (!end) return 0;
+    size_t line = (size_t)(end - p) + 1;
+    if (p[0] != '$') return line;
+    
+    long long n = strtoll(p + 1, NULL, 10);
+    if (n < 0) return line;
+    size_t total = line + (size_t)n + 2;
+    return total <= avail ? total : 0;
+}
+
+// Read until `count` replies have arrived; false if the connection failed
+static bool read_replies(int fd, ReplyBuffer *in, int count, uint64_t *errors) {
+    size_t pos = 0;
+    while (count > 0) {
+        size_t n = pos < in->len ? reply_length(in->data + pos, in->len - pos) : 0;
+        if (n > 0) {
+            if (in->data[pos] == '-') (*errors)++;
+            pos += n;
+            count--;
+            continue;
+        }
+        
+        // Need more: keep the partial reply, then read
+        memmove(in->data, in->data + pos, in->len - pos);
+        in->len -= pos;
+        pos = 0;
+        if (in->cap - in->len < 4096) {
+            size_t cap = in->cap * 2;
+            char *data = (char*)realloc(in->data, cap);
+            if (!data) return false;
+            in->data = data;
+            in->cap = cap;
+        }
+        ssize_t got = recv(fd, in->data + in->len, in->cap - in->len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        in->len += (size_t)got;
+    }
+    
+    memmove(in->data, in->data + pos, in->len - pos);
+    in->len -= pos;
+    return true;
+}
+
+// Append one RESP command of `argc` arguments to out; returns the new length
+static size_t append_command(char *out, size_t len, int argc, const char **argv,
+                             const size_t *argl) {
+    len += (size_t)sprintf(out + len, "*%d\r\n", argc);
+    for (int i = 0; i < argc; i++) {
+        len += (size_t)sprintf(out + len, "$%zu\r\n", argl[i]);
+        memcpy(out + len, argv[i], argl[i]);
+        len += argl[i];
+        out[len++] = '\r';
+        out[len++] = '\n';
+    }
+    return len;
+}
+
+static size_t append_set(char *out, size_t len, const char *key, size_t key_len,
+                         const char *value, size_t value_len) {
+    const char *argv[3] = { "SET", key, value };
+    size_t argl[3] = { 3, key_len, value_len };
+    return append_command(out, len, 3, argv, argl);
+}
+
+static size_t append_get(char *out, size_t len, const char *key, size_t key_len) {
+    const char *argv[2] = { "GET", key };
+    size_t argl[2] = { 3, key_len };
+    return append_command(out, len, 2, argv, argl);
+}
+
+// Room for one command of either kind
+static size_t command_bytes(const LoadConfig *config) {
+    return 96 + config->value_size;
+}
+
+static void* client_main(void *arg) {
+    Client *c = (Client*)arg;
+    const LoadConfig *config = c->config;
+    int fd = connect_to(config);
+    char *out = (char*)malloc(command_bytes(config) * config->pipeline);
+    char *value = (char*)malloc(config->value_size);
+    ReplyBuffer in = { (char*)malloc(65536), 0, 65536 };
+    if (fd < 0 || !out || !value || !in.data) {
+        c->failed = true;
+        goto done;
+    }
+    memset(value, 'v', config->value_size);
+    
+    char key[32];
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        size_t len = 0;
+        for (int i = 0; i < config->pipeline; i++) {
+            uint64_t r = next_random(&c->seed);
+            size_t k = (size_t)(r >> 8) % config->keys;
+            int key_len = snprintf(key, sizeof(key), "key_%zu", k);
+            if ((int)(r & 0xff) * 100 < config->read_pct * 256) {
+                len = append_get(out, len, key, key_len);
+            } else {
+                len = append_set(out, len, key, key_len, value, config->value_size);
+            }
+        }
+        
+        uint64_t start = now_ns();
+        if (!send_all(fd, out, len) || !read_replies(fd, &in, config->pipeline, &c->errors)) {
+            c->failed = true;
+            break;
+        }
+        uint64_t elapsed = now_ns() - start;
+        
+        if (c->sample_count < c->sample_cap) {
+            c->samples[c->sample_count++] = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+        }
+        c->requests += (uint64_t)config->pipeline;
+    }
+
+done:
+    if (fd >= 0) close(fd);
+    free(out);
+    free(value);
+    free(in.data);
+    return NULL;
+}
+
+// Store every key once, 1000 SETs per round trip
+static bool preload(const LoadConfig *config) {
+    int fd = connect_to(config);
+    if (fd < 0) return false;
+    
+    enum { BATCH = 1000 };
+    char *out = (char*)malloc(command_bytes(config) * BATCH);
+    char *value = (char*)malloc(config->value_size);
+    ReplyBuffer in = { (char*)malloc(65536), 0, 65536 };
+    bool ok = out && value && in.data;
+    if (ok) memset(value, 'v', config->value_size);
+    
+    char key[32];
+    uint64_t errors = 0;
+    for (size_t k = 0; ok && k < config->keys; ) {
+        size_t len = 0;
+        int n = 0;
+        for (; n < BATCH && k < config->keys; n++, k++) {
+            int key_len = snprintf(key, sizeof(key), "key_%zu", k);
+            len = append_set(out, len, key, key_len, value, config->value_size);
+        }
+        ok = send_all(fd, out, len) && read_replies(fd, &in, n, &errors) && errors == 0;
+    }
+    
+    close(fd);
+    free(out);
+    free(value);
+    free(in.data);
+    return ok;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint32_t *sorted, size_t n, double p) {
+    if (n == 0) return 0;
+    size_t i = (size_t)(p / 100.0 * (n - 1));
+    return sorted[i] / 1000.0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-H host] [-p port] [-c connections] [-P pipeline] "
+                    "[-s seconds] [-r read_pct] [-k keys] [-v value_size]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    LoadConfig config = { "127.0.0.1", "6380", 4, 16, 2.0, 90, 100000, 32 };
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:c:P:s:r:k:v:h")) != -1) {
+        switch (opt) {
+            case 'H': config.host = optarg; break;
+            case 'p': config.port = optarg; break;
+            case 'c': config.connections = atoi(optarg); break;
+            case 'P': config.pipeline = atoi(optarg); break;
+            case 's': config.seconds = atof(optarg); break;
+            case 'r': config.read_pct = atoi(optarg); break;
+            case 'k': config.keys = (size_t)atol(optarg); break;
+            case 'v': config.value_size = (size_t)atol(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.connections < 1 || config.pipeline < 1 || config.seconds <= 0 ||
+        config.keys == 0 || config.value_size == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    if (!preload(&config)) {
+        fprintf(stderr, "Failed to preload %s:%s\n", config.host, config.port);
+        return 1;
+    }
+    
+    printf("simple_db loadgen: %s:%s, %d connection(s), pipeline %d, %d%% reads, "
+           "%zu keys, %zu-byte values, %.1fs\n", config.host, config.port,
+           config.connections, config.pipeline, config.read_pct, config.keys,
+           config.value_size, config.seconds);
+    
+    int n = config.connections;
+    pthread_t *tids = (pthread_t*)malloc(sizeof(pthread_t) * n);
+    Client *clients = (Client*)calloc(n, sizeof(Client));
+    size_t cap = 1 << 20;
+    bool ok = tids && clients;
+    for (int i = 0; ok && i < n; i++) {
+        clients[i] = (Client){ &config, 0x9E3779B97F4A7C15ull * (i + 1), 0, 0,
+                               (uint32_t*)malloc(cap * sizeof(uint32_t)), 0, cap, false };
+        ok = clients[i].samples != NULL;
+    }
+    
+    if (ok) {
+        running = 1;
+        for (int i = 0; i < n; i++) pthread_create(&tids[i], NULL, client_main, &clients[i]);
+        double start = now_seconds();
+        usleep((useconds_t)(config.seconds * 1e6));
+        __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+        
+        uint64_t requests = 0, errors = 0;
+        size_t samples = 0;
+        for (int i = 0; i < n; i++) {
+            pthread_join(tids[i], NULL);
+            requests += clients[i].requests;
+            errors += clients[i].errors;
+            samples += clients[i].sample_count;
+            if (clients[i].failed) ok = false;
+        }
+        double elapsed = now_seconds() - start;
+        
+        // Percentiles over every connection's batches
+        uint32_t *all = (uint32_t*)malloc((samples ? samples : 1) * sizeof(uint32_t));
+        size_t used = 0;
+        for (int i = 0; all && i < n; i++) {
+            memcpy(all + used, clients[i].samples, clients[i].sample_count * sizeof(uint32_t));
+            used += clients[i].sample_count;
+        }
+        if (all) {
+            qsort(all, used, sizeof(uint32_t), compare_u32);
+            printf("%12s %10s %10s %10s %10s %10s\n", "requests/s", "p50 us", "p99 us",
+                   "p99.9 us", "max us", "errors");
+            printf("%12.0f %10.1f %10.1f %10.1f %10.1f %10llu\n", requests / elapsed,
+                   percentile_us(all, used, 50), percentile_us(all, used, 99),
+                   percentile_us(all, used, 99.9), used ? all[used - 1] / 1000.0 : 0,
+                   (unsigned long long)errors);
+        }
+        if (!ok) fprintf(stderr, "A connection failed before the run ended\n");
+        free(all);
+    }
+    
+    for (int i = 0; clients && i < n; i++) free(clients[i].samples);
+    free(tids);
+    free(clients);
+    return ok ? 0 : 1;
+}
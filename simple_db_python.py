@@ -14,8 +14,11 @@ Usage:
 
 import ctypes
 import os
+import struct
 import sys
-from typing import Optional, List, Dict
+import threading
+import time
+from typing import Optional, List, Dict, Iterable, Iterator, Mapping, Tuple, Union
 
 # Determine the library name based on platform
 if sys.platform == 'darwin':
@@ -54,8 +57,56 @@ class DBStats(ctypes.Structure):
         ("total_collisions", ctypes.c_size_t),
         ("max_chain_length", ctypes.c_size_t),
         ("used_buckets", ctypes.c_size_t),
+        ("total_buckets", ctypes.c_size_t),
+        ("hits", ctypes.c_uint64),
+        ("misses", ctypes.c_uint64),
+        ("evictions", ctypes.c_uint64),
+        ("expirations", ctypes.c_uint64),
+        ("memory_used", ctypes.c_size_t),
     ]
 
+DB_OP_KINDS = 3
+DB_LATENCY_BUCKETS = 256
+DB_PROBE_BUCKETS = 16
+
+class DBOpStats(ctypes.Structure):
+    """Counters and histograms for one kind of operation"""
+    _fields_ = [
+        ("count", ctypes.c_uint64),
+        ("found", ctypes.c_uint64),
+        ("sampled", ctypes.c_uint64),
+        ("latency", ctypes.c_uint64 * DB_LATENCY_BUCKETS),
+        ("probes", ctypes.c_uint64 * DB_PROBE_BUCKETS),
+    ]
+
+class DBStatsEx(ctypes.Structure):
+    """Extended statistics structure (db_stats_ex)"""
+    _fields_ = [
+        ("total_entries", ctypes.c_size_t),
+        ("total_buckets", ctypes.c_size_t),
+        ("memory_used", ctypes.c_size_t),
+        ("evictions", ctypes.c_uint64),
+        ("expirations", ctypes.c_uint64),
+        ("ops", DBOpStats * DB_OP_KINDS),
+    ]
+
+class DBWalConfig(ctypes.Structure):
+    """Write-ahead log settings structure (zero fields take the defaults)"""
+    _fields_ = [
+        ("flush_interval_us", ctypes.c_uint),
+        ("batch_bytes", ctypes.c_size_t),
+        ("wait_durable", ctypes.c_bool),
+    ]
+
+# Storage engines (enum DBEngine)
+DB_ENGINE_CHAINED = 0
+DB_ENGINE_SWISS = 1
+
+ENGINES = {
+    'chained': DB_ENGINE_CHAINED,
+    'swiss': DB_ENGINE_SWISS,
+}
+
 # ============================================================================
 # C Function Signatures
 # ============================================================================
@@ -64,6 +115,46 @@ class DBStats(ctypes.Structure):
 lib.db_create.argtypes = []
 lib.db_create.restype = ctypes.c_void_p
 
+# Database* db_create_with_capacity(size_t capacity)
+lib.db_create_with_capacity.argtypes = [ctypes.c_size_t]
+lib.db_create_with_capacity.restype = ctypes.c_void_p
+
+# Database* db_create_ex(DBEngine engine, size_t capacity)
+lib.db_create_ex.argtypes = [ctypes.c_int, ctypes.c_size_t]
+lib.db_create_ex.restype = ctypes.c_void_p
+
+# bool db_save(Database *db, const char *path)
+lib.db_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_save.restype = ctypes.c_bool
+
+# Database* db_open_mmap(const char *path)
+lib.db_open_mmap.argtypes = [ctypes.c_char_p]
+lib.db_open_mmap.restype = ctypes.c_void_p
+
+# bool db_wal_open(Database *db, const char *path, const DBWalConfig *config)
+lib.db_wal_open.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(DBWalConfig)]
+lib.db_wal_open.restype = ctypes.c_bool
+
+# bool db_wal_sync(Database *db)
+lib.db_wal_sync.argtypes = [ctypes.c_void_p]
+lib.db_wal_sync.restype = ctypes.c_bool
+
+# void db_wal_close(Database *db)
+lib.db_wal_close.argtypes = [ctypes.c_void_p]
+lib.db_wal_close.restype = None
+
+# bool db_compact(Database *db, const char *snapshot_path)
+lib.db_compact.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_compact.restype = ctypes.c_bool
+
+# bool db_save_background(Database *db, const char *path)
+lib.db_save_background.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_save_background.restype = ctypes.c_bool
+
+# bool db_save_wait(Database *db)
+lib.db_save_wait.argtypes = [ctypes.c_void_p]
+lib.db_save_wait.restype = ctypes.c_bool
+
 # void db_destroy(Database *db)
 lib.db_destroy.argtypes = [ctypes.c_void_p]
 lib.db_destroy.restype = None
@@ -76,6 +167,10 @@ lib.db_set.restype = ctypes.c_bool
 lib.db_get.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
 lib.db_get.restype = ctypes.c_char_p
 
+# long db_get_copy(Database *db, const char *key, char *buf, size_t size)
+lib.db_get_copy.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_get_copy.restype = ctypes.c_long
+
 # bool db_delete(Database *db, const char *key)
 lib.db_delete.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
 lib.db_delete.restype = ctypes.c_bool
@@ -84,6 +179,132 @@ lib.db_delete.restype = ctypes.c_bool
 lib.db_exists.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
 lib.db_exists.restype = ctypes.c_bool
 
+# bool db_set_n(Database *db, const char *key, size_t key_len, const char *value,
+#               size_t value_len)
+lib.db_set_n.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                         ctypes.c_char_p, ctypes.c_size_t]
+lib.db_set_n.restype = ctypes.c_bool
+
+# const char* db_get_n(Database *db, const char *key, size_t key_len, size_t *value_len)
+# (void* rather than char*: ctypes would stop a char* result at the first NUL)
+lib.db_get_n.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                         ctypes.POINTER(ctypes.c_size_t)]
+lib.db_get_n.restype = ctypes.c_void_p
+
+# bool db_delete_n(Database *db, const char *key, size_t key_len)
+lib.db_delete_n.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_delete_n.restype = ctypes.c_bool
+
+# bool db_set_max_value_length(Database *db, size_t max_len)
+lib.db_set_max_value_length.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+lib.db_set_max_value_length.restype = ctypes.c_bool
+
+# bool db_set_ex_n(Database *db, const char *key, size_t key_len, const char *value,
+#                  size_t value_len, uint64_t ttl_ms)
+lib.db_set_ex_n.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                            ctypes.c_char_p, ctypes.c_size_t, ctypes.c_uint64]
+lib.db_set_ex_n.restype = ctypes.c_bool
+
+# long long db_ttl(Database *db, const char *key)
+lib.db_ttl.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_ttl.restype = ctypes.c_longlong
+
+# bool db_set_max_memory(Database *db, size_t max_bytes)
+lib.db_set_max_memory.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+lib.db_set_max_memory.restype = ctypes.c_bool
+
+# uint64_t db_hash(const char *key)
+lib.db_hash.argtypes = [ctypes.c_char_p]
+lib.db_hash.restype = ctypes.c_uint64
+
+# bool db_set_hashed(Database *db, const char *key, const char *value, uint64_t hash)
+lib.db_set_hashed.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint64]
+lib.db_set_hashed.restype = ctypes.c_bool
+
+# const char* db_get_hashed(Database *db, const char *key, uint64_t hash)
+lib.db_get_hashed.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint64]
+lib.db_get_hashed.restype = ctypes.c_char_p
+
+# size_t db_mset(Database *db, const char *keys, const char *values, size_t n)
+lib.db_mset.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_mset.restype = ctypes.c_size_t
+
+# size_t db_mget(Database *db, const char *keys, size_t n, char *out, size_t out_size,
+#                long *lengths)
+lib.db_mget.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                        ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_long)]
+lib.db_mget.restype = ctypes.c_size_t
+
+# size_t db_mdelete(Database *db, const char *keys, size_t n)
+lib.db_mdelete.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_mdelete.restype = ctypes.c_size_t
+
+# size_t db_scan(Database *db, uint64_t *cursor, char *out, size_t out_size, size_t max_records,
+#                bool *done)
+lib.db_scan.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint64), ctypes.c_char_p,
+                        ctypes.c_size_t, ctypes.c_size_t, ctypes.POINTER(ctypes.c_bool)]
+lib.db_scan.restype = ctypes.c_size_t
+
+# DBSnapshot* db_snapshot_begin(Database *db)
+lib.db_snapshot_begin.argtypes = [ctypes.c_void_p]
+lib.db_snapshot_begin.restype = ctypes.c_void_p
+
+# void db_snapshot_end(DBSnapshot *snapshot)
+lib.db_snapshot_end.argtypes = [ctypes.c_void_p]
+lib.db_snapshot_end.restype = None
+
+# const char* db_snapshot_get(DBSnapshot *snapshot, const char *key)
+lib.db_snapshot_get.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_snapshot_get.restype = ctypes.c_char_p
+
+# size_t db_snapshot_scan(DBSnapshot *snapshot, char *out, size_t out_size, size_t max_records,
+#                         bool *done)
+lib.db_snapshot_scan.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                                 ctypes.c_size_t, ctypes.POINTER(ctypes.c_bool)]
+lib.db_snapshot_scan.restype = ctypes.c_size_t
+
+# bool db_snapshot_save(DBSnapshot *snapshot, const char *path)
+lib.db_snapshot_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_snapshot_save.restype = ctypes.c_bool
+
+# size_t db_snapshot_count(const DBSnapshot *snapshot)
+lib.db_snapshot_count.argtypes = [ctypes.c_void_p]
+lib.db_snapshot_count.restype = ctypes.c_size_t
+
+# size_t db_snapshot_memory(const DBSnapshot *snapshot)
+lib.db_snapshot_memory.argtypes = [ctypes.c_void_p]
+lib.db_snapshot_memory.restype = ctypes.c_size_t
+
+# bool db_snapshot_ok(const DBSnapshot *snapshot)
+lib.db_snapshot_ok.argtypes = [ctypes.c_void_p]
+lib.db_snapshot_ok.restype = ctypes.c_bool
+
+# bool db_enable_ordered_index(Database *db)
+lib.db_enable_ordered_index.argtypes = [ctypes.c_void_p]
+lib.db_enable_ordered_index.restype = ctypes.c_bool
+
+# DBCursor* db_scan_prefix(Database *db, const char *prefix)
+lib.db_scan_prefix.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_scan_prefix.restype = ctypes.c_void_p
+
+# DBCursor* db_scan_range(Database *db, const char *start, const char *end)
+lib.db_scan_range.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+lib.db_scan_range.restype = ctypes.c_void_p
+
+# size_t db_cursor_fetch(DBCursor *cursor, char *out, size_t out_size, size_t max_records,
+#                        bool *done)
+lib.db_cursor_fetch.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_size_t,
+                                ctypes.POINTER(ctypes.c_bool)]
+lib.db_cursor_fetch.restype = ctypes.c_size_t
+
+# void db_cursor_seek_after(DBCursor *cursor, const char *key)
+lib.db_cursor_seek_after.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+lib.db_cursor_seek_after.restype = None
+
+# void db_cursor_close(DBCursor *cursor)
+lib.db_cursor_close.argtypes = [ctypes.c_void_p]
+lib.db_cursor_close.restype = None
+
 # size_t db_count(Database *db)
 lib.db_count.argtypes = [ctypes.c_void_p]
 lib.db_count.restype = ctypes.c_size_t
@@ -100,10 +321,74 @@ lib.db_keys.restype = ctypes.POINTER(ctypes.c_char_p)
 lib.db_stats.argtypes = [ctypes.c_void_p]
 lib.db_stats.restype = DBStats
 
+# bool db_stats_ex(Database *db, DBStatsEx *stats)
+lib.db_stats_ex.argtypes = [ctypes.c_void_p, ctypes.POINTER(DBStatsEx)]
+lib.db_stats_ex.restype = ctypes.c_bool
+
+# uint64_t db_latency_bucket_ns(size_t bucket)
+lib.db_latency_bucket_ns.argtypes = [ctypes.c_size_t]
+lib.db_latency_bucket_ns.restype = ctypes.c_uint64
+
+# uint64_t db_latency_percentile(const DBOpStats *op, double percentile)
+lib.db_latency_percentile.argtypes = [ctypes.POINTER(DBOpStats), ctypes.c_double]
+lib.db_latency_percentile.restype = ctypes.c_uint64
+
 # void db_print(Database *db)
 lib.db_print.argtypes = [ctypes.c_void_p]
 lib.db_print.restype = None
 
+# ShardedDatabase* db_sharded_create(DBEngine engine, size_t shards, size_t capacity)
+lib.db_sharded_create.argtypes = [ctypes.c_int, ctypes.c_size_t, ctypes.c_size_t]
+lib.db_sharded_create.restype = ctypes.c_void_p
+
+# void db_sharded_destroy(ShardedDatabase *sdb)
+lib.db_sharded_destroy.argtypes = [ctypes.c_void_p]
+lib.db_sharded_destroy.restype = None
+
+# DBShardClient* db_sharded_client_open(ShardedDatabase *sdb)
+lib.db_sharded_client_open.argtypes = [ctypes.c_void_p]
+lib.db_sharded_client_open.restype = ctypes.c_void_p
+
+# void db_sharded_client_close(DBShardClient *client)
+lib.db_sharded_client_close.argtypes = [ctypes.c_void_p]
+lib.db_sharded_client_close.restype = None
+
+# bool db_sharded_set(DBShardClient *client, const char *key, size_t key_len,
+#                     const char *value, size_t value_len)
+lib.db_sharded_set.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                               ctypes.c_char_p, ctypes.c_size_t]
+lib.db_sharded_set.restype = ctypes.c_bool
+
+# long db_sharded_get(DBShardClient *client, const char *key, size_t key_len,
+#                     char *buf, size_t size)
+lib.db_sharded_get.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                               ctypes.c_char_p, ctypes.c_size_t]
+lib.db_sharded_get.restype = ctypes.c_long
+
+# bool db_sharded_delete(DBShardClient *client, const char *key, size_t key_len)
+lib.db_sharded_delete.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_sharded_delete.restype = ctypes.c_bool
+
+# size_t db_sharded_mset(DBShardClient *client, const char *keys, const char *values,
+#                        size_t n)
+lib.db_sharded_mset.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p,
+                                ctypes.c_size_t]
+lib.db_sharded_mset.restype = ctypes.c_size_t
+
+# size_t db_sharded_mget(DBShardClient *client, const char *keys, size_t n, char *out,
+#                        size_t out_size, long *lengths)
+lib.db_sharded_mget.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t,
+                                ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_long)]
+lib.db_sharded_mget.restype = ctypes.c_size_t
+
+# size_t db_sharded_mdelete(DBShardClient *client, const char *keys, size_t n)
+lib.db_sharded_mdelete.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+lib.db_sharded_mdelete.restype = ctypes.c_size_t
+
+# size_t db_sharded_count(ShardedDatabase *sdb)
+lib.db_sharded_count.argtypes = [ctypes.c_void_p]
+lib.db_sharded_count.restype = ctypes.c_size_t
+
 # ============================================================================
 # Python Wrapper Class
 # ============================================================================
@@ -111,12 +396,135 @@ lib.db_print.restype = None
 class SimpleDB:
     """Python wrapper for the simple in-memory database"""
     
-    def __init__(self):
-        """Create a new database instance"""
-        self._db = lib.db_create()
+    def __init__(self, capacity: Optional[int] = None, engine: str = 'chained'):
+        """
+        Create a new database instance
+        
+        Args:
+            capacity: Optional number of entries to pre-size the table for,
+                      so bulk loads don't trigger resizes
+            engine: Storage engine, 'chained' (default) or 'swiss'
+        """
+        if engine not in ENGINES:
+            raise ValueError(f"Unknown engine: {engine}")
+        
+        if engine == 'chained' and capacity is None:
+            self._db = lib.db_create()
+        else:
+            self._db = lib.db_create_ex(ENGINES[engine], capacity or 0)
         if not self._db:
             raise MemoryError("Failed to create database")
     
+    @classmethod
+    def open_mmap(cls, path: str) -> 'SimpleDB':
+        """
+        Open a snapshot written by save()
+        
+        The file is memory-mapped instead of loaded, so this returns
+        immediately regardless of its size. Later writes are kept in memory
+        and reach disk through the next save().
+        
+        Args:
+            path: Snapshot file path
+            
+        Raises:
+            OSError: If the file is missing or not a valid snapshot
+        """
+        db = cls.__new__(cls)
+        db._db = lib.db_open_mmap(os.fsencode(path))
+        if not db._db:
+            raise OSError(f"Cannot open snapshot: {path}")
+        return db
+    
+    def save(self, path: str):
+        """
+        Write all entries to a snapshot file (atomically replaced)
+        
+        Raises:
+            OSError: If the file cannot be written
+        """
+        if not lib.db_save(self._db, os.fsencode(path)):
+            raise OSError(f"Cannot save snapshot: {path}")
+    
+    def save_background(self, path: str):
+        """
+        Start writing a snapshot of the database as it is now; writers
+        carry on meanwhile. Call save_wait() for the result.
+        
+        Raises:
+            OSError: If a background save is already running
+        """
+        if not lib.db_save_background(self._db, os.fsencode(path)):
+            raise OSError(f"Cannot start background save: {path}")
+    
+    def save_wait(self):
+        """
+        Wait for the background save to finish
+        
+        Raises:
+            OSError: If none was running or the snapshot could not be written
+        """
+        if not lib.db_save_wait(self._db):
+            raise OSError("Background save failed")
+    
+    def snapshot(self) -> 'ReadView':
+        """
+        Open a read view: the database frozen as it is now, while writes
+        carry on. Use it as a context manager, or close() it promptly;
+        an open view keeps the old value of every key written since.
+        
+        Raises:
+            MemoryError: If the view cannot be allocated
+        """
+        return ReadView(self)
+    
+    def wal_open(self, path: str, flush_interval_us: int = 2000,
+                 batch_bytes: int = 65536, wait_durable: bool = False):
+        """
+        Replay a write-ahead log into the database and log later changes
+        
+        Changes are group-committed by a background thread: one write and
+        sync per flush_interval_us or batch_bytes of changes, whichever
+        comes first. To recover after compact(), open the snapshot with
+        open_mmap() and then call wal_open() on it.
+        
+        Args:
+            path: Log file path (created if missing)
+            flush_interval_us: Longest a change waits to be synced
+            batch_bytes: Buffered bytes that trigger an early flush
+            wait_durable: If True, set/delete return only once synced
+            
+        Raises:
+            OSError: If the log cannot be opened or one is already open
+        """
+        config = DBWalConfig(flush_interval_us, batch_bytes, wait_durable)
+        if not lib.db_wal_open(self._db, os.fsencode(path), ctypes.byref(config)):
+            raise OSError(f"Cannot open write-ahead log: {path}")
+    
+    def wal_sync(self):
+        """
+        Flush and sync the write-ahead log now
+        
+        Raises:
+            OSError: If no log is open or it could not be written
+        """
+        if not lib.db_wal_sync(self._db):
+            raise OSError("Write-ahead log sync failed")
+    
+    def wal_close(self):
+        """Flush and close the write-ahead log, if one is open"""
+        lib.db_wal_close(self._db)
+    
+    def compact(self, path: str):
+        """
+        Save a snapshot to path and empty the write-ahead log
+        
+        Raises:
+            OSError: If the snapshot or the log cannot be written
+        """
+        if not lib.db_compact(self._db, os.fsencode(path)):
+            raise OSError(f"Cannot compact into snapshot: {path}")
+    
     def __del__(self):
         """Destroy the database when the object is garbage collected"""
         if hasattr(self, '_db') and self._db:
@@ -132,27 +540,76 @@ class SimpleDB:
         self.__del__()
         return False
     
-    def set(self, key: str, value: str) -> bool:
+    @staticmethod
+    def _bytes(data: Union[str, bytes], what: str) -> bytes:
+        """UTF-8 encode a str; bytes are passed to C as they are"""
+        if isinstance(data, bytes):
+            return data
+        if isinstance(data, str):
+            return data.encode('utf-8')
+        raise TypeError(f"{what} must be str or bytes")
+    
+    def set(self, key: Union[str, bytes], value: Union[str, bytes],
+            ttl_ms: Optional[int] = None) -> bool:
         """
         Set a key-value pair in the database
         
         Args:
-            key: The key (max 256 characters)
-            value: The value (max 4096 characters)
+            key: The key (max 255 bytes, no NUL characters)
+            value: The value, str or bytes (bytes may hold NULs); at most
+                   4095 bytes unless raised with set_max_value_length()
+            ttl_ms: Expire the key this many milliseconds from now; None
+                    stores it without a TTL (clearing any previous one)
             
         Returns:
             True if successful, False otherwise
+            
+        Raises:
+            ValueError: If ttl_ms is not positive
         """
-        if not isinstance(key, str) or not isinstance(value, str):
-            raise TypeError("Key and value must be strings")
+        key = self._bytes(key, "Key")
+        value = self._bytes(value, "Value")
+        if ttl_ms is None:
+            return lib.db_set_n(self._db, key, len(key), value, len(value))
+        if ttl_ms <= 0:
+            raise ValueError(f"TTL must be positive: {ttl_ms}")
+        return lib.db_set_ex_n(self._db, key, len(key), value, len(value), ttl_ms)
+    
+    def ttl(self, key: Union[str, bytes]) -> int:
+        """
+        Time left before a key expires
         
-        return lib.db_set(
-            self._db,
-            key.encode('utf-8'),
-            value.encode('utf-8')
-        )
+        Args:
+            key: The key to check
+            
+        Returns:
+            Milliseconds left, -1 if the key has no TTL, -2 if it is missing
+        """
+        return lib.db_ttl(self._db, self._bytes(key, "Key"))
     
-    def get(self, key: str) -> Optional[str]:
+    def set_max_memory(self, max_bytes: int):
+        """
+        Cap the memory used by keys and values; writes beyond it evict keys
+        that were not read recently
+        
+        Args:
+            max_bytes: Budget in bytes, or 0 for no limit (the default)
+            
+        Raises:
+            ValueError: If max_bytes is negative
+        """
+        if max_bytes < 0:
+            raise ValueError(f"Memory budget must not be negative: {max_bytes}")
+        lib.db_set_max_memory(self._db, max_bytes)
+    
+    def _get_raw(self, key: Union[str, bytes]) -> Optional[bytes]:
+        """Look a key up and copy its value out of the C thread buffer"""
+        key = self._bytes(key, "Key")
+        length = ctypes.c_size_t()
+        ptr = lib.db_get_n(self._db, key, len(key), ctypes.byref(length))
+        return ctypes.string_at(ptr, length.value) if ptr else None
+    
+    def get(self, key: Union[str, bytes]) -> Optional[str]:
         """
         Get a value by key
         
@@ -160,15 +617,38 @@ class SimpleDB:
             key: The key to look up
             
         Returns:
-            The value if found, None otherwise
+            The value decoded as UTF-8 if found, None otherwise
         """
-        if not isinstance(key, str):
-            raise TypeError("Key must be a string")
+        value = self._get_raw(key)
+        return value.decode('utf-8') if value is not None else None
+    
+    def get_bytes(self, key: Union[str, bytes]) -> Optional[bytes]:
+        """
+        Get a value by key without decoding it
         
-        result = lib.db_get(self._db, key.encode('utf-8'))
-        return result.decode('utf-8') if result else None
+        Args:
+            key: The key to look up
+            
+        Returns:
+            The value's bytes if found, None otherwise
+        """
+        return self._get_raw(key)
+    
+    def set_max_value_length(self, max_len: int):
+        """
+        Accept values up to max_len bytes in later writes
+        
+        Args:
+            max_len: New limit in bytes (default 4095, at most 1 GB)
+            
+        Raises:
+            ValueError: If max_len exceeds the ceiling
+        """
+        if not lib.db_set_max_value_length(self._db, max_len):
+            raise ValueError(f"Value limit too large: {max_len}")
+        self._scan_buffer = max(self._SCAN_BUFFER, max_len + 258 + self._RECORD.size)
     
-    def delete(self, key: str) -> bool:
+    def delete(self, key: Union[str, bytes]) -> bool:
         """
         Delete a key-value pair
         
@@ -178,12 +658,10 @@ class SimpleDB:
         Returns:
             True if deleted, False if key not found
         """
-        if not isinstance(key, str):
-            raise TypeError("Key must be a string")
-        
-        return lib.db_delete(self._db, key.encode('utf-8'))
+        key = self._bytes(key, "Key")
+        return lib.db_delete_n(self._db, key, len(key))
     
-    def exists(self, key: str) -> bool:
+    def exists(self, key: Union[str, bytes]) -> bool:
         """
         Check if a key exists
         
@@ -193,10 +671,245 @@ class SimpleDB:
         Returns:
             True if key exists, False otherwise
         """
+        return lib.db_exists(self._db, self._bytes(key, "Key"))
+    
+    @staticmethod
+    def key_hash(key: str) -> int:
+        """
+        Hash a key the way the database does, for get_hashed/set_hashed
+        
+        Args:
+            key: The key to hash
+            
+        Returns:
+            64-bit hash value
+        """
+        if not isinstance(key, str):
+            raise TypeError("Key must be a string")
+        
+        return lib.db_hash(key.encode('utf-8'))
+    
+    def set_hashed(self, key: str, value: str, key_hash: int) -> bool:
+        """
+        set() with the key's hash already computed by key_hash()
+        
+        Returns:
+            True if successful, False otherwise
+        """
+        if not isinstance(key, str) or not isinstance(value, str):
+            raise TypeError("Key and value must be strings")
+        
+        return lib.db_set_hashed(self._db, key.encode('utf-8'), value.encode('utf-8'), key_hash)
+    
+    def get_hashed(self, key: str, key_hash: int) -> Optional[str]:
+        """
+        get() with the key's hash already computed by key_hash()
+        
+        Returns:
+            The value if found, None otherwise
+        """
         if not isinstance(key, str):
             raise TypeError("Key must be a string")
         
-        return lib.db_exists(self._db, key.encode('utf-8'))
+        result = lib.db_get_hashed(self._db, key.encode('utf-8'), key_hash)
+        return result.decode('utf-8') if result else None
+    
+    @staticmethod
+    def _pack(strings: Iterable[str]) -> bytes:
+        """Encode strings into one buffer of NUL-terminated UTF-8 strings"""
+        try:
+            joined = '\0'.join(strings)
+        except TypeError:
+            raise TypeError("Keys and values must be strings") from None
+        return joined.encode('utf-8') + b'\0'
+    
+    def mset(self, items: Union[Mapping[str, str], Iterable[Tuple[str, str]]]) -> int:
+        """
+        Set many key-value pairs in one call into the C library
+        
+        Args:
+            items: Mapping or iterable of (key, value) pairs
+            
+        Returns:
+            Number of pairs stored (over-long keys or values are skipped)
+        """
+        pairs = list(items.items() if isinstance(items, Mapping) else items)
+        if not pairs:
+            return 0
+        
+        keys = self._pack(k for k, _ in pairs)
+        values = self._pack(v for _, v in pairs)
+        return lib.db_mset(self._db, keys, values, len(pairs))
+    
+    def mset_packed(self, keys: bytes, values: bytes, count: int) -> int:
+        """
+        Like mset, for keys and values already packed as NUL-terminated
+        UTF-8 strings (count of each), as they come from a file
+        
+        Returns:
+            Number of pairs stored
+        """
+        return lib.db_mset(self._db, keys, values, count) if count else 0
+    
+    def mget(self, keys: Iterable[str]) -> List[Optional[str]]:
+        """
+        Get many values in one call into the C library
+        
+        Args:
+            keys: Keys to look up
+            
+        Returns:
+            Values in the same order as keys, None for missing keys
+        """
+        keys = list(keys)
+        if not keys:
+            return []
+        
+        return self._mget_packed(lib.db_mget, self._db, keys)
+    
+    @classmethod
+    def _mget_packed(cls, mget, handle, keys: List[str]) -> List[Optional[str]]:
+        """Call a db_mget-style function and unpack its values"""
+        packed = cls._pack(keys)
+        lengths = (ctypes.c_long * len(keys))()
+        size = max(4096, len(packed) * 4)
+        
+        # One crossing unless the values outgrow the first guess
+        while True:
+            out = ctypes.create_string_buffer(size)
+            needed = mget(handle, packed, len(keys), out, size, lengths)
+            if needed <= size:
+                break
+            size = needed
+        
+        # Values may contain NUL, so slice them out by length
+        raw = out.raw
+        values, pos = [], 0
+        for length in lengths:
+            if length < 0:
+                values.append(None)
+                continue
+            values.append(raw[pos:pos + length].decode('utf-8'))
+            pos += length + 1
+        return values
+    
+    def mdelete(self, keys: Iterable[str]) -> int:
+        """
+        Delete many keys in one call into the C library
+        
+        Args:
+            keys: Keys to delete
+            
+        Returns:
+            Number of keys that existed
+        """
+        keys = list(keys)
+        if not keys:
+            return 0
+        
+        return lib.db_mdelete(self._db, self._pack(keys), len(keys))
+    
+    def enable_ordered_index(self):
+        """
+        Maintain an ordered index of the keys so scan_prefix() and
+        scan_range() work. Built from the current contents; later writes
+        keep it up to date.
+        
+        Raises:
+            MemoryError: If the index cannot be built
+        """
+        if not lib.db_enable_ordered_index(self._db):
+            raise MemoryError("Failed to build ordered index")
+    
+    # Scan buffer: room for one maximal record (4 KB value by default;
+    # set_max_value_length() grows it with the limit). Scans still double
+    # their buffer when a record doesn't fit, as in a mapped snapshot.
+    _SCAN_BUFFER = 64 * 1024
+    _scan_buffer = _SCAN_BUFFER
+    
+    # DBScanRecord header of each scan record: key_len, value_len (native
+    # order, unaligned), then key, NUL, value, NUL
+    _RECORD = struct.Struct('=II')
+    
+    @classmethod
+    def _records(cls, data: bytes, count: int, raw: bool) -> Iterator[Tuple[str, Union[str, bytes]]]:
+        """Split count scan records out of a buffer by their lengths"""
+        offset = 0
+        for _ in range(count):
+            key_len, value_len = cls._RECORD.unpack_from(data, offset)
+            key = offset + cls._RECORD.size
+            value = key + key_len + 1
+            result = data[value:value + value_len]
+            yield data[key:key + key_len].decode('utf-8'), result if raw else result.decode('utf-8')
+            offset = value + value_len + 1
+    
+    def _scan(self, cursor, limit: Optional[int], after: Optional[str],
+              raw: bool) -> List[Tuple[str, Union[str, bytes]]]:
+        """Drain up to limit records from a C cursor, resuming after `after`"""
+        if not cursor:
+            raise RuntimeError("Ordered index is not enabled (call enable_ordered_index())")
+        
+        try:
+            if after is not None:
+                lib.db_cursor_seek_after(cursor, after.encode('utf-8'))
+            
+            records = []
+            done = ctypes.c_bool(False)
+            buf = ctypes.create_string_buffer(self._scan_buffer)
+            while not done.value and (limit is None or len(records) < limit):
+                want = len(buf) if limit is None else limit - len(records)
+                got = lib.db_cursor_fetch(cursor, buf, len(buf), want, ctypes.byref(done))
+                if got == 0 and not done.value:
+                    # The next record didn't fit: retry with more room
+                    buf = ctypes.create_string_buffer(len(buf) * 2)
+                    continue
+                
+                records.extend(self._records(buf.raw, got, raw))
+            return records
+        finally:
+            lib.db_cursor_close(cursor)
+    
+    def scan_prefix(self, prefix: str, limit: Optional[int] = None,
+                    after: Optional[str] = None,
+                    raw: bool = False) -> List[Tuple[str, Union[str, bytes]]]:
+        """
+        Get the records whose key starts with prefix, in key order
+        
+        Args:
+            prefix: Key prefix ('' for every key)
+            limit: Return at most this many records (one page)
+            after: Resume after this key, e.g. the last key of the
+                   previous page
+            raw: Return the values as bytes instead of decoded str
+            
+        Returns:
+            List of (key, value) tuples
+        """
+        if not isinstance(prefix, str):
+            raise TypeError("Prefix must be a string")
+        
+        return self._scan(lib.db_scan_prefix(self._db, prefix.encode('utf-8')), limit, after, raw)
+    
+    def scan_range(self, start: Optional[str] = None, end: Optional[str] = None,
+                   limit: Optional[int] = None, after: Optional[str] = None,
+                   raw: bool = False) -> List[Tuple[str, Union[str, bytes]]]:
+        """
+        Get the records with start <= key < end, in key order
+        
+        Args:
+            start: First key of the range (None: from the smallest key)
+            end: Exclusive end of the range (None: to the largest key)
+            limit: Return at most this many records (one page)
+            after: Resume after this key
+            raw: Return the values as bytes instead of decoded str
+            
+        Returns:
+            List of (key, value) tuples
+        """
+        cursor = lib.db_scan_range(self._db,
+                                   start.encode('utf-8') if start is not None else None,
+                                   end.encode('utf-8') if end is not None else None)
+        return self._scan(cursor, limit, after, raw)
     
     def count(self) -> int:
         """
@@ -211,6 +924,40 @@ class SimpleDB:
         """Clear all entries from the database"""
         lib.db_clear(self._db)
     
+    def scan(self, batch: int = 1000, raw: bool = False) -> Iterator[Tuple[str, Union[str, bytes]]]:
+        """
+        Iterate over every record, in no particular order
+        
+        Records are fetched from C batch by batch, so memory stays flat
+        however large the database is. Keys present for the whole
+        iteration are yielded at least once even if the table resizes
+        meanwhile (a few may then repeat); keys written or deleted during
+        it may or may not appear.
+        
+        Args:
+            batch: Records to fetch per call into C
+            raw: Yield the values as bytes (they may hold NULs) instead
+                 of decoded str
+            
+        Yields:
+            (key, value) tuples
+        """
+        if batch < 1:
+            raise ValueError(f"Batch must be at least 1: {batch}")
+        
+        cursor = ctypes.c_uint64(0)
+        done = ctypes.c_bool(False)
+        buf = ctypes.create_string_buffer(self._scan_buffer)
+        while not done.value:
+            got = lib.db_scan(self._db, ctypes.byref(cursor), buf, len(buf), batch,
+                              ctypes.byref(done))
+            if got == 0 and not done.value:
+                # One bucket's records didn't fit: retry with more room
+                buf = ctypes.create_string_buffer(len(buf) * 2)
+                continue
+            
+            yield from self._records(buf.raw, got, raw)
+    
     def keys(self) -> List[str]:
         """
         Get all keys in the database
@@ -218,37 +965,19 @@ class SimpleDB:
         Returns:
             List of all keys
         """
-        count = ctypes.c_size_t()
-        keys_ptr = lib.db_keys(self._db, ctypes.byref(count))
-        
-        if not keys_ptr or count.value == 0:
-            return []
-        
-        # Extract keys from C array
-        keys = []
-        for i in range(count.value):
-            key = keys_ptr[i]
-            if key:
-                keys.append(key.decode('utf-8'))
-        
-        # Free the array (but not the strings, they belong to the database)
-        ctypes.pythonapi.PyMem_Free(keys_ptr)
-        
-        return keys
+        return list(dict.fromkeys(key for key, _ in self.scan(raw=True)))
     
-    def items(self) -> Dict[str, str]:
+    def items(self, raw: bool = False) -> Dict[str, Union[str, bytes]]:
         """
         Get all key-value pairs
         
+        Args:
+            raw: Return the values as bytes instead of decoded str
+            
         Returns:
             Dictionary of all key-value pairs
         """
-        result = {}
-        for key in self.keys():
-            value = self.get(key)
-            if value is not None:
-                result[key] = value
-        return result
+        return dict(self.scan(raw=raw))
     
     def stats(self) -> dict:
         """
@@ -258,8 +987,13 @@ class SimpleDB:
             Dictionary with statistics:
             - total_entries: Number of entries
             - used_buckets: Number of hash buckets in use
+            - total_buckets: Current size of the bucket array
             - total_collisions: Number of hash collisions
             - max_chain_length: Longest collision chain
+            - hits / misses: get lookups that found / didn't find a key
+            - evictions: Keys dropped to stay within set_max_memory()
+            - expirations: Keys removed after their TTL passed
+            - memory_used: Bytes charged against the memory budget
         """
         stats = lib.db_stats(self._db)
         return {
@@ -267,6 +1001,53 @@ class SimpleDB:
             'used_buckets': stats.used_buckets,
             'total_collisions': stats.total_collisions,
             'max_chain_length': stats.max_chain_length,
+            'total_buckets': stats.total_buckets,
+            'hits': stats.hits,
+            'misses': stats.misses,
+            'evictions': stats.evictions,
+            'expirations': stats.expirations,
+            'memory_used': stats.memory_used,
+        }
+    
+    def stats_ex(self) -> dict:
+        """
+        Get per-operation counters and latency / probe-length histograms.
+        Cheap enough to poll: nothing walks the table.
+        
+        Returns:
+            Dictionary with total_entries, total_buckets, memory_used,
+            evictions, expirations and an 'ops' entry holding, for each of
+            get / set / delete:
+            - count / found: operations, and those that hit, stored or removed
+            - sampled: operations timed into the latency histogram
+            - p50_ns / p90_ns / p99_ns / p999_ns: latency percentiles
+            - latency: {bucket lower bound in ns: count}, non-empty buckets only
+            - probes: counts by probe length; the last is that length or more
+        """
+        stats = DBStatsEx()
+        lib.db_stats_ex(self._db, ctypes.byref(stats))
+        ops = {}
+        for kind, name in enumerate(('get', 'set', 'delete')):
+            op = stats.ops[kind]
+            ops[name] = {
+                'count': op.count,
+                'found': op.found,
+                'sampled': op.sampled,
+                'p50_ns': lib.db_latency_percentile(ctypes.byref(op), 50.0),
+                'p90_ns': lib.db_latency_percentile(ctypes.byref(op), 90.0),
+                'p99_ns': lib.db_latency_percentile(ctypes.byref(op), 99.0),
+                'p999_ns': lib.db_latency_percentile(ctypes.byref(op), 99.9),
+                'latency': {lib.db_latency_bucket_ns(i): n
+                            for i, n in enumerate(op.latency) if n},
+                'probes': list(op.probes),
+            }
+        return {
+            'total_entries': stats.total_entries,
+            'total_buckets': stats.total_buckets,
+            'memory_used': stats.memory_used,
+            'evictions': stats.evictions,
+            'expirations': stats.expirations,
+            'ops': ops,
         }
     
     def print(self):
@@ -277,6 +1058,10 @@ class SimpleDB:
         """Support len() function"""
         return self.count()
     
+    def __iter__(self):
+        """Iterate over the keys, as scan() does"""
+        return (key for key, _ in self.scan(raw=True))
+    
     def __contains__(self, key):
         """Support 'in' operator"""
         return self.exists(key)
@@ -303,6 +1088,302 @@ class SimpleDB:
         return f"<SimpleDB entries={self.count()}>"
 
 
+class ReadView:
+    """
+    Consistent view of a SimpleDB at one moment (see SimpleDB.snapshot())
+    
+    Not thread-safe: use a view from one thread at a time.
+    """
+    
+    def __init__(self, db: SimpleDB):
+        self._owner = db    # Keeps the database alive while the view is open
+        self._view = lib.db_snapshot_begin(db._db)
+        if not self._view:
+            raise MemoryError("Failed to open read view")
+        self._scanned = False
+    
+    def _handle(self):
+        if not self._view:
+            raise ValueError("Read view is closed")
+        return self._view
+    
+    def get(self, key: str) -> Optional[str]:
+        """Get the value key had when the view was opened, or None"""
+        if not isinstance(key, str):
+            raise TypeError("Key must be a string")
+        
+        result = lib.db_snapshot_get(self._handle(), key.encode('utf-8'))
+        return result.decode('utf-8') if result is not None else None
+    
+    def scan(self, batch: int = 1000, raw: bool = False) -> Iterator[Tuple[str, Union[str, bytes]]]:
+        """
+        Iterate over every record of the view, each exactly once, in no
+        particular order. A view can be scanned once.
+        
+        Yields:
+            (key, value) tuples, values as bytes if raw else decoded str
+        """
+        if batch < 1:
+            raise ValueError(f"Batch must be at least 1: {batch}")
+        view = self._handle()
+        if self._scanned:
+            raise RuntimeError("Read view was already scanned")
+        self._scanned = True
+        
+        done = ctypes.c_bool(False)
+        buf = ctypes.create_string_buffer(self._owner._scan_buffer)
+        while not done.value:
+            got = lib.db_snapshot_scan(view, buf, len(buf), batch, ctypes.byref(done))
+            if got == 0 and not done.value:
+                # One bucket's records didn't fit: retry with more room
+                buf = ctypes.create_string_buffer(len(buf) * 2)
+                continue
+            
+            yield from SimpleDB._records(buf.raw, got, raw)
+        if not lib.db_snapshot_ok(view):
+            raise MemoryError("Read view lost a version (out of memory)")
+    
+    def items(self, raw: bool = False) -> Dict[str, Union[str, bytes]]:
+        """Get all key-value pairs of the view, values as bytes if raw"""
+        return dict(self.scan(raw=raw))
+    
+    def save(self, path: str):
+        """
+        Write the view to a snapshot file (before any scan)
+        
+        Raises:
+            OSError: If the file cannot be written or the view was scanned
+        """
+        if self._scanned or not lib.db_snapshot_save(self._handle(), os.fsencode(path)):
+            raise OSError(f"Cannot save read view: {path}")
+        self._scanned = True
+    
+    def count(self) -> int:
+        """Number of entries when the view was opened"""
+        return lib.db_snapshot_count(self._handle())
+    
+    def memory(self) -> int:
+        """Bytes held for old versions of keys written since"""
+        return lib.db_snapshot_memory(self._handle())
+    
+    def ok(self) -> bool:
+        """False if a version was lost to an allocation failure"""
+        return lib.db_snapshot_ok(self._handle())
+    
+    def close(self):
+        """Release the view and the old versions it kept"""
+        if self._view:
+            lib.db_snapshot_end(self._view)
+            self._view = None
+    
+    def __del__(self):
+        """Release the view when the object is garbage collected"""
+        self.close()
+    
+    def __enter__(self):
+        """Context manager entry"""
+        return self
+    
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        """Context manager exit"""
+        self.close()
+        return False
+
+
+class ShardedDB:
+    """
+    Keys split across shards, one per core, each served by its own C thread
+    
+    Calls are handed to the shards over lock-free queues; batches are split
+    by shard and looked up in parallel. Each Python thread gets its own C
+    client handle, opened on first use and kept until the database is
+    destroyed.
+    """
+    
+    _GET_BUFFER = 4096
+    
+    def __init__(self, shards: int = 0, engine: str = 'chained', capacity: int = 0):
+        """
+        Create a sharded database
+        
+        Args:
+            shards: Number of shards, 0 (default) for one per online CPU
+            engine: Storage engine of every shard, 'chained' or 'swiss'
+            capacity: Expected total number of keys, spread over the shards
+        """
+        if engine not in ENGINES:
+            raise ValueError(f"Unknown engine: {engine}")
+        
+        self._sdb = lib.db_sharded_create(ENGINES[engine], shards, capacity)
+        if not self._sdb:
+            raise MemoryError("Failed to create sharded database")
+        self._local = threading.local()
+    
+    def __del__(self):
+        """Stop the shard threads when the object is garbage collected"""
+        if hasattr(self, '_sdb') and self._sdb:
+            lib.db_sharded_destroy(self._sdb)
+            self._sdb = None
+    
+    def __enter__(self):
+        """Context manager entry"""
+        return self
+    
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        """Context manager exit"""
+        self.__del__()
+        return False
+    
+    def _client(self) -> int:
+        """The calling thread's client handle"""
+        client = getattr(self._local, 'client', None)
+        if client is None:
+            client = lib.db_sharded_client_open(self._sdb)
+            if not client:
+                raise RuntimeError("No free client handles")
+            self._local.client = client
+        return client
+    
+    def set(self, key: Union[str, bytes], value: Union[str, bytes]) -> bool:
+        """
+        Set a key-value pair on the key's shard
+        
+        Args:
+            key: The key (max 255 bytes, no NUL characters)
+            value: The value, str or bytes (at most 4095 bytes)
+            
+        Returns:
+            True if successful, False otherwise
+        """
+        key = SimpleDB._bytes(key, "Key")
+        value = SimpleDB._bytes(value, "Value")
+        return lib.db_sharded_set(self._client(), key, len(key), value, len(value))
+    
+    def get_bytes(self, key: Union[str, bytes]) -> Optional[bytes]:
+        """
+        Get a value by key without decoding it
+        
+        Args:
+            key: The key to look up
+            
+        Returns:
+            The value's bytes if found, None otherwise
+        """
+        key = SimpleDB._bytes(key, "Key")
+        size = self._GET_BUFFER
+        while True:
+            buf = ctypes.create_string_buffer(size)
+            length = lib.db_sharded_get(self._client(), key, len(key), buf, size)
+            if length < size:
+                return buf.raw[:length] if length >= 0 else None
+            size = length + 1
+    
+    def get(self, key: Union[str, bytes]) -> Optional[str]:
+        """
+        Get a value by key
+        
+        Args:
+            key: The key to look up
+            
+        Returns:
+            The value decoded as UTF-8 if found, None otherwise
+        """
+        value = self.get_bytes(key)
+        return value.decode('utf-8') if value is not None else None
+    
+    def delete(self, key: Union[str, bytes]) -> bool:
+        """
+        Delete a key-value pair
+        
+        Args:
+            key: The key to delete
+            
+        Returns:
+            True if the key existed, False otherwise
+        """
+        key = SimpleDB._bytes(key, "Key")
+        return lib.db_sharded_delete(self._client(), key, len(key))
+    
+    def mset(self, items: Union[Mapping[str, str], Iterable[Tuple[str, str]]]) -> int:
+        """
+        Set many key-value pairs; every shard stores its share in parallel
+        
+        Args:
+            items: Mapping or iterable of (key, value) pairs
+            
+        Returns:
+            Number of pairs stored (over-long keys or values are skipped)
+        """
+        pairs = list(items.items() if isinstance(items, Mapping) else items)
+        if not pairs:
+            return 0
+        
+        keys = SimpleDB._pack(k for k, _ in pairs)
+        values = SimpleDB._pack(v for _, v in pairs)
+        return lib.db_sharded_mset(self._client(), keys, values, len(pairs))
+    
+    def mget(self, keys: Iterable[str]) -> List[Optional[str]]:
+        """
+        Get many values; every shard looks up its share in parallel
+        
+        Args:
+            keys: Keys to look up
+            
+        Returns:
+            Values in the same order as keys, None for missing keys
+        """
+        keys = list(keys)
+        if not keys:
+            return []
+        
+        return SimpleDB._mget_packed(lib.db_sharded_mget, self._client(), keys)
+    
+    def mdelete(self, keys: Iterable[str]) -> int:
+        """
+        Delete many keys
+        
+        Args:
+            keys: Keys to delete
+            
+        Returns:
+            Number of keys that existed
+        """
+        keys = list(keys)
+        if not keys:
+            return 0
+        
+        return lib.db_sharded_mdelete(self._client(), SimpleDB._pack(keys), len(keys))
+    
+    def count(self) -> int:
+        """
+        Get the number of entries over all shards
+        
+        Returns:
+            The number of key-value pairs
+        """
+        return lib.db_sharded_count(self._sdb)
+    
+    def __len__(self):
+        """Support len() function"""
+        return self.count()
+    
+    def __getitem__(self, key):
+        """Support db[key] syntax"""
+        value = self.get(key)
+        if value is None:
+            raise KeyError(key)
+        return value
+    
+    def __setitem__(self, key, value):
+        """Support db[key] = value syntax"""
+        if not self.set(key, value):
+            raise RuntimeError(f"Failed to set key: {key}")
+    
+    def __repr__(self):
+        """String representation"""
+        return f"<ShardedDB entries={self.count()}>"
+
+
 # ============================================================================
 # Example Usage
 # ============================================================================
@@ -347,12 +1428,53 @@ if __name__ == "__main__":
     print(f"'missing' in db => {'missing' in db}")
     print()
     
+    # Test precomputed-hash variants
+    print("Testing hashed GET/SET...")
+    h = SimpleDB.key_hash("name")
+    print(f"key_hash('name') => {h:#018x}")
+    print(f"get_hashed('name') => {db.get_hashed('name', h)}")
+    print()
+    
+    # Test binary values
+    print("Testing binary values...")
+    blob = bytes(range(256)) * 64
+    db.set_max_value_length(1 << 20)
+    db.set(b"blob", blob)
+    print(f"get_bytes('blob') => {len(db.get_bytes('blob'))} bytes, "
+          f"intact: {db.get_bytes('blob') == blob}")
+    db.delete("blob")
+    print()
+    
+    # Test TTL expiry
+    print("Testing TTL expiry...")
+    db.set("session", "token", ttl_ms=100)
+    print(f"ttl('session') => {db.ttl('session')} ms, get => {db.get('session')}")
+    time.sleep(0.15)
+    print(f"after 150 ms: get => {db.get('session')}, ttl => {db.ttl('session')}")
+    print()
+    
     # Test KEYS operation
     print("Testing KEYS operation...")
     keys = db.keys()
     print(f"Keys: {keys}")
     print()
     
+    # Test SCAN iteration
+    print("Testing SCAN iteration...")
+    scanned = sorted(db.scan(batch=2))
+    print(f"Scanned {len(scanned)} records two at a time: {[k for k, _ in scanned]}")
+    assert [k for k, _ in scanned] == sorted(keys)
+    small = SimpleDB()
+    small.mset({f"wide:{i}": "v" * 40 for i in range(5)})
+    small.set("bin", b"x\0y")
+    small._scan_buffer = 32                    # Too small for any bucket
+    assert sorted(small.keys()) == ["bin"] + [f"wide:{i}" for i in range(5)]
+    assert small.items(raw=True)["bin"] == b"x\0y"
+    assert small.items()["wide:0"] == "v" * 40
+    print("✓ Scan grows its buffer from the first call; binary values come back whole")
+    del small
+    print()
+    
     # Test ITEMS operation
     print("Testing ITEMS operation...")
     items = db.items()
@@ -382,6 +1504,24 @@ if __name__ == "__main__":
     print(f"Total count: {len(db)}")
     print()
     
+    # Batch test: one FFI crossing per call instead of one per key
+    import time
+    print("Batch test: 10000 keys, single calls vs one batch call...")
+    pairs = {f"batch_{i}": f"value_{i}" for i in range(10000)}
+    start = time.perf_counter()
+    for k, v in pairs.items():
+        db.set(k, v)
+    single = [db.get(k) for k in pairs]
+    loop_time = time.perf_counter() - start
+    start = time.perf_counter()
+    db.mset(pairs)
+    batch = db.mget(pairs)
+    batch_time = time.perf_counter() - start
+    print(f"✓ set+get loop: {loop_time * 1000:.1f} ms, mset+mget: {batch_time * 1000:.1f} ms")
+    print(f"✓ Results match: {single == batch}")
+    print(f"✓ Deleted {db.mdelete(pairs)} batch keys")
+    print()
+    
     # Final statistics
     print("Final Statistics:")
     stats = db.stats()
@@ -393,6 +1533,13 @@ if __name__ == "__main__":
         print(f"  avg_chain_length: {avg_chain:.2f}")
     print()
     
+    # Operation statistics
+    print("Operation Statistics:")
+    for name, op in db.stats_ex()['ops'].items():
+        print(f"  {name}: {op['count']} ops, {op['found']} found, "
+              f"p50 {op['p50_ns']} ns, p99 {op['p99_ns']} ns, probes {op['probes'][:4]}")
+    print()
+    
     # Test CLEAR operation
     print("Testing CLEAR operation...")
     db.clear()
@@ -400,6 +1547,89 @@ if __name__ == "__main__":
     print(f"Count after clear: {db.count()}")
     print()
     
+    # Snapshot test
+    import tempfile
+    print("Testing snapshot save / open_mmap...")
+    db.mset({"name": "Alice", "city": "Paris"})
+    snapshot_path = os.path.join(tempfile.gettempdir(), f"simple_db_demo_{os.getpid()}.snap")
+    db.save(snapshot_path)
+    mapped = SimpleDB.open_mmap(snapshot_path)
+    mapped["city"] = "Rome"  # Goes to the in-memory overlay
+    print(f"✓ Mapped {len(mapped)} entries: name => {mapped['name']}, city => {mapped['city']}")
+    del mapped
+    print()
+    
+    # Write-ahead log test: changes survive a restart, compaction empties the log
+    print("Testing write-ahead log replay and compaction...")
+    wal_path = snapshot_path + ".wal"
+    logged = SimpleDB()
+    logged.wal_open(wal_path)
+    logged.mset({f"wal_{i}": str(i) for i in range(1000)})
+    logged.delete("wal_7")
+    del logged
+    replayed = SimpleDB()
+    replayed.wal_open(wal_path)
+    print(f"✓ Replayed {len(replayed)} entries, wal_7 deleted: {'wal_7' not in replayed}")
+    replayed.compact(snapshot_path)
+    replayed["after"] = "compaction"
+    del replayed
+    recovered = SimpleDB.open_mmap(snapshot_path)
+    recovered.wal_open(wal_path)
+    print(f"✓ Snapshot + log: {len(recovered)} entries, after => {recovered['after']}")
+    del recovered
+    os.remove(wal_path)
+    print()
+    
+    # Ordered scans: prefix queries without a full scan and sort
+    print("Testing ordered index scans...")
+    ordered = SimpleDB()
+    ordered.mset({f"user:{i:04d}": f"name_{i}" for i in range(1000)})
+    ordered.mset({f"order:{i:04d}": "open" for i in range(100)})
+    ordered.enable_ordered_index()
+    page = ordered.scan_prefix("user:", limit=3)
+    print(f"✓ First page: {page}")
+    page = ordered.scan_prefix("user:", limit=3, after=page[-1][0])
+    print(f"✓ Next page: {[k for k, _ in page]}")
+    print(f"✓ Range order:0010..order:0015: {[k for k, _ in ordered.scan_range('order:0010', 'order:0015')]}")
+    print(f"✓ {len(ordered.scan_prefix('user:'))} user keys in order")
+    ordered.set("user:bin", b"a\0b")
+    assert ordered.scan_prefix("user:bin", raw=True) == [("user:bin", b"a\0b")]
+    ordered.set_max_value_length(200_000)
+    ordered.set("user:big", "b" * 150_000)
+    del ordered._scan_buffer                   # As on a fresh wrapper
+    assert ordered.scan_prefix("user:big") == [("user:big", "b" * 150_000)]
+    del ordered
+    print()
+    
+    # Read views: a consistent scan and a background save while writing
+    print("Testing read views and background save...")
+    viewed = SimpleDB()
+    viewed.mset({f"acct:{i}": "100" for i in range(1000)})
+    with viewed.snapshot() as view:
+        for i, (key, _) in enumerate(view.scan(batch=100)):
+            viewed[key] = "0"                  # Writes don't reach the view
+            viewed[f"new:{i}"] = "1"
+        print(f"✓ View: {view.count()} entries, acct:0 => {view.get('acct:0')} "
+              f"(live: {viewed['acct:0']}), kept {view.memory()} bytes of old values")
+    viewed.save_background(snapshot_path)
+    viewed.clear()
+    viewed.save_wait()
+    saved = SimpleDB.open_mmap(snapshot_path)
+    print(f"✓ Background save: {len(saved)} entries although cleared meanwhile")
+    del saved, viewed
+    os.remove(snapshot_path)
+    print()
+    
+    # Sharded mode: one shard thread per core, batches fanned out to all
+    print("Testing sharded database...")
+    with ShardedDB(shards=4) as sharded:
+        sharded.mset({f"user:{i}": f"name_{i}" for i in range(1000)})
+        sharded["answer"] = "42"
+        print(f"✓ {len(sharded)} entries over 4 shards, answer => {sharded['answer']}")
+        print(f"✓ mget in order: {sharded.mget(['user:1', 'missing', 'user:999'])}")
+        print(f"✓ Deleted {sharded.mdelete(f'user:{i}' for i in range(500))} keys")
+    print()
+    
     # Context manager test
     print("Testing context manager...")
     with SimpleDB() as temp_db:
@@ -0,0 +1,812 @@
+/*
+ * Network server for simple_db
+ *
+ * Serves one Database over TCP so several processes (web workers, scripts)
+ * share a single copy of the data. The protocol is the RESP subset Redis
+ * clients speak, so redis-cli and redis client libraries work unchanged:
+ *
+ *   PING, ECHO, GET, SET key value [EX seconds | PX ms], DEL key..., EXISTS key...,
+ *   MGET key..., MSET key value..., TTL, PTTL, DBSIZE, FLUSHDB, INFO, SAVE,
+ *   COMMAND, QUIT
+ *
+ * Inline commands ("GET key\r\n", as typed into telnet) are accepted too.
+ *
+ * Each thread runs its own epoll loop over non-blocking sockets, with its
+ * own SO_REUSEPORT listener, so the kernel spreads connections across
+ * threads and no connection state is shared. Clients may pipeline: every
+ * complete command in a read is executed before the replies, accumulated
+ * in one buffer, go out in a single write. A large value is not copied
+ * into that buffer; its reply is sent with writev straight from the copy
+ * db_get_n returns.
+ *
+ * Usage:
+ *   simple_db_server [-p port] [-t threads] [-e chained|swiss] [-s snapshot]
+ *                    [-w wal_path] [-M max_memory] [-V max_value_len]
+ *
+ * With -s the snapshot is mapped at startup if it exists, and SAVE writes
+ * it (compacting the log when -w is given too).
+ *
+ * Compile:
+ * gcc -pthread -Wall -Wextra -O2 simple_db_server.c simple_db.c -o simple_db_server
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE  // accept4
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "simple_db.h"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define READ_CHUNK (16 * 1024)        // Bytes asked of each read()
+#define MAX_EVENTS 64
+#define MAX_ARGS (1024 * 1024)        // Arguments in one command
+#define MAX_INLINE (64 * 1024)        // Longest inline command line
+#define OUT_HIGH_WATER (1024 * 1024)  // Stop reading while this much is unsent
+#define DIRECT_VALUE_BYTES (16 * 1024) // Values this long are written from place
+
+typedef struct {
+    int port;
+    int threads;
+    DBEngine engine;
+    const char *snapshot_path;
+    const char *wal_path;
+    size_t max_memory;
+    size_t max_value_len;
+} ServerConfig;
+
+// Growable byte buffer; data[start, len) is pending
+typedef struct {
+    char *data;
+    size_t start;
+    size_t len;
+    size_t cap;
+} Buffer;
+
+typedef struct {
+    int fd;
+    Buffer in;
+    Buffer out;
+    const char **argv;    // Current command's arguments, inside `in`
+    size_t *argl;
+    size_t args_cap;
+    bool closing;         // Close once `out` is flushed
+    bool writable_wait;   // EPOLLOUT registered
+} Connection;
+
+typedef struct {
+    Database *db;
+    const ServerConfig *config;
+    pthread_mutex_t *save_lock;
+    int epoll_fd;
+    int listen_fd;
+} ServerThread;
+
+static volatile sig_atomic_t stopping;
+static size_t max_bulk = MAX_INLINE;  // Longest argument: the value limit, or more
+
+static void on_signal(int sig) {
+    (void)sig;
+    stopping = 1;
+}
+
+// ============================================================================
+// BUFFERS
+// ============================================================================
+
+// Make room for `extra` more bytes, sliding the pending bytes to the front
+// before growing
+static bool buffer_reserve(Buffer *b, size_t extra) {
+    if (b->start > 0 && (b->start == b->len || b->cap - b->len < extra)) {
+        memmove(b->data, b->data + b->start, b->len - b->start);
+        b->len -= b->start;
+        b->start = 0;
+    }
+    if (b->cap - b->len >= extra) return true;
+    
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap - b->len < extra) cap *= 2;
+    char *data = (char*)realloc(b->data, cap);
+    if (!data) return false;
+    b->data = data;
+    b->cap = cap;
+    return true;
+}
+
+static inline size_t buffer_pending(const Buffer *b) {
+    return b->len - b->start;
+}
+
+static bool buffer_append(Buffer *b, const void *bytes, size_t n) {
+    if (!buffer_reserve(b, n)) return false;
+    memcpy(b->data + b->len, bytes, n);
+    b->len += n;
+    return true;
+}
+
+static void buffer_free(Buffer *b) {
+    free(b->data);
+    b->data = NULL;
+    b->start = b->len = b->cap = 0;
+}
+
+// ============================================================================
+// REPLIES
+// ============================================================================
+
+static void reply_raw(Connection *c, const char *text) {
+    if (!buffer_append(&c->out, text, strlen(text))) c->closing = true;
+}
+
+static void reply_error(Connection *c, const char *message) {
+    char line[256];
+    snprintf(line, sizeof(line), "-%s\r\n", message);
+    reply_raw(c, line);
+}
+
+static void reply_int(Connection *c, long long value) {
+    char line[32];
+    snprintf(line, sizeof(line), ":%lld\r\n", value);
+    reply_raw(c, line);
+}
+
+static void reply_array(Connection *c, size_t n) {
+    char line[32];
+    snprintf(line, sizeof(line), "*%zu\r\n", n);
+    reply_raw(c, line);
+}
+
+// Write as much of iov as the socket takes now, leaving iov[] holding
+// what it didn't; returns false on error
+static bool write_iov(int fd, struct iovec *iov, int count, size_t *written) {
+    *written = 0;
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        *written += (size_t)n;
+        
+        // Empty the fully written entries, trim the partial one
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov->iov_len = 0;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return true;
+}
+
+// A bulk string reply. Short values are copied into the output buffer;
+// long ones go out with one writev of everything queued so far, the
+// header, the value where db_get_n left it, and the CRLF. Only what the
+// socket doesn't take is copied.
+static void reply_bulk(Connection *c, const char *value, size_t len) {
+    char header[32];
+    int header_len = snprintf(header, sizeof(header), "$%zu\r\n", len);
+    
+    if (len < DIRECT_VALUE_BYTES || c->writable_wait || c->closing) {
+        if (!buffer_append(&c->out, header, header_len) ||
+            !buffer_append(&c->out, value, len) ||
+            !buffer_append(&c->out, "\r\n", 2)) c->closing = true;
+        return;
+    }
+    
+    struct iovec iov[4] = {
+        { c->out.data + c->out.start, buffer_pending(&c->out) },
+        { header, (size_t)header_len },
+        { (void*)value, len },
+        { "\r\n", 2 },
+    };
+    size_t queued = buffer_pending(&c->out), written;
+    if (!write_iov(c->fd, iov, 4, &written)) {
+        c->closing = true;
+        return;
+    }
+    
+    // iov[] was trimmed to what the socket didn't take; queue that
+    c->out.start += written < queued ? written : queued;
+    for (int i = 1; i < 4; i++) {
+        if (iov[i].iov_len && !buffer_append(&c->out, iov[i].iov_base, iov[i].iov_len)) {
+            c->closing = true;
+        }
+    }
+}
+
+static void reply_nil(Connection *c) {
+    reply_raw(c, "$-1\r\n");
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+static bool arg_is(const Connection *c, size_t i, const char *name) {
+    return strlen(name) == c->argl[i] && strncasecmp(c->argv[i], name, c->argl[i]) == 0;
+}
+
+// Parse a whole argument as a non-negative integer
+static bool arg_u64(const Connection *c, size_t i, uint64_t *out) {
+    if (c->argl[i] == 0 || c->argl[i] > 19) return false;
+    uint64_t value = 0;
+    for (size_t k = 0; k < c->argl[i]; k++) {
+        char ch = c->argv[i][k];
+        if (ch < '0' || ch > '9') return false;
+        value = value * 10 + (uint64_t)(ch - '0');
+    }
+    *out = value;
+    return true;
+}
+
+static void wrong_args(Connection *c) {
+    reply_error(c, "ERR wrong number of arguments");
+}
+
+static void cmd_set(ServerThread *t, Connection *c, size_t argc) {
+    uint64_t ttl_ms = 0;
+    if (argc == 5) {
+        uint64_t n;
+        if (!arg_u64(c, 4, &n) || n == 0) {
+            reply_error(c, "ERR invalid expire time");
+            return;
+        }
+        if (arg_is(c, 3, "EX") && n <= UINT64_MAX / 1000) {
+            ttl_ms = n * 1000;
+        } else if (arg_is(c, 3, "PX")) {
+            ttl_ms = n;
+        } else {
+            reply_error(c, "ERR syntax error");
+            return;
+        }
+    } else if (argc != 3) {
+        wrong_args(c);
+        return;
+    }
+    
+    bool ok = ttl_ms
+              ? db_set_ex_n(t->db, c->argv[1], c->argl[1], c->argv[2], c->argl[2], ttl_ms)
+              : db_set_n(t->db, c->argv[1], c->argl[1], c->argv[2], c->argl[2]);
+    if (ok) {
+        reply_raw(c, "+OK\r\n");
+    } else {
+        reply_error(c, "ERR key too long or value too large");
+    }
+}
+
+static void cmd_get(ServerThread *t, Connection *c, size_t i) {
+    size_t len;
+    const char *value = db_get_n(t->db, c->argv[i], c->argl[i], &len);
+    if (value) {
+        reply_bulk(c, value, len);
+    } else {
+        reply_nil(c);
+    }
+}
+
+static void cmd_info(ServerThread *t, Connection *c) {
+    DBStats stats = db_stats(t->db);
+    char text[512];
+    int n = snprintf(text, sizeof(text),
+                     "# Keyspace\r\nkeys:%zu\r\nbuckets:%zu\r\nmax_chain_length:%zu\r\n"
+                     "# Stats\r\nhits:%llu\r\nmisses:%llu\r\nevictions:%llu\r\n"
+                     "expirations:%llu\r\n# Memory\r\nused_memory:%zu\r\n",
+                     stats.total_entries, stats.total_buckets, stats.max_chain_length,
+                     (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+                     (unsigned long long)stats.evictions,
+                     (unsigned long long)stats.expirations, stats.memory_used);
+    reply_bulk(c, text, (size_t)n);
+}
+
+static void cmd_save(ServerThread *t, Connection *c) {
+    if (!t->config->snapshot_path) {
+        reply_error(c, "ERR no snapshot path configured (-s)");
+        return;
+    }
+    
+    pthread_mutex_lock(t->save_lock);
+    bool ok = t->config->wal_path ? db_compact(t->db, t->config->snapshot_path)
+                                  : db_save(t->db, t->config->snapshot_path);
+    pthread_mutex_unlock(t->save_lock);
+    if (ok) {
+        reply_raw(c, "+OK\r\n");
+    } else {
+        reply_error(c, "ERR snapshot failed");
+    }
+}
+
+// Run the command in c->argv. Arguments are NUL-terminated in place (the
+// byte after each one is a delimiter already consumed), so C-string calls
+// can take them directly.
+static void execute(ServerThread *t, Connection *c, size_t argc) {
+    Database *db = t->db;
+    for (size_t i = 0; i < argc; i++) ((char*)c->argv[i])[c->argl[i]] = '\0';
+    
+    if (arg_is(c, 0, "GET")) {
+        if (argc != 2) {
+            wrong_args(c);
+            return;
+        }
+        cmd_get(t, c, 1);
+    } else if (arg_is(c, 0, "SET")) {
+        cmd_set(t, c, argc);
+    } else if (arg_is(c, 0, "MGET")) {
+        if (argc < 2) {
+            wrong_args(c);
+            return;
+        }
+        reply_array(c, argc - 1);
+        for (size_t i = 1; i < argc; i++) cmd_get(t, c, i);
+    } else if (arg_is(c, 0, "MSET")) {
+        if (argc < 3 || argc % 2 == 0) {
+            wrong_args(c);
+            return;
+        }
+        bool ok = true;
+        for (size_t i = 1; i < argc; i += 2) {
+            ok = db_set_n(db, c->argv[i], c->argl[i], c->argv[i + 1], c->argl[i + 1]) && ok;
+        }
+        if (ok) {
+            reply_raw(c, "+OK\r\n");
+        } else {
+            reply_error(c, "ERR key too long or value too large");
+        }
+    } else if (arg_is(c, 0, "DEL")) {
+        if (argc < 2) {
+            wrong_args(c);
+            return;
+        }
+        long long deleted = 0;
+        for (size_t i = 1; i < argc; i++) deleted += db_delete_n(db, c->argv[i], c->argl[i]);
+        reply_int(c, deleted);
+    } else if (arg_is(c, 0, "EXISTS")) {
+        if (argc < 2) {
+            wrong_args(c);
+            return;
+        }
+        long long found = 0;
+        for (size_t i = 1; i < argc; i++) {
+            found += strlen(c->argv[i]) == c->argl[i] && db_exists(db, c->argv[i]);
+        }
+        reply_int(c, found);
+    } else if (arg_is(c, 0, "TTL") || arg_is(c, 0, "PTTL")) {
+        if (argc != 2) {
+            wrong_args(c);
+            return;
+        }
+        long long ttl = strlen(c->argv[1]) == c->argl[1] ? db_ttl(db, c->argv[1]) : -2;
+        // TTL rounds up, so a key about to expire doesn't report 0
+        if (ttl > 0 && arg_is(c, 0, "TTL")) ttl = (ttl + 999) / 1000;
+        reply_int(c, ttl);
+    } else if (arg_is(c, 0, "PING")) {
+        if (argc == 2) {
+            reply_bulk(c, c->argv[1], c->argl[1]);
+        } else {
+            reply_raw(c, "+PONG\r\n");
+        }
+    } else if (arg_is(c, 0, "ECHO")) {
+        if (argc != 2) {
+            wrong_args(c);
+            return;
+        }
+        reply_bulk(c, c->argv[1], c->argl[1]);
+    } else if (arg_is(c, 0, "DBSIZE")) {
+        reply_int(c, (long long)db_count(db));
+    } else if (arg_is(c, 0, "FLUSHDB") || arg_is(c, 0, "FLUSHALL")) {
+        db_clear(db);
+        reply_raw(c, "+OK\r\n");
+    } else if (arg_is(c, 0, "INFO")) {
+        cmd_info(t, c);
+    } else if (arg_is(c, 0, "SAVE")) {
+        cmd_save(t, c);
+    } else if (arg_is(c, 0, "COMMAND")) {
+        reply_array(c, 0);  // redis-cli asks on connect; no command table
+    } else if (arg_is(c, 0, "QUIT")) {
+        reply_raw(c, "+OK\r\n");
+        c->closing = true;
+    } else {
+        char message[96];
+        snprintf(message, sizeof(message), "ERR unknown command '%.40s'", c->argv[0]);
+        reply_error(c, message);
+    }
+}
+
+// ============================================================================
+// PARSING
+// ============================================================================
+
+typedef enum { PARSE_OK, PARSE_NEED_MORE, PARSE_ERROR } ParseResult;
+
+static bool ensure_args(Connection *c, size_t n) {
+    if (n <= c->args_cap) return true;
+    
+    size_t cap = c->args_cap ? c->args_cap : 16;
+    while (cap < n) cap *= 2;
+    const char **argv = (const char**)realloc(c->argv, cap * sizeof(char*));
+    if (!argv) return false;
+    c->argv = argv;
+    size_t *argl = (size_t*)realloc(c->argl, cap * sizeof(size_t));
+    if (!argl) return false;
+    c->argl = argl;
+    c->args_cap = cap;
+    return true;
+}
+
+// Read "<number>\r\n" at *pos; NEED_MORE if the line isn't complete yet
+static ParseResult parse_number(const char *p, const char *end, const char **pos, long long *out) {
+    const char *cr = memchr(p, '\r', end - p);
+    if (!cr || cr + 1 >= end) return (end - p) > 32 ? PARSE_ERROR : PARSE_NEED_MORE;
+    if (cr[1] != '\n' || cr == p || cr - p > 19) return PARSE_ERROR;
+    
+    bool negative = *p == '-';
+    long long value = 0;
+    for (const char *q = p + negative; q < cr; q++) {
+        if (*q < '0' || *q > '9') return PARSE_ERROR;
+        value = value * 10 + (*q - '0');
+    }
+    *out = negative ? -value : value;
+    *pos = cr + 2;
+    return PARSE_OK;
+}
+
+// Inline command: space-separated words up to the end of the line
+static ParseResult parse_inline(Connection *c, const char *p, const char *end,
+                                size_t *argc, size_t *consumed) {
+    const char *nl = memchr(p, '\n', end - p);
+    if (!nl) return end - p > MAX_INLINE ? PARSE_ERROR : PARSE_NEED_MORE;
+    
+    const char *line_end = nl > p && nl[-1] == '\r' ? nl - 1 : nl;
+    size_t n = 0;
+    for (const char *q = p; q < line_end; ) {
+        while (q < line_end && (*q == ' ' || *q == '\t')) q++;
+        if (q == line_end) break;
+        const char *word = q;
+        while (q < line_end && *q != ' ' && *q != '\t') q++;
+        if (!ensure_args(c, n + 1)) return PARSE_ERROR;
+        c->argv[n] = word;
+        c->argl[n] = (size_t)(q - word);
+        n++;
+    }
+    
+    *argc = n;
+    *consumed = (size_t)(nl + 1 - p);
+    return PARSE_OK;
+}
+
+// One command from the start of the pending input: a RESP array of bulk
+// strings, or an inline line. Arguments point into the input buffer.
+static ParseResult parse_command(Connection *c, size_t *argc, size_t *consumed) {
+    const char *start = c->in.data + c->in.start;
+    const char *end = c->in.data + c->in.len;
+    if (start == end) return PARSE_NEED_MORE;
+    if (*start != '*') return parse_inline(c, start, end, argc, consumed);
+    
+    const char *p = start + 1;
+    long long n;
+    ParseResult r = parse_number(p, end, &p, &n);
+    if (r != PARSE_OK) return r;
+    if (n < 0 || n > MAX_ARGS || !ensure_args(c, (size_t)n)) return PARSE_ERROR;
+    
+    long long max_len = (long long)max_bulk;
+    for (long long i = 0; i < n; i++) {
+        if (p >= end) return PARSE_NEED_MORE;
+        if (*p != '$') return PARSE_ERROR;
+        long long len;
+        r = parse_number(p + 1, end, &p, &len);
+        if (r != PARSE_OK) return r;
+        if (len < 0 || len > max_len) return PARSE_ERROR;
+        if (end - p < len + 2) return PARSE_NEED_MORE;
+        if (p[len] != '\r' || p[len + 1] != '\n') return PARSE_ERROR;
+        
+        c->argv[i] = p;
+        c->argl[i] = (size_t)len;
+        p += len + 2;
+    }
+    
+    *argc = (size_t)n;
+    *consumed = (size_t)(p - start);
+    return PARSE_OK;
+}
+
+// ============================================================================
+// EVENT LOOP
+// ============================================================================
+
+static void conn_close(ServerThread *t, Connection *c) {
+    epoll_ctl(t->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    buffer_free(&c->in);
+    buffer_free(&c->out);
+    free(c->argv);
+    free(c->argl);
+    free(c);
+}
+
+// Interest follows the buffers: EPOLLOUT while replies are unsent, no
+// EPOLLIN while too many are
+static void conn_update_events(ServerThread *t, Connection *c) {
+    size_t unsent = buffer_pending(&c->out);
+    bool want_out = unsent > 0;
+    struct epoll_event ev = { .events = (unsent < OUT_HIGH_WATER ? EPOLLIN : 0) |
+                                        (want_out ? EPOLLOUT : 0),
+                              .data.ptr = c };
+    epoll_ctl(t->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->writable_wait = want_out;
+}
+
+// Send queued replies; false if the connection failed
+static bool conn_flush(Connection *c) {
+    while (buffer_pending(&c->out) > 0) {
+        ssize_t n = write(c->fd, c->out.data + c->out.start, buffer_pending(&c->out));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        c->out.start += (size_t)n;
+    }
+    c->out.start = c->out.len = 0;
+    return true;
+}
+
+// Execute every complete command buffered; false on a protocol error
+static bool conn_process(ServerThread *t, Connection *c) {
+    while (!c->closing && buffer_pending(&c->out) < OUT_HIGH_WATER) {
+        size_t argc = 0, consumed = 0;
+        ParseResult r = parse_command(c, &argc, &consumed);
+        if (r == PARSE_NEED_MORE) break;
+        if (r == PARSE_ERROR) {
+            reply_error(c, "ERR Protocol error");
+            c->closing = true;
+            return false;
+        }
+        
+        if (argc > 0) execute(t, c, argc);
+        c->in.start += consumed;
+    }
+    if (c->in.start == c->in.len) c->in.start = c->in.len = 0;
+    return true;
+}
+
+static void conn_readable(ServerThread *t, Connection *c) {
+    for (;;) {
+        if (!buffer_reserve(&c->in, READ_CHUNK)) {
+            c->closing = true;
+            break;
+        }
+        ssize_t n = read(c->fd, c->in.data + c->in.len, c->in.cap - c->in.len);
+        if (n > 0) {
+            c->in.len += (size_t)n;
+            conn_process(t, c);
+            if (c->closing || buffer_pending(&c->out) >= OUT_HIGH_WATER) break;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) c->closing = true;
+        break;
+    }
+}
+
+static void conn_event(ServerThread *t, Connection *c, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) c->closing = true;
+    if (events & EPOLLIN) conn_readable(t, c);
+    
+    // Once the replies are out, commands held back by the high-water mark
+    // run; the socket may have nothing more to read to wake us for them
+    bool ok;
+    for (;;) {
+        ok = conn_flush(c);
+        size_t pending = buffer_pending(&c->in);
+        if (!ok || c->closing || buffer_pending(&c->out) > 0 || pending == 0) break;
+        conn_process(t, c);
+        if (buffer_pending(&c->in) == pending) break;
+    }
+    
+    if (!ok || (c->closing && buffer_pending(&c->out) == 0)) {
+        conn_close(t, c);
+        return;
+    }
+    bool want_out = buffer_pending(&c->out) > 0;
+    if (want_out != c->writable_wait || (!want_out && c->closing)) conn_update_events(t, c);
+}
+
+static void accept_all(ServerThread *t) {
+    for (;;) {
+        int fd = accept4(t->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN, or out of descriptors until a client leaves
+        }
+        
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Connection *c = (Connection*)calloc(1, sizeof(Connection));
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if (!c || epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+    }
+}
+
+static int listen_on(int port) {
+    int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    bool v6 = fd >= 0;
+    if (!v6) fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    
+    int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    
+    int ok;
+    if (v6) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        struct sockaddr_in6 addr = { .sin6_family = AF_INET6, .sin6_port = htons(port),
+                                     .sin6_addr = in6addr_any };
+        ok = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    } else {
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port),
+                                    .sin_addr.s_addr = htonl(INADDR_ANY) };
+        ok = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    if (ok != 0 || listen(fd, 511) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void* server_main(void *arg) {
+    ServerThread *t = (ServerThread*)arg;
+    struct epoll_event events[MAX_EVENTS];
+    
+    while (!stopping) {
+        // The timeout bounds how long a shutdown signal waits
+        int n = epoll_wait(t->epoll_fd, events, MAX_EVENTS, 200);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                accept_all(t);
+            } else {
+                conn_event(t, (Connection*)events[i].data.ptr, events[i].events);
+            }
+        }
+    }
+    return NULL;
+}
+
+static Database* open_database(const ServerConfig *config) {
+    Database *db = NULL;
+    if (config->snapshot_path && access(config->snapshot_path, F_OK) == 0) {
+        db = db_open_mmap(config->snapshot_path);
+        if (!db) {
+            fprintf(stderr, "Cannot open snapshot %s\n", config->snapshot_path);
+            return NULL;
+        }
+    } else {
+        db = db_create_ex(config->engine, 0);
+        if (!db) return NULL;
+    }
+    
+    if (config->max_value_len && !db_set_max_value_length(db, config->max_value_len)) {
+        fprintf(stderr, "Value limit too large: %zu\n", config->max_value_len);
+        db_destroy(db);
+        return NULL;
+    }
+    // Arguments longer than this close the connection; shorter ones past
+    // the value limit just get an error reply
+    if (config->max_value_len > max_bulk) max_bulk = config->max_value_len;
+    if (config->max_memory) db_set_max_memory(db, config->max_memory);
+    if (config->wal_path && !db_wal_open(db, config->wal_path, NULL)) {
+        fprintf(stderr, "Cannot open write-ahead log %s\n", config->wal_path);
+        db_destroy(db);
+        return NULL;
+    }
+    return db;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-p port] [-t threads] [-e chained|swiss] [-s snapshot] "
+                    "[-w wal_path] [-M max_memory] [-V max_value_len]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    ServerConfig config = { 6380, 1, DB_ENGINE_CHAINED, NULL, NULL, 0, 0 };
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:e:s:w:M:V:h")) != -1) {
+        switch (opt) {
+            case 'p': config.port = atoi(optarg); break;
+            case 't': config.threads = atoi(optarg); break;
+            case 'e':
+                config.engine = strcmp(optarg, "swiss") == 0 ? DB_ENGINE_SWISS : DB_ENGINE_CHAINED;
+                break;
+            case 's': config.snapshot_path = optarg; break;
+            case 'w': config.wal_path = optarg; break;
+            case 'M': config.max_memory = (size_t)atoll(optarg); break;
+            case 'V': config.max_value_len = (size_t)atoll(optarg); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.port <= 0 || config.port > 65535 || config.threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    Database *db = open_database(&config);
+    if (!db) return 1;
+    
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+    ServerThread *threads = (ServerThread*)calloc(config.threads, sizeof(ServerThread));
+    pthread_t *tids = (pthread_t*)calloc(config.threads, sizeof(pthread_t));
+    int started = 0;
+    bool ok = threads && tids;
+    
+    for (int i = 0; ok && i < config.threads; i++) {
+        ServerThread *t = &threads[i];
+        *t = (ServerThread){ db, &config, &save_lock, epoll_create1(EPOLL_CLOEXEC),
+                             listen_on(config.port) };
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+        ok = t->epoll_fd >= 0 && t->listen_fd >= 0 &&
+             epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, t->listen_fd, &ev) == 0 &&
+             pthread_create(&tids[i], NULL, server_main, t) == 0;
+        if (ok) started++;
+    }
+    
+    if (ok) {
+        printf("simple_db server: port %d, %d thread(s), %zu keys loaded\n",
+               config.port, config.threads, db_count(db));
+        fflush(stdout);
+    } else {
+        fprintf(stderr, "Cannot listen on port %d: %s\n", config.port, strerror(errno));
+        stopping = 1;
+    }
+    
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    for (int i = 0; threads && i < config.threads; i++) {
+        if (threads[i].listen_fd >= 0) close(threads[i].listen_fd);
+        if (threads[i].epoll_fd >= 0) close(threads[i].epoll_fd);
+    }
+    free(threads);
+    free(tids);
+    db_destroy(db);  // Also syncs and closes the log
+    return ok ? 0 : 1;
+}
+
+#else
+
+int main(void) {
+    fprintf(stderr, "simple_db_server needs Linux (epoll)\n");
+    return 1;
+}
+
+#endif
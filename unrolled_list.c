@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "unrolled_list.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Search reads a node as 16 ints, so a node must be exactly 64 bytes
+_Static_assert(sizeof(UNode) == UNROLLED_NODE_BYTES, "UNode must fill one 64-byte line");
+_Static_assert(UNROLLED_NODE_BYTES == 16 * sizeof(int), "search compares 16 ints per node");
+
+// Bitmask of the slots of a node holding target (bit i = data[i]). The SIMD
+// paths compare the whole 64-byte node, count and next included, and mask
+// off everything past count; other targets use a loop.
+static inline uint32_t nodeMatch(const UNode* node, int target) {
+    uint32_t mask;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(target);
+    __m256i lo = _mm256_loadu_si256((const __m256i*)node);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)node + 1);
+    mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lo, needle))) |
+           ((uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hi, needle))) << 8);
+#elif defined(__SSE2__)
+    // Narrow the four 32-bit compare results to bytes for one movemask
+    __m128i needle = _mm_set1_epi32(target);
+    const __m128i* lanes = (const __m128i*)node;
+    __m128i eq01 = _mm_packs_epi32(_mm_cmpeq_epi32(_mm_loadu_si128(lanes), needle),
+                                   _mm_cmpeq_epi32(_mm_loadu_si128(lanes + 1), needle));
+    __m128i eq23 = _mm_packs_epi32(_mm_cmpeq_epi32(_mm_loadu_si128(lanes + 2), needle),
+                                   _mm_cmpeq_epi32(_mm_loadu_si128(lanes + 3), needle));
+    mask = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(eq01, eq23));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint32_t bit_weights[4] = {1, 2, 4, 8};
+    int32x4_t needle = vdupq_n_s32(target);
+    uint32x4_t weights = vld1q_u32(bit_weights);
+    const int32_t* lanes = (const int32_t*)node;
+    mask = 0;
+    for (int i = 0; i < 4; i++) {
+        uint32x4_t eq = vceqq_s32(vld1q_s32(lanes + 4 * i), needle);
+        mask |= vaddvq_u32(vandq_u32(eq, weights)) << (4 * i);
+    }
+#else
+    mask = 0;
+    for (int i = 0; i < node->count; i++) {
+        if (node->data[i] == target) mask |= 1u << i;
+    }
+#endif
+    return mask & ((1u << node->count) - 1);
+}
+
+// Create a pool sized for unrolled nodes
+NodePool* createUListPool(int nodesPerBlock) {
+    return createNodePool(sizeof(UNode), nodesPerBlock > 0 ? (size_t)nodesPerBlock : 0);
+}
+
+// Take an empty node from the list's pool
+static UNode* newUNode(UList* list) {
+    UNode* node = (UNode*)poolAllocNode(list->pool);
+    if (node == NULL) return NULL;
+    node->count = 0;
+    node->next = NULL;
+    return node;
+}
+
+// Give every node from `node` on back to the pool
+static void releaseUNodes(UList* list, UNode* node) {
+    while (node != NULL) {
+        UNode* next = node->next;
+        poolFreeNode(list->pool, node);
+        node = next;
+    }
+}
+
+// Set up an empty list handle
+int initUList(UList* list, NodePool* pool) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->ownsPool = (pool == NULL);
+    list->pool = pool != NULL ? pool : createUListPool(0);
+    return list->pool != NULL;
+}
+
+// Free a list handle's nodes (and its pool, if it owns one)
+void destroyUList(UList* list) {
+    if (list->ownsPool) {
+        destroyNodePool(list->pool);
+    } else {
+        releaseUNodes(list, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->pool = NULL;
+}
+
+// Empty a list handle but keep it usable
+void uListClear(UList* list) {
+    if (list->ownsPool) {
+        resetNodePool(list->pool);
+    } else {
+        releaseUNodes(list, list->head);
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Append into the tail node, starting a new one when it is full
+int uListAppend(UList* list, int data) {
+    UNode* tail = list->tail;
+    if (tail == NULL || tail->count == UNROLLED_CAPACITY) {
+        UNode* node = newUNode(list);
+        if (node == NULL) return 0;
+        
+        if (tail == NULL) {
+            list->head = node;
+        } else {
+            tail->next = node;
+        }
+        list->tail = tail = node;
+    }
+    tail->data[tail->count++] = data;
+    list->length++;
+    return 1;
+}
+
+// Insert at the front, shifting the head node's values up by one
+int uListPrepend(UList* list, int data) {
+    UNode* head = list->head;
+    if (head == NULL || head->count == UNROLLED_CAPACITY) {
+        UNode* node = newUNode(list);
+        if (node == NULL) return 0;
+        
+        node->next = head;
+        if (head == NULL) {
+            list->tail = node;
+        }
+        list->head = head = node;
+    }
+    memmove(head->data + 1, head->data, (size_t)head->count * sizeof(int));
+    head->data[0] = data;
+    head->count++;
+    list->length++;
+    return 1;
+}
+
+// Append an array: top up the tail node, then fill whole new nodes taken
+// side by side from the pool
+int uListInsertArray(UList* list, int* arr, int size) {
+    if (size == 0) return 1;
+    if (arr == NULL || size < 0) return 0;
+    
+    int done = 0;
+    if (list->tail != NULL) {
+        UNode* tail = list->tail;
+        int room = UNROLLED_CAPACITY - tail->count;
+        done = room < size ? room : size;
+        memcpy(tail->data + tail->count, arr, (size_t)done * sizeof(int));
+        tail->count += done;
+    }
+    
+    int rest = size - done;
+    if (rest > 0) {
+        int nodes = (rest + UNROLLED_CAPACITY - 1) / UNROLLED_CAPACITY;
+        UNode* run = (UNode*)poolAllocRun(list->pool, (size_t)nodes);
+        if (run == NULL) {
+            if (list->tail != NULL) list->tail->count -= done;
+            return 0;
+        }
+        
+        for (int i = 0; i < nodes; i++) {
+            int count = rest < UNROLLED_CAPACITY ? rest : UNROLLED_CAPACITY;
+            memcpy(run[i].data, arr + done, (size_t)count * sizeof(int));
+            run[i].count = count;
+            run[i].next = i + 1 < nodes ? &run[i + 1] : NULL;
+            done += count;
+            rest -= count;
+        }
+        
+        if (list->tail == NULL) {
+            list->head = run;
+        } else {
+            list->tail->next = run;
+        }
+        list->tail = &run[nodes - 1];
+    }
+    
+    list->length += size;
+    return 1;
+}
+
+// Delete the first occurrence of data. A node left less than half full
+// absorbs its successor when both fit in one node; empty nodes are freed.
+int uListDelete(UList* list, int data) {
+    UNode* prev = NULL;
+    UNode* node = list->head;
+    uint32_t mask = 0;
+    
+    while (node != NULL && (mask = nodeMatch(node, data)) == 0) {
+        prev = node;
+        node = node->next;
+    }
+    if (node == NULL) return 0;
+    
+    int slot = __builtin_ctz(mask);
+    node->count--;
+    memmove(node->data + slot, node->data + slot + 1, (size_t)(node->count - slot) * sizeof(int));
+    list->length--;
+    
+    if (node->count == 0) {
+        if (prev == NULL) {
+            list->head = node->next;
+        } else {
+            prev->next = node->next;
+        }
+        if (list->tail == node) {
+            list->tail = prev;
+        }
+        poolFreeNode(list->pool, node);
+        return 1;
+    }
+    
+    UNode* next = node->next;
+    if (next != NULL && node->count < UNROLLED_CAPACITY / 2 &&
+        node->count + next->count <= UNROLLED_CAPACITY) {
+        memcpy(node->data + node->count, next->data, (size_t)next->count * sizeof(int));
+        node->count += next->count;
+        node->next = next->next;
+        if (list->tail == next) {
+            list->tail = node;
+        }
+        poolFreeNode(list->pool, next);
+    }
+    return 1;
+}
+
+// Search node by node; each node is one SIMD compare of its values
+int uListSearch(const UList* list, int target) {
+    int position = 0;
+    
+    for (const UNode* node = list->head; node != NULL; node = node->next) {
+        uint32_t mask = nodeMatch(node, target);
+        if (mask != 0) {
+            return position + __builtin_ctz(mask);
+        }
+        position += node->count;
+    }
+    return -1;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Sort through a flat copy of the values, then write them back packing
+// every node full and releasing the nodes left over
+int uListSort(UList* list) {
+    if (list->length < 2) return 1;
+    
+    int* values = (int*)malloc((size_t)list->length * sizeof(int));
+    if (values == NULL) return 0;
+    
+    int n = 0;
+    for (UNode* node = list->head; node != NULL; node = node->next) {
+        memcpy(values + n, node->data, (size_t)node->count * sizeof(int));
+        n += node->count;
+    }
+    qsort(values, (size_t)n, sizeof(int), compareInts);
+    
+    UNode* node = list->head;
+    int done = 0;
+    while (done < n) {
+        int count = n - done < UNROLLED_CAPACITY ? n - done : UNROLLED_CAPACITY;
+        memcpy(node->data, values + done, (size_t)count * sizeof(int));
+        node->count = count;
+        done += count;
+        if (done < n) {
+            node = node->next;
+        }
+    }
+    releaseUNodes(list, node->next);
+    node->next = NULL;
+    list->tail = node;
+    
+    free(values);
+    return 1;
+}
+
+// Reverse the node order and the values inside each node
+void uListReverse(UList* list) {
+    UNode* prev = NULL;
+    UNode* node = list->head;
+    
+    while (node != NULL) {
+        for (int i = 0, j = node->count - 1; i < j; i++, j--) {
+            int temp = node->data[i];
+            node->data[i] = node->data[j];
+            node->data[j] = temp;
+        }
+        UNode* next = node->next;
+        node->next = prev;
+        prev = node;
+        node = next;
+    }
+    list->tail = list->head;
+    list->head = prev;
+}
+
+// Get a list handle's length in O(1)
+int uListLength(const UList* list) {
+    return list->length;
+}
+
+// Read the value at a position, skipping whole nodes on the way
+int uListGet(const UList* list, int position, int* value) {
+    if (position < 0 || position >= list->length) return 0;
+    
+    const UNode* node = list->head;
+    while (position >= node->count) {
+        position -= node->count;
+        node = node->next;
+    }
+    *value = node->data[position];
+    return 1;
+}
+
+// Display the list one node per bracket group
+void displayUList(const UList* list, const char* label) {
+    if (list->head == NULL) {
+        printf("%s: [Empty]\n", label);
+        return;
+    }
+    
+    printf("%s: ", label);
+    for (const UNode* node = list->head; node != NULL; node = node->next) {
+        printf("[");
+        for (int i = 0; i < node->count; i++) {
+            printf("%s%d", i == 0 ? "" : " ", node->data[i]);
+        }
+        printf("] -> ");
+    }
+    printf("NULL\n");
+}
@@ -0,0 +1,53 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include "node_pool.h"
+
+// Unrolled linked list: each node is one 64-byte cache line holding up to
+// UNROLLED_CAPACITY ints (13 on 64-bit targets) instead of one int and a
+// pointer, so a traversal follows one pointer per cache line and search
+// compares a whole node at a time with SIMD.
+#define UNROLLED_NODE_BYTES 64
+#define UNROLLED_CAPACITY ((int)((UNROLLED_NODE_BYTES - sizeof(void*) - sizeof(int)) / sizeof(int)))
+
+typedef struct UNode {
+    int data[UNROLLED_CAPACITY];    // First, so SIMD loads start on the node
+    int count;
+    struct UNode* next;
+} UNode;
+
+// List handle, used like List: nodes come from `pool`, or from a pool the
+// handle owns when it is NULL. Calls return 1 on success and 0 if out of
+// memory (or, for uListDelete, if the value is absent).
+typedef struct UList {
+    UNode* head;
+    UNode* tail;
+    int length;
+    NodePool* pool;
+    int ownsPool;
+} UList;
+
+NodePool* createUListPool(int nodesPerBlock);
+int initUList(UList* list, NodePool* pool);
+void destroyUList(UList* list);
+void uListClear(UList* list);
+
+// Insert operations
+int uListAppend(UList* list, int data);
+int uListPrepend(UList* list, int data);
+int uListInsertArray(UList* list, int* arr, int size);  // Fills whole nodes
+int uListDelete(UList* list, int data);                 // First occurrence
+
+// Search algorithm: position of the first match, or -1
+int uListSearch(const UList* list, int target);
+
+// Sort (O(length) scratch; packs the nodes full) and reverse
+int uListSort(UList* list);
+void uListReverse(UList* list);
+
+// Utility functions
+int uListLength(const UList* list);
+int uListGet(const UList* list, int position, int* value);
+void displayUList(const UList* list, const char* label);
+
+#endif
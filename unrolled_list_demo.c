@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "linked_list.h"
+#include "unrolled_list.h"
+
+#define BENCH_ELEMENTS 1000000
+#define BENCH_SEARCHES 200
+
+// Function to print section headers
+void printSection(const char* title) {
+    printf("\n╔════════════════════════════════════════════════════════╗\n");
+    printf("║  %-52s  ║\n", title);
+    printf("╚════════════════════════════════════════════════════════╝\n\n");
+}
+
+static double elapsedMs(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// Walk through the basic operations on a small list
+void unrolledBasics(void) {
+    printSection("1. UNROLLED LIST - Several Values per Node");
+    
+    UList list;
+    if (!initUList(&list, NULL)) {
+        printf("✗ Memory allocation failed!\n");
+        return;
+    }
+    
+    int values[30];
+    for (int i = 0; i < 30; i++) {
+        values[i] = (i * 17) % 31;
+    }
+    uListInsertArray(&list, values, 30);
+    printf("Each node holds up to %d ints in %d bytes.\n\n", UNROLLED_CAPACITY,
+           UNROLLED_NODE_BYTES);
+    displayUList(&list, "Inserted 30      ");
+    
+    uListPrepend(&list, 99);
+    displayUList(&list, "Prepend 99       ");
+    
+    for (int v = 0; v < 12; v++) {
+        uListDelete(&list, v);
+    }
+    displayUList(&list, "Delete 0..11     ");
+    
+    uListSort(&list);
+    displayUList(&list, "Sorted           ");
+    
+    uListReverse(&list);
+    displayUList(&list, "Reversed         ");
+    
+    printf("\nsearch(99) = position %d, length = %d\n", uListSearch(&list, 99),
+           uListLength(&list));
+    destroyUList(&list);
+}
+
+// Compare memory per element with one-int-per-node lists
+void memoryLayout(void) {
+    printSection("2. MEMORY - Bytes per Element");
+    
+    printf("Node  : %zu bytes for 1 int            -> %5.1f bytes per element\n",
+           sizeof(Node), (double)sizeof(Node));
+    printf("UNode : %zu bytes for up to %d ints    -> %5.1f bytes per element (full)\n",
+           sizeof(UNode), UNROLLED_CAPACITY, (double)sizeof(UNode) / UNROLLED_CAPACITY);
+}
+
+// Time linear search through both layouts
+void searchBenchmark(void) {
+    printSection("3. SEARCH - Node vs UNode");
+    
+    int* values = (int*)malloc(BENCH_ELEMENTS * sizeof(int));
+    if (values == NULL) {
+        printf("✗ Memory allocation failed!\n");
+        return;
+    }
+    for (int i = 0; i < BENCH_ELEMENTS; i++) {
+        values[i] = i;
+    }
+    
+    // Plain nodes from malloc, as the interactive driver builds them
+    Node* head = NULL;
+    Node* tail = NULL;
+    for (int i = 0; i < BENCH_ELEMENTS; i++) {
+        Node* node = createNode(values[i]);
+        if (node == NULL) break;
+        if (tail == NULL) head = node; else tail->next = node;
+        tail = node;
+    }
+    
+    UList list;
+    if (!initUList(&list, NULL) || !uListInsertArray(&list, values, BENCH_ELEMENTS)) {
+        printf("✗ Memory allocation failed!\n");
+        freeList(head);
+        free(values);
+        return;
+    }
+    
+    struct timespec start, end;
+    long checksum = 0;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_SEARCHES; i++) {
+        checksum += search(head, (i * 7919) % BENCH_ELEMENTS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double nodeMs = elapsedMs(start, end) / BENCH_SEARCHES;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_SEARCHES; i++) {
+        checksum -= uListSearch(&list, (i * 7919) % BENCH_ELEMENTS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double unrolledMs = elapsedMs(start, end) / BENCH_SEARCHES;
+    
+    printf("%d elements, %d searches (checksum %ld)\n\n", BENCH_ELEMENTS, BENCH_SEARCHES,
+           checksum);
+    printf("search()       : %8.3f ms per search\n", nodeMs);
+    printf("uListSearch()  : %8.3f ms per search  (%.1fx faster)\n", unrolledMs,
+           nodeMs / unrolledMs);
+    
+    destroyUList(&list);
+    freeList(head);
+    free(values);
+}
+
+int main() {
+    unrolledBasics();
+    memoryLayout();
+    searchBenchmark();
+    return EXIT_SUCCESS;
+}